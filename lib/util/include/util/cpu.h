@@ -0,0 +1,61 @@
+/*
+ * libutil - Yet Another Utility Library
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of the library libutil.
+ *
+ * libutil is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libutil is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+/**
+ * @file
+ */
+
+#ifndef UTIL_CPU_H_
+#define UTIL_CPU_H_
+
+#include <util/config.h>
+
+#include <stddef.h>
+
+// Instruction set extensions that kernels are specialized for
+#define CPU_SSE2     0x01
+#define CPU_SSSE3    0x02
+#define CPU_SSE42    0x04 ///< Including the CRC32 instruction
+#define CPU_POPCNT   0x08
+#define CPU_AVX2     0x10
+#define CPU_AVX512BW 0x20
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+// Single functions are compiled for the given extensions in addition to
+// the baseline target and selected at run-time, cf. cpu_features.
+#define HAVE_CPU_DISPATCH
+#define CPU_TARGET(x) __attribute__((target(x)))
+#endif
+
+/**
+ * Detects the instruction set extensions of the executing CPU once
+ * and returns them as a combination of the CPU_* flags.
+ */
+const unsigned int cpu_features();
+
+/**
+ * Restricts the features reported by cpu_features to the given mask,
+ * e.g., in order to test the baseline implementations.
+ */
+void cpu_restrict_features(const unsigned int mask);
+
+/**
+ * Writes the names of the detected features separated by spaces.
+ */
+char* const cpu_features_str(char* const buf, const size_t size);
+
+#endif /* UTIL_CPU_H_ */
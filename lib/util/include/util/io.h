@@ -122,6 +122,14 @@ typedef struct
 		char* buf;
 		size_t len;
 		slices_t slices;
+		// Items passed on in several chunks, e.g., network streams (cf.
+		// net_stream), come with a slot the consumer may keep its state
+		// in. All but the last chunk of such an item are marked as partial.
+		void** state;
+		int partial;
+		// The number of the item in the order of arrival for items that are
+		// processed concurrently and out of order, cf. net_workers.
+		size_t id;
 #ifdef MAINTAIN_METADATA
 		metaref_t meta;
 #endif
@@ -216,6 +224,75 @@ typedef struct {
 
 	void* usr;
 } net_data_t;
+
+/**
+ * Passes on TCP streams chunk-wise as their data arrives rather than merged
+ * at their end. The last \p overlap bytes of a chunk are repeated at the
+ * beginning of the next one of the same stream, e.g., n-1 for byte n-grams.
+ *
+ * @param f The opened network input.
+ * @param overlap The number of bytes to carry over between chunks.
+ */
+void net_stream(file_t* const f, const size_t overlap);
+
+/**
+ * Restricts the processing of a network dump to one of several shards. TCP
+ * connections are assigned to shards by hashing their endpoints, such that
+ * each of several processes may reassemble and process its share of the
+ * same dump independently.
+ *
+ * @param f The opened network dump.
+ * @param shard The shard to process.
+ * @param num_shards The total number of shards.
+ */
+void net_shard(file_t* const f, const size_t shard, const size_t num_shards);
+
+/**
+ * Additionally passes on the payloads of UDP datagrams sent to or from the
+ * given ports. Datagrams sent to one of the ports are considered as client
+ * communication, those sent from one of the ports as server communication.
+ * Just as TCP streams, datagrams are passed on in batches of the requested
+ * size, cf. FN_RECV.
+ *
+ * @param f The opened network input.
+ * @param ports Comma-separated ports or ranges thereof, e.g., "53,5000-5010",
+ *        or "all".
+ * @return EXIT_SUCCESS if the ports could be parsed, EXIT_FAILURE otherwise.
+ */
+const int net_udp(file_t* const f, const char* const ports);
+
+/**
+ * Limits the time complete streams and datagrams are held back in order to
+ * fill a batch, cf. FN_RECV. For live traffic this is checked whenever the
+ * capture returns, i.e., at the latest after the PCAP timeout.
+ *
+ * @param f The opened network input.
+ * @param seconds The maximal latency or 0 for none.
+ */
+void net_latency(file_t* const f, const double seconds);
+
+/**
+ * Scores reassembled TCP streams on \p num_workers threads rather than the
+ * capture thread. The payloads are copied to pooled buffers and handed over
+ * through a lock-free ring. If the workers cannot keep up, payloads are
+ * dropped instead of stalling the capture. The callback passed to the recv
+ * function consequently needs to be thread-safe. Not applicable to
+ * chunk-wise streams, cf. net_stream.
+ *
+ * @param f The opened network input.
+ * @param num_workers The number of threads.
+ */
+void net_workers(file_t* const f, const size_t num_workers);
+
+/**
+ * Returns the number of packets read from a network dump so far, i.e.,
+ * irrespective of the shard they belong to. Only maintained for sharded
+ * processing, cf. net_shard.
+ *
+ * @param f The opened network dump.
+ * @return The number of packets read so far.
+ */
+const size_t net_packets(const file_t* const f);
 #endif
 
 extern void* const REOPEN;
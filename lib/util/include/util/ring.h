@@ -0,0 +1,99 @@
+/*
+ * libutil - Yet Another Utility Library
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of the library libutil.
+ *
+ * libutil is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libutil is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+/**
+ * @file
+ */
+
+#ifndef UTIL_RING_H_
+#define UTIL_RING_H_
+
+#include <stddef.h>
+
+/**
+ * A bounded lock-free queue of pointers that may be used by several
+ * producers and consumers concurrently. The implementation follows Dmitry
+ * Vyukov's bounded MPMC queue: every slot carries a sequence number that
+ * tells whether it is ready to be written or read in the current lap.
+ */
+typedef struct
+{
+	size_t seq;
+	void* item;
+} ring_slot_t;
+
+typedef struct
+{
+	ring_slot_t* slots;
+	size_t mask;
+
+	size_t head; // next slot to be written
+	size_t tail; // next slot to be read
+
+	// Statistics
+	size_t num_pushed;
+	size_t num_full;   // failed pushes
+	size_t max_usage;  // high watermark
+} ring_t;
+
+/**
+ * Initializes a ring that holds at least \p capacity items. The capacity
+ * is rounded up to the next power of two.
+ *
+ * @param r The ring.
+ * @param capacity The minimal number of items.
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE otherwise.
+ */
+const int ring_init(ring_t* const r, const size_t capacity);
+
+/**
+ * Adds an item to the ring.
+ *
+ * @param r The ring.
+ * @param item The item.
+ * @return TRUE if the item was added, FALSE if the ring is full.
+ */
+const int ring_push(ring_t* const r, void* const item);
+
+/**
+ * Removes the oldest item from the ring.
+ *
+ * @param r The ring.
+ * @param item [out] The item.
+ * @return TRUE if an item was removed, FALSE if the ring is empty.
+ */
+const int ring_pop(ring_t* const r, void** const item);
+
+/**
+ * Returns the (approximate) number of items in the ring.
+ *
+ * @param r The ring.
+ * @return The number of items.
+ */
+const size_t ring_size(ring_t* const r);
+
+/**
+ * Returns the number of items the ring may hold at once.
+ *
+ * @param r The ring.
+ * @return The capacity.
+ */
+const size_t ring_capacity(const ring_t* const r);
+
+void ring_destroy(ring_t* const r);
+
+#endif /* UTIL_RING_H_ */
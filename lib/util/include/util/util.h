@@ -41,6 +41,12 @@ const int cmp2(const char* const s, const char* const needles[]);
 const int stricmp(const char* const a, const char* const b);
 
 const int isprintable(const char* const s);
+
+// The values of hex digits plus one, 0 for all other characters
+extern const unsigned char HEX_VALUES[0x100];
+#define HEXVAL(ch) (HEX_VALUES[(unsigned char) (ch)] -1)
+#define ISHEX(ch) (HEX_VALUES[(unsigned char) (ch)] != 0)
+
 const size_t inline_decode(char* s, const size_t len);
 const size_t encode(char** out, size_t* outsize, const char* const s, const size_t len);
 const int starts_with(const char* const s, const char* const prefix);
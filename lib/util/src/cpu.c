@@ -0,0 +1,85 @@
+/*
+ * libutil - Yet Another Utility Library
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of the library libutil.
+ *
+ * libutil is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libutil is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "util/cpu.h"
+
+#include <assert.h>
+#include <string.h>
+
+
+static int detected = 0;
+static unsigned int features = 0;
+static unsigned int restriction = ~0u;
+
+static const unsigned int cpu_detect()
+{
+	unsigned int x = 0;
+#ifdef HAVE_CPU_DISPATCH
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2"))     x |= CPU_SSE2;
+	if (__builtin_cpu_supports("ssse3"))    x |= CPU_SSSE3;
+	if (__builtin_cpu_supports("sse4.2"))   x |= CPU_SSE42;
+	if (__builtin_cpu_supports("popcnt"))   x |= CPU_POPCNT;
+	if (__builtin_cpu_supports("avx2"))     x |= CPU_AVX2;
+	if (__builtin_cpu_supports("avx512bw")) x |= CPU_AVX512BW;
+#elif defined(__SSE2__)
+	x |= CPU_SSE2;
+#endif
+	return x;
+}
+
+const unsigned int cpu_features()
+{
+	// Threads that detect at the same time store the very same result
+	if (!__atomic_load_n(&detected, __ATOMIC_ACQUIRE))
+	{
+		__atomic_store_n(&features, cpu_detect(), __ATOMIC_RELAXED);
+		__atomic_store_n(&detected, 1, __ATOMIC_RELEASE);
+	}
+	return __atomic_load_n(&features, __ATOMIC_RELAXED) & __atomic_load_n(&restriction, __ATOMIC_RELAXED);
+}
+
+void cpu_restrict_features(const unsigned int mask)
+{
+	__atomic_store_n(&restriction, mask, __ATOMIC_RELAXED);
+}
+
+
+static const struct { unsigned int flag; const char* const name; } CPU_FEATURE_NAMES[] =
+{
+	{CPU_SSE2, "sse2"}, {CPU_SSSE3, "ssse3"}, {CPU_SSE42, "sse4.2"},
+	{CPU_POPCNT, "popcnt"}, {CPU_AVX2, "avx2"}, {CPU_AVX512BW, "avx512bw"}
+};
+
+char* const cpu_features_str(char* const buf, const size_t size)
+{
+	assert(buf != NULL && size > 0);
+	const unsigned int x = cpu_features();
+
+	buf[0] = 0x00;
+	for (size_t i = 0; i < sizeof(CPU_FEATURE_NAMES)/sizeof(CPU_FEATURE_NAMES[0]); i++)
+	{
+		if (!(x & CPU_FEATURE_NAMES[i].flag)) continue;
+
+		const size_t len = strlen(buf);
+		if (len +strlen(CPU_FEATURE_NAMES[i].name) +2 > size) break;
+
+		if (len > 0) strcat(buf, " ");
+		strcat(buf, CPU_FEATURE_NAMES[i].name);
+	}
+	return buf;
+}
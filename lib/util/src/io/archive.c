@@ -335,6 +335,10 @@ static inline int archive_read_next(file_t* const f, data_t* const out, const si
 		archive_read_data(it->a, out->buf, out->len);
 	}
 
+	// Files exceeding the chunk size are passed on in several chunks
+	out->state = NULL;
+	out->partial = (it->state.n < it->state.size);
+
 	if (it->state.n >= it->state.size)
 	{
 		archive_read_data_skip(it->a); // Not really necessary
@@ -21,6 +21,8 @@
 #include <util/config.h>
 #include <util/io.h>
 
+#include <string.h>
+
 const int all_filter(file_t* const f, const char* const pattern);
 const int all_filter_ex(file_t* const f, const char* const pattern);
 const int all_filter_close(file_t* const f);
@@ -102,7 +104,8 @@ const size_t type##_read2(file_t* const f, dataset_t* const ds, const size_t chu
 		if (ds->n >= ds->capacity)                                                                     \
 		{                                                                                              \
 			ds->capacity *= 2;                                                                         \
-			ds->data = (data_t*) realloc(ds->data, ds->capacity * sizeof(data_t*));                    \
+			ds->data = (data_t*) realloc(ds->data, ds->capacity * sizeof(data_t));                     \
+			memset(ds->data +ds->n, 0x00, (ds->capacity -ds->n) * sizeof(data_t));                     \
 		}                                                                                              \
 		                                                                                               \
 		ret = type##_read_next(f, &ds->data[ds->n], chunk_size -size);                                 \
@@ -220,6 +220,9 @@ static inline const int file_read_next(file_t* const f, data_t* const out, const
 #ifdef EXTENDED_METADATA
 	out->meta.filename = f->meta.filename;
 #endif
+	// Lines exceeding the chunk size are passed on in several chunks
+	out->state = NULL;
+	out->partial = (it->state.pos < it->state.size);
 
 	if (it->state.pos >= it->state.size)
 	{
@@ -21,9 +21,13 @@
 #ifdef USE_NETWORK
 #include <nids.h>
 #include <errno.h>
+#include <stdint.h>
 #include <signal.h>
+#include <pthread.h>
+#include <sys/time.h>
 
 #include <util/log.h>
+#include <util/ring.h>
 
 struct
 {
@@ -31,10 +35,68 @@ struct
 	FN_DATA callback;
 	void* data;
 	int merge_payloads;
+	size_t overlap; // cf. net_stream
+	size_t shard, num_shards; // cf. net_shard
+	size_t num_packets;
 	size_t num_chunks;
 	uint8_t state;
 } nids_user;
 
+// Payloads are handed from the capture thread to the workers through a ring
+// (cf. net_workers), using a fixed pool of buffers that is recycled via a
+// second ring. If the pool is exhausted, i.e., the workers cannot keep up,
+// payloads are dropped rather than stalling the capture. Idle workers sleep
+// until the capture thread hands over the next payload.
+#define NET_RING_SIZE 4096
+
+typedef struct
+{
+	char* buf;
+	size_t len;
+	size_t capacity;
+	size_t id;
+} net_payload_t;
+
+struct
+{
+	size_t num_workers;
+	ring_t queue; // capture -> workers
+	ring_t pool;  // workers -> capture
+	net_payload_t* payloads;
+	int done;
+	size_t num_handed; // Dropped payloads are counted as well
+	size_t num_dropped;
+
+	pthread_mutex_t lock;
+	pthread_cond_t ready;
+	size_t num_sleeping;
+} net_ring;
+
+
+// UDP datagrams of the selected ports, cf. net_udp
+struct
+{
+	int enabled;
+	int all_ports;
+	uint8_t ports[0x10000 /8];
+} net_udp_user;
+
+// Complete TCP streams and UDP datagrams are copied and passed on in batches
+// of the requested size, or once the oldest one has waited for too long
+// (cf. net_latency). libnids reuses its buffers, hence the copies.
+struct
+{
+	size_t size;
+	data_t* data;
+	size_t* capacity;
+	size_t n;
+
+	double latency;
+	double oldest;
+} net_batch;
+
+#define UDP_PORT(p) (net_udp_user.all_ports || (net_udp_user.ports[(p) >> 3] & (1 << ((p) & 7))))
+
 
 // OPEN
 // This is a stripped down version of libnids initialization functionality
@@ -97,6 +159,17 @@ const int net_open(file_t* const f, const char* const filename, const char* mode
 	f->data = &nids_params;
 	f->is_device = params->is_device;
 
+	// Streams are merged unless requested otherwise, cf. net_stream
+	nids_user.merge_payloads = TRUE;
+	nids_user.overlap = 0;
+	nids_user.shard = 0;
+	nids_user.num_shards = 1;
+	nids_user.num_packets = 0;
+	net_ring.num_workers = 0;
+	net_ring.num_handed = 0;
+	net_udp_user.enabled = FALSE;
+	net_batch.latency = 0.0;
+
 	net_data_t* const d = calloc(1, sizeof(net_data_t));
 	d->client_comm = params->client_comm;
 	d->server_comm = params->server_comm;
@@ -152,15 +225,368 @@ const int net_filter(file_t* const f, const char* const pattern)
 
 // RECV
 #define PROCESS(hs,count) { \
-	data[0].buf = (hs)->data; \
-	data[0].len = (hs)->count; \
 	nids_user.meta->num_items++; \
-	nids_user.meta->total_size += data[0].len; \
+	nids_user.meta->total_size += (size_t) (hs)->count; \
+	if (net_ring.num_workers > 0) \
+	{ \
+		net_handoff((hs)->data, (size_t) (hs)->count); \
+	} \
+	else if (net_batch.size > 1) \
+	{ \
+		net_batch_add((hs)->data, (size_t) (hs)->count, d->usr); \
+	} \
+	else \
+	{ \
+		data[0].buf = (hs)->data; \
+		data[0].len = (hs)->count; \
+		data[0].state = NULL; \
+		data[0].partial = FALSE; \
+		nids_user.callback(data, 1, d->usr); \
+	} \
+	nids_user.num_chunks++; \
+	hourglass(&nids_user.state, nids_user.num_chunks); \
+}
+
+static const double net_now()
+{
+	struct timeval t;
+	gettimeofday(&t, NULL);
+	return (double) t.tv_sec +(double) t.tv_usec /1000000.0;
+}
+
+static void net_batch_flush(void* const usr)
+{
+	if (net_batch.n > 0)
+	{
+		nids_user.callback(net_batch.data, net_batch.n, usr);
+		net_batch.n = 0;
+	}
+}
+
+static void net_batch_expire(void* const usr)
+{
+	if (net_batch.n > 0 && net_batch.latency > 0.0 && net_now() -net_batch.oldest >= net_batch.latency)
+	{
+		net_batch_flush(usr);
+	}
+}
+
+static void net_batch_add(const char* const buf, const size_t len, void* const usr)
+{
+	const size_t i = net_batch.n;
+	if (net_batch.capacity[i] < len)
+	{
+		char* const x = (char*) realloc(net_batch.data[i].buf, len);
+		if (x == NULL) return;
+
+		net_batch.data[i].buf = x;
+		net_batch.capacity[i] = len;
+	}
+
+	memcpy(net_batch.data[i].buf, buf, len);
+	net_batch.data[i].len = len;
+
+	if (net_batch.n++ == 0 && net_batch.latency > 0.0)
+	{
+		net_batch.oldest = net_now();
+	}
+
+	if (net_batch.n >= net_batch.size)
+	{
+		net_batch_flush(usr);
+	}
+	else
+	{
+		net_batch_expire(usr);
+	}
+}
+
+void net_latency(file_t* const f, const double seconds)
+{
+	assert(f != NULL);
+	net_batch.latency = seconds;
+}
+
+static void net_handoff(const char* const buf, const size_t len)
+{
+	// The numbers of dropped payloads are skipped, such that drops show
+	const size_t id = net_ring.num_handed++;
+
+	net_payload_t* p = NULL;
+	if (!ring_pop(&net_ring.pool, (void**) &p))
+	{
+		net_ring.num_dropped++;
+		return;
+	}
+
+	if (p->capacity < len)
+	{
+		char* const x = (char*) realloc(p->buf, len);
+		if (x == NULL)
+		{
+			ring_push(&net_ring.pool, p);
+			net_ring.num_dropped++;
+			return;
+		}
+		p->buf = x;
+		p->capacity = len;
+	}
+
+	memcpy(p->buf, buf, len);
+	p->len = len;
+	p->id = id;
+
+	// There are no more payloads than slots, hence this never fails
+	ring_push(&net_ring.queue, p);
+
+	// Pairs with the increment in net_worker_wait, such that either the
+	// worker finds the payload or the capture thread finds the worker.
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&net_ring.num_sleeping, __ATOMIC_RELAXED) > 0)
+	{
+		pthread_mutex_lock(&net_ring.lock);
+		pthread_cond_signal(&net_ring.ready);
+		pthread_mutex_unlock(&net_ring.lock);
+	}
+}
+
+// Blocks until there is a payload or all of them have been processed.
+// Returns FALSE in the latter case.
+static const int net_worker_wait(net_payload_t** const p)
+{
+	pthread_mutex_lock(&net_ring.lock);
+	__atomic_add_fetch(&net_ring.num_sleeping, 1, __ATOMIC_SEQ_CST);
+
+	int ret = TRUE;
+	for (;;)
+	{
+		// Once done, all payloads have been queued already
+		const int done = __atomic_load_n(&net_ring.done, __ATOMIC_ACQUIRE);
+		if (ring_pop(&net_ring.queue, (void**) p)) break;
+		if (done)
+		{
+			ret = FALSE;
+			break;
+		}
+		pthread_cond_wait(&net_ring.ready, &net_ring.lock);
+	}
+
+	__atomic_sub_fetch(&net_ring.num_sleeping, 1, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&net_ring.lock);
+	return ret;
+}
+
+static void* net_worker(void* usr)
+{
+	data_t data[1];
+	memset(data, 0x00, sizeof(data));
+
+	for (;;)
+	{
+		net_payload_t* p = NULL;
+		if (!ring_pop(&net_ring.queue, (void**) &p) && !net_worker_wait(&p))
+		{
+			break;
+		}
+
+		data[0].buf = p->buf;
+		data[0].len = p->len;
+		data[0].id = p->id;
+		nids_user.callback(data, 1, usr);
+
+		ring_push(&net_ring.pool, p);
+	}
+	return NULL;
+}
+
+void net_workers(file_t* const f, const size_t num_workers)
+{
+	assert(f != NULL);
+	net_ring.num_workers = num_workers;
+}
+
+static const int net_workers_start(pthread_t* const threads, void* const usr)
+{
+	if (ring_init(&net_ring.queue, NET_RING_SIZE) != EXIT_SUCCESS) return EXIT_FAILURE;
+	if (ring_init(&net_ring.pool, NET_RING_SIZE) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+	net_ring.payloads = (net_payload_t*) calloc(NET_RING_SIZE, sizeof(net_payload_t));
+	if (net_ring.payloads == NULL) return EXIT_FAILURE;
+
+	for (size_t i = 0; i < NET_RING_SIZE; i++)
+	{
+		ring_push(&net_ring.pool, &net_ring.payloads[i]);
+	}
+	net_ring.done = FALSE;
+	net_ring.num_dropped = 0;
+	net_ring.num_sleeping = 0;
+
+	pthread_mutex_init(&net_ring.lock, NULL);
+	pthread_cond_init(&net_ring.ready, NULL);
+
+	for (size_t i = 0; i < net_ring.num_workers; i++)
+	{
+		if (pthread_create(&threads[i], NULL, net_worker, usr) != 0)
+		{
+			warn("Unable to start more than %"ZU" workers.", (SIZE_T) i);
+			net_ring.num_workers = i;
+			break;
+		}
+	}
+	return (net_ring.num_workers > 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+static void net_workers_stop(pthread_t* const threads)
+{
+	pthread_mutex_lock(&net_ring.lock);
+	__atomic_store_n(&net_ring.done, TRUE, __ATOMIC_RELEASE);
+	pthread_cond_broadcast(&net_ring.ready);
+	pthread_mutex_unlock(&net_ring.lock);
+
+	for (size_t i = 0; i < net_ring.num_workers; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+
+	info("Handed %"ZU" payloads to %"ZU" workers, %"ZU" dropped",
+			(SIZE_T) net_ring.queue.num_pushed, (SIZE_T) net_ring.num_workers, (SIZE_T) net_ring.num_dropped);
+	info("At most %"ZU" of %"ZU" payloads queued at once",
+			(SIZE_T) net_ring.queue.max_usage, (SIZE_T) NET_RING_SIZE);
+
+	for (size_t i = 0; i < NET_RING_SIZE; i++)
+	{
+		free(net_ring.payloads[i].buf);
+	}
+	free(net_ring.payloads);
+	ring_destroy(&net_ring.queue);
+	ring_destroy(&net_ring.pool);
+
+	pthread_cond_destroy(&net_ring.ready);
+	pthread_mutex_destroy(&net_ring.lock);
+}
+
+// Passes on what has been collected of one direction of a stream so far,
+// i.e., the new data preceded by the bytes kept from the previous chunk.
+#define PROCESS_CHUNK(hs, slot, is_partial, num_new) { \
+	data[0].buf = (hs)->data; \
+	data[0].len = (size_t) ((hs)->count -(hs)->offset); \
+	data[0].state = (slot); \
+	data[0].partial = (is_partial); \
+	if (!(is_partial)) nids_user.meta->num_items++; \
+	nids_user.meta->total_size += (size_t) (num_new); \
 	nids_user.callback(data, 1, d->usr); \
 	nids_user.num_chunks++; \
 	hourglass(&nids_user.state, nids_user.num_chunks); \
 }
 
+void net_stream(file_t* const f, const size_t overlap)
+{
+	assert(f != NULL);
+	nids_user.merge_payloads = FALSE;
+	nids_user.overlap = overlap;
+}
+
+void net_shard(file_t* const f, const size_t shard, const size_t num_shards)
+{
+	assert(f != NULL);
+	assert(!f->is_device);
+	assert(shard < num_shards);
+
+	nids_user.shard = shard;
+	nids_user.num_shards = num_shards;
+}
+
+const size_t net_packets(const file_t* const f)
+{
+	assert(f != NULL);
+	return nids_user.num_packets;
+}
+
+// Both directions of a connection need to end up in the same shard, hence
+// the endpoints are combined symmetrically before mixing (murmur3's fmix32).
+static const size_t net_shard_of(const uint32_t saddr, const uint32_t daddr, const uint16_t sport, const uint16_t dport)
+{
+	uint32_t h = (saddr ^daddr) +(uint32_t) (sport ^dport) *0x9e3779b1;
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+	return (size_t) h % nids_user.num_shards;
+}
+
+// Returns FALSE for TCP and UDP packets that are handled by another shard. Anything
+// else (fragments, other protocols and link types) is passed on as is, and
+// the ownership of a connection is checked once more when it is established.
+static const int net_shard_owns(const int linktype, const u_char* const pkt, const size_t caplen)
+{
+	size_t off = 0;
+	switch (linktype)
+	{
+	case DLT_EN10MB:
+		off = 14;
+		if (caplen >= off && pkt[12] == 0x81 && pkt[13] == 0x00) off += 4; // 802.1Q
+		if (caplen < off || pkt[off -2] != 0x08 || pkt[off -1] != 0x00) return TRUE;
+		break;
+	case DLT_LINUX_SLL:
+		off = 16;
+		if (caplen < off || pkt[14] != 0x08 || pkt[15] != 0x00) return TRUE;
+		break;
+	case DLT_NULL: case DLT_LOOP:
+		off = 4;
+		break;
+	case DLT_RAW:
+		break;
+	default:
+		return TRUE;
+	}
+
+	const u_char* const ip = pkt +off;
+	if (caplen < off +20 || (ip[0] >> 4) != 4) return TRUE;
+
+	const size_t ihl = (size_t) (ip[0] & 0x0f) *4;
+	const int fragment = ((ip[6] & 0x3f) | ip[7]) != 0; // MF flag or offset
+	if ((ip[9] != 6 && ip[9] != 17) || fragment || caplen < off +ihl +4) return TRUE;
+
+	uint32_t saddr, daddr;
+	memcpy(&saddr, ip +12, sizeof(uint32_t));
+	memcpy(&daddr, ip +16, sizeof(uint32_t));
+
+	// TCP and UDP share the position of the ports
+	const u_char* const l4 = ip +ihl;
+	const uint16_t sport = (uint16_t) ((l4[0] << 8) | l4[1]);
+	const uint16_t dport = (uint16_t) ((l4[2] << 8) | l4[3]);
+
+	return net_shard_of(saddr, daddr, sport, dport) == nids_user.shard;
+}
+
+static void net_shard_handler(u_char* usr, const struct pcap_pkthdr* hdr, const u_char* pkt)
+{
+	const int linktype = *((int*) usr);
+	nids_user.num_packets++;
+
+	if (net_shard_owns(linktype, pkt, hdr->caplen))
+	{
+		nids_pcap_handler(NULL, (struct pcap_pkthdr*) hdr, (u_char*) pkt);
+	}
+}
+
+static void net_recv_tcpchunk(struct tcp_stream* const s, struct half_stream* const hs, void** const slot, const int process)
+{
+	static data_t data[1];
+	net_data_t* const d = (net_data_t*) nids_user.data;
+
+	const int avail = hs->count -hs->offset;
+	if (process)
+	{
+		PROCESS_CHUNK(hs, slot, TRUE, hs->count_new);
+	}
+
+	// Only the overlap is kept, such that the memory per stream is bounded
+	const int keep = (process ? (int) MIN((size_t) avail, nids_user.overlap) : 0);
+	nids_discard(s, avail -keep);
+}
+
 void net_recv_tcp(struct tcp_stream* const s, void** reserved)
 {
 	// --batch-size is ignored for network streams
@@ -170,12 +596,21 @@ void net_recv_tcp(struct tcp_stream* const s, void** reserved)
 	switch (s->nids_state)
 	{
 	case NIDS_JUST_EST:
+		if (nids_user.num_shards > 1 && net_shard_of(s->addr.saddr, s->addr.daddr, s->addr.source, s->addr.dest) != nids_user.shard)
+		{
+			return;
+		}
 		s->client.collect++;
 		s->server.collect++;
 #ifdef WE_WANT_URGENT_DATA
 		s->server.collect_urg++;
 		a_tcp->client.collect_urg++;
 #endif
+		if (!nids_user.merge_payloads)
+		{
+			// One slot for the consumer's state per direction
+			s->user = calloc(2, sizeof(void*));
+		}
 		return;
 
 	case NIDS_DATA:
@@ -185,6 +620,15 @@ void net_recv_tcp(struct tcp_stream* const s, void** reserved)
             return;
         }
 
+        if (s->user != NULL)
+        {
+        	void** const slots = (void**) s->user;
+        	// XXX: Yes, its somehow always the other way around.
+        	if (s->client.count_new) net_recv_tcpchunk(s, &s->client, &slots[0], d->server_comm);
+        	if (s->server.count_new) net_recv_tcpchunk(s, &s->server, &slots[1], d->client_comm);
+        	return;
+        }
+
         // Check who sent the data
     	// XXX: Yes, its somehow always the other way around.
 		if (d->server_comm && s->client.count_new) PROCESS(&s->client, count_new);
@@ -198,25 +642,115 @@ void net_recv_tcp(struct tcp_stream* const s, void** reserved)
 			if (d->client_comm && s->server.count != 0) PROCESS(&s->server, count);
 			if (d->server_comm && s->client.count != 0) PROCESS(&s->client, count);
         }
+        else if (s->user != NULL)
+        {
+        	// The last chunk finalizes the consumer's state
+        	void** const slots = (void**) s->user;
+			if (d->client_comm && s->server.count != 0) PROCESS_CHUNK(&s->server, &slots[1], FALSE, 0);
+			if (d->server_comm && s->client.count != 0) PROCESS_CHUNK(&s->client, &slots[0], FALSE, 0);
+
+        	free(s->user);
+        	s->user = NULL;
+        }
         break;
 	}
 }
 
 
+const int net_udp(file_t* const f, const char* const ports)
+{
+	assert(f != NULL && ports != NULL);
+
+	memset(net_udp_user.ports, 0x00, sizeof(net_udp_user.ports));
+	net_udp_user.all_ports = (strcmp(ports, "all") == 0);
+
+	for (const char* x = ports; !net_udp_user.all_ports && *x != 0x00; )
+	{
+		char* end;
+		const long from = strtol(x, &end, 10);
+		long to = from;
+
+		if (*end == '-')
+		{
+			to = strtol(end +1, &end, 10);
+		}
+		if (end == x || (*end != ',' && *end != 0x00) || from < 0 || to < from || to > 0xffff)
+		{
+			return EXIT_FAILURE;
+		}
+
+		for (long p = from; p <= to; p++)
+		{
+			net_udp_user.ports[p >> 3] |= (uint8_t) (1 << (p & 7));
+		}
+		x = (*end == ',' ? end +1 : end);
+	}
+
+	net_udp_user.enabled = TRUE;
+	return EXIT_SUCCESS;
+}
+
+void net_recv_udp(struct tuple4* addr, char* buf, int len, struct ip* iph)
+{
+	net_data_t* const d = (net_data_t*) nids_user.data;
+
+	if (nids_user.num_shards > 1 && net_shard_of(addr->saddr, addr->daddr, addr->source, addr->dest) != nids_user.shard)
+	{
+		return;
+	}
+
+	// Datagrams to one of the ports are considered to be sent by the client,
+	// those from one of the ports by the server.
+	const int to_port = UDP_PORT(addr->dest), from_port = UDP_PORT(addr->source);
+	if (len <= 0 || !((d->client_comm && to_port) || (d->server_comm && from_port)))
+	{
+		return;
+	}
+
+	nids_user.meta->num_items++;
+	nids_user.meta->total_size += (size_t) len;
+	nids_user.num_chunks++;
+	hourglass(&nids_user.state, nids_user.num_chunks);
+
+	if (net_ring.num_workers > 0)
+	{
+		net_handoff(buf, (size_t) len);
+		return;
+	}
+
+	net_batch_add(buf, (size_t) len, d->usr);
+}
+
 const size_t net_recv(file_t* const f, FN_DATA callback, const size_t batch_size, void* const usr)
 {
 	// For the network mode we would like to process the data as recent as
-	// possible on a stream basis
-	assert(batch_size == 1);
+	// possible on a stream basis. Batches of several streams are therefore
+	// passed on after net_latency seconds at the latest.
+	assert(batch_size > 0);
 
 	nids_user.meta = &f->meta;
 	nids_user.callback = callback;
 	((net_data_t*) nids_user.data)->usr = usr;
-	nids_user.merge_payloads = TRUE;
 	nids_user.state = 0;
 
-	//nids_register_udp((void *) net_recv_udp);
 	nids_register_tcp((void*) net_recv_tcp);
+	if (net_udp_user.enabled)
+	{
+		nids_register_udp((void*) net_recv_udp);
+	}
+
+	net_batch.size = batch_size;
+	net_batch.data = (data_t*) calloc(batch_size, sizeof(data_t));
+	net_batch.capacity = (size_t*) calloc(batch_size, sizeof(size_t));
+	net_batch.n = 0;
+
+	if (net_batch.data == NULL || net_batch.capacity == NULL)
+	{
+		error("Unable to allocate memory for batches of network data.");
+		free(net_batch.data);
+		free(net_batch.capacity);
+		return 0;
+	}
 
 	// Disable checksum control
 	static struct nids_chksum_ctl ctl;
@@ -225,7 +759,47 @@ const size_t net_recv(file_t* const f, FN_DATA callback, const size_t batch_size
 	ctl.action = NIDS_DONT_CHKSUM;
 	nids_register_chksum_ctl(&ctl, 1);
 
-	nids_run();
+	pthread_t* const threads = (net_ring.num_workers > 0 ? (pthread_t*) calloc(net_ring.num_workers, sizeof(pthread_t)) : NULL);
+	if (net_ring.num_workers > 0 && (threads == NULL || net_workers_start(threads, usr) != EXIT_SUCCESS))
+	{
+		error("Unable to start the workers.");
+		free(threads);
+		return 0;
+	}
+
+	if (nids_user.num_shards > 1)
+	{
+		// Same as nids_run, but only the packets of our shard are reassembled
+		int linktype = pcap_datalink(nids_params.pcap_desc);
+		pcap_loop(nids_params.pcap_desc, -1, net_shard_handler, (u_char*) &linktype);
+	}
+	else if (f->is_device && net_batch.size > 1 && net_batch.latency > 0.0)
+	{
+		// Same as nids_run, but pending batches are checked whenever the
+		// capture returns, i.e., with new packets or after its timeout.
+		while (nids_dispatch(-1) >= 0)
+		{
+			net_batch_expire(usr);
+		}
+	}
+	else
+	{
+		nids_run();
+	}
+
+	net_batch_flush(usr);
+	for (size_t i = 0; i < net_batch.size; i++)
+	{
+		free(net_batch.data[i].buf);
+	}
+	free(net_batch.data);
+	free(net_batch.capacity);
+
+	if (threads != NULL)
+	{
+		net_workers_stop(threads);
+		free(threads);
+	}
 
 	hourglass_stop();
 	return nids_user.num_chunks;
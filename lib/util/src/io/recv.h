@@ -35,7 +35,8 @@ inline const size_t recv_stub_ex(file_t* const f, FN_READ read, FN_DATA data, co
 	buf.n = 0;
 
 	size_t n = 0, N = 0;
-	while ((n = read(f, &buf, batch_size)) > 0)
+	// Chunks of empty strings amount to zero bytes, cf. READ2_STUB
+	while ((n = read(f, &buf, batch_size)) > 0 || buf.n > 0)
 	{
 #ifndef NDEBUG
 		const int ret = data(buf.data, buf.n, usr);
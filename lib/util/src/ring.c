@@ -0,0 +1,150 @@
+/*
+ * libutil - Yet Another Utility Library
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of the library libutil.
+ *
+ * libutil is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libutil is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include <util/ring.h>
+#include <util/util.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define LOAD(x)     __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#define CAS(x, e, v) __atomic_compare_exchange_n(&(x), &(e), (v), TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+
+// Raises the high watermark, which several producers may do at once
+static inline void ring_watermark(ring_t* const r, const size_t usage)
+{
+	size_t x = __atomic_load_n(&r->max_usage, __ATOMIC_RELAXED);
+	while (usage > x && !CAS(r->max_usage, x, usage));
+}
+
+const int ring_init(ring_t* const r, const size_t capacity)
+{
+	assert(r != NULL);
+	assert(capacity > 0);
+
+	size_t n = 2;
+	while (n < capacity && n < SIZE_MAX/2) n <<= 1;
+
+	r->slots = (ring_slot_t*) malloc(n *sizeof(ring_slot_t));
+	if (r->slots == NULL)
+	{
+		return EXIT_FAILURE;
+	}
+
+	for (size_t i = 0; i < n; i++)
+	{
+		r->slots[i].seq = i;
+		r->slots[i].item = NULL;
+	}
+
+	r->mask = n -1;
+	r->head = r->tail = 0;
+	r->num_pushed = r->num_full = r->max_usage = 0;
+	return EXIT_SUCCESS;
+}
+
+const int ring_push(ring_t* const r, void* const item)
+{
+	assert(r != NULL);
+
+	size_t pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+	for (;;)
+	{
+		ring_slot_t* const slot = &r->slots[pos & r->mask];
+		const size_t seq = LOAD(slot->seq);
+
+		if (seq == pos)
+		{
+			// The slot is free in this lap, claim it
+			if (CAS(r->head, pos, pos +1))
+			{
+				slot->item = item;
+				STORE(slot->seq, pos +1);
+
+				__atomic_add_fetch(&r->num_pushed, 1, __ATOMIC_RELAXED);
+				// Consumers may have moved past this item already
+				const size_t tail = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+				if (tail < pos +1) ring_watermark(r, pos +1 -tail);
+				return TRUE;
+			}
+		}
+		else if ((ptrdiff_t) (seq -pos) < 0)
+		{
+			// The slot has not been consumed yet in the previous lap
+			__atomic_add_fetch(&r->num_full, 1, __ATOMIC_RELAXED);
+			return FALSE;
+		}
+		else
+		{
+			pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+		}
+	}
+}
+
+const int ring_pop(ring_t* const r, void** const item)
+{
+	assert(r != NULL && item != NULL);
+
+	size_t pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+	for (;;)
+	{
+		ring_slot_t* const slot = &r->slots[pos & r->mask];
+		const size_t seq = LOAD(slot->seq);
+
+		if (seq == pos +1)
+		{
+			// The slot has been written in this lap, claim it
+			if (CAS(r->tail, pos, pos +1))
+			{
+				*item = slot->item;
+				STORE(slot->seq, pos +r->mask +1);
+				return TRUE;
+			}
+		}
+		else if ((ptrdiff_t) (seq -(pos +1)) < 0)
+		{
+			return FALSE;
+		}
+		else
+		{
+			pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+		}
+	}
+}
+
+const size_t ring_size(ring_t* const r)
+{
+	assert(r != NULL);
+	const size_t tail = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+	const size_t head = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+	return (head > tail ? head -tail : 0);
+}
+
+const size_t ring_capacity(const ring_t* const r)
+{
+	assert(r != NULL);
+	return r->mask +1;
+}
+
+void ring_destroy(ring_t* const r)
+{
+	if (r == NULL) return;
+	free(r->slots);
+	r->slots = NULL;
+}
@@ -16,6 +16,7 @@
  */
 
 #include "util/util.h"
+#include "util/cpu.h"
 
 #include <stdarg.h>
 #include <stdlib.h>
@@ -29,6 +30,13 @@
 #include <sys/types.h>
 #endif
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef HAVE_CPU_DISPATCH
+#include <immintrin.h>
+#endif
+
 const int cmp(const char* const s, ...)
 {
 	va_list args;
@@ -91,46 +99,98 @@ const int isprintable(const char* const s)
 	return TRUE;
 }
 
+const unsigned char HEX_VALUES[0x100] = {
+	['0'] =  1, ['1'] =  2, ['2'] =  3, ['3'] =  4, ['4'] =  5,
+	['5'] =  6, ['6'] =  7, ['7'] =  8, ['8'] =  9, ['9'] = 10,
+	['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+	['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16
+};
+
+// Returns the position of the next '%' at or after i, or len if there is none
+static const size_t find_percent_scalar(const char* const s, const size_t i, const size_t len)
+{
+	const char* const x = (const char*) memchr(s +i, '%', len -i);
+	return (x == NULL ? len : (size_t) (x -s));
+}
+
+#ifdef __SSE2__
+static const size_t find_percent_sse2(const char* const s, size_t i, const size_t len)
+{
+	const __m128i p = _mm_set1_epi8('%');
+	for (; i +16 <= len; i += 16)
+	{
+		const unsigned int m = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (s +i)), p));
+		if (m != 0) return i +(size_t) __builtin_ctz(m);
+	}
+	return find_percent_scalar(s, i, len);
+}
+#endif
+
+#ifdef HAVE_CPU_DISPATCH
+CPU_TARGET("avx2") static const size_t find_percent_avx2(const char* const s, size_t i, const size_t len)
+{
+	const __m256i p = _mm256_set1_epi8('%');
+	for (; i +32 <= len; i += 32)
+	{
+		const unsigned int m = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (s +i)), p));
+		if (m != 0) return i +(size_t) __builtin_ctz(m);
+	}
+	return find_percent_scalar(s, i, len);
+}
+#endif
+
+typedef const size_t (*FN_FINDPERCENT)(const char* const s, const size_t i, const size_t len);
+
+static FN_FINDPERCENT find_percent_fct()
+{
+#ifdef HAVE_CPU_DISPATCH
+	if (cpu_features() & CPU_AVX2) return find_percent_avx2;
+#endif
+#ifdef __SSE2__
+	return find_percent_sse2;
+#else
+	return find_percent_scalar;
+#endif
+}
+
 const size_t inline_decode(char* s, const size_t len)
 {
-	char buf[5] = "0x00";
+	const FN_FINDPERCENT find_percent = find_percent_fct();
 
-	size_t j = 0;
-	for (size_t i = 0; i < len; i++, j++)
+	size_t i = 0, j = 0;
+	while (i < len)
 	{
-		if (s[i] != '%')
+		// Runs without any encoding are moved as a whole
+		const size_t k = find_percent(s, i, len);
+		if (j != i)
 		{
-			s[j] = s[i];
-			continue;
+			memmove(s +j, s +i, k -i);
 		}
+		j += k -i;
+		i = k;
+
+		if (i >= len) break;
 
 		// write out truncated sequence
-		const size_t x = len -i;
-		if (x <= 2)
+		if (len -i <= 2)
 		{
-			for (size_t k = 0; k < x; k++, i++, j++)
-			{
-				s[j] = s[i];
-			}
+			memmove(s +j, s +i, len -i);
+			j += len -i;
 			break;
 		}
 
-		buf[2] = s[++i];
-		buf[3] = s[++i];
-
 		// is valid encoding?
-		if (isxdigit(buf[2]) && isxdigit(buf[3]))
+		if (ISHEX(s[i +1]) && ISHEX(s[i +2]))
 		{
-			unsigned int ch;
-			sscanf(buf, "%x", (unsigned int*) &ch);
-			s[j] = (char) ch;
+			s[j++] = (char) ((HEXVAL(s[i +1]) << 4) | HEXVAL(s[i +2]));
 		}
 		else
 		{
 			s[j++] = '%';
-			s[j++] = buf[2];
-			s[j]   = buf[3];
+			s[j++] = s[i +1];
+			s[j++] = s[i +2];
 		}
+		i += 3;
 	}
 	s[j] = 0x00;
 	return j;
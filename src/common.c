@@ -20,6 +20,12 @@
 #include <salad/util.h>
 #include <util/log.h>
 
+#ifdef USE_NETWORK
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 const char* const saladmode_to_string(saladmode_t m)
 {
 	switch (m)
@@ -28,6 +34,8 @@ const char* const saladmode_to_string(saladmode_t m)
 	case PREDICT:  return "predict";
 	case INSPECT:  return "inspect";
 	case STATS:    return "stats";
+	case FREEZE:   return "freeze";
+	case SERVE:    return "serve";
 	case TEST:      return "test";
 	default: break;
 	}
@@ -36,23 +44,61 @@ const char* const saladmode_to_string(saladmode_t m)
 
 const saladmode_t to_saladmode(const char* const str)
 {
-	switch (cmp(str, "train", "predict", "inspect", "stats", "test", NULL))
+	switch (cmp(str, "train", "predict", "inspect", "stats", "test", "freeze", "serve", NULL))
 	{
 	case 0: return TRAINING;
 	case 1: return PREDICT;
 	case 2: return INSPECT;
 	case 3: return STATS;
 	case 4: return TEST;
+	case 5: return FREEZE;
+	case 6: return SERVE;
 	}
 	return UNDEFINED;
 }
 
 
 
-const int salad_heart(const config_t* const c, FN_SALAD fct)
+#ifdef USE_NETWORK
+// The worker processes of salad_heart_sharded record for every piece of
+// output the number of packets read up to that point. This allows to merge
+// the outputs of all workers in the order of a single pass over the dump.
+static struct
+{
+	FN_RECV recv;
+	FN_DATA callback;
+	const file_t* f;
+	FILE* out;
+	FILE* marks;
+	long pos;
+} shard = { NULL, NULL, NULL, NULL, NULL, 0 };
+
+static const int salad_shard_callback(data_t* data, const size_t n, void* const usr)
+{
+	const int ret = shard.callback(data, n, usr);
+
+	const long pos = ftell(shard.out);
+	if (pos != shard.pos)
+	{
+		const size_t mark[2] = { net_packets(shard.f), (size_t) pos };
+		fwrite(mark, sizeof(size_t), 2, shard.marks);
+		shard.pos = pos;
+	}
+	return ret;
+}
+
+static const size_t salad_shard_recv(file_t* const f, FN_DATA callback, const size_t batch_size, void* const usr)
+{
+	shard.callback = callback;
+	shard.f = f;
+	return shard.recv(f, salad_shard_callback, batch_size, usr);
+}
+#endif
+
+static const int salad_heart_ex(const config_t* const c, FN_SALAD fct, FILE* const shard_out, FILE* const shard_marks)
 {
 	assert(c != NULL);
-	const data_processor_t* const dp = to_dataprocessor(c->input_type);
+	const data_processor_t* dp = to_dataprocessor(c->input_type);
 
 #ifdef USE_NETWORK
 	net_param_t p = {
@@ -77,6 +123,15 @@ const int salad_heart(const config_t* const c, FN_SALAD fct)
 		return EXIT_FAILURE;
 	}
 
+#ifdef USE_NETWORK
+	if (c->net_udp_ports != NULL && net_udp(&f_in, c->net_udp_ports) != EXIT_SUCCESS)
+	{
+		error("Unable to parse the UDP ports '%s'.", c->net_udp_ports);
+		dp->close(&f_in);
+		return EXIT_FAILURE;
+	}
+#endif
+
 	ret = dp->filter(&f_in, c->input_filter);
 	if (ret != EXIT_SUCCESS)
 	{
@@ -91,10 +146,31 @@ const int salad_heart(const config_t* const c, FN_SALAD fct)
 		return EXIT_FAILURE;
 	}
 
+#ifdef USE_NETWORK
+	data_processor_t sharded;
+	if (shard_out != NULL)
+	{
+		net_shard(&f_in, c->net_shard, c->net_workers);
+
+		shard.recv = dp->recv;
+		shard.out = shard_out;
+		shard.marks = shard_marks;
+		shard.pos = 0;
+
+		sharded = *dp;
+		sharded.recv = salad_shard_recv;
+		dp = &sharded;
+	}
+#endif
+
 	const char* const opentype = (c->update_model ? "rb+" : "wb+");
 
-	FILE* const f_out = fopen(c->output, opentype);
-	if (f_out == NULL)
+	// Training several models at once writes one file per model, cf.
+	// salad_train_stub. Consequently, there is no single output file.
+	const int multi = (c->mode == TRAINING && c->num_ngram_lengths > 1);
+
+	FILE* const f_out = (shard_out != NULL ? shard_out : (multi ? NULL : fopen(c->output, opentype)));
+	if (f_out == NULL && !multi)
 	{
 		error("Unable to open/ create output file.");
 		if (f_in.fd != NULL)
@@ -107,11 +183,161 @@ const int salad_heart(const config_t* const c, FN_SALAD fct)
 	const int result = fct(c, dp, &f_in, f_out);
 
 	dp->close(&f_in);
-	fclose(f_out);
+	if (f_out != NULL && f_out != shard_out)
+	{
+		fclose(f_out);
+	}
 
 	return result;
 }
 
+#ifdef USE_NETWORK
+// Copies the next len bytes of one worker's output.
+static const int salad_shard_copy(FILE* const from, const size_t len, FILE* const to)
+{
+	char buf[0x1000];
+	for (size_t i = 0; i < len; )
+	{
+		const size_t m = fread(buf, 1, MIN(sizeof(buf), len -i), from);
+		if (m == 0 || fwrite(buf, 1, m, to) != m) return EXIT_FAILURE;
+		i += m;
+	}
+	return EXIT_SUCCESS;
+}
+
+// Hashes the connections of a network dump into c->net_workers shards that
+// are reassembled and processed by separate processes, cf. net_shard.
+// libnids maintains its state globally, hence processes rather than threads.
+static const int salad_heart_sharded(const config_t* const c, FN_SALAD fct)
+{
+	const size_t num = c->net_workers;
+
+	FILE** const outs = (FILE**) calloc(num, sizeof(FILE*));
+	FILE** const marks = (FILE**) calloc(num, sizeof(FILE*));
+	pid_t* const pids = (pid_t*) calloc(num, sizeof(pid_t));
+	size_t* const next = (size_t*) calloc(num *2, sizeof(size_t));
+	size_t* const pos = (size_t*) calloc(num, sizeof(size_t));
+
+	int ret = (outs == NULL || marks == NULL || pids == NULL || next == NULL || pos == NULL ? EXIT_FAILURE : EXIT_SUCCESS);
+	for (size_t k = 0; k < num && ret == EXIT_SUCCESS; k++)
+	{
+		outs[k] = tmpfile();
+		marks[k] = tmpfile();
+		if (outs[k] == NULL || marks[k] == NULL) ret = EXIT_FAILURE;
+	}
+
+	FILE* const f_out = (ret == EXIT_SUCCESS ? fopen(c->output, "wb+") : NULL);
+	if (f_out == NULL)
+	{
+		error("Unable to open/ create output file.");
+		ret = EXIT_FAILURE;
+	}
+
+	fflush(stdout);
+	fflush(stderr);
+
+	size_t num_started = 0;
+	for (; num_started < num && ret == EXIT_SUCCESS; num_started++)
+	{
+		pids[num_started] = fork();
+		if (pids[num_started] < 0)
+		{
+			error("Unable to start worker %"ZU".", (SIZE_T) num_started);
+			ret = EXIT_FAILURE;
+			break;
+		}
+
+		if (pids[num_started] == 0)
+		{
+			config_t cc = *c;
+			cc.net_shard = num_started;
+
+			const int r = salad_heart_ex(&cc, fct, outs[num_started], marks[num_started]);
+			fflush(outs[num_started]);
+			fflush(marks[num_started]);
+			fflush(stdout);
+			fflush(stderr);
+			_exit(r);
+		}
+	}
+
+	for (size_t k = 0; k < num_started; k++)
+	{
+		int status;
+		if (waitpid(pids[k], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+		{
+			error("Worker %"ZU" failed.", (SIZE_T) k);
+			ret = EXIT_FAILURE;
+		}
+	}
+
+	// Merge the outputs in the order of the packets that caused them
+	size_t remaining = 0;
+	for (size_t k = 0; k < num && ret == EXIT_SUCCESS; k++)
+	{
+		rewind(outs[k]);
+		rewind(marks[k]);
+		if (fread(&next[2*k], sizeof(size_t), 2, marks[k]) == 2)
+		{
+			remaining++;
+		}
+		else
+		{
+			fclose(outs[k]);
+			outs[k] = NULL;
+		}
+	}
+
+	while (remaining > 0 && ret == EXIT_SUCCESS)
+	{
+		size_t k = num;
+		for (size_t j = 0; j < num; j++)
+		{
+			if (outs[j] != NULL && (k == num || next[2*j] < next[2*k])) k = j;
+		}
+
+		ret = salad_shard_copy(outs[k], next[2*k +1] -pos[k], f_out);
+		pos[k] = next[2*k +1];
+
+		if (fread(&next[2*k], sizeof(size_t), 2, marks[k]) != 2)
+		{
+			fclose(outs[k]);
+			outs[k] = NULL;
+			remaining--;
+		}
+	}
+
+	for (size_t k = 0; k < num; k++)
+	{
+		if (outs != NULL && outs[k] != NULL) fclose(outs[k]);
+		if (marks != NULL && marks[k] != NULL) fclose(marks[k]);
+	}
+	if (f_out != NULL)
+	{
+		fclose(f_out);
+	}
+
+	free(outs);
+	free(marks);
+	free(pids);
+	free(next);
+	free(pos);
+	return ret;
+}
+#endif
+
+const int salad_heart(const config_t* const c, FN_SALAD fct)
+{
+	assert(c != NULL);
+#ifdef USE_NETWORK
+	if (c->net_workers > 1 && c->input_type == IOMODE_NETWORK_DUMP)
+	{
+		return salad_heart_sharded(c, fct);
+	}
+#endif
+	return salad_heart_ex(c, fct, NULL, NULL);
+}
+
 
 void salad_header(const char* const msg, const metadata_t* const meta, const config_t* c)
 {
@@ -138,7 +364,19 @@ void salad_header(const char* const msg, const metadata_t* const meta, const con
 void echo_options(config_t* const config)
 {
 	info("Options:");
-	info(" # n-Gram length: %u", (unsigned int) config->ngram_length);
+	if (config->num_ngram_lengths > 1)
+	{
+		char buf[0x100] = "";
+		for (size_t i = 0, k = 0; i < config->num_ngram_lengths && k < sizeof(buf); i++)
+		{
+			k += (size_t) snprintf(buf +k, sizeof(buf) -k, (i == 0 ? "%u" : ",%u"), (unsigned int) config->ngram_lengths[i]);
+		}
+		info(" # n-Gram lengths: %s", buf);
+	}
+	else
+	{
+		info(" # n-Gram length: %u", (unsigned int) config->ngram_length);
+	}
 
 	if (config->binary_ngrams)
 	{
@@ -150,11 +388,41 @@ void echo_options(config_t* const config)
 		info(" # Delimiter: '%s'", config->delimiter);
 	}
 
+	if (config->intern_tokens)
+	{
+		info(" # Intern tokens");
+	}
+
 	info(" # Filter size: %u", config->filter_size);
-	info(" # Hash set: %s", hashset_to_string(config->hash_set));
+
+	if (IS_BLOOMFILTER(config->container))
+	{
+		info(" # Hash set: %s", hashset_to_string(config->hash_set));
+	}
+
+	if (config->num_ngram_lengths > 1 && config->direct_hashes)
+	{
+		info(" # Direct hash set for n <= %u", config->filter_size /CHAR_BIT);
+	}
+
+	if (config->container != CONTAINER_BLOOMFILTER)
+	{
+		info(" # Container: %s", container_to_string(config->container));
+	}
 }
 
 
+// The whole space of short byte n-grams fits into a bitmap no larger than
+// the default bloom filter. Indexing it directly is exact and cheaper.
+void config_pick_hashset(config_t* const c)
+{
+	if (c->direct_hashes && c->ngram_length *CHAR_BIT <= c->filter_size)
+	{
+		c->hash_set = HASHES_DIRECT;
+		c->filter_size = (unsigned int) (c->ngram_length *CHAR_BIT);
+	}
+}
+
 const int salad_from_config(salad_t* const s, const config_t* const c)
 {
 	assert(s != NULL && c != NULL);
@@ -162,10 +430,22 @@ const int salad_from_config(salad_t* const s, const config_t* const c)
 
 	// TODO: right now there only are bloom filters!
 	assert(c->filter_size <= USHRT_MAX);
-	salad_set_bloomfilter_ex(s, bloom_init((unsigned short) c->filter_size, c->hash_set));
+	switch (c->container)
+	{
+	case CONTAINER_COUNTINGBLOOMFILTER:
+		salad_set_countingbloomfilter_ex(s, bloom_init_counting((unsigned short) c->filter_size, c->hash_set));
+		break;
+	case CONTAINER_CUCKOOFILTER:
+		salad_set_cuckoofilter_ex(s, cuckoo_init((unsigned short) c->filter_size));
+		break;
+	default:
+		salad_set_bloomfilter_ex(s, bloom_init((unsigned short) c->filter_size, c->hash_set));
+		break;
+	}
 	salad_use_binary_ngrams(s, c->binary_ngrams);
 	salad_set_delimiter(s, c->delimiter);
 	salad_set_ngramlength(s, c->ngram_length);
+	salad_intern_tokens(s, c->intern_tokens);
 
 	return EXIT_SUCCESS;
 }
@@ -195,3 +475,121 @@ const int salad_from_file_v(const char* const id, const char* const filename, sa
 
 	return ret;
 }
+
+
+// Picks the classifier of the k-th model
+static void models_prepare(models_t* const m, const size_t k)
+{
+	salad_t* const s = &m->models[k];
+
+	const model_type_t t = to_model_type(s->as_binary, _(s)->use_tokens, _(s)->tokens != NULL);
+	m->fcts[k] = pick_classifier(t, TRUE);
+
+	const model_param_t p = {TO_CONTAINER(s->model), NULL, s->ngram_length, _(s)->delimiter.d, _(s)->tokens, NULL};
+	memcpy(&m->params[k], &p, sizeof(model_param_t));
+}
+
+const int models_from_files(const char* const names, const char* const shared, models_t* const out, const int echo)
+{
+	assert(names != NULL && out != NULL);
+	memset(out, 0x00, sizeof(models_t));
+
+	char* x = NULL;
+	STRDUP(names, x);
+	if (x == NULL) return EXIT_FAILURE;
+
+	size_t num = 1;
+	for (const char* y = x; *y != 0x00; y++)
+	{
+		if (*y == ',') num++;
+	}
+
+	out->models = (salad_t*) calloc(num, sizeof(salad_t));
+	out->fcts = (FN_CLASSIFIER*) calloc(num, sizeof(FN_CLASSIFIER));
+	out->params = (model_param_t*) calloc(num, sizeof(model_param_t));
+	out->shared = (shared_t*) calloc(num, sizeof(shared_t));
+
+	int ret = (out->models != NULL && out->fcts != NULL && out->params != NULL && out->shared != NULL ? EXIT_SUCCESS : EXIT_FAILURE);
+
+	// Each model brings along its own specification, i.e., the models may
+	// differ in the n-gram length as well as in the type of n-grams.
+	for (char* name = strtok(x, ","); ret == EXIT_SUCCESS && name != NULL; name = strtok(NULL, ","))
+	{
+		char segment[0x100];
+		snprintf(segment, sizeof(segment), "%s.%"ZU, (shared != NULL ? shared : ""), (SIZE_T) (out->num +1));
+
+		salad_t* const s = &out->models[out->num];
+		if (salad_from_shared("training", name, (shared != NULL ? segment : NULL), s, &out->shared[out->num]) != EXIT_SUCCESS)
+		{
+			ret = EXIT_FAILURE;
+			break;
+		}
+		out->num++;
+
+		if (TO_CONTAINER(s->model)->type == CONTAINER_TWOCLASSBLOOMFILTER)
+		{
+			error("Two-class models cannot be combined with other ones (%s).", name);
+			ret = EXIT_FAILURE;
+			break;
+		}
+
+		models_prepare(out, out->num -1);
+
+		if (echo)
+		{
+			info("Model %"ZU": %s (n = %"ZU")", (SIZE_T) out->num, name, (SIZE_T) s->ngram_length);
+		}
+	}
+
+	free(x);
+	if (ret != EXIT_SUCCESS)
+	{
+		models_destroy(out);
+	}
+	return ret;
+}
+
+const int models_from_salad(salad_t* const s, models_t* const out)
+{
+	assert(s != NULL && out != NULL);
+	memset(out, 0x00, sizeof(models_t));
+
+	container_t* const c = TO_CONTAINER(s->model);
+	if (c == NULL || c->type == CONTAINER_TWOCLASSBLOOMFILTER)
+	{
+		return EXIT_FAILURE;
+	}
+
+	out->models = (salad_t*) calloc(1, sizeof(salad_t));
+	out->fcts = (FN_CLASSIFIER*) calloc(1, sizeof(FN_CLASSIFIER));
+	out->params = (model_param_t*) calloc(1, sizeof(model_param_t));
+
+	if (out->models == NULL || out->fcts == NULL || out->params == NULL)
+	{
+		models_destroy(out);
+		return EXIT_FAILURE;
+	}
+
+	memcpy(&out->models[0], s, sizeof(salad_t));
+	memcpy(s, &EMPTY_SALAD_OBJECT, sizeof(salad_t));
+
+	out->num = 1;
+	models_prepare(out, 0);
+	return EXIT_SUCCESS;
+}
+
+void models_destroy(models_t* const m)
+{
+	if (m == NULL) return;
+
+	for (size_t k = 0; k < m->num; k++)
+	{
+		if (m->shared != NULL) salad_unshare(&m->shared[k]);
+		salad_destroy(&m->models[k]);
+	}
+	free(m->models);
+	free(m->fcts);
+	free(m->params);
+	free(m->shared);
+	memset(m, 0x00, sizeof(models_t));
+}
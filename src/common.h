@@ -25,14 +25,18 @@
 #include <util/config.h>
 
 #include <salad/salad.h>
+#include <salad/classify.h>
 #include <salad/io.h>
 #include <salad/container/common.h>
+#include <salad/container/container.h>
 #include <util/config.h>
 #include <util/util.h>
 #include <util/io.h>
 
 #include <config.h>
 
+#include "shared.h"
+
 #ifndef USE_ARCHIVES
 // Just to make sure ;)
 #undef GROUPED_INPUT
@@ -44,6 +48,8 @@ typedef enum {
 	PREDICT,
 	INSPECT,
 	STATS,
+	FREEZE,
+	SERVE,
 	TEST
 } saladmode_t;
 
@@ -59,20 +65,32 @@ typedef enum {
 	SALAD_HELP_PREDICT,
 	SALAD_HELP_INSPECT,
 	SALAD_HELP_STATS,
+	SALAD_HELP_FREEZE,
+	SALAD_HELP_SERVE,
 	SALAD_HELP_TEST,
 	SALAD_VERSION
 } saladstate_t;
 
+#define MAX_NGRAM_LENGTHS 16
+
 typedef struct
 {
 	saladmode_t mode;
 	iomode_t input_type;
 	size_t batch_size;
+	size_t chunk_size; // Process strings in chunks of that many bytes (optional)
 	int group_input;
 	char* input_filter;
 	char* pcap_filter;
 	int net_clientcomm;
 	int net_servercomm;
+	int net_stream;         // Score streams while their data arrives
+	size_t net_checkpoint;  // ...and every that many bytes per stream
+	double net_checkpoint_time; // ...or seconds
+	char* net_udp_ports;    // Also process UDP datagrams of these ports
+	double net_batch_latency; // Seconds a batch of network data may wait
+	size_t net_workers;     // Process network dumps in that many processes
+	size_t net_shard;       // ...the one of the current process, cf. salad_heart
 	char* input;
 	char* bloom;
 	char* bbloom;
@@ -81,12 +99,25 @@ typedef struct
 	char* output;
 	salad_outputfmt_t output_type;
 	size_t ngram_length;
+	// Training several models at once, one per n-gram length (cf. -n 2,3,5)
+	size_t ngram_lengths[MAX_NGRAM_LENGTHS];
+	size_t num_ngram_lengths;
 	char* delimiter;
+	int intern_tokens;
 	int binary_ngrams;
 	int count;
 	unsigned int filter_size;
 	hashset_t hash_set;
+	int direct_hashes; // Neither the hash set nor the filter size were set, cf. config_pick_hashset
+	container_type_t container;
+	size_t decay;
+	int forget;
 	char* nan;
+	size_t window; // Score windows of n-grams rather than whole strings
+	char* shared_model; // Name of the shared memory segment of the model
+	char* socket;  // The Unix domain socket to serve requests on
+	size_t serve_workers;
+	int serve_watch; // Reload models once their files change
 	int echo_params;
 } config_t;
 
@@ -95,11 +126,19 @@ static const config_t DEFAULT_CONFIG =
 	.mode = UNDEFINED,
 	.input_type = IOMODE_LINES,
 	.batch_size = 128,
+	.chunk_size = 0,
 	.group_input = FALSE,
 	.input_filter = "",
 	.pcap_filter = "tcp",
 	.net_clientcomm = TRUE,
 	.net_servercomm = TRUE,
+	.net_stream = FALSE,
+	.net_checkpoint = 0,
+	.net_checkpoint_time = 0.0,
+	.net_udp_ports = NULL,
+	.net_batch_latency = 1.0,
+	.net_workers = 1,
+	.net_shard = 0,
 	.input = NULL,
 	.bloom = NULL,
 	.bbloom = NULL,
@@ -108,12 +147,24 @@ static const config_t DEFAULT_CONFIG =
 	.output = NULL,
 	.output_type = DEFAULT_OUTPUTFMT,
 	.ngram_length = 3,
+	.ngram_lengths = {0},
+	.num_ngram_lengths = 0,
 	.delimiter = NULL,
+	.intern_tokens = FALSE,
 	.binary_ngrams = FALSE,
 	.count = 0,
 	.filter_size = 24,
 	.hash_set = DEFAULT_HASHSET,
+	.direct_hashes = FALSE,
+	.container = CONTAINER_BLOOMFILTER,
+	.decay = 0,
+	.forget = FALSE,
 	.nan = "nan",
+	.window = 0,
+	.shared_model = NULL,
+	.socket = NULL,
+	.serve_workers = 4,
+	.serve_watch = FALSE,
 	.echo_params = FALSE
 };
 
@@ -125,7 +176,25 @@ void salad_header(const char* const msg, const metadata_t* const meta, const con
 void echo_options(config_t* const config);
 
 const int salad_from_config(salad_t* const s, const config_t* const c);
+// Picks the direct hash set for byte n-grams of the configured length if possible
+void config_pick_hashset(config_t* const c);
 const int salad_from_file_v(const char* const id, const char* const filename, salad_t* const out);
 
+// Several one-class models that are applied side by side, cf. -b a,b,c
+typedef struct
+{
+	salad_t* models;
+	FN_CLASSIFIER* fcts;
+	model_param_t* params;
+	shared_t* shared; // cf. --shared-model
+	size_t num;
+} models_t;
+
+// Shares the models via the segments <shared>.1, <shared>.2, etc. if given
+const int models_from_files(const char* const names, const char* const shared, models_t* const out, const int echo);
+// Takes over a loaded one-class model, which is left empty
+const int models_from_salad(salad_t* const s, models_t* const out);
+void models_destroy(models_t* const m);
+
 
 #endif /* COMMON_H_ */
@@ -20,6 +20,7 @@
 #include <salad/salad.h>
 #include <salad/util.h>
 #include <salad/io.h>
+#include <util/cpu.h>
 #include <util/vec.h>
 #include <util/io.h>
 #include <util/log.h>
@@ -54,6 +55,12 @@ static struct option main_longopts[] = {
 #define OPTION_BINARY      1003
 #define OPTION_NETCLIENT   1004
 #define OPTION_NETSERVER   1005
+#define OPTION_CONTAINER   1006
+#define OPTION_DECAY       1007
+#define OPTION_FORGET      1008
+#define OPTION_INTERN      1009
+#define OPTION_CHUNKSIZE   1014
+#define OPTION_UDPPORTS    1016
 
 static struct option train_longopts[] = {
 	// I/O options
@@ -63,8 +70,12 @@ static struct option train_longopts[] = {
 	{ "pcap-filter",    required_argument, NULL, 'p' },
 	{ "client-only",    no_argument,       NULL, OPTION_NETCLIENT},
 	{ "server-only",    no_argument,       NULL, OPTION_NETSERVER},
+	{ "udp-ports",      required_argument, NULL, OPTION_UDPPORTS },
 	{ "batch-size",     required_argument, NULL, OPTION_BATCHSIZE },
+	{ "chunk-size",     required_argument, NULL, OPTION_CHUNKSIZE },
 	{ "update-model",   no_argument,       NULL, 'u' },
+	{ "decay",          required_argument, NULL, OPTION_DECAY },
+	{ "forget",         no_argument,       NULL, OPTION_FORGET },
 	{ "output",         required_argument, NULL, 'o' },
 #ifdef USE_ARCHIVES
 	{ "output-format",  required_argument, NULL, 'F' },
@@ -73,9 +84,11 @@ static struct option train_longopts[] = {
 	// Feature options
 	{ "ngram-length",   required_argument, NULL, 'n' },
 	{ "ngram-delim",    required_argument, NULL, 'd' },
+	{ "intern-tokens",  no_argument,       NULL, OPTION_INTERN },
 	{ "binary",         no_argument,       NULL, OPTION_BINARY },
 	{ "filter-size",    required_argument, NULL, 's' },
 	{ "hash-set",       required_argument, NULL, OPTION_HASHSET},
+	{ "container",      required_argument, NULL, OPTION_CONTAINER},
 
 	// Generic options
 	{ "echo-params",    no_argument, NULL, 'e' },
@@ -87,6 +100,14 @@ static struct option train_longopts[] = {
 
 #define PREDICT_OPTION_STR "i:f:gp:o:b:r:eqh"
 #define OPTION_BBLOOM    1003
+#define OPTION_WINDOW    1010
+#define OPTION_NETSTREAM 1011
+#define OPTION_CHECKPOINT 1012
+#define OPTION_CHECKPOINTTIME 1013
+#define OPTION_WORKERS   1015
+#define OPTION_BATCHLATENCY 1017
+#define OPTION_WATCH     1018
+#define OPTION_SHAREDMODEL 1019
 
 static struct option predict_longopts[] = {
 	// I/O options
@@ -96,13 +117,23 @@ static struct option predict_longopts[] = {
 	{ "pcap-filter",    required_argument, NULL, 'p' },
 	{ "client-only",    no_argument,       NULL, OPTION_NETCLIENT},
 	{ "server-only",    no_argument,       NULL, OPTION_NETSERVER},
+	{ "udp-ports",      required_argument, NULL, OPTION_UDPPORTS },
+	{ "stream",         no_argument,       NULL, OPTION_NETSTREAM },
+	{ "checkpoint",     required_argument, NULL, OPTION_CHECKPOINT },
+	{ "checkpoint-time", required_argument, NULL, OPTION_CHECKPOINTTIME },
+	{ "workers",        required_argument, NULL, OPTION_WORKERS },
+	{ "watch",          no_argument,       NULL, OPTION_WATCH },
 	{ "batch-size",     required_argument, NULL, OPTION_BATCHSIZE },
+	{ "batch-latency",  required_argument, NULL, OPTION_BATCHLATENCY },
+	{ "chunk-size",     required_argument, NULL, OPTION_CHUNKSIZE },
 	{ "group-input",    no_argument, NULL, 'g' },
 	{ "output",         required_argument, NULL, 'o' },
 
 	{ "bloom",          required_argument, NULL, 'b' },
 	{ "bad-bloom",      required_argument, NULL, OPTION_BBLOOM },
 	{ "nan-str",        required_argument, NULL, 'r' },
+	{ "window",         required_argument, NULL, OPTION_WINDOW },
+	{ "shared-model",   required_argument, NULL, OPTION_SHAREDMODEL },
 
 	// Generic options
 	{ "echo-params",    no_argument, NULL, 'e' },
@@ -112,6 +143,28 @@ static struct option predict_longopts[] = {
 };
 
 
+#define FREEZE_OPTION_STR "i:f:p:b:o:F:qh"
+
+static struct option freeze_longopts[] = {
+	// I/O options
+	{ "input",          required_argument, NULL, 'i' },
+	{ "input-format",   required_argument, NULL, 'f' },
+	{ "input-filter",   required_argument, NULL, OPTION_INPUTFILTER },
+	{ "pcap-filter",    required_argument, NULL, 'p' },
+	{ "client-only",    no_argument,       NULL, OPTION_NETCLIENT},
+	{ "server-only",    no_argument,       NULL, OPTION_NETSERVER},
+	{ "batch-size",     required_argument, NULL, OPTION_BATCHSIZE },
+	{ "bloom",          required_argument, NULL, 'b' },
+	{ "output",         required_argument, NULL, 'o' },
+	{ "output-format",  required_argument, NULL, 'F' },
+
+	// Generic options
+	{ "quiet",          no_argument, NULL, 'q' },
+	{ "help",           no_argument, NULL, 'h' },
+	{ NULL,             0, NULL, 0 }
+};
+
+
 #define INSPECT_OPTION_STR "i:f:p:b:o:n:d:s:eqh"
 
 static struct option inspect_longopts[] = {
@@ -132,6 +185,7 @@ static struct option inspect_longopts[] = {
 	{ "binary",         no_argument,       NULL, OPTION_BINARY },
 	{ "filter-size",    required_argument, NULL, 's' },
 	{ "hash-set",       required_argument, NULL, OPTION_HASHSET},
+	{ "container",      required_argument, NULL, OPTION_CONTAINER},
 
 	// Generic options
 	{ "echo-params",    no_argument, NULL, 'e' },
@@ -153,6 +207,23 @@ static struct option stats_longopts[] = {
 };
 
 
+#define SERVE_OPTION_STR "b:s:eqh"
+
+static struct option serve_longopts[] = {
+	// I/O options
+	{ "bloom",          required_argument, NULL, 'b' },
+	{ "socket",         required_argument, NULL, 's' },
+	{ "workers",        required_argument, NULL, OPTION_WORKERS },
+	{ "watch",          no_argument,       NULL, OPTION_WATCH },
+
+	// Generic options
+	{ "echo-params",    no_argument, NULL, 'e' },
+	{ "quiet",          no_argument, NULL, 'q' },
+	{ "help",           no_argument, NULL, 'h' },
+	{ NULL,             0, NULL, 0 }
+};
+
+
 #ifdef TEST_SALAD
 #define TEST_OPTION_STR "s:mh"
 
@@ -173,9 +244,10 @@ const int usage_main()
 	print("Usage: salad [<mode>] [options]\n"
 	"\n"
 #ifdef TEST_SALAD
-	"<mode> may be one of 'train', 'predict', 'inspect', 'stats' or 'test'\n"
+	"<mode> may be one of 'train', 'predict', 'freeze', 'inspect', 'stats', 'serve'\n"
+	"or 'test'\n"
 #else
-	"<mode> may be one of 'train', 'predict', 'inspect' or 'stats'\n"
+	"<mode> may be one of 'train', 'predict', 'freeze', 'inspect', 'stats' or 'serve'\n"
 #endif
 	"\n"
 	"Generic options:\n"
@@ -199,6 +271,8 @@ const int usage_train()
 #endif
 	"       --batch-size <num>     Set the size of batches that are read and \n"
 	"                              processed in one go (Default: %"ZU").\n"
+	"       --chunk-size <num>     Process strings in chunks of at most <num> bytes\n"
+	"                              without losing the n-grams spanning chunks.\n"
 #ifdef USE_NETWORK
 	"  -p,  --pcap-filter <str>    Filter expression for the PCAP library in case\n"
 	"                              network data is processed (Default: %s).\n"
@@ -206,11 +280,19 @@ const int usage_train()
 	"                              communication.\n"
 	"       --server-only          Only consider the server-side of the network\n"
 	"                              communication.\n"
+	"       --udp-ports <list>     Also process UDP datagrams sent to or from the\n"
+	"                              given ports, e.g., 53,5000-5010 or all.\n"
 #endif
 	"  -u,  --update-model         In case the specified output file exists and\n"
 	"                              contains a valid model this flag indicates\n"
 	"                              that that model should be update rather than\n"
 	"                              recreated from scratch.\n"
+	"       --decay <num>          Halve the counts of the model to be updated\n"
+	"                              <num> times before training, such that rare\n"
+	"                              n-grams expire (counting bloom filters only).\n"
+	"       --forget               Remove the n-grams of the input from the model\n"
+	"                              to be updated rather than adding them\n"
+	"                              (counting bloom filters only).\n"
 	"  -o,  --output <file>        The output filename.\n"
 #ifdef USE_ARCHIVES
 	// If there is no libarchive support we can only make use of text-based configurations.
@@ -219,16 +301,26 @@ const int usage_train()
 #endif
 	"\n"
 	"Feature options:\n"
-	"  -n,  --ngram-len <num>      Set length of n-grams (Default: %"ZU").\n"
+	"  -n,  --ngram-len <num>      Set length of n-grams (Default: %"ZU"). A list\n"
+	"                              such as 2,3,5 or 2-4 trains one model per\n"
+	"                              length, written to <file>.<n>, each as if\n"
+	"                              trained on its own.\n"
 	"  -d,  --ngram-delim <delim>  Set delimiters for the use of word/ token n-grams.\n"
 	"                              If omitted or empty byte n-grams are used.\n"
+	"       --intern-tokens        Map the tokens to integer ids stored along with\n"
+	"                              the model and build the n-grams of these ids.\n"
 	"       --binary               Indicates to use bit n-grams rather than byte\n"
 	"                              or token n-grams and consequently, disables the\n"
 	"                              --ngram-delim option.\n"
 	"  -s,  --filter-size <num>    Set the size of the bloom filter as bits of\n"
 	"                              the index (Default: %u).\n"
-	"       --hash-set <hashes>    Set the hash set to be used: 'simple', 'simple2'\n"
-	"                              or 'murmur' (Default: '%s').\n"
+	"       --hash-set <hashes>    Set the hash set to be used: 'simple', 'simple2',\n"
+	"                              'murmur', 'mix', 'direct' or 'crc'\n"
+	"                              (Default: '%s').\n"
+	"                              Byte n-grams with n <= 3 use 'direct' unless\n"
+	"                              either the hash set or the filter size is set.\n"
+	"       --container <type>     Set the type of the model: " VALID_CONTAINERS "\n"
+	"                              (Default: '%s').\n"
 	"\n"
 	"Generic options:\n"
 	"  -e,  --echo-params          Echo used parameters and settings.\n"
@@ -240,7 +332,8 @@ const int usage_train()
 #endif
 	/* --ngram-len   */ (SIZE_T) DEFAULT_CONFIG.ngram_length,
 	/* --filter-size */ DEFAULT_CONFIG.filter_size,
-	/* --hash-set    */ hashset_to_string(DEFAULT_CONFIG.hash_set));
+	/* --hash-set    */ hashset_to_string(DEFAULT_CONFIG.hash_set),
+	/* --container   */ container_to_string(DEFAULT_CONFIG.container));
 	return EXIT_SUCCESS;
 }
 
@@ -259,6 +352,8 @@ const int usage_predict()
 #endif
 	"       --batch-size <num>     Set the size of batches that are read and \n"
 	"                              processed in one go (Default: %"ZU").\n"
+	"       --chunk-size <num>     Process strings in chunks of at most <num> bytes\n"
+	"                              without losing the n-grams spanning chunks.\n"
 #ifdef USE_NETWORK
 	"  -p,  --pcap-filter <str>    Filter expression for the PCAP library in case\n"
 	"                              network data is processed (Default: %s).\n"
@@ -266,23 +361,89 @@ const int usage_predict()
 	"                              communication.\n"
 	"       --server-only          Only consider the server-side of the network\n"
 	"                              communication.\n"
+	"       --udp-ports <list>     Also process UDP datagrams sent to or from the\n"
+	"                              given ports, e.g., 53,5000-5010 or all.\n"
+	"       --batch-latency <s>    The maximal time complete streams are held\n"
+	"                              back to fill a batch (Default: %g).\n"
+	"       --stream               Score TCP streams while their data arrives\n"
+	"                              rather than when they are closed (byte\n"
+	"                              n-grams only). Output: <score> <stream>.\n"
+	"       --checkpoint <num>     Additionally report the score of a stream\n"
+	"                              every <num> bytes (implies --stream).\n"
+	"       --checkpoint-time <s>  Additionally report the score of a stream\n"
+	"                              every <s> seconds (implies --stream).\n"
+	"       --workers <num>        Process network dumps in <num> processes,\n"
+	"                              each handling a share of the connections,\n"
+	"                              or score live traffic on <num> threads\n"
+	"                              (each score followed by the stream number).\n"
+	"       --watch                Reload the models once their files change.\n"
+	"                              SIGHUP always triggers a reload.\n"
 #endif
 #ifdef GROUPED_INPUT
 	"  -g,  --group-input        Indicates that predictions for inputs in the \n"
 	"                              same \"group\" should be grouped as well. \n"
 #endif
-	"  -b,  --bloom <file>         The bloom filter to be used.\n"
+	"  -b,  --bloom <file>         The bloom filter to be used. Several comma-\n"
+	"                              separated models yield one score column each.\n"
 	"       --bad-bloom <file>     The bloom filter for the 2nd class (optional).\n"
 	"  -o,  --output <file>        The output filename.\n"
 	"\n"
 	"Feature options:\n"
 	"  -r,  --nan-str <str>        Set the string to be shown for NaN values.\n"
+	"       --window <num>         Score the window of <num> n-grams with the\n"
+	"                              most unknown n-grams rather than the whole\n"
+	"                              string and append its byte offset and length\n"
+	"                              (byte n-grams only).\n"
+	"       --shared-model <name>  Share the bit array of the bloom filter among\n"
+	"                              processes via the shared memory segment <name>.\n"
 	"\n"
 	"Generic options:\n"
 	"  -e,  --echo-params          Echo used parameters and settings.\n"
 	"  -q,  --quiet                Suppress all output but warning and errors.\n"
 	"  -h,  --help                 Print this help screen.\n",
 	/* --batch-size  */  (SIZE_T) DEFAULT_CONFIG.batch_size
+#ifdef USE_NETWORK
+	/* --pcap-filter */ ,DEFAULT_CONFIG.pcap_filter
+	/* --batch-latency */ ,DEFAULT_CONFIG.net_batch_latency
+#endif
+	);
+	return EXIT_SUCCESS;
+}
+
+
+const int usage_freeze()
+{
+	print("Usage: salad freeze [options]\n"
+	"\n"
+	"I/O options:\n"
+	"  -i,  --input <file>         The input filename, i.e., the training data.\n"
+	"  -f,  --input-format <fmt>   Sets the format of input. This option might be \n"
+	"                              one of " IOMODES ".\n"
+#ifdef USE_REGEX_FILTER
+	"       --input-filter <regex> The regular expression for filtering input lines\n"
+	"                              or filenames respectively.\n"
+#endif
+	"       --batch-size <num>     Set the size of batches that are read and \n"
+	"                              processed in one go (Default: %"ZU").\n"
+#ifdef USE_NETWORK
+	"  -p,  --pcap-filter <str>    Filter expression for the PCAP library in case\n"
+	"                              network data is processed (Default: %s).\n"
+	"       --client-only          Only consider the client-side of the network\n"
+	"                              communication.\n"
+	"       --server-only          Only consider the server-side of the network\n"
+	"                              communication.\n"
+#endif
+	"  -b,  --bloom <file>         The trained model to be frozen.\n"
+	"  -o,  --output <file>        The output filename.\n"
+#ifdef USE_ARCHIVES
+	"  -F,  --output-format <fmt>  Sets the format of the output. This option\n"
+	"                              might be one of 'txt' or 'archive'.\n"
+#endif
+	"\n"
+	"Generic options:\n"
+	"  -q,  --quiet                Suppress all output but warning and errors.\n"
+	"  -h,  --help                 Print this help screen.\n",
+	/* --batch-size  */  (SIZE_T) DEFAULT_CONFIG.batch_size
 #ifdef USE_NETWORK
 	/* --pcap-filter */ ,DEFAULT_CONFIG.pcap_filter
 #endif
@@ -325,8 +486,13 @@ const int usage_inspect()
 	"                              --ngram-delim option.\n"
 	"  -s,  --filter-size <num>    Set the size of the bloom filter as bits of\n"
 	"                              the index (Default: %u).\n"
-	"       --hash-set <hashes>    Set the hash set to be used: 'simple', 'simple2'\n"
-	"                              or 'murmur' (Default: '%s').\n"
+	"       --hash-set <hashes>    Set the hash set to be used: 'simple', 'simple2',\n"
+	"                              'murmur', 'mix', 'direct' or 'crc'\n"
+	"                              (Default: '%s').\n"
+	"                              Byte n-grams with n <= 3 use 'direct' unless\n"
+	"                              either the hash set or the filter size is set.\n"
+	"       --container <type>     Set the type of the model: " VALID_CONTAINERS "\n"
+	"                              (Default: '%s').\n"
 	"\n"
 	"Generic options:\n"
 	"  -e,  --echo-params          Echo used parameters and settings.\n"
@@ -337,7 +503,8 @@ const int usage_inspect()
 #endif
 	/* --ngram-len   */ (SIZE_T) DEFAULT_CONFIG.ngram_length,
 	/* --filter-size */ DEFAULT_CONFIG.filter_size,
-	/* --hash-set    */ hashset_to_string(DEFAULT_CONFIG.hash_set));
+	/* --hash-set    */ hashset_to_string(DEFAULT_CONFIG.hash_set),
+	/* --container   */ container_to_string(DEFAULT_CONFIG.container));
 	return EXIT_SUCCESS;
 }
 
@@ -355,6 +522,28 @@ const int usage_stats()
 }
 
 
+const int usage_serve()
+{
+	print("Usage: salad serve [options]\n"
+	"\n"
+	"I/O options:\n"
+	"  -b,  --bloom <file>         The bloom filter to be used. A comma-separated\n"
+	"                              list of models yields one score per model.\n"
+	"  -s,  --socket <file>        The Unix domain socket to listen on.\n"
+	"       --workers <num>        Answer requests with <num> threads\n"
+	"                              (Default: %"ZU").\n"
+	"       --watch                Reload the models once their files change.\n"
+	"                              SIGHUP always triggers a reload.\n"
+	"\n"
+	"Generic options:\n"
+	"  -e,  --echo-params          Echo used parameters and settings.\n"
+	"  -q,  --quiet                Suppress all output but warning and errors.\n"
+	"  -h,  --help                 Print this help screen.\n",
+	/* --workers */ (SIZE_T) DEFAULT_CONFIG.serve_workers);
+	return EXIT_SUCCESS;
+}
+
+
 #ifdef TEST_SALAD
 const int usage_test()
 {
@@ -377,6 +566,9 @@ const int version()
 	    "Copyright (c) 2012-2015 Christian Wressnegger (christian@mlsec.org)\n",
 	    VERSION_STR);
 
+	char buf[0x100];
+	print("CPU features: %s\n", cpu_features_str(buf, sizeof(buf)));
+
 	return EXIT_SUCCESS;
 }
 
@@ -392,6 +584,20 @@ const int check_netparams(config_t* const config, const int conly, const int son
 		config->net_clientcomm = conly;
 		config->net_servercomm = sonly;
 	}
+
+#ifdef USE_NETWORK
+	if (config->net_udp_ports != NULL && config->input_type != IOMODE_NETWORK && config->input_type != IOMODE_NETWORK_DUMP)
+	{
+		warn("UDP ports only apply to network data and are ignored.");
+		config->net_udp_ports = NULL;
+	}
+
+	// Datagrams need to pass the default PCAP filter as well
+	if (config->net_udp_ports != NULL && config->pcap_filter == DEFAULT_CONFIG.pcap_filter)
+	{
+		config->pcap_filter = "tcp or udp";
+	}
+#endif
 	return EXIT_SUCCESS;
 }
 
@@ -419,11 +625,12 @@ const int check_input(config_t* const config, const int filesOnly, const int che
 #endif
 		if (config->input_type == IOMODE_NETWORK || config->input_type == IOMODE_NETWORK_DUMP)
 		{
-			if (check_batchsize && config->batch_size != 1)
+			// Streams are processed one by one as soon as they are complete,
+			// unless batches are requested explicitly.
+			if (!check_batchsize)
 			{
-				warn("For processing network data we default the batch size to 1");
+				config->batch_size = 1;
 			}
-			config->batch_size = 1;
 
 			const int empty = (config->pcap_filter == NULL || config->pcap_filter[0] == '\0');
 			const char* const filter = (empty ? "unfiltered" : config->pcap_filter);
@@ -498,6 +705,44 @@ const salad_outputfmt_t as_outputmode(const char* const x)
 	return y;
 }
 
+// Parses a single n-gram length, a comma separated list of lengths, or
+// ranges thereof such as "2-4,8".
+static const int as_ngramlengths(const char* const str, config_t* const config)
+{
+	size_t lengths[MAX_NGRAM_LENGTHS], num = 0;
+	const char* x = str;
+
+	do
+	{
+		char* end;
+		const long long int from = strtoll(x, &end, 10);
+		long long int to = from;
+
+		if (*end == '-')
+		{
+			to = strtoll(end +1, &end, 10);
+		}
+		if (end == x || (*end != ',' && *end != 0x00) || from <= 0 || to < from)
+		{
+			return EXIT_FAILURE;
+		}
+
+		for (long long int n = from; n <= to; n++)
+		{
+			if (num >= MAX_NGRAM_LENGTHS) return EXIT_FAILURE;
+			lengths[num++] = (size_t) MIN(SIZE_MAX, (unsigned long) n);
+		}
+		x = (*end == ',' ? end +1 : end);
+	}
+	while (*x != 0x00);
+
+	config->ngram_length = lengths[0];
+	config->num_ngram_lengths = (num > 1 ? num : 0);
+	memcpy(config->ngram_lengths, lengths, num *sizeof(size_t));
+
+	return EXIT_SUCCESS;
+}
+
 const saladstate_t parse_traininglike_options_ex(int argc, char* argv[], config_t* const config,
 		const char *shortopts, const struct option *longopts)
 {
@@ -507,7 +752,7 @@ const saladstate_t parse_traininglike_options_ex(int argc, char* argv[], config_
 	char* end; // For parsing numbers with strto*
 	int conly = FALSE, sonly = FALSE;
 
-	int option, bs = FALSE, fo = FALSE;
+	int option, bs = FALSE, fo = FALSE, hs = FALSE;
 	while ((option = getopt_long(argc, argv, shortopts, longopts, NULL)) != -1)
 	{
 		switch (option)
@@ -542,6 +787,18 @@ const saladstate_t parse_traininglike_options_ex(int argc, char* argv[], config_
 			break;
 		}
 
+		case OPTION_CHUNKSIZE:
+		{
+			char* end; // For parsing numbers with strto*
+			const long long int chunk_size = strtoll(optarg, &end, 10);
+			if (chunk_size <= 0)
+			{
+				warn("Illegal chunk size specified.");
+			}
+			else config->chunk_size = (size_t) MIN(SIZE_MAX, (unsigned long) chunk_size);
+			break;
+		}
+
 #ifdef USE_NETWORK
 		case 'p':
 			config->pcap_filter = optarg;
@@ -554,6 +811,10 @@ const saladstate_t parse_traininglike_options_ex(int argc, char* argv[], config_
 		case OPTION_NETSERVER:
 			sonly = TRUE;
 			break;
+
+		case OPTION_UDPPORTS:
+			config->net_udp_ports = optarg;
+			break;
 #endif
 		case 'b':
 			config->bloom = optarg;
@@ -572,29 +833,31 @@ const saladstate_t parse_traininglike_options_ex(int argc, char* argv[], config_
 			break;
 
 		case 'n':
-		{
 			fo = TRUE;
-			const long long int ngram_length = strtoll(optarg, &end, 10);
-			if (ngram_length <= 0)
+			if (as_ngramlengths(optarg, config) != EXIT_SUCCESS)
 			{
 				warn("Illegal n-gram length specified.");
 				warn("Defaulting to: %"ZU"\n", (SIZE_T) config->ngram_length);
 			}
-			else config->ngram_length = (size_t) MIN(SIZE_MAX, (unsigned long) ngram_length);
 			break;
-		}
+
 		case 'd':
 			fo = TRUE;
 			config->delimiter = optarg;
 			break;
 
+		case OPTION_INTERN:
+			fo = TRUE;
+			config->intern_tokens = TRUE;
+			break;
+
 		case OPTION_BINARY:
 			config->binary_ngrams = TRUE;
 			break;
 
 		case 's':
 		{
-			fo = TRUE;
+			fo = hs = TRUE;
 			const long long int filter_size = strtoll(optarg, &end, 10);
 			if (filter_size <= 0)
 			{
@@ -606,7 +869,7 @@ const saladstate_t parse_traininglike_options_ex(int argc, char* argv[], config_
 		}
 		case OPTION_HASHSET:
 		{
-			fo = TRUE;
+			fo = hs = TRUE;
 			hashset_t hashset = to_hashset(optarg);
 			if (hashset == HASHES_UNDEFINED)
 			{
@@ -616,6 +879,43 @@ const saladstate_t parse_traininglike_options_ex(int argc, char* argv[], config_
 			else config->hash_set = hashset;
 			break;
 		}
+		case OPTION_CONTAINER:
+		{
+			fo = TRUE;
+			container_type_t container = to_containertype(optarg);
+			if (container == CONTAINER_UNKNOWN)
+			{
+				warn("Illegal container specified.");
+				warn("Defaulting to: %s\n", container_to_string(config->container));
+			}
+			else if (container == CONTAINER_XORFILTER)
+			{
+				warn("Static containers cannot be trained, use 'salad freeze' instead.");
+				warn("Defaulting to: %s\n", container_to_string(config->container));
+			}
+			else if (container == CONTAINER_TWOCLASSBLOOMFILTER)
+			{
+				warn("Two-class containers are built from the models of both classes at prediction time.");
+				warn("Defaulting to: %s\n", container_to_string(config->container));
+			}
+			else config->container = container;
+			break;
+		}
+		case OPTION_DECAY:
+		{
+			const long long int decay = strtoll(optarg, &end, 10);
+			if (end == optarg || *end != 0x00 || decay < 0)
+			{
+				warn("Illegal decay specified.");
+				warn("Defaulting to: %"ZU"\n", (SIZE_T) config->decay);
+			}
+			else config->decay = (size_t) MIN(SIZE_MAX, (unsigned long) decay);
+			break;
+		}
+		case OPTION_FORGET:
+			config->forget = TRUE;
+			break;
+
 		case 'e':
 			config->echo_params = TRUE;
 			break;
@@ -639,13 +939,58 @@ const saladstate_t parse_traininglike_options_ex(int argc, char* argv[], config_
 
 	config->transfer_spec = !fo;
 
-	if (config->binary_ngrams && config->ngram_length > MASK_BITSIZE)
+	if ((config->forget || config->decay > 0) && !config->update_model)
+	{
+		error("Forgetting and aging n-grams is only possible when updating");
+		error("an existing model (cf. --update-model).");
+		return SALAD_EXIT;
+	}
+
+	size_t max_ngram_length = config->ngram_length;
+	for (size_t i = 0; i < config->num_ngram_lengths; i++)
+	{
+		max_ngram_length = MAX(max_ngram_length, config->ngram_lengths[i]);
+	}
+
+	if (config->chunk_size > 0 && (config->forget || config->num_ngram_lengths > 0))
+	{
+		error("Processing strings in chunks can neither be combined with");
+		error("forgetting n-grams nor with several n-gram lengths.");
+		return SALAD_EXIT;
+	}
+
+	if (config->num_ngram_lengths > 0 && (config->mode != TRAINING || config->update_model))
+	{
+		error("Several n-gram lengths can only be used when training");
+		error("new models rather than updating an existing one.");
+		return SALAD_EXIT;
+	}
+
+	if (config->binary_ngrams && max_ngram_length > MASK_BITSIZE)
 	{
 		error("When using binary n-grams currently only a maximal");
 		error("length of %u bits is supported.", MASK_BITSIZE);
 		return SALAD_EXIT;
 	}
 
+	if (config->intern_tokens && (config->delimiter == NULL || config->delimiter[0] == 0x00))
+	{
+		warn("Interning tokens requires token n-grams (cf. --ngram-delim).");
+		config->intern_tokens = FALSE;
+	}
+
+	// Short byte n-grams are indexed directly, cf. config_pick_hashset. When
+	// training several models at once, this is decided per n-gram length,
+	// such that each model equals the one of a single run.
+	config->direct_hashes = (!hs && !config->update_model && !config->binary_ngrams
+			&& (config->delimiter == NULL || config->delimiter[0] == 0x00)
+			&& (config->container == CONTAINER_BLOOMFILTER || config->container == CONTAINER_COUNTINGBLOOMFILTER));
+
+	if (config->num_ngram_lengths == 0)
+	{
+		config_pick_hashset(config);
+	}
+
 	if (check_netparams(config, conly, sonly) == EXIT_FAILURE) return SALAD_HELP_TRAIN;
 	if (check_input(config, TRUE, bs) == EXIT_FAILURE) return SALAD_EXIT;
 	if (check_output(config) == EXIT_FAILURE) return SALAD_EXIT;
@@ -668,7 +1013,7 @@ const saladstate_t parse_training_options(int argc, char* argv[], config_t* cons
 }
 
 
-const saladstate_t parse_predict_options(int argc, char* argv[], config_t* const config)
+const saladstate_t parse_predictlike_options_ex(int argc, char* argv[], config_t* const config, const char* const shortopts, const struct option* longopts)
 {
 	assert(argv != NULL);
 	assert(config != NULL);
@@ -676,7 +1021,7 @@ const saladstate_t parse_predict_options(int argc, char* argv[], config_t* const
 	int conly = FALSE, sonly = FALSE;
 
 	int option, bs = FALSE;
-	while ((option = getopt_long(argc, argv, PREDICT_OPTION_STR, predict_longopts, NULL)) != -1)
+	while ((option = getopt_long(argc, argv, shortopts, longopts, NULL)) != -1)
 	{
 		switch (option)
 		{
@@ -711,6 +1056,18 @@ const saladstate_t parse_predict_options(int argc, char* argv[], config_t* const
 			break;
 		}
 
+		case OPTION_CHUNKSIZE:
+		{
+			char* end; // For parsing numbers with strto*
+			const long long int chunk_size = strtoll(optarg, &end, 10);
+			if (chunk_size <= 0)
+			{
+				warn("Illegal chunk size specified.");
+			}
+			else config->chunk_size = (size_t) MIN(SIZE_MAX, (unsigned long) chunk_size);
+			break;
+		}
+
 #ifdef USE_NETWORK
 		case 'p':
 			config->pcap_filter = optarg;
@@ -723,6 +1080,68 @@ const saladstate_t parse_predict_options(int argc, char* argv[], config_t* const
 		case OPTION_NETSERVER:
 			sonly = TRUE;
 			break;
+
+		case OPTION_UDPPORTS:
+			config->net_udp_ports = optarg;
+			break;
+
+		case OPTION_NETSTREAM:
+			config->net_stream = TRUE;
+			break;
+
+		case OPTION_CHECKPOINT:
+		{
+			char* end; // For parsing numbers with strto*
+			const long long int checkpoint = strtoll(optarg, &end, 10);
+			if (checkpoint <= 0)
+			{
+				warn("Illegal checkpoint specified.");
+			}
+			else config->net_checkpoint = (size_t) MIN(SIZE_MAX, (unsigned long) checkpoint);
+			config->net_stream = TRUE;
+			break;
+		}
+
+		case OPTION_CHECKPOINTTIME:
+		{
+			char* end; // For parsing numbers with strto*
+			const double t = strtod(optarg, &end);
+			if (!(t > 0.0))
+			{
+				warn("Illegal checkpoint time specified.");
+			}
+			else config->net_checkpoint_time = t;
+			config->net_stream = TRUE;
+			break;
+		}
+
+		case OPTION_BATCHLATENCY:
+		{
+			char* end; // For parsing numbers with strto*
+			const double t = strtod(optarg, &end);
+			if (!(t >= 0.0))
+			{
+				warn("Illegal batch latency specified.");
+			}
+			else config->net_batch_latency = t;
+			break;
+		}
+
+		case OPTION_WORKERS:
+		{
+			char* end; // For parsing numbers with strto*
+			const long long int workers = strtoll(optarg, &end, 10);
+			if (workers <= 0)
+			{
+				warn("Illegal number of workers specified.");
+			}
+			else config->net_workers = (size_t) MIN(SIZE_MAX, (unsigned long) workers);
+			break;
+		}
+
+		case OPTION_WATCH:
+			config->serve_watch = TRUE;
+			break;
 #endif
 #ifdef GROUPED_INPUT
 		case 'g':
@@ -733,6 +1152,10 @@ const saladstate_t parse_predict_options(int argc, char* argv[], config_t* const
 			config->output = optarg;
 			break;
 
+		case 'F':
+			config->output_type = as_outputmode(optarg);
+			break;
+
 		case 'b':
 			config->bloom = optarg;
 			break;
@@ -745,6 +1168,22 @@ const saladstate_t parse_predict_options(int argc, char* argv[], config_t* const
 			config->nan = optarg;
 			break;
 
+		case OPTION_SHAREDMODEL:
+			config->shared_model = optarg;
+			break;
+
+		case OPTION_WINDOW:
+		{
+			char* end; // For parsing numbers with strto*
+			const long long int window = strtoll(optarg, &end, 10);
+			if (window <= 0)
+			{
+				warn("Illegal window size specified.");
+			}
+			else config->window = (size_t) MIN(SIZE_MAX, (unsigned long) window);
+			break;
+		}
+
 		case 'e':
 			config->echo_params = TRUE;
 			break;
@@ -767,9 +1206,42 @@ const saladstate_t parse_predict_options(int argc, char* argv[], config_t* const
 	}
 
 	if (check_netparams(config, conly, sonly) == EXIT_FAILURE) return SALAD_HELP_PREDICT;
-	if (check_input(config, FALSE, bs) == EXIT_FAILURE) return SALAD_EXIT;
+	// Freezing a model corresponds to a second pass over the training data
+	if (check_input(config, config->mode == FREEZE, bs) == EXIT_FAILURE) return SALAD_EXIT;
 	if (check_output(config) == EXIT_FAILURE) return SALAD_EXIT;
 
+#ifdef USE_NETWORK
+	if (config->net_stream && config->input_type != IOMODE_NETWORK && config->input_type != IOMODE_NETWORK_DUMP)
+	{
+		warn("Streaming only applies to network data and is ignored.");
+		config->net_stream = FALSE;
+	}
+
+	if (config->net_workers > 1 && config->input_type != IOMODE_NETWORK && config->input_type != IOMODE_NETWORK_DUMP)
+	{
+		warn("Several workers only apply to network data and are ignored.");
+		config->net_workers = 1;
+	}
+
+	if (config->net_workers > 1 && config->input_type == IOMODE_NETWORK && config->net_stream)
+	{
+		warn("Streams of live network data are scored on the capture thread.");
+		config->net_workers = 1;
+	}
+
+	if (config->serve_watch && config->input_type != IOMODE_NETWORK && config->input_type != IOMODE_NETWORK_DUMP)
+	{
+		warn("Watching the models only applies to network data and is ignored.");
+		config->serve_watch = FALSE;
+	}
+
+	if (config->serve_watch && (config->shared_model != NULL || config->bbloom != NULL))
+	{
+		warn("Shared models and bad content models are not reloaded.");
+		config->serve_watch = FALSE;
+	}
+#endif
+
 	if (config->echo_params)
 	{
 		// cf. salad_predict_stub
@@ -777,6 +1249,25 @@ const saladstate_t parse_predict_options(int argc, char* argv[], config_t* const
 	return SALAD_RUN;
 }
 
+const saladstate_t parse_predict_options(int argc, char* argv[], config_t* const config)
+{
+	return parse_predictlike_options_ex(argc, argv, config, PREDICT_OPTION_STR, predict_longopts);
+}
+
+
+const saladstate_t parse_freeze_options(int argc, char* argv[], config_t* const config)
+{
+	const saladstate_t m = parse_predictlike_options_ex(argc, argv, config, FREEZE_OPTION_STR, freeze_longopts);
+	if (m == SALAD_HELP_PREDICT) return SALAD_HELP_FREEZE;
+
+	if (m == SALAD_RUN && config->bloom == NULL)
+	{
+		error("No model specified.");
+		return SALAD_EXIT;
+	}
+	return m;
+}
+
 
 const saladstate_t parse_inspect_options(int argc, char* argv[], config_t* const config)
 {
@@ -820,6 +1311,74 @@ const saladstate_t parse_stats_options(int argc, char* argv[], config_t* const c
 	return SALAD_RUN;
 }
 
+const saladstate_t parse_serve_options(int argc, char* argv[], config_t* const config)
+{
+	assert(argv != NULL);
+	assert(config != NULL);
+
+	int option;
+	while ((option = getopt_long(argc, argv, SERVE_OPTION_STR, serve_longopts, NULL)) != -1)
+	{
+		switch (option)
+		{
+		case 'b':
+			config->bloom = optarg;
+			break;
+
+		case 's':
+			config->socket = optarg;
+			break;
+
+		case OPTION_WORKERS:
+		{
+			char* end; // For parsing numbers with strto*
+			const long long int workers = strtoll(optarg, &end, 10);
+			if (workers <= 0)
+			{
+				warn("Illegal number of workers specified.");
+			}
+			else config->serve_workers = (size_t) MIN(SIZE_MAX, (unsigned long) workers);
+			break;
+		}
+
+		case OPTION_WATCH:
+			config->serve_watch = TRUE;
+			break;
+
+		case 'e':
+			config->echo_params = TRUE;
+			break;
+
+		case 'q':
+			log_level = WARNING;
+			break;
+
+		case '?':
+		case 'h':
+			log_level = STATUS;
+			return SALAD_HELP_SERVE;
+
+		default:
+			// In order to catch program argument that correspond to
+			// features that were excluded at compile time.
+			fprintf(stderr, "invalid option -- '%c'\n", option);
+			return SALAD_HELP_SERVE;
+		}
+	}
+
+	if (config->bloom == NULL || config->bloom[0] == 0x00)
+	{
+		error("No bloom filter specified.");
+		return SALAD_EXIT;
+	}
+	if (config->socket == NULL || config->socket[0] == 0x00)
+	{
+		error("No socket specified.");
+		return SALAD_EXIT;
+	}
+	return SALAD_RUN;
+}
+
 #ifdef TEST_SALAD
 const saladstate_t parse_test_options(int argc, char* argv[], test_config_t* const config)
 {
@@ -876,8 +1435,10 @@ const saladstate_t parse_options(int argc, char* argv[], config_t* const config,
 		{
 		case TRAINING: return parse_training_options(argc, argv, config);
 		case PREDICT:  return parse_predict_options(argc, argv, config);
+		case FREEZE:   return parse_freeze_options(argc, argv, config);
 		case INSPECT:  return parse_inspect_options(argc, argv, config);
 		case STATS:    return parse_stats_options(argc, argv, config);
+		case SERVE:    return parse_serve_options(argc, argv, config);
 #ifdef TEST_SALAD
 		case TEST:     return parse_test_options(argc, argv, test_config);
 #endif
@@ -920,8 +1481,10 @@ int main(int argc, char* argv[])
 	case SALAD_HELP:         return usage_main();
 	case SALAD_HELP_TRAIN:   return usage_train();
 	case SALAD_HELP_PREDICT: return usage_predict();
+	case SALAD_HELP_FREEZE:  return usage_freeze();
 	case SALAD_HELP_INSPECT: return usage_inspect();
 	case SALAD_HELP_STATS:   return usage_stats();
+	case SALAD_HELP_SERVE:   return usage_serve();
 #ifdef TEST_SALAD
 	case SALAD_HELP_TEST:    return usage_test();
 #endif
@@ -944,9 +1507,15 @@ int main(int argc, char* argv[])
 	case PREDICT:
 		ret = _salad_predict_(&config);
 		break;
+	case FREEZE:
+		ret = _salad_freeze_(&config);
+		break;
 	case INSPECT:
 		ret = _salad_inspect_(&config);
 		break;
+	case SERVE:
+		ret = _salad_serve_(&config);
+		break;
 	default:
 		is_metaop = TRUE;
 		break;
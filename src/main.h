@@ -162,6 +162,9 @@
  * @subsection sec_salad-predict salad-predict(1)
  * Predicts the anomaly score of the specified data.
  *
+ * @subsection sec_salad-freeze  salad-freeze(1)
+ * Exports a trained model as compact, static filter.
+ *
  * @subsection sec_salad-stats   salad-stats(1)
  * Provides statistical information of a trained anomaly detector.
  *
@@ -169,6 +172,9 @@
  * Analyzes the specified data with respect to the n-gram model used by the
  * detector.
  *
+ * @subsection sec_salad-serve   salad-serve(1)
+ * Answers scoring requests over a Unix domain socket.
+ *
  * @section sec_copyright COPYRIGHT
  * \copydoc hidden_copyright
  */
@@ -196,9 +202,12 @@ int main(int argc, char* argv[]);
  * restricted to the binary embedding of n-grams, that is, the representation of
  * the pure Boolean occurrence of such n-grams. The actual mapping of an n-gram
  * to the index within the bit array is achieved by hashing the n-gram value. To
- * do so \b Salad offers two different <em>hash sets</em>: (1) three fundamentally
- * different hash functions and (2) three differently seeded instances of the
- * murmur hash function.
+ * do so \b Salad offers three different <em>hash sets</em>: (1) three fundamentally
+ * different hash functions, (2) three differently seeded instances of the
+ * murmur hash function and (3) three indices mixed from a single 64-bit murmur
+ * hash. In token mode the latter hashes every token only once and combines the
+ * token hashes to the hash of the n-gram. In bit mode it hashes the value of
+ * each bit n-gram directly.
  *
  * @section train_sec_ops OPTIONS
  *
@@ -219,7 +228,14 @@ int main(int argc, char* argv[]);
  *
  * @par     --batch-size &lt;num&gt;
  * Sets the size of batches that are read and processed in one go. When
- * processing network streams this is automatically set to 1.
+ * processing network data this defaults to 1, i.e., every stream is
+ * processed as soon as it is complete. Larger batches consist of copies of
+ * complete streams and datagrams.
+ *
+ * @par     --chunk-size &lt;num&gt;
+ * Processes strings in chunks of at most &lt;num&gt; bytes, such that large
+ * inputs do not have to be held in memory at once. The n-grams spanning
+ * chunks are nevertheless considered exactly once.
  *
  * @par -p, --pcap-filter &lt;str&gt;
  * Filter expression for the PCAP library in case network data is processed
@@ -232,11 +248,29 @@ int main(int argc, char* argv[]);
  * @par     --server-only
  * Only consider the server-side of the network communication -- cf. USE_NETWORK.
  *
+ * @par     --udp-ports &lt;list&gt;
+ * Additionally process the payloads of UDP datagrams sent to or from the
+ * given comma-separated ports or port ranges, e.g., 53,5000-5010, or "all".
+ * Unless a PCAP filter is specified, both TCP and UDP traffic is captured.
+ * Just as TCP streams, datagrams are processed in batches if --batch-size
+ * is given explicitly -- cf. USE_NETWORK.
+ *
  * @par -u, --update-model
  * In case the specified output file exists and contains a valid model this
  * flag indicates that that model should be update rather than recreated from
  * scratch.
  *
+ * @par     --decay &lt;num&gt;
+ * Halve the counts of the model to be updated &lt;num&gt; times before training,
+ * such that n-grams that have not been seen recently expire. This requires
+ * a counting bloom filter (cf. --container).
+ *
+ * @par     --forget
+ * Remove the n-grams of the input from the model to be updated rather than
+ * adding them. This requires a counting bloom filter (cf. --container).
+ * Cuckoo filters store each n-gram once only and thus, cannot tell whether
+ * other training data still contributes an n-gram.
+ *
  * @par -o, --output &lt;file&gt;
  * The output filename.
  *
@@ -246,12 +280,20 @@ int main(int argc, char* argv[]);
  *
  * @subsection train_sec_featureops Feature Options:
  * @par -n, --ngram-len &lt;num&gt;
- * Set length of n-grams (Default: 3).
+ * Set length of n-grams (Default: 3). A list of lengths such as 2,3,5 or a
+ * range such as 2-4 trains one model per length in a single pass over the
+ * data. The models are written to &lt;file&gt;.&lt;n&gt; and share all other
+ * settings. Each model equals the one of a separate run with its n, i.e.,
+ * the 'direct' hash set is chosen per n-gram length.
  *
  * @par -d, --ngram-delim &lt;delim&gt;
  * Set delimiters for the use of word/ token n-grams. If omitted or empty
  * byte n-grams are used.
  *
+ * @par     --intern-tokens
+ * Map the tokens to integer ids stored along with the model and build the
+ * n-grams of these ids.
+ *
  * @par     --binary
  * Indicates to use bit n-grams rather than byte or token n-grams and
  * consequently, disables the --ngram-delim option.
@@ -260,7 +302,21 @@ int main(int argc, char* argv[]);
  * Set the size of the bloom filter as bits of the index (Default: 24).
  *
  * @par     --hash-set &lt;hashes&gt;
- * Set the hash set to be used: 'simple', 'simple2' or 'murmur' (Default: 'simple2').
+ * Set the hash set to be used: 'simple', 'simple2', 'murmur', 'mix',
+ * 'direct' or 'crc' (Default: 'simple2'). Token models using 'mix' cannot be
+ * frozen. The 'crc' hash set uses the crc32 instruction of SSE4.2 if
+ * available and computes the same values in software otherwise.
+ * The 'direct' hash set indexes byte n-grams as they are and thus, is exact
+ * if the filter size is at least 8n bits. Byte n-grams with n <= 3 use it
+ * by default unless either the hash set or the filter size is specified.
+ *
+ * @par     --container &lt;type&gt;
+ * Set the type of the model: 'bloom-filter', 'counting-bloom-filter' or
+ * 'cuckoo-filter' (Default: 'bloom-filter'). The counting bloom filter
+ * additionally keeps a 4-bit counter per bit and thus, requires five times
+ * the memory. The cuckoo filter stores 16-bit fingerprints in the same
+ * amount of memory as the bloom filter. It yields a lower false-positive
+ * rate, but holds at most one n-gram per 16 bits of the filter.
  *
  * @subsection train_sec_genericops Generic Options:
  * @par -e, --echo-params
@@ -316,7 +372,14 @@ const int _salad_train_(const config_t* const c);
  *
  * @par     --batch-size &lt;num&gt;
  * Sets the size of batches that are read and processed in one go. When
- * processing network streams this is automatically set to 1.
+ * processing network data this defaults to 1, i.e., every stream is
+ * processed as soon as it is complete. Larger batches consist of copies of
+ * complete streams and datagrams.
+ *
+ * @par     --chunk-size &lt;num&gt;
+ * Processes strings in chunks of at most &lt;num&gt; bytes, such that large
+ * inputs do not have to be held in memory at once. The n-grams spanning
+ * chunks are nevertheless considered exactly once.
  *
  * @par -p, --pcap-filter &lt;str&gt;
  * Filter expression for the PCAP library in case network data is processed
@@ -329,15 +392,63 @@ const int _salad_train_(const config_t* const c);
  * @par     --server-only
  * Only consider the server-side of the network communication -- cf. USE_NETWORK.
  *
+ * @par     --udp-ports &lt;list&gt;
+ * Additionally process the payloads of UDP datagrams sent to or from the
+ * given comma-separated ports or port ranges, e.g., 53,5000-5010, or "all".
+ * Unless a PCAP filter is specified, both TCP and UDP traffic is captured.
+ * Just as TCP streams, datagrams are processed in batches if --batch-size
+ * is given explicitly -- cf. USE_NETWORK.
+ *
+ * @par     --batch-latency &lt;sec&gt;
+ * The maximal time complete streams of live network traffic are held back
+ * in order to fill a batch (Default: 1). The latency is checked at least
+ * whenever the capture times out -- cf. USE_NETWORK.
+ *
+ * @par     --stream
+ * Score TCP streams chunk by chunk while their data arrives rather than
+ * reassembling them completely, such that the memory per stream is bounded
+ * and long-lived connections are scored at all. Each line of the output
+ * holds a score followed by the number of the stream -- cf. USE_NETWORK.
+ *
+ * @par     --checkpoint &lt;num&gt;
+ * Additionally report the score of a stream every &lt;num&gt; bytes. Implies
+ * --stream -- cf. USE_NETWORK.
+ *
+ * @par     --checkpoint-time &lt;sec&gt;
+ * Additionally report the score of a stream if at least &lt;sec&gt; seconds
+ * passed since its last report. Implies --stream -- cf. USE_NETWORK.
+ *
+ * @par     --workers &lt;num&gt;
+ * Processes network dumps in &lt;num&gt; processes. The connections are
+ * distributed among them by hashing their endpoints, such that each process
+ * reassembles and scores its share only. The output corresponds to that of a
+ * single process, except for the numbers of streams (cf. --stream) that are
+ * unique but assigned interleaved. For live network traffic the streams
+ * are scored on &lt;num&gt; threads instead, such that the capture is not
+ * stalled by the scoring. Streams are dropped if the threads cannot keep up,
+ * and the order of the output may differ from that of the streams. Hence,
+ * each line holds a score followed by the number of the stream in the order
+ * of arrival, where dropped streams leave gaps -- cf. USE_NETWORK.
+ *
+ * @par     --watch
+ * Reload the one-class models once their files change, as in salad-serve.
+ * Network data is always scored with models that are loaded anew on SIGHUP.
+ * Batches in progress finish on the models they were started with. Shared
+ * models and bad content models are not reloaded -- cf. USE_NETWORK.
+ *
  * @par -g, --group-input
  * Indicates that predictions for inputs in the same "group" should be
  * grouped as well.
  *
  * @par -b, --bloom &lt;file&gt;
- * The bloom filter to be used.
+ * The bloom filter to be used. Several comma-separated models, e.g., as
+ * trained with a list of n-gram lengths, are applied in one pass over the
+ * data and yield one space-separated score column each.
  *
  * @par     --bad-bloom &lt;file&gt;
- * The bloom filter for the 2nd class (optional).
+ * The bloom filter for the 2nd class (optional). If both filters are of the
+ * same size and use the same hash functions, their bits are interleaved such
+ * that one pass over the hash functions answers both queries.
  *
  * @par -o, --output &lt;file&gt;
  * The output filename.
@@ -346,6 +457,26 @@ const int _salad_train_(const config_t* const c);
  * @par -r, --nan-str &lt;str&gt;
  * Set the string to be shown for NaN values.
  *
+ * @par     --window &lt;num&gt;
+ * Rather than scoring a string as a whole, slide a window of &lt;num&gt;
+ * n-grams over it and report the score of the window containing the most
+ * unknown n-grams, followed by its byte offset and length. Hence, a short
+ * anomalous region is not diluted by a long benign remainder. Only available
+ * for byte n-grams and one-class models.
+ *
+ * @par     --shared-model &lt;name&gt;
+ * Share the bit array of the bloom filter among several processes via the
+ * POSIX shared memory segment &lt;name&gt;. The first process publishes the
+ * filter it has loaded, while all others only read the specification of
+ * the model and attach to the segment read-only, provided that it was
+ * published from the very same model file. Otherwise, or if the segment is
+ * not available, the process loads a private copy. A bad content model and
+ * the models of a comma-separated list use the segments &lt;name&gt;.bad and
+ * &lt;name&gt;.1, &lt;name&gt;.2, etc., and are not interleaved. The
+ * segments persist after the processes exit. Segments of a crashed
+ * publisher, and those of another model whose publisher has exited, e.g.,
+ * after retraining, are replaced.
+ *
  * @subsection stats_sec_genericops Generic Options:
  * @par -e, --echo-params
  * Echo used parameters and settings.
@@ -361,6 +492,72 @@ const int _salad_train_(const config_t* const c);
  */
 const int _salad_predict_(const config_t* const c);
 
+/**
+ * @page salad-freeze Freeze mode of Salad
+ *
+ * @section freeze_sec_syn SYNOPSIS
+ *
+ * salad freeze [options]
+ *
+ * @section freeze_sec_desc DESCRIPTION
+ *
+ * Exports a trained model as static xor filter (Graf and Lemire, 2020). Static
+ * filters cannot be updated once they are built, but use only about 20 bits
+ * per n-gram at a false positive rate of 2^-16 and answer each query with
+ * exactly three memory accesses.
+ *
+ * Since filters do not allow to enumerate their content, the training data is
+ * read once more and the set of n-grams contained in the model is collected
+ * for building the static filter.
+ *
+ * @section freeze_sec_ops OPTIONS
+ *
+ * @subsection freeze_sec_ioops I/O Options:
+ * @par -i, --input &lt;file&gt;
+ * The input filename, i.e., the data the model was trained on.
+ *
+ * @par -f, --input-format &lt;fmt&gt;
+ * Sets the format of input -- cf. salad-train(1).
+ *
+ * @par     --input-filter &lt;regex&gt;
+ * The regular expression for filtering input lines or filenames respectively
+ * depending on the input format/ type used -- cf. USE_REGEX_FILTER.
+ *
+ * @par     --batch-size &lt;num&gt;
+ * Sets the size of batches that are read and processed in one go.
+ *
+ * @par -p, --pcap-filter &lt;str&gt;
+ * Filter expression for the PCAP library in case network data is processed
+ * -- cf. USE_NETWORK.
+ *
+ * @par     --client-only
+ * Only consider the client-side of the network communication -- cf. USE_NETWORK.
+ *
+ * @par     --server-only
+ * Only consider the server-side of the network communication -- cf. USE_NETWORK.
+ *
+ * @par -b, --bloom &lt;file&gt;
+ * The trained model to be frozen.
+ *
+ * @par -o, --output &lt;file&gt;
+ * The output filename.
+ *
+ * @par -F, --output-format &lt;fmt&gt;
+ * Sets the format of the output. This option might be either 'txt' or
+ * 'archive' -- cf. USE_ARCHIVES.
+ *
+ * @subsection freeze_sec_genericops Generic Options:
+ * @par -q, --quiet
+ * Suppress all output but warning and errors.
+ *
+ * @par -h, --help
+ * Print the help screen.
+ *
+ * @section freeze_sec_copyright COPYRIGHT
+ * \copydoc hidden_copyright
+ */
+const int _salad_freeze_(const config_t* const c);
+
 /**
  * @page salad-stats Statistics mode of Salad
  *
@@ -429,7 +626,9 @@ const int _salad_stats_(const config_t* const c);
  *
  * @par     --batch-size &lt;num&gt;
  * Sets the size of batches that are read and processed in one go. When
- * processing network streams this is automatically set to 1.
+ * processing network data this defaults to 1, i.e., every stream is
+ * processed as soon as it is complete. Larger batches consist of copies of
+ * complete streams and datagrams.
  *
  * @par -p, --pcap-filter &lt;str&gt;
  * Filter expression for the PCAP library in case network data is processed
@@ -464,7 +663,17 @@ const int _salad_stats_(const config_t* const c);
  * Set the size of the bloom filter as bits of the index (Default: 24).
  *
  * @par     --hash-set &lt;hashes&gt;
- * Set the hash set to be used: 'simple', 'simple2' or 'murmur' (Default: 'simple2').
+ * Set the hash set to be used: 'simple', 'simple2', 'murmur', 'mix',
+ * 'direct' or 'crc' (Default: 'simple2'). Token models using 'mix' cannot be
+ * frozen. The 'crc' hash set uses the crc32 instruction of SSE4.2 if
+ * available and computes the same values in software otherwise.
+ * The 'direct' hash set indexes byte n-grams as they are and thus, is exact
+ * if the filter size is at least 8n bits. Byte n-grams with n <= 3 use it
+ * by default unless either the hash set or the filter size is specified.
+ *
+ * @par     --container &lt;type&gt;
+ * Set the type of the model: 'bloom-filter', 'counting-bloom-filter' or
+ * 'cuckoo-filter' (Default: 'bloom-filter'), cf. salad-train.
  *
  * @subsection inspect_sec_genericops Generic Options:
  * @par -e, --echo-params
@@ -478,6 +687,73 @@ const int _salad_stats_(const config_t* const c);
  */
 const int _salad_inspect_(const config_t* const c);
 
+/**
+ * @page salad-serve Serving mode of Salad
+ *
+ * @section serve_sec_syn SYNOPSIS
+ *
+ * salad serve [options]
+ *
+ * @section serve_sec_desc DESCRIPTION
+ *
+ * Loads one or several models once and answers scoring requests over a Unix
+ * domain socket until it receives SIGINT or SIGTERM. This avoids loading the
+ * model for every invocation of salad-predict if strings arrive one by one.
+ *
+ * On SIGHUP, or once the model files change if --watch is given, the models
+ * are loaded anew while requests are still answered with the current ones.
+ * The new models replace the current ones only if they were generated with
+ * the same parameters. Requests in progress finish on the models they were
+ * started with. Models are best replaced by renaming a completely written
+ * file over the old one.
+ *
+ * Requests and responses are binary and use the byte order of the host. A
+ * request consists of the number of strings as 32-bit unsigned integer,
+ * followed by the strings, each of which is prefixed by its length in bytes
+ * as 32-bit unsigned integer. A single request must not exceed 64 MiB.
+ *
+ * For every request the server answers with the number of strings and the
+ * number of models as 32-bit unsigned integers, followed by one double per
+ * string and model in this order. The scores correspond to the output of
+ * salad-predict, i.e., strings that are too short to be scored yield NaN.
+ * A client may send several requests without awaiting the responses, which
+ * are returned in the same order. Malformed requests close the connection.
+ *
+ * @section serve_sec_ops OPTIONS
+ *
+ * @subsection serve_sec_ioops I/O Options:
+ * @par -b, --bloom &lt;file&gt;
+ * The bloom filter to be used. A comma-separated list of one-class models
+ * yields one score per model, cf. salad-predict.
+ *
+ * @par -s, --socket &lt;file&gt;
+ * The Unix domain socket to listen on. A stale socket of a previous instance
+ * is replaced.
+ *
+ * @par     --workers &lt;num&gt;
+ * Answer requests with &lt;num&gt; threads (Default: 4). Each connection is
+ * served by one thread at a time.
+ *
+ * @par     --watch
+ * Reload the models once their files change. Changes are picked up as soon
+ * as the files did not change for half a second. SIGHUP always triggers a
+ * reload.
+ *
+ * @subsection serve_sec_genericops Generic Options:
+ * @par -e, --echo-params
+ * Echo used parameters and settings.
+ *
+ * @par -q, --quiet
+ * Suppress all output but warning and errors.
+ *
+ * @par -h, --help
+ * Print the help screen.
+ *
+ * @section serve_sec_copyright COPYRIGHT
+ * \copydoc hidden_copyright
+ */
+const int _salad_serve_(const config_t* const c);
+
 #ifdef TEST_SALAD
 /**
  * @page salad-test (Unit) Testing of the implementation of Salad
@@ -27,16 +27,24 @@
 
 typedef struct
 {
-	BLOOM* bloom;
+	container_t* model;
 	const vec_t* weights;
 
 } bloomize_t;
 
 typedef struct
 {
-	BLOOM* bloom1;
-	BLOOM* bloom2;
-	size_t new, uniq, total;
+	const container_t* model;
+	FPSET* keys;
+
+} collect_t;
+
+typedef struct
+{
+	container_t* model;
+	FPSET* uniq;
+	HLL* hll;
+	size_t new, num_uniq, total;
 } bloomize_stats_ex_t;
 
 
@@ -45,7 +53,8 @@ BLOOM* const bloomizeb(const char* str, const size_t len, const size_t n, const
 	BLOOM* const bloom = bloom_init(DEFAULT_BFSIZE, DEFAULT_HASHSET);
 	if (bloom != NULL)
 	{
-		bloomizeb_ex(bloom, str, len, n);
+		container_t c = {CONTAINER_BLOOMFILTER, bloom};
+		bloomizeb_ex(&c, str, len, n);
 	}
 	return bloom;
 }
@@ -55,7 +64,8 @@ BLOOM* const bloomize(const char* str, const size_t len, const size_t n)
 	BLOOM* const bloom = bloom_init(DEFAULT_BFSIZE, DEFAULT_HASHSET);
 	if (bloom != NULL)
 	{
-		bloomize_ex(bloom, str, len, n);
+		container_t c = {CONTAINER_BLOOMFILTER, bloom};
+		bloomize_ex(&c, str, len, n);
 	}
 	return bloom;
 }
@@ -65,7 +75,8 @@ BLOOM* const bloomizew(const char* str, const size_t len, const size_t n, const
 	BLOOM* const bloom = bloom_init(DEFAULT_BFSIZE, DEFAULT_HASHSET);
 	if (bloom != NULL)
 	{
-		bloomizew_ex(bloom, str, len, n, delim);
+		container_t c = {CONTAINER_BLOOMFILTER, bloom};
+		bloomizew_ex(&c, str, len, n, delim);
 	}
 	return bloom;
 }
@@ -77,7 +88,26 @@ static inline void simple_add(const char* const ngram, const size_t len, void* c
 	assert(ngram != NULL && data != NULL);
 	bloomize_t* const d = (bloomize_t*) data;
 
-	bloom_add_str(d->bloom, ngram, len);
+	container_add_str(d->model, ngram, len);
+}
+
+static inline void simple_remove(const char* const ngram, const size_t len, void* const data)
+{
+	assert(ngram != NULL && data != NULL);
+	bloomize_t* const d = (bloomize_t*) data;
+
+	container_remove_str(d->model, ngram, len);
+}
+
+static inline void collect(const char* const ngram, const size_t len, void* const data)
+{
+	assert(ngram != NULL && data != NULL);
+	collect_t* const d = (collect_t*) data;
+
+	if (container_check_str(d->model, ngram, len))
+	{
+		fpset_add(d->keys, murmur64_hash_n(ngram, len));
+	}
 }
 
 static inline void checked_add(const char* const ngram, const size_t len, void* const data)
@@ -88,25 +118,34 @@ static inline void checked_add(const char* const ngram, const size_t len, void*
     const dim_t dim = hash(ngram, len);
     if (vec_get(d->weights, dim) > 0.0)
     {
-		bloom_add_str(d->bloom, ngram, len);
+		container_add_str(d->model, ngram, len);
     }
 }
 
+static inline void track_uniq(bloomize_stats_ex_t* const d, const char* const ngram, const size_t len)
+{
+	const uint64_t fp = murmur64_hash_n(ngram, len);
+	if (fpset_add(d->uniq, fp))
+	{
+		d->num_uniq++;
+		if (d->hll != NULL)
+		{
+			hll_add_hash(d->hll, fp);
+		}
+	}
+}
+
 static inline void counted_add_ex(const char* const ngram, const size_t len, void* const data)
 {
 	assert(ngram != NULL && data != NULL);
 	bloomize_stats_ex_t* const d = (bloomize_stats_ex_t*) data;
 
-	if (!bloom_check_str(d->bloom1, ngram, len))
+	if (!container_check_str(d->model, ngram, len))
 	{
 		d->new++;
-		bloom_add_str(d->bloom1, ngram, len);
-	}
-	if (!bloom_check_str(d->bloom2, ngram, len))
-	{
-		d->uniq++;
-		bloom_add_str(d->bloom2, ngram, len);
+		container_add_str(d->model, ngram, len);
 	}
+	track_uniq(d, ngram, len);
 }
 
 static inline void counted_add(const char* const ngram, const size_t len, void* const data)
@@ -120,15 +159,11 @@ static inline void count_ex(const char* const ngram, const size_t len, void* con
 	assert(ngram != NULL && data != NULL);
 	bloomize_stats_ex_t* const d = (bloomize_stats_ex_t*) data;
 
-	if (!bloom_check_str(d->bloom1, ngram, len))
+	if (!container_check_str(d->model, ngram, len))
 	{
 		d->new++;
 	}
-	if (!bloom_check_str(d->bloom2, ngram, len))
-	{
-		d->uniq++;
-		bloom_add_str(d->bloom2, ngram, len);
-	}
+	track_uniq(d, ngram, len);
 }
 
 static inline void count(const char* const ngram, const size_t len, void* const data)
@@ -138,10 +173,74 @@ static inline void count(const char* const ngram, const size_t len, void* const
 }
 
 
-#define BLOOMIZE_DUAL(X, bloom1, _bloom2, str, len, n, delim, out, fct)  \
+// callbacks for n-grams hashed by value, cf. extract_bitgrams_hashed
+static inline void simple_add_hash(const uint64_t h, void* const data)
+{
+	assert(data != NULL);
+	container_add_hash(((bloomize_t*) data)->model, h);
+}
+
+static inline void simple_remove_hash(const uint64_t h, void* const data)
+{
+	assert(data != NULL);
+	container_remove_hash(((bloomize_t*) data)->model, h);
+}
+
+static inline void checked_add_hash(const uint64_t h, void* const data)
+{
+	assert(data != NULL);
+	bloomize_t* const d = (bloomize_t*) data;
+
+	// The hash takes the place of the dimension of the n-gram
+	if (vec_get(d->weights, (dim_t) h) > 0.0)
+	{
+		container_add_hash(d->model, h);
+	}
+}
+
+static inline void track_uniq_hash(bloomize_stats_ex_t* const d, const uint64_t h)
+{
+	if (fpset_add(d->uniq, h))
+	{
+		d->num_uniq++;
+		if (d->hll != NULL)
+		{
+			hll_add_hash(d->hll, h);
+		}
+	}
+}
+
+static inline void counted_add_hash(const uint64_t h, void* const data)
+{
+	assert(data != NULL);
+	bloomize_stats_ex_t* const d = (bloomize_stats_ex_t*) data;
+
+	if (!container_check_hash(d->model, h))
+	{
+		d->new++;
+		container_add_hash(d->model, h);
+	}
+	track_uniq_hash(d, h);
+	d->total++;
+}
+
+static inline void count_hash(const uint64_t h, void* const data)
+{
+	assert(data != NULL);
+	bloomize_stats_ex_t* const d = (bloomize_stats_ex_t*) data;
+
+	if (!container_check_hash(d->model, h))
+	{
+		d->new++;
+	}
+	track_uniq_hash(d, h);
+	d->total++;
+}
+
+
+#define BLOOMIZE_DUAL(X, _model, _uniq, _hll, str, len, n, delim, num, out, fct)\
 {                                                                        \
-	BLOOM* const BD_bloom1 = bloom1;                                     \
-	BLOOM* const BD_bloom2 = bloom2;                                     \
+	container_t* const BD_model = _model;                                      \
 	const char* const BD_str = str;                                      \
 	const size_t BD_len = len;                                           \
 	const size_t BD_n = n;                                               \
@@ -150,110 +249,286 @@ static inline void count(const char* const ngram, const size_t len, void* const
 	                                                                     \
 	if (out == NULL)                                                     \
 	{                                                                    \
-		BLOOMIZE_EX(#X[0], BD_bloom1, BD_str, BD_len, BD_n, BD_delim);   \
+		BLOOMIZE_EX(#X[0], BD_model, BD_str, BD_len, BD_n, BD_delim);    \
 		return;                                                          \
 	}                                                                    \
 	                                                                     \
 	bloomize_stats_ex_t data;                                            \
-	data.bloom1 = BD_bloom1;                                             \
-	data.bloom2 = BD_bloom2;                                             \
-	data.new = data.uniq = data.total = 0;                               \
+	data.model = BD_model;                                               \
+	data.uniq = _uniq;                                                   \
+	data.hll = _hll;                                                     \
+	data.new = data.num_uniq = data.total = 0;                           \
 	                                                                     \
-	bloom_clear(BD_bloom2);                                              \
-	extract_##X##grams(BD_str, BD_len, BD_n, BD_delim, fct, &data);      \
+	/* Only touches as many slots as n-grams may be extracted */         \
+	fpset_reset(data.uniq, num);                                         \
+	extract_##X##grams_for(BD_model, BD_str, BD_len, BD_n, BD_delim, fct, &data); \
 	                                                                     \
 	BD_out->new = data.new;                                              \
-	BD_out->uniq = data.uniq;                                            \
+	BD_out->uniq = data.num_uniq;                                        \
 	BD_out->total = data.total;                                          \
 }
 
+// The maximal number of n-grams in a string of the given length
+#define NUM_BITGRAMS(len, n) (n < CHAR_BIT *sizeof(size_t) -1 ? MIN((len) *CHAR_BIT, ((size_t) 1) << (n)) : (len) *CHAR_BIT)
+#define NUM_NGRAMS(len, n) ((len) >= (n) ? (len) -(n) +1 : 0)
+#define NUM_WGRAMS(len, n) ((len)/2 +1)
+
 // bit n-grams
-void bloomizeb_ex(BLOOM* const bloom, const char* const str, const size_t len, const size_t n)
+void bloomizeb_ex(container_t* const model, const char* const str, const size_t len, const size_t n)
 {
 	bloomize_t data;
-	data.bloom = bloom;
+	data.model = model;
 	data.weights = NULL;
 
+	if (container_hashes_tokens(model))
+	{
+		extract_bitgrams_hashed(str, len, n, simple_add_hash, &data);
+		return;
+	}
 	extract_bitgrams(str, len, n, simple_add, &data);
 }
 
-void bloomizeb_ex2(BLOOM* const bloom, const char* const str, const size_t len, const size_t n, const vec_t* const weights)
+void bloomizeb_ex2(container_t* const model, const char* const str, const size_t len, const size_t n, const vec_t* const weights)
 {
 	bloomize_t data;
-	data.bloom = bloom;
+	data.model = model;
 	data.weights = weights;
 
+	if (container_hashes_tokens(model))
+	{
+		extract_bitgrams_hashed(str, len, n, checked_add_hash, &data);
+		return;
+	}
 	extract_bitgrams(str, len, n, checked_add, &data);
 }
 
-void bloomizeb_ex3(BLOOM* const bloom1, BLOOM* const bloom2, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out)
+static inline void bloomizeb_hashed(container_t* const model, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out, FN_PROCESS_HASH fct)
 {
-	BLOOMIZE_DUAL(b, bloom1, bloom2, str, len, n, NO_DELIMITER, out, counted_add);
+	bloomize_stats_ex_t data;
+	data.model = model;
+	data.uniq = uniq;
+	data.hll = hll;
+	data.new = data.num_uniq = data.total = 0;
+
+	fpset_reset(data.uniq, NUM_BITGRAMS(len, n));
+	extract_bitgrams_hashed(str, len, n, fct, &data);
+
+	out->new = data.new;
+	out->uniq = data.num_uniq;
+	out->total = data.total;
 }
 
-void bloomizeb_ex4(BLOOM* const bloom1, BLOOM* const bloom2, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out)
+void bloomizeb_ex3(container_t* const model, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out)
 {
-	BLOOMIZE_DUAL(b, bloom1, bloom2, str, len, n, NO_DELIMITER, out, count);
+	if (out != NULL && container_hashes_tokens(model))
+	{
+		bloomizeb_hashed(model, uniq, hll, str, len, n, out, counted_add_hash);
+		return;
+	}
+	BLOOMIZE_DUAL(b, model, uniq, hll, str, len, n, NO_DELIMITER, NUM_BITGRAMS(len, n), out, counted_add);
 }
 
+void bloomizeb_ex4(container_t* const model, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out)
+{
+	if (out != NULL && container_hashes_tokens(model))
+	{
+		bloomizeb_hashed(model, uniq, hll, str, len, n, out, count_hash);
+		return;
+	}
+	BLOOMIZE_DUAL(b, model, uniq, hll, str, len, n, NO_DELIMITER, NUM_BITGRAMS(len, n), out, count);
+}
 
 // byte or character n-grams
-void bloomize_ex(BLOOM* const bloom, const char* const str, const size_t len, const size_t n)
+void bloomize_ex(container_t* const model, const char* const str, const size_t len, const size_t n)
 {
+	if (model->type == CONTAINER_BLOOMFILTER || model->type == CONTAINER_COUNTINGBLOOMFILTER)
+	{
+		const FN_BLOOM_ADD_BYTEGRAMS kernel = bloom_add_bytegrams_fct((BLOOM*) model->data, n);
+		if (kernel != NULL)
+		{
+			kernel((BLOOM*) model->data, str, len);
+			return;
+		}
+	}
+
 	bloomize_t data;
-	data.bloom = bloom;
+	data.model = model;
 	data.weights = NULL;
 
     extract_bytegrams(str, len, n, simple_add, &data);
 }
 
-void bloomize_ex2(BLOOM* const bloom, const char* const str, const size_t len, const size_t n, const vec_t* const weights)
+void bloomize_ex2(container_t* const model, const char* const str, const size_t len, const size_t n, const vec_t* const weights)
 {
 	bloomize_t data;
-	data.bloom = bloom;
+	data.model = model;
 	data.weights = weights;
 
 	extract_bytegrams(str, len, n, checked_add, &data);
 }
 
-void bloomize_ex3(BLOOM* const bloom1, BLOOM* const bloom2, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out)
+void bloomize_ex3(container_t* const model, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out)
 {
-	BLOOMIZE_DUAL(n, bloom1, bloom2, str, len, n, NO_DELIMITER, out, counted_add_ex);
-	out->total = (len >= n ? len -n +1 : 0);
+	BLOOMIZE_DUAL(n, model, uniq, hll, str, len, n, NO_DELIMITER, NUM_NGRAMS(len, n), out, counted_add_ex);
+	out->total = NUM_NGRAMS(len, n);
 }
 
-void bloomize_ex4(BLOOM* const bloom1, BLOOM* const bloom2, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out)
+void bloomize_ex4(container_t* const model, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out)
 {
-	BLOOMIZE_DUAL(n, bloom1, bloom2, str, len, n, NO_DELIMITER, out, count_ex);
-	out->total = (len >= n ? len -n +1 : 0);
+	BLOOMIZE_DUAL(n, model, uniq, hll, str, len, n, NO_DELIMITER, NUM_NGRAMS(len, n), out, count_ex);
+	out->total = NUM_NGRAMS(len, n);
 }
 
 
 // token or word n-grams
-void bloomizew_ex(BLOOM* const bloom, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim)
+void bloomizew_ex(container_t* const model, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim)
 {
 	bloomize_t data;
-	data.bloom = bloom;
+	data.model = model;
 	data.weights = NULL;
 
-	extract_wgrams(str, len, n, delim, simple_add, &data);
+	extract_wgrams_for(model, str, len, n, delim, simple_add, &data);
 }
 
-void bloomizew_ex2(BLOOM* const bloom, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, const vec_t* const weights)
+void bloomizew_ex2(container_t* const model, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, const vec_t* const weights)
 {
 	bloomize_t data;
-	data.bloom = bloom;
+	data.model = model;
 	data.weights = weights;
 
-	extract_wgrams(str, len, n, delim, checked_add, &data);
+	extract_wgrams_for(model, str, len, n, delim, checked_add, &data);
+}
+
+void bloomizew_ex3(container_t* const model, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, bloomize_stats_t* const out)
+{
+	BLOOMIZE_DUAL(w, model, uniq, hll, str, len, n, delim, NUM_WGRAMS(len, n), out, counted_add);
+}
+
+void bloomizew_ex4(container_t* const model, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, bloomize_stats_t* const out)
+{
+	BLOOMIZE_DUAL(w, model, uniq, hll, str, len, n, delim, NUM_WGRAMS(len, n), out, count);
+}
+
+
+// n-grams of interned tokens
+void bloomizei_ex(container_t* const model, DICT* const dict, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim)
+{
+	bloomize_t data;
+	data.model = model;
+	data.weights = NULL;
+
+	extract_igrams(str, len, n, delim, dict, TRUE, simple_add, &data);
+}
+
+static inline void bloomizei_dual(container_t* const model, DICT* const dict, const int learn, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, bloomize_stats_t* const out, FN_PROCESS_NGRAM fct)
+{
+	if (out == NULL)
+	{
+		bloomizei_ex(model, dict, str, len, n, delim);
+		return;
+	}
+
+	bloomize_stats_ex_t data;
+	data.model = model;
+	data.uniq = uniq;
+	data.hll = hll;
+	data.new = data.num_uniq = data.total = 0;
+
+	fpset_reset(data.uniq, NUM_WGRAMS(len, n));
+	extract_igrams(str, len, n, delim, dict, learn, fct, &data);
+
+	out->new = data.new;
+	out->uniq = data.num_uniq;
+	out->total = data.total;
+}
+
+void bloomizei_ex3(container_t* const model, DICT* const dict, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, bloomize_stats_t* const out)
+{
+	bloomizei_dual(model, dict, TRUE, uniq, hll, str, len, n, delim, out, counted_add);
+}
+
+void bloomizei_ex4(container_t* const model, DICT* const dict, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, bloomize_stats_t* const out)
+{
+	bloomizei_dual(model, dict, FALSE, uniq, hll, str, len, n, delim, out, count);
+}
+
+
+// removal of n-grams, e.g., from counting bloom filters
+void forgetb_ex(container_t* const model, const char* const str, const size_t len, const size_t n)
+{
+	bloomize_t data;
+	data.model = model;
+	data.weights = NULL;
+
+	if (container_hashes_tokens(model))
+	{
+		extract_bitgrams_hashed(str, len, n, simple_remove_hash, &data);
+		return;
+	}
+	extract_bitgrams(str, len, n, simple_remove, &data);
+}
+
+void forget_ex(container_t* const model, const char* const str, const size_t len, const size_t n)
+{
+	bloomize_t data;
+	data.model = model;
+	data.weights = NULL;
+
+	extract_bytegrams(str, len, n, simple_remove, &data);
 }
 
-void bloomizew_ex3(BLOOM* const bloom1, BLOOM* const bloom2, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, bloomize_stats_t* const out)
+void forgetw_ex(container_t* const model, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim)
 {
-	BLOOMIZE_DUAL(w, bloom1, bloom2, str, len, n, delim, out, counted_add);
+	bloomize_t data;
+	data.model = model;
+	data.weights = NULL;
+
+	extract_wgrams_for(model, str, len, n, delim, simple_remove, &data);
 }
 
-void bloomizew_ex4(BLOOM* const bloom1, BLOOM* const bloom2, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, bloomize_stats_t* const out)
+void forgeti_ex(container_t* const model, DICT* const dict, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim)
 {
-	BLOOMIZE_DUAL(w, bloom1, bloom2, str, len, n, delim, out, count);
+	bloomize_t data;
+	data.model = model;
+	data.weights = NULL;
+
+	extract_igrams(str, len, n, delim, dict, FALSE, simple_remove, &data);
+}
+
+
+// collecting the n-grams known to a model
+void collectb_ex(const container_t* const model, FPSET* const keys, const char* const str, const size_t len, const size_t n)
+{
+	collect_t data;
+	data.model = model;
+	data.keys = keys;
+
+	extract_bitgrams(str, len, n, collect, &data);
+}
+
+void collect_ex(const container_t* const model, FPSET* const keys, const char* const str, const size_t len, const size_t n)
+{
+	collect_t data;
+	data.model = model;
+	data.keys = keys;
+
+	extract_bytegrams(str, len, n, collect, &data);
+}
+
+void collectw_ex(const container_t* const model, FPSET* const keys, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim)
+{
+	collect_t data;
+	data.model = model;
+	data.keys = keys;
+
+	extract_wgrams_for(model, str, len, n, delim, collect, &data);
+}
+
+void collecti_ex(const container_t* const model, DICT* const dict, FPSET* const keys, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim)
+{
+	collect_t data;
+	data.model = model;
+	data.keys = keys;
+
+	extract_igrams(str, len, n, delim, dict, FALSE, collect, &data);
 }
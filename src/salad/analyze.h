@@ -26,6 +26,9 @@
 #include "util.h"
 
 #include <container/bloom.h>
+#include <container/dict.h>
+#include <container/fpset.h>
+#include <container/hll.h>
 #include <util/vec.h>
 
 #include <stdint.h>
@@ -41,152 +44,173 @@ typedef struct
 	size_t total;
 } bloomize_stats_t;
 
-typedef void (*FN_BLOOMIZE)(bloom_param_t* const p, const char* const str, const size_t len, bloomize_stats_t* const out);
+typedef struct {
+	container_t* const model; ///< The model to check and possibly update
+	FPSET* const uniq;  ///< Tracks the n-grams of a single string
+	HLL* const hll;     ///< Estimates the number of distinct n-grams overall (optional)
+	const size_t n;     ///< n-gram length
+	const delimiter_array_t delim;
+	DICT* const tokens; ///< The dictionary of interned tokens (optional)
+} bloomize_param_t;
+
+typedef void (*FN_BLOOMIZE)(bloomize_param_t* const p, const char* const str, const size_t len, bloomize_stats_t* const out);
 
 /**
  * Extract bit n-grams from the specified input string in order
- * to populate the given bloom filter.
+ * to populate the given model.
  *
- * @param[inout] bloom The bloom filter to be populated.
+ * @param[inout] model The model (e.g., a bloom filter) to be populated.
  * @param[in] str The string to analyze.
  * @param[in] len The length of the string to analyze.
  * @param[in] n The n-gram length to use.
  */
-void bloomizeb_ex (BLOOM* const bloom, const char* const str, const size_t len, const size_t n);
+void bloomizeb_ex (container_t* const model, const char* const str, const size_t len, const size_t n);
 /**
  * Extract bit n-grams from the specified input string in order
- * to populate the given bloom filter. However, only n-grams with
+ * to populate the given model. However, only n-grams with
  * positive weight are added.
  *
- * @param[inout] bloom The bloom filter to be populated.
+ * @param[inout] model The model (e.g., a bloom filter) to be populated.
  * @param[in] str The string to analyze.
  * @param[in] len The length of the string to analyze.
  * @param[in] n The n-gram length to use.
  * @param[in] weights Weight values for particular n-grams.
  */
-void bloomizeb_ex2(BLOOM* const bloom, const char* const str, const size_t len, const size_t n, const vec_t* const weights);
+void bloomizeb_ex2(container_t* const model, const char* const str, const size_t len, const size_t n, const vec_t* const weights);
 /**
  * Extract bit n-grams from the specified input string in order
- * to populate the first bloom filter. The second bloom filter
- * is cleared and used to track the 'uniqueness' of n-grams
- * within the given string.
+ * to populate the given model. The set is reset and used
+ * to track the 'uniqueness' of n-grams within the given string.
+ * Unique n-grams are also fed to the HyperLogLog estimator, if
+ * specified, in order to estimate the number of distinct n-grams
+ * across several strings.
  *
- * After checking the first filter, new n-grams are added and
- * counted as 'new' in the statistics. The first bloom filter
- * is updated with each new n-gram, hence new n-grams are counted
- * exactly once.
+ * After checking the model, new n-grams are added and counted
+ * as 'new' in the statistics. The model is updated
+ * with each new n-gram, hence new n-grams are counted exactly once.
  *
  * Additionally, the total number of n-grams is recorded.
  *
- * @param[inout] bloom The bloom filter to be populated.
+ * @param[inout] model The model (e.g., a bloom filter) to be populated.
+ * @param[inout] uniq The set tracking the n-grams of the string.
+ * @param[inout] hll The distinct n-gram estimator or NULL.
  * @param[in] str The string to analyze.
  * @param[in] len The length of the string to analyze.
  * @param[in] n The n-gram length to use.
  * @param[out] out The statistical data collected during execution.
  */
-void bloomizeb_ex3(BLOOM* const bloom1, BLOOM* const bloom2, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out);
+void bloomizeb_ex3(container_t* const model, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out);
 /**
  * Extract bit n-grams from the specified input string in order
- * to populate the first bloom filter. The second bloom filter
- * is cleared and used to track the 'uniqueness' of n-grams
- * within the given string.
+ * to populate the given model. The set is reset and used
+ * to track the 'uniqueness' of n-grams within the given string.
+ * Unique n-grams are also fed to the HyperLogLog estimator, if
+ * specified, in order to estimate the number of distinct n-grams
+ * across several strings.
  *
- * After checking the first filter, new n-grams are added and
- * counted as 'new' in the statistics. The first bloom filter
- * is updated with each new n-gram, hence new n-grams are counted
- * exactly once.
+ * After checking the model, new n-grams are added and counted
+ * as 'new' in the statistics. The model is updated
+ * with each new n-gram, hence new n-grams are counted exactly once.
  *
  * Additionally, the total number of n-grams is recorded.
  *
- * @param[inout] bloom The bloom filter to be populated.
+ * @param[inout] model The model (e.g., a bloom filter) to be populated.
+ * @param[inout] uniq The set tracking the n-grams of the string.
+ * @param[inout] hll The distinct n-gram estimator or NULL.
  * @param[in] str The string to analyze.
  * @param[in] len The length of the string to analyze.
  * @param[in] n The n-gram length to use.
  * @param[out] out The statistical data collected during execution.
  */
-void bloomizeb_ex4(BLOOM* const bloom1, BLOOM* const bloom2, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out);
+void bloomizeb_ex4(container_t* const model, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out);
 
 /**
  * Extract byte n-grams from the specified input string in order
- * to populate the given bloom filter.
+ * to populate the given model.
  *
- * @param[inout] bloom The bloom filter to be populated.
+ * @param[inout] model The model (e.g., a bloom filter) to be populated.
  * @param[in] str The string to analyze.
  * @param[in] len The length of the string to analyze.
  * @param[in] n The n-gram length to use.
  */
-void bloomize_ex (BLOOM* const bloom, const char* const str, const size_t len, const size_t n);
+void bloomize_ex (container_t* const model, const char* const str, const size_t len, const size_t n);
 /**
  * Extract byte n-grams from the specified input string in order
- * to populate the given bloom filter. However, only n-grams with
+ * to populate the given model. However, only n-grams with
  * positive weight are added.
  *
- * @param[inout] bloom The bloom filter to be populated.
+ * @param[inout] model The model (e.g., a bloom filter) to be populated.
  * @param[in] str The string to analyze.
  * @param[in] len The length of the string to analyze.
  * @param[in] n The n-gram length to use.
  * @param[in] weights Weight values for particular n-grams.
  */
-void bloomize_ex2(BLOOM* const bloom, const char* const str, const size_t len, const size_t n, const vec_t* const weights);
+void bloomize_ex2(container_t* const model, const char* const str, const size_t len, const size_t n, const vec_t* const weights);
 /**
  * Extract byte n-grams from the specified input string in order
- * to populate the first bloom filter. The second bloom filter
- * is cleared and used to track the 'uniqueness' of n-grams
- * within the given string.
+ * to populate the given model. The set is reset and used
+ * to track the 'uniqueness' of n-grams within the given string.
+ * Unique n-grams are also fed to the HyperLogLog estimator, if
+ * specified, in order to estimate the number of distinct n-grams
+ * across several strings.
  *
- * After checking the first filter, new n-grams are added and
- * counted as 'new' in the statistics. The first bloom filter
- * is updated with each new n-gram, hence new n-grams are counted
- * exactly once.
+ * After checking the model, new n-grams are added and counted
+ * as 'new' in the statistics. The model is updated
+ * with each new n-gram, hence new n-grams are counted exactly once.
  *
  * Additionally, the total number of n-grams is recorded.
  *
- * @param[inout] bloom The bloom filter to be populated.
+ * @param[inout] model The model (e.g., a bloom filter) to be populated.
+ * @param[inout] uniq The set tracking the n-grams of the string.
+ * @param[inout] hll The distinct n-gram estimator or NULL.
  * @param[in] str The string to analyze.
  * @param[in] len The length of the string to analyze.
  * @param[in] n The n-gram length to use.
  * @param[out] out The statistical data collected during execution.
  */
-void bloomize_ex3(BLOOM* const bloom1, BLOOM* const bloom2, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out);
+void bloomize_ex3(container_t* const model, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out);
 /**
  * Extract byte n-grams from the specified input string in order
- * to populate the first bloom filter. The second bloom filter
- * is cleared and used to track the 'uniqueness' of n-grams
- * within the given string.
+ * to populate the given model. The set is reset and used
+ * to track the 'uniqueness' of n-grams within the given string.
+ * Unique n-grams are also fed to the HyperLogLog estimator, if
+ * specified, in order to estimate the number of distinct n-grams
+ * across several strings.
  *
- * After checking the first filter, new n-grams are added and
- * counted as 'new' in the statistics. The first bloom filter
- * is updated with each new n-gram, hence new n-grams are counted
- * exactly once.
+ * After checking the model, new n-grams are added and counted
+ * as 'new' in the statistics. The model is updated
+ * with each new n-gram, hence new n-grams are counted exactly once.
  *
  * Additionally, the total number of n-grams is recorded.
  *
- * @param[inout] bloom The bloom filter to be populated.
+ * @param[inout] model The model (e.g., a bloom filter) to be populated.
+ * @param[inout] uniq The set tracking the n-grams of the string.
+ * @param[inout] hll The distinct n-gram estimator or NULL.
  * @param[in] str The string to analyze.
  * @param[in] len The length of the string to analyze.
  * @param[in] n The n-gram length to use.
  * @param[out] out The statistical data collected during execution.
  */
-void bloomize_ex4(BLOOM* const bloom1, BLOOM* const bloom2, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out);
+void bloomize_ex4(container_t* const model, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, bloomize_stats_t* const out);
 
 /**
  * Extract n-grams based on byte tokens from the specified input
- * string in order to populate the given bloom filter.
+ * string in order to populate the given model.
  *
- * @param[inout] bloom The bloom filter to be populated.
+ * @param[inout] model The model (e.g., a bloom filter) to be populated.
  * @param[in] str The string to analyze.
  * @param[in] len The length of the string to analyze.
  * @param[in] n The n-gram length to use.
  * @param[in] delim The delimiter to use for splitting the input
  *                  in tokens.
  */
-void bloomizew_ex (BLOOM* const bloom, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim);
+void bloomizew_ex (container_t* const model, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim);
 /**
  * Extract n-grams based on byte tokens from the specified input
- * string in order to populate the given bloom filter. However,
+ * string in order to populate the given model. However,
  * only n-grams with positive weight are added.
  *
- * @param[inout] bloom The bloom filter to be populated.
+ * @param[inout] model The model (e.g., a bloom filter) to be populated.
  * @param[in] str The string to analyze.
  * @param[in] len The length of the string to analyze.
  * @param[in] n The n-gram length to use.
@@ -194,21 +218,24 @@ void bloomizew_ex (BLOOM* const bloom, const char* const str, const size_t len,
  *                  in tokens.
  * @param[in] weights Weight values for particular n-grams.
  */
-void bloomizew_ex2(BLOOM* const bloom, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, const vec_t* const weights);
+void bloomizew_ex2(container_t* const model, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, const vec_t* const weights);
 /**
  * Extract n-grams based on byte tokens from the specified input
- * string in order to populate the first bloom filter. The second
- * bloom filter is cleared and used to track the 'uniqueness' of
- * n-grams within the given string.
+ * string in order to populate the given model. The set is
+ * reset and used to track the 'uniqueness' of n-grams within the
+ * given string. Unique n-grams are also fed to the HyperLogLog
+ * estimator, if specified, in order to estimate the number of
+ * distinct n-grams across several strings.
  *
- * After checking the first filter, new n-grams are added and
- * counted as 'new' in the statistics. The first bloom filter
- * is updated with each new n-gram, hence new n-grams are counted
- * exactly once.
+ * After checking the model, new n-grams are added and counted
+ * as 'new' in the statistics. The model is updated
+ * with each new n-gram, hence new n-grams are counted exactly once.
  *
  * Additionally, the total number of n-grams is recorded.
  *
- * @param[inout] bloom The bloom filter to be populated.
+ * @param[inout] model The model (e.g., a bloom filter) to be populated.
+ * @param[inout] uniq The set tracking the n-grams of the string.
+ * @param[inout] hll The distinct n-gram estimator or NULL.
  * @param[in] str The string to analyze.
  * @param[in] len The length of the string to analyze.
  * @param[in] n The n-gram length to use.
@@ -216,29 +243,187 @@ void bloomizew_ex2(BLOOM* const bloom, const char* const str, const size_t len,
  *                  in tokens.
  * @param[out] out The statistical data collected during execution.
  */
-void bloomizew_ex3(BLOOM* const bloom1, BLOOM* const bloom2, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, bloomize_stats_t* const out);
+void bloomizew_ex3(container_t* const model, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, bloomize_stats_t* const out);
 /**
  * Extract n-grams based on byte tokens from the specified input
- * string in order to populate the first bloom filter. The second
- * bloom filter is cleared and used to track the 'uniqueness' of
- * n-grams within the given string.
+ * string in order to populate the given model. The set is
+ * reset and used to track the 'uniqueness' of n-grams within the
+ * given string. Unique n-grams are also fed to the HyperLogLog
+ * estimator, if specified, in order to estimate the number of
+ * distinct n-grams across several strings.
  *
- * After checking the first filter, new n-grams are added and
- * counted as 'new' in the statistics. The first bloom filter
- * is updated with each new n-gram, hence new n-grams are counted
- * exactly once.
+ * After checking the model, new n-grams are added and counted
+ * as 'new' in the statistics. The model is updated
+ * with each new n-gram, hence new n-grams are counted exactly once.
  *
  * Additionally, the total number of n-grams is recorded.
  *
- * @param[inout] bloom The bloom filter to be populated.
+ * @param[inout] model The model (e.g., a bloom filter) to be populated.
+ * @param[inout] uniq The set tracking the n-grams of the string.
+ * @param[inout] hll The distinct n-gram estimator or NULL.
  * @param[in] str The string to analyze.
  * @param[in] len The length of the string to analyze.
  * @param[in] n The n-gram length to use.
  * @param[out] out The statistical data collected during execution.
  */
-void bloomizew_ex4(BLOOM* const bloom1, BLOOM* const bloom2, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, bloomize_stats_t* const out);
+void bloomizew_ex4(container_t* const model, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, bloomize_stats_t* const out);
 
+/**
+ * Extract n-grams based on interned tokens from the specified input
+ * string in order to populate the given model. Tokens that are not
+ * part of the dictionary yet are added to it.
+ *
+ * @param[inout] model The model (e.g., a bloom filter) to be populated.
+ * @param[inout] dict The dictionary of interned tokens.
+ * @param[in] str The string to analyze.
+ * @param[in] len The length of the string to analyze.
+ * @param[in] n The n-gram length to use.
+ * @param[in] delim The delimiter to use for splitting the input
+ *                  in tokens.
+ */
+void bloomizei_ex (container_t* const model, DICT* const dict, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim);
+/**
+ * Extract n-grams based on interned tokens from the specified input
+ * string in order to populate the given model and collect statistics
+ * as bloomizew_ex3 does. Tokens that are not part of the dictionary
+ * yet are added to it.
+ *
+ * @param[inout] model The model (e.g., a bloom filter) to be populated.
+ * @param[inout] dict The dictionary of interned tokens.
+ * @param[inout] uniq The set tracking the n-grams of the string.
+ * @param[inout] hll The distinct n-gram estimator or NULL.
+ * @param[in] str The string to analyze.
+ * @param[in] len The length of the string to analyze.
+ * @param[in] n The n-gram length to use.
+ * @param[in] delim The delimiter to use for splitting the input
+ *                  in tokens.
+ * @param[out] out The statistical data collected during execution.
+ */
+void bloomizei_ex3(container_t* const model, DICT* const dict, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, bloomize_stats_t* const out);
+/**
+ * Extract n-grams based on interned tokens from the specified input
+ * string and collect statistics as bloomizew_ex4 does. Neither the
+ * model nor the dictionary are modified.
+ *
+ * @param[in] model The model (e.g., a bloom filter) to check against.
+ * @param[in] dict The dictionary of interned tokens.
+ * @param[inout] uniq The set tracking the n-grams of the string.
+ * @param[inout] hll The distinct n-gram estimator or NULL.
+ * @param[in] str The string to analyze.
+ * @param[in] len The length of the string to analyze.
+ * @param[in] n The n-gram length to use.
+ * @param[in] delim The delimiter to use for splitting the input
+ *                  in tokens.
+ * @param[out] out The statistical data collected during execution.
+ */
+void bloomizei_ex4(container_t* const model, DICT* const dict, FPSET* const uniq, HLL* const hll, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, bloomize_stats_t* const out);
+
+/**
+ * Extract bit n-grams from the specified input string in order to
+ * remove them from the given model. N-grams that are
+ * not contained in the filter are skipped.
+ *
+ * @param[inout] model The model to be updated. It needs to support
+ *                     removal, e.g., a counting bloom filter.
+ * @param[in] str The string to analyze.
+ * @param[in] len The length of the string to analyze.
+ * @param[in] n The n-gram length to use.
+ */
+void forgetb_ex(container_t* const model, const char* const str, const size_t len, const size_t n);
+/**
+ * Extract byte n-grams from the specified input string in order to
+ * remove them from the given model. N-grams that are
+ * not contained in the filter are skipped.
+ *
+ * @param[inout] model The model to be updated. It needs to support
+ *                     removal, e.g., a counting bloom filter.
+ * @param[in] str The string to analyze.
+ * @param[in] len The length of the string to analyze.
+ * @param[in] n The n-gram length to use.
+ */
+void forget_ex (container_t* const model, const char* const str, const size_t len, const size_t n);
+/**
+ * Extract n-grams based on byte tokens from the specified input
+ * string in order to remove them from the given model. N-grams that are not contained in the filter are skipped.
+ *
+ * @param[inout] model The model to be updated. It needs to support
+ *                     removal, e.g., a counting bloom filter.
+ * @param[in] str The string to analyze.
+ * @param[in] len The length of the string to analyze.
+ * @param[in] n The n-gram length to use.
+ * @param[in] delim The delimiter to use for splitting the input
+ *                  in tokens.
+ */
+void forgetw_ex(container_t* const model, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim);
+/**
+ * Extract n-grams based on interned tokens from the specified input
+ * string in order to remove them from the given model. N-grams that
+ * are not contained in the filter are skipped.
+ *
+ * @param[inout] model The model to be updated. It needs to support
+ *                     removal, e.g., a counting bloom filter.
+ * @param[in] dict The dictionary of interned tokens.
+ * @param[in] str The string to analyze.
+ * @param[in] len The length of the string to analyze.
+ * @param[in] n The n-gram length to use.
+ * @param[in] delim The delimiter to use for splitting the input
+ *                  in tokens.
+ */
+void forgeti_ex(container_t* const model, DICT* const dict, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim);
 
+/**
+ * Extract bit n-grams from the specified input string and collect
+ * the hashes of those contained in the given model, e.g., in order
+ * to freeze the model (cf. salad_freeze).
+ *
+ * @param[in] model The model the n-grams are checked against.
+ * @param[inout] keys The set of n-gram hashes to be populated.
+ * @param[in] str The string to analyze.
+ * @param[in] len The length of the string to analyze.
+ * @param[in] n The n-gram length to use.
+ */
+void collectb_ex(const container_t* const model, FPSET* const keys, const char* const str, const size_t len, const size_t n);
+/**
+ * Extract byte n-grams from the specified input string and collect
+ * the hashes of those contained in the given model, e.g., in order
+ * to freeze the model (cf. salad_freeze).
+ *
+ * @param[in] model The model the n-grams are checked against.
+ * @param[inout] keys The set of n-gram hashes to be populated.
+ * @param[in] str The string to analyze.
+ * @param[in] len The length of the string to analyze.
+ * @param[in] n The n-gram length to use.
+ */
+void collect_ex (const container_t* const model, FPSET* const keys, const char* const str, const size_t len, const size_t n);
+/**
+ * Extract n-grams based on byte tokens from the specified input
+ * string and collect the hashes of those contained in the given
+ * model, e.g., in order to freeze the model (cf. salad_freeze).
+ *
+ * @param[in] model The model the n-grams are checked against.
+ * @param[inout] keys The set of n-gram hashes to be populated.
+ * @param[in] str The string to analyze.
+ * @param[in] len The length of the string to analyze.
+ * @param[in] n The n-gram length to use.
+ * @param[in] delim The delimiter to use for splitting the input
+ *                  in tokens.
+ */
+void collectw_ex(const container_t* const model, FPSET* const keys, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim);
+/**
+ * Extract n-grams based on interned tokens from the specified input
+ * string and collect the hashes of those contained in the given
+ * model, e.g., in order to freeze the model (cf. salad_freeze).
+ *
+ * @param[in] model The model the n-grams are checked against.
+ * @param[in] dict The dictionary of interned tokens.
+ * @param[inout] keys The set of n-gram hashes to be populated.
+ * @param[in] str The string to analyze.
+ * @param[in] len The length of the string to analyze.
+ * @param[in] n The n-gram length to use.
+ * @param[in] delim The delimiter to use for splitting the input
+ *                  in tokens.
+ */
+void collecti_ex(const container_t* const model, DICT* const dict, FPSET* const keys, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim);
 
 
 // macros for the generic use of the bloomize functions
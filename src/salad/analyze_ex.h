@@ -28,10 +28,11 @@
  * at compilation time. Hence, they will be optimized away and do
  * not influence runtime badly.
  */
-#define BLOOMIZE_EX_(Y, X, bloom1, bloom2, str, len, n, delim, weights, stats)          \
+#define BLOOMIZE_EX_(Y, X, model, uniq, hll, str, len, n, delim, weights, stats)      \
 {	                                                                                    \
-	BLOOM* const BEX_bloom1 = bloom1;                                                   \
-	BLOOM* const BEX_bloom2 = bloom2;                                                   \
+	container_t* const BEX_model = model;                                                   \
+	FPSET* const BEX_uniq = uniq;                                                       \
+	HLL* const BEX_hll = hll;                                                           \
 	const char* const BEX_str = str;                                                    \
 	const size_t BEX_len = len;                                                         \
 	const size_t BEX_n = n;                                                             \
@@ -45,16 +46,16 @@
 		switch (Y)                                                                      \
 		{	                                                                            \
 		case 2:                                                                         \
-			bloomizeb_ex2(BEX_bloom1, BEX_str, BEX_len, BEX_n, BEX_weights);            \
+			bloomizeb_ex2(BEX_model, BEX_str, BEX_len, BEX_n, BEX_weights);            \
 			break;                                                                      \
 		case 3:                                                                         \
-			bloomizeb_ex3(BEX_bloom1, BEX_bloom2, BEX_str, BEX_len, BEX_n, BEX_stats);  \
+			bloomizeb_ex3(BEX_model, BEX_uniq, BEX_hll, BEX_str, BEX_len, BEX_n, BEX_stats);  \
 			break;                                                                      \
 		case 4:                                                                         \
-			bloomizeb_ex4(BEX_bloom1, BEX_bloom2, BEX_str, BEX_len, BEX_n, BEX_stats);  \
+			bloomizeb_ex4(BEX_model, BEX_uniq, BEX_hll, BEX_str, BEX_len, BEX_n, BEX_stats);  \
 			break;                                                                      \
 		default:                                                                        \
-			bloomizeb_ex(BEX_bloom1, BEX_str, BEX_len, BEX_n);                          \
+			bloomizeb_ex(BEX_model, BEX_str, BEX_len, BEX_n);                          \
 			break;                                                                      \
 		}	                                                                            \
 		break;                                                                          \
@@ -62,16 +63,16 @@
 		switch (Y)                                                                      \
 		{	                                                                            \
 		case 2:                                                                         \
-			bloomizew_ex2(BEX_bloom1, BEX_str, BEX_len, BEX_n, BEX_delim, BEX_weights); \
+			bloomizew_ex2(BEX_model, BEX_str, BEX_len, BEX_n, BEX_delim, BEX_weights); \
 			break;                                                                      \
 		case 3:                                                                         \
-			bloomizew_ex3(BEX_bloom1, BEX_bloom2, BEX_str, BEX_len, BEX_n, BEX_delim, BEX_stats); \
+			bloomizew_ex3(BEX_model, BEX_uniq, BEX_hll, BEX_str, BEX_len, BEX_n, BEX_delim, BEX_stats); \
 			break;                                                                      \
 		case 4:                                                                         \
-			bloomizew_ex4(BEX_bloom1, BEX_bloom2, BEX_str, BEX_len, BEX_n, BEX_delim, BEX_stats); \
+			bloomizew_ex4(BEX_model, BEX_uniq, BEX_hll, BEX_str, BEX_len, BEX_n, BEX_delim, BEX_stats); \
 			break;                                                                      \
 		default:                                                                        \
-			bloomizew_ex(BEX_bloom1, BEX_str, BEX_len, BEX_n, BEX_delim);               \
+			bloomizew_ex(BEX_model, BEX_str, BEX_len, BEX_n, BEX_delim);               \
 			break;                                                                      \
 		}	                                                                            \
 		break;                                                                          \
@@ -79,15 +80,16 @@
 		switch (Y)                                                                      \
 		{	                                                                            \
 		case 2:                                                                         \
-			bloomize_ex2(BEX_bloom1, BEX_str, BEX_len, BEX_n, BEX_weights);             \
+			bloomize_ex2(BEX_model, BEX_str, BEX_len, BEX_n, BEX_weights);             \
+			break;                                                                      \
 		case 3:                                                                         \
-			bloomize_ex3(BEX_bloom1, BEX_bloom2, BEX_str, BEX_len, BEX_n, BEX_stats);   \
+			bloomize_ex3(BEX_model, BEX_uniq, BEX_hll, BEX_str, BEX_len, BEX_n, BEX_stats);   \
 			break;                                                                      \
 		case 4:                                                                         \
-			bloomize_ex4(BEX_bloom1, BEX_bloom2, BEX_str, BEX_len, BEX_n, BEX_stats);   \
+			bloomize_ex4(BEX_model, BEX_uniq, BEX_hll, BEX_str, BEX_len, BEX_n, BEX_stats);   \
 			break;                                                                      \
 		default:                                                                        \
-			bloomize_ex(BEX_bloom1, BEX_str, BEX_len, BEX_n);                           \
+			bloomize_ex(BEX_model, BEX_str, BEX_len, BEX_n);                           \
 			break;                                                                      \
 		}	                                                                            \
 		break;                                                                          \
@@ -97,33 +99,33 @@
 /**
  * A generic macro for the call of the bloomize<X>_ex functions.
  */
-#define BLOOMIZE_EX(X, bloom, str, len, n, delim)                                       \
+#define BLOOMIZE_EX(X, model, str, len, n, delim)                                       \
 {	                                                                                    \
-	BLOOMIZE_EX_(1, (X), (bloom), (NULL), (str), (len), (n), (delim), NULL, NULL);      \
+	BLOOMIZE_EX_(1, (X), (model), NULL, NULL, (str), (len), (n), (delim), NULL, NULL);  \
 }
 
 /**
  * A generic macro for the call of the bloomize<X>_ex2 functions.
  */
-#define BLOOMIZE_EX2(X, bloom, str, len, n, delim, weights)                             \
+#define BLOOMIZE_EX2(X, model, str, len, n, delim, weights)                             \
 {	                                                                                    \
-	BLOOMIZE_EX_(2, (X), (bloom), (NULL), (str), (len), (n), (delim), (weights), NULL); \
+	BLOOMIZE_EX_(2, (X), (model), NULL, NULL, (str), (len), (n), (delim), (weights), NULL); \
 }
 
 /**
  * A generic macro for the call of the bloomize<X>_ex3 functions.
  */
-#define BLOOMIZE_EX3(X, bloom, bloom2, str, len, n, delim, stats)                       \
+#define BLOOMIZE_EX3(X, model, uniq, hll, str, len, n, delim, stats)                   \
 {	                                                                                    \
-	BLOOMIZE_EX_(3, (X), (bloom), (bloom2), (str), (len), (n), (delim), NULL, (stats)); \
+	BLOOMIZE_EX_(3, (X), (model), (uniq), (hll), (str), (len), (n), (delim), NULL, (stats)); \
 }
 
 /**
  * A generic macro for the call of the bloomize<X>_ex4 functions.
  */
-#define BLOOMIZE_EX4(X, bloom, bloom2, str, len, n, delim, stats)                       \
+#define BLOOMIZE_EX4(X, model, uniq, hll, str, len, n, delim, stats)                   \
 {	                                                                                    \
-	BLOOMIZE_EX_(4, (X), (bloom), (bloom2), (str), (len), (n), (delim), NULL, (stats)); \
+	BLOOMIZE_EX_(4, (X), (model), (uniq), (hll), (str), (len), (n), (delim), NULL, (stats)); \
 }
 
 #endif /* SALAD_ANALYZE_EX_H_ */
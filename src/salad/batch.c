@@ -0,0 +1,257 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "salad.h"
+#include "common.h"
+#include "classify.h"
+#include "util.h"
+
+#include <util/util.h>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+// The number of strings a thread claims at once
+#define BATCH_CHUNK 16
+// The upper bound for the threads of the pool, cf. batch_pool_grow
+#define BATCH_MAX_THREADS 256
+
+
+struct salad_handle
+{
+	FN_CLASSIFIER fct;
+	model_param_t param;
+};
+
+salad_handle_t* const salad_handle_create(const salad_t* const s)
+{
+	assert(s != NULL);
+
+	container_t* const model = TO_CONTAINER(s->model);
+	if (model == NULL || s->data == NULL)
+	{
+		return NULL;
+	}
+
+	salad_handle_t* const h = (salad_handle_t*) malloc(sizeof(salad_handle_t));
+	if (h == NULL)
+	{
+		return NULL;
+	}
+
+	// Same as salad_predict_ex, an interleaved model holds both classes
+	const int two_class = (model->type == CONTAINER_TWOCLASSBLOOMFILTER);
+	h->fct = pick_classifier(to_model_type(s->as_binary, _(s)->use_tokens, _(s)->tokens != NULL), !two_class);
+
+	const model_param_t p = {model, (two_class ? model : NULL), s->ngram_length, _(s)->delimiter.d, _(s)->tokens, NULL};
+	memcpy(&h->param, &p, sizeof(model_param_t));
+	return h;
+}
+
+void salad_handle_destroy(salad_handle_t* const h)
+{
+	free(h);
+}
+
+
+// Every thread owns a range of the strings. Both, the owner and the other
+// threads claim chunks from its front, such that a range is processed at
+// most once no matter who gets to it.
+typedef struct
+{
+	size_t next;
+	size_t end;
+	uint8_t padding[64 -2*sizeof(size_t)]; // One cache line per range
+} batch_range_t;
+
+typedef struct batch
+{
+	const salad_handle_t* h;
+	const salad_view_t* views;
+	double* out;
+
+	batch_range_t* ranges;
+	size_t num;
+
+	// Guarded by the lock of the pool, cf. batch_pool_t
+	int open;      // Whether or not threads may still join in
+	size_t users;  // The threads of the pool that are working on it
+	struct batch* next;
+} batch_t;
+
+// Threads that are started once and sleep while there is nothing to do.
+// Batches of concurrent callers are queued, and every thread helps out with
+// the first one that still has strings left and asks for that many threads.
+typedef struct
+{
+	pthread_mutex_t lock;
+	pthread_cond_t wake;  // Signaled for every new batch
+	pthread_cond_t idle;  // Signaled once a batch has no users anymore
+	batch_t* head;
+	size_t num;
+} batch_pool_t;
+
+static batch_pool_t pool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, 0};
+
+
+static const int batch_claim(batch_range_t* const r, size_t* const from, size_t* const to)
+{
+	const size_t x = __atomic_fetch_add(&r->next, BATCH_CHUNK, __ATOMIC_RELAXED);
+	if (x >= r->end)
+	{
+		return FALSE;
+	}
+
+	*from = x;
+	*to = MIN(x +BATCH_CHUNK, r->end);
+	return TRUE;
+}
+
+static void batch_work(const batch_t* const b, const size_t id)
+{
+	// The classifiers only read the model, cf. salad_handle_t
+	model_param_t* const p = (model_param_t*) &b->h->param;
+
+	// The own range first, then those of the others in turn
+	size_t from, to;
+	for (size_t k = 0; k < b->num; k++)
+	{
+		batch_range_t* const r = &b->ranges[(id +k) % b->num];
+		while (batch_claim(r, &from, &to))
+		{
+			for (size_t i = from; i < to; i++)
+			{
+				b->out[i] = b->h->fct(p, b->views[i].buf, b->views[i].len);
+			}
+		}
+	}
+}
+
+// The threads of the pool keep their scratch memory of the n-gram extraction
+// from one batch to the next, cf. ngrams_scratch_free.
+static void* batch_thread(void* const usr)
+{
+	// The calling thread is worker 0, the threads of the pool count from 1
+	const size_t id = (size_t) (uintptr_t) usr;
+
+	pthread_mutex_lock(&pool.lock);
+	for (;;)
+	{
+		batch_t* b = pool.head;
+		while (b != NULL && (!b->open || id >= b->num))
+		{
+			b = b->next;
+		}
+
+		if (b == NULL)
+		{
+			pthread_cond_wait(&pool.wake, &pool.lock);
+			continue;
+		}
+
+		b->users++;
+		pthread_mutex_unlock(&pool.lock);
+
+		batch_work(b, id);
+
+		pthread_mutex_lock(&pool.lock);
+		// All strings are claimed once a single thread runs out of work
+		b->open = FALSE;
+		if (--b->users == 0)
+		{
+			pthread_cond_broadcast(&pool.idle);
+		}
+	}
+	return NULL;
+}
+
+// Starts threads until there are n of them. Fewer threads simply take over
+// the ranges of those that could not be started.
+static void batch_pool_grow(const size_t n)
+{
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+	pthread_t t;
+	while (pool.num < MIN(n, BATCH_MAX_THREADS)
+	       && pthread_create(&t, &attr, batch_thread, (void*) (uintptr_t) (pool.num +1)) == 0)
+	{
+		pool.num++;
+	}
+	pthread_attr_destroy(&attr);
+}
+
+const int salad_predict_batch(const salad_handle_t* const h, const salad_view_t* const views, const size_t n, double* const out, const size_t nthreads)
+{
+	if (h == NULL || h->fct == NULL || (n > 0 && (views == NULL || out == NULL)))
+	{
+		return EXIT_FAILURE;
+	}
+
+	// No more threads than there are chunks
+	const size_t num = MAX(1, MIN(nthreads, (n +BATCH_CHUNK -1)/ BATCH_CHUNK));
+
+	batch_range_t* const ranges = (batch_range_t*) calloc(num, sizeof(batch_range_t));
+	if (ranges == NULL)
+	{
+		return EXIT_FAILURE;
+	}
+
+	batch_t b = {h, views, out, ranges, num, TRUE, 0, NULL};
+	for (size_t k = 0; k < num; k++)
+	{
+		ranges[k].next = k *n/ num;
+		ranges[k].end = (k +1) *n/ num;
+	}
+
+	if (num == 1)
+	{
+		batch_work(&b, 0);
+		free(ranges);
+		return EXIT_SUCCESS;
+	}
+
+	// The calling thread is the first worker
+	pthread_mutex_lock(&pool.lock);
+	batch_pool_grow(num -1);
+
+	batch_t** tail = &pool.head;
+	while (*tail != NULL) tail = &(*tail)->next;
+	*tail = &b;
+
+	pthread_cond_broadcast(&pool.wake);
+	pthread_mutex_unlock(&pool.lock);
+
+	batch_work(&b, 0);
+
+	// Threads that are still scoring their last chunk are waited for
+	pthread_mutex_lock(&pool.lock);
+	b.open = FALSE;
+	for (tail = &pool.head; *tail != &b; tail = &(*tail)->next);
+	*tail = b.next;
+
+	while (b.users > 0)
+	{
+		pthread_cond_wait(&pool.idle, &pool.lock);
+	}
+	pthread_mutex_unlock(&pool.lock);
+
+	free(ranges);
+	return EXIT_SUCCESS;
+}
@@ -20,14 +20,15 @@
 #include "ngrams.h"
 
 #include <stdlib.h>
+#include <string.h>
 
-const model_type_t to_model_type(const int as_binary, const int use_tokens)
+const model_type_t to_model_type(const int as_binary, const int use_tokens, const int intern_tokens)
 {
 	if (as_binary) {
 		return BIT_NGRAM;
 
 	} else if (use_tokens) {
-		return TOKEN_NGRAM;
+		return (intern_tokens ? TOKENID_NGRAM : TOKEN_NGRAM);
 
 	} else {
 		return BYTE_NGRAM;
@@ -37,7 +38,7 @@ const model_type_t to_model_type(const int as_binary, const int use_tokens)
 
 typedef struct
 {
-	BLOOM* bloom;
+	const container_t* model;
 	unsigned int num_known;
 	unsigned int num_ngrams;
 
@@ -48,27 +49,36 @@ static inline void check(const char* const ngram, const size_t len, void* const
 	assert(ngram != NULL && data != NULL);
 	check_t* const d = (check_t*) data;
 
-	if (bloom_check_str(d->bloom, ngram, len)) d->num_known++;
+	if (container_check_str(d->model, ngram, len)) d->num_known++;
 	d->num_ngrams++;
 }
 
-#define CLASSIFY_1CLASS(X, bloom, input, len, n, delim)                     \
+#define CLASSIFY_1CLASS(X, model, input, len, n, delim)                     \
 {	                                                                        \
-	BLOOM* const C1C_bloom = bloom;                                         \
+	container_t* const C1C_model = model;                                     \
 	const char* const C1C_input = input;                                    \
 	const size_t C1C_len = len;                                             \
 	const size_t C1C_n = n;                                                 \
 	const delimiter_array_t C1C_delim = delim;                              \
 	                                                                        \
 	check_t data;                                                           \
-	data.bloom = C1C_bloom;                                                 \
+	data.model = C1C_model;                                                 \
 	data.num_known = 0;                                                     \
 	data.num_ngrams = 0;                                                    \
 	                                                                        \
-	extract_##X##grams(C1C_input, C1C_len, C1C_n, C1C_delim, check, &data); \
+	extract_##X##grams_for(C1C_model, C1C_input, C1C_len, C1C_n, C1C_delim, check, &data); \
 	return ((double) (data.num_ngrams -data.num_known))/ data.num_ngrams;   \
 }
 
+static inline void check_hash(const uint64_t h, void* const data)
+{
+	assert(data != NULL);
+	check_t* const d = (check_t*) data;
+
+	if (container_check_hash(d->model, h)) d->num_known++;
+	d->num_ngrams++;
+}
+
 #define GOOD 0
 #define BAD  1
 
@@ -77,95 +87,270 @@ static inline void check2(const char* const ngram, const size_t len, void* const
 	assert(ngram != NULL && data != NULL);
 	check_t* const d = (check_t*) data;
 
-	if (bloom_check_str(d[GOOD].bloom, ngram, len)) d[GOOD].num_known++;
-	if (bloom_check_str(d[BAD ].bloom, ngram, len)) d[BAD ].num_known++;
+	if (d[GOOD].model->type == CONTAINER_TWOCLASSBLOOMFILTER)
+	{
+		// Both classes are answered by one pass over the hash functions
+		const int x = bloom_check2_str((BLOOM*) d[GOOD].model->data, ngram, len);
+		if (x & BLOOM_GOOD) d[GOOD].num_known++;
+		if (x & BLOOM_BAD ) d[BAD ].num_known++;
+	}
+	else
+	{
+		if (container_check_str(d[GOOD].model, ngram, len)) d[GOOD].num_known++;
+		if (container_check_str(d[BAD ].model, ngram, len)) d[BAD ].num_known++;
+	}
+
+	d[BAD].num_ngrams++;
+}
+
+static inline void check2_hash(const uint64_t h, void* const data)
+{
+	assert(data != NULL);
+	check_t* const d = (check_t*) data;
+
+	if (d[GOOD].model->type == CONTAINER_TWOCLASSBLOOMFILTER)
+	{
+		const int x = bloom_check2_hash((BLOOM*) d[GOOD].model->data, h);
+		if (x & BLOOM_GOOD) d[GOOD].num_known++;
+		if (x & BLOOM_BAD ) d[BAD ].num_known++;
+	}
+	else
+	{
+		if (container_check_hash(d[GOOD].model, h)) d[GOOD].num_known++;
+		if (container_check_hash(d[BAD ].model, h)) d[BAD ].num_known++;
+	}
 
 	d[BAD].num_ngrams++;
 }
 
-#define CLASSIFY_2CLASS(X, bloom, bbloom, input, len, n, delim)                         \
+#define CLASSIFY_2CLASS(X, model, bmodel, input, len, n, delim)                         \
 {	                                                                                    \
-	BLOOM* const C2C_bloom = bloom;                                                     \
-	BLOOM* const C2C_bbloom = bbloom;                                                   \
+	container_t* const C2C_model = model;                                                 \
+	container_t* const C2C_bmodel = bmodel;                                                 \
 	const char* const C2C_input = input;                                                \
 	const size_t C2C_len = len;                                                         \
 	const size_t C2C_n = n;                                                             \
 	const delimiter_array_t C2C_delim = delim;                                          \
 	                                                                                    \
 	check_t data[2];                                                                    \
-	data[GOOD].bloom = C2C_bloom;                                                       \
+	data[GOOD].model = C2C_model;                                                       \
 	data[GOOD].num_known = 0;                                                           \
 	data[GOOD].num_ngrams = 0;                                                          \
 	                                                                                    \
-	data[BAD].bloom = C2C_bbloom;                                                       \
+	data[BAD].model = C2C_bmodel;                                                       \
 	data[BAD].num_known = 0;                                                            \
 	data[BAD].num_ngrams = 0;                                                           \
 	                                                                                    \
-	extract_##X##grams(C2C_input, C2C_len, C2C_n, C2C_delim, check2, &data);            \
+	extract_##X##grams_for(C2C_model, C2C_input, C2C_len, C2C_n, C2C_delim, check2, &data); \
 	return (((double)data[BAD].num_known) -data[GOOD].num_known)/ data[BAD].num_ngrams; \
 }
 
 // bit n-grams
-const double classify_1class_b_ex(BLOOM* const bloom, const char* const input, const size_t len, const size_t n)
+const double classify_1class_b_ex(container_t* const model, const char* const input, const size_t len, const size_t n)
 {
-	CLASSIFY_1CLASS(b, bloom, input, len, n, NO_DELIMITER);
+	if (container_hashes_tokens(model))
+	{
+		check_t data = {model, 0, 0};
+		extract_bitgrams_hashed(input, len, n, check_hash, &data);
+		return ((double) (data.num_ngrams -data.num_known))/ data.num_ngrams;
+	}
+	CLASSIFY_1CLASS(b, model, input, len, n, NO_DELIMITER);
 }
 
-const double classify_1class_b(bloom_param_t* const p, const char* const input, const size_t len)
+const double classify_1class_b(model_param_t* const p, const char* const input, const size_t len)
 {
-	return classify_1class_b_ex(p->bloom1, input, len, p->n);
+	return classify_1class_b_ex(p->model1, input, len, p->n);
 }
 
-const double classify_2class_b_ex(BLOOM* const bloom, BLOOM* const bbloom, const char* const input, const size_t len, const size_t n)
+const double classify_2class_b_ex(container_t* const model, container_t* const bmodel, const char* const input, const size_t len, const size_t n)
 {
-	CLASSIFY_2CLASS(b, bloom, bbloom, input, len, n, NO_DELIMITER);
+	if (container_hashes_tokens(model))
+	{
+		check_t data[2] = {{model, 0, 0}, {bmodel, 0, 0}};
+		extract_bitgrams_hashed(input, len, n, check2_hash, &data);
+		return (((double)data[BAD].num_known) -data[GOOD].num_known)/ data[BAD].num_ngrams;
+	}
+	CLASSIFY_2CLASS(b, model, bmodel, input, len, n, NO_DELIMITER);
 }
 
-const double classify_2class_b(bloom_param_t* const p, const char* const input, const size_t len)
+const double classify_2class_b(model_param_t* const p, const char* const input, const size_t len)
 {
-	return classify_2class_b_ex(p->bloom1, p->bloom2, input, len, p->n);
+	return classify_2class_b_ex(p->model1, p->model2, input, len, p->n);
 }
 
 // byte n-grams
-const double classify_1class_ex(BLOOM* const bloom, const char* const input, const size_t len, const size_t n)
+const double classify_1class_ex(container_t* const model, const char* const input, const size_t len, const size_t n)
 {
-	CLASSIFY_1CLASS(n, bloom, input, len, n, NO_DELIMITER);
+	if (model->type == CONTAINER_BLOOMFILTER || model->type == CONTAINER_COUNTINGBLOOMFILTER)
+	{
+		const FN_BLOOM_CHECK_BYTEGRAMS kernel = bloom_check_bytegrams_fct((BLOOM*) model->data, n);
+		if (kernel != NULL)
+		{
+			const unsigned int num_ngrams = (unsigned int) (len < n ? 0 : len -n +1);
+			const unsigned int num_known = (unsigned int) kernel((BLOOM*) model->data, input, len);
+			return ((double) (num_ngrams -num_known))/ num_ngrams;
+		}
+	}
+	CLASSIFY_1CLASS(n, model, input, len, n, NO_DELIMITER);
+}
+
+const double classify_1class(model_param_t* const p, const char* const input, const size_t len)
+{
+	return classify_1class_ex(p->model1, input, len, p->n);
+}
+
+// Counts the known byte n-grams rather than returning their ratio, such
+// that the counts of consecutive chunks of a stream can be accumulated.
+const size_t classify_1class_known_ex(container_t* const model, const char* const input, const size_t len, const size_t n)
+{
+	if (model->type == CONTAINER_BLOOMFILTER || model->type == CONTAINER_COUNTINGBLOOMFILTER)
+	{
+		const FN_BLOOM_CHECK_BYTEGRAMS kernel = bloom_check_bytegrams_fct((BLOOM*) model->data, n);
+		if (kernel != NULL)
+		{
+			return kernel((BLOOM*) model->data, input, len);
+		}
+	}
+
+	check_t data = {model, 0, 0};
+	extract_ngrams_for(model, input, len, n, NO_DELIMITER, check, &data);
+	return data.num_known;
 }
 
-const double classify_1class(bloom_param_t* const p, const char* const input, const size_t len)
+// Slides a window of w n-grams over the input and keeps track of the number
+// of unknown n-grams within, such that each n-gram is checked only once.
+const window_t classify_1class_window_ex(container_t* const model, const char* const input, const size_t len, const size_t n, const size_t w)
 {
-	return classify_1class_ex(p->bloom1, input, len, p->n);
+	assert(w > 0);
+	const size_t num_ngrams = (len < n ? 0 : len -n +1);
+	const size_t num = MIN(w, num_ngrams);
+
+	window_t x = {0.0, 0, 0};
+	if (num == 0)
+	{
+		x.score = ((double) 0)/ num_ngrams; // cf. classify_1class_ex
+		x.len = len;
+		return x;
+	}
+
+	// Checking byte n-grams does not touch the scratch memory of the thread
+	unsigned char* const ring = (unsigned char*) ngrams_scratch(num *sizeof(unsigned char));
+	if (ring == NULL)
+	{
+		x.score = classify_1class_ex(model, input, len, n);
+		x.len = len;
+		return x;
+	}
+	memset(ring, 0x00, num *sizeof(unsigned char));
+
+	size_t unknown = 0, max_unknown = 0, j = 0;
+	for (size_t i = 0; i < num_ngrams; i++)
+	{
+		const unsigned char u = !container_check_str(model, input +i, n);
+
+		unknown -= ring[j];
+		unknown += u;
+		ring[j] = u;
+		j = (j +1 == num ? 0 : j +1);
+
+		if (i +1 >= num && unknown > max_unknown)
+		{
+			max_unknown = unknown;
+			x.offset = i +1 -num;
+		}
+	}
+
+	x.score = ((double) max_unknown)/ num;
+	x.len = num +n -1;
+	return x;
 }
 
-const double classify_2class_ex(BLOOM* const bloom, BLOOM* const bbloom, const char* const input, const size_t len, const size_t n)
+const double classify_2class_ex(container_t* const model, container_t* const bmodel, const char* const input, const size_t len, const size_t n)
 {
-	CLASSIFY_2CLASS(n, bloom, bbloom, input, len, n, NO_DELIMITER);
+	CLASSIFY_2CLASS(n, model, bmodel, input, len, n, NO_DELIMITER);
 }
 
-const double classify_2class(bloom_param_t* const p, const char* const input, const size_t len)
+const double classify_2class(model_param_t* const p, const char* const input, const size_t len)
 {
-	return classify_2class_ex(p->bloom1, p->bloom2, input, len, p->n);
+	return classify_2class_ex(p->model1, p->model2, input, len, p->n);
 }
 
 // token/ word n-grams
-const double classify_1class_w_ex(BLOOM* const bloom, const char* const input, const size_t len, const size_t n, const delimiter_array_t delim)
+const double classify_1class_w_ex(container_t* const model, const char* const input, const size_t len, const size_t n, const delimiter_array_t delim)
+{
+	CLASSIFY_1CLASS(w, model, input, len, n, delim);
+}
+
+const double classify_1class_w(model_param_t* const p, const char* const input, const size_t len)
+{
+	return classify_1class_w_ex(p->model1, input, len, p->n, p->delim);
+}
+
+const size_t classify_1class_w_known_ex(container_t* const model, const char* const input, const size_t len, const size_t n, const delimiter_array_t delim, size_t* const num)
 {
-	CLASSIFY_1CLASS(w, bloom, input, len, n, delim);
+	check_t data = {model, 0, 0};
+	extract_wgrams_for(model, input, len, n, delim, check, &data);
+
+	*num = data.num_ngrams;
+	return data.num_known;
 }
 
-const double classify_1class_w(bloom_param_t* const p, const char* const input, const size_t len)
+const double classify_2class_w_ex(container_t* const model, container_t* const bmodel, const char* const input, const size_t len, const size_t n, const delimiter_array_t delim)
 {
-	return classify_1class_w_ex(p->bloom1, input, len, p->n, p->delim);
+	CLASSIFY_2CLASS(w, model, bmodel, input, len, n, delim);
 }
 
-const double classify_2class_w_ex(BLOOM* const bloom, BLOOM* const bbloom, const char* const input, const size_t len, const size_t n, const delimiter_array_t delim)
+const double classify_2class_w(model_param_t* const p, const char* const input, const size_t len)
 {
-	CLASSIFY_2CLASS(w, bloom, bbloom, input, len, n, delim);
+	return classify_2class_w_ex(p->model1, p->model2, input, len, p->n, p->delim);
 }
 
-const double classify_2class_w(bloom_param_t* const p, const char* const input, const size_t len)
+// n-grams of interned tokens
+const double classify_1class_i_ex(container_t* const model, DICT* const dict, const char* const input, const size_t len, const size_t n, const delimiter_array_t delim)
 {
-	return classify_2class_w_ex(p->bloom1, p->bloom2, input, len, p->n, p->delim);
+	check_t data;
+	data.model = model;
+	data.num_known = 0;
+	data.num_ngrams = 0;
+
+	extract_igrams(input, len, n, delim, dict, FALSE, check, &data);
+	return ((double) (data.num_ngrams -data.num_known))/ data.num_ngrams;
+}
+
+const double classify_1class_i(model_param_t* const p, const char* const input, const size_t len)
+{
+	return classify_1class_i_ex(p->model1, p->tokens1, input, len, p->n, p->delim);
+}
+
+const size_t classify_1class_i_known_ex(container_t* const model, DICT* const dict, const char* const input, const size_t len, const size_t n, const delimiter_array_t delim, size_t* const num)
+{
+	check_t data = {model, 0, 0};
+	extract_igrams(input, len, n, delim, dict, FALSE, check, &data);
+
+	*num = data.num_ngrams;
+	return data.num_known;
+}
+
+const double classify_2class_i_ex(container_t* const model, DICT* const dict, container_t* const bmodel, DICT* const bdict, const char* const input, const size_t len, const size_t n, const delimiter_array_t delim)
+{
+	// Each model has a dictionary of its own, hence, the ids differ
+	check_t data[2];
+	data[GOOD].model = model;
+	data[GOOD].num_known = 0;
+	data[GOOD].num_ngrams = 0;
+
+	data[BAD].model = bmodel;
+	data[BAD].num_known = 0;
+	data[BAD].num_ngrams = 0;
+
+	extract_igrams(input, len, n, delim, dict, FALSE, check, &data[GOOD]);
+	extract_igrams(input, len, n, delim, bdict, FALSE, check, &data[BAD]);
+	return (((double)data[BAD].num_known) -data[GOOD].num_known)/ data[BAD].num_ngrams;
+}
+
+const double classify_2class_i(model_param_t* const p, const char* const input, const size_t len)
+{
+	return classify_2class_i_ex(p->model1, p->tokens1, p->model2, p->tokens2, input, len, p->n, p->delim);
 }
 
 
@@ -182,6 +367,9 @@ FN_CLASSIFIER pick_classifier(const model_type_t t, const int anomaly_detection)
 
 	case TOKEN_NGRAM:
 		return (anomaly_detection ? classify_1class_w : classify_2class_w);
+
+	case TOKENID_NGRAM:
+		return (anomaly_detection ? classify_1class_i : classify_2class_i);
 	}
 	return NULL;
 }
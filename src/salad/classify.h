@@ -26,20 +26,36 @@
 #include "util.h"
 
 
-typedef enum { BIT_NGRAM, BYTE_NGRAM, TOKEN_NGRAM } model_type_t;
-const model_type_t to_model_type(const int as_binary, const int use_tokens);
+typedef enum { BIT_NGRAM, BYTE_NGRAM, TOKEN_NGRAM, TOKENID_NGRAM } model_type_t;
+const model_type_t to_model_type(const int as_binary, const int use_tokens, const int intern_tokens);
 
 
-typedef const double (*FN_CLASSIFIER)(bloom_param_t* const p, const char* const input, const size_t len);
+typedef const double (*FN_CLASSIFIER)(model_param_t* const p, const char* const input, const size_t len);
 
-const double classify_1class_b_ex(BLOOM* const bloom, const char* const input, const size_t len, const size_t n);
-const double classify_2class_b_ex(BLOOM* const bloom, BLOOM* const bbloom, const char* const input, const size_t len, const size_t n);
+const double classify_1class_b_ex(container_t* const model, const char* const input, const size_t len, const size_t n);
+const double classify_2class_b_ex(container_t* const model, container_t* const bmodel, const char* const input, const size_t len, const size_t n);
 
-const double classify_1class_ex  (BLOOM* const bloom, const char* const input, const size_t len, const size_t n);
-const double classify_2class_ex  (BLOOM* const bloom, BLOOM* const bbloom, const char* const input, const size_t len, const size_t n);
+const double classify_1class_ex  (container_t* const model, const char* const input, const size_t len, const size_t n);
+const double classify_2class_ex  (container_t* const model, container_t* const bmodel, const char* const input, const size_t len, const size_t n);
 
-const double classify_1class_w_ex(BLOOM* const bloom, const char* const input, const size_t len, const size_t n, const delimiter_array_t delim);
-const double classify_2class_w_ex(BLOOM* const bloom, BLOOM* const bbloom, const char* const input, const size_t len, const size_t n, const delimiter_array_t delim);
+const size_t classify_1class_known_ex(container_t* const model, const char* const input, const size_t len, const size_t n);
+const size_t classify_1class_w_known_ex(container_t* const model, const char* const input, const size_t len, const size_t n, const delimiter_array_t delim, size_t* const num);
+const size_t classify_1class_i_known_ex(container_t* const model, DICT* const dict, const char* const input, const size_t len, const size_t n, const delimiter_array_t delim, size_t* const num);
+
+typedef struct
+{
+	double score;  // Highest ratio of unknown n-grams within a window
+	size_t offset; // Byte offset of that window
+	size_t len;    // Length of that window in bytes
+} window_t;
+
+const window_t classify_1class_window_ex(container_t* const model, const char* const input, const size_t len, const size_t n, const size_t w);
+
+const double classify_1class_w_ex(container_t* const model, const char* const input, const size_t len, const size_t n, const delimiter_array_t delim);
+const double classify_2class_w_ex(container_t* const model, container_t* const bmodel, const char* const input, const size_t len, const size_t n, const delimiter_array_t delim);
+
+const double classify_1class_i_ex(container_t* const model, DICT* const dict, const char* const input, const size_t len, const size_t n, const delimiter_array_t delim);
+const double classify_2class_i_ex(container_t* const model, DICT* const dict, container_t* const bmodel, DICT* const bdict, const char* const input, const size_t len, const size_t n, const delimiter_array_t delim);
 
 
 FN_CLASSIFIER pick_classifier(const model_type_t t, const int anomaly_detection);
@@ -23,6 +23,7 @@
 #define SALAD_COMMON_H_
 
 #include <util/config.h>
+#include <container/dict.h>
 
 #include <stddef.h>
 #include <stdint.h>
@@ -69,12 +70,14 @@ typedef struct
 {
 	int use_tokens; //!< Whether or not to use word/ token n-grams rather than byte/ bit n-grams.
 	delimiter_t delimiter; //!< The delimiter of the tokens in case token n-grams are used.
+	DICT* tokens; //!< The dictionary of interned tokens in case they are represented by ids.
 } saladcontext_t;
 
 
 #define EMPTY_SALAD_CONTEXT_INITIALIZER { \
 		.use_tokens= 0, \
-		.delimiter = EMPTY_DELIMITER_INITIALIZER \
+		.delimiter = EMPTY_DELIMITER_INITIALIZER, \
+		.tokens = NULL \
 }
 
 #define _(s)  ((saladcontext_t*) (s)->data)
@@ -25,11 +25,14 @@
 
 const hashset_t to_hashset(const char* const str)
 {
-	switch (cmp(str, "simple", "simple2", "murmur", NULL))
+	switch (cmp(str, "simple", "simple2", "murmur", "mix", "direct", "crc", NULL))
 	{
 	case 0: return HASHES_SIMPLE;
 	case 1: return HASHES_SIMPLE2;
 	case 2: return HASHES_MURMUR;
+	case 3: return HASHES_MIX;
+	case 4: return HASHES_DIRECT;
+	case 5: return HASHES_CRC;
 	default: break;
 	}
 
@@ -43,6 +46,9 @@ const char* const hashset_to_string(hashset_t hs)
 	case HASHES_SIMPLE: return "simple";
 	case HASHES_SIMPLE2: return "simple2";
 	case HASHES_MURMUR: return "murmur";
+	case HASHES_MIX: return "mix";
+	case HASHES_DIRECT: return "direct";
+	case HASHES_CRC: return "crc";
 	default: break;
 	}
 	return "undefined";
@@ -58,6 +64,13 @@ hashfunc_t HASH_FCTS[NUM_HASHFCTS] =
 	murmur_hash1_n,
 	murmur_hash2_n,
 	djb2_hash_n,
+	mix_hash0_n,
+	mix_hash1_n,
+	mix_hash2_n,
+	direct_hash_n,
+	crc_hash0_n,
+	crc_hash1_n,
+	crc_hash2_n,
 };
 
 const char* const HASH_FCTNAMES[NUM_HASHFCTS +1] =
@@ -65,6 +78,9 @@ const char* const HASH_FCTNAMES[NUM_HASHFCTS +1] =
 		"sax", "sdbm", "djb",
 		"murmur1-0", "murmur1-1", "murmur1-2",
 		"djb2",
+		"mix-0", "mix-1", "mix-2",
+		"direct",
+		"crc32c-0", "crc32c-1", "crc32c-2",
 		NULL // In order to be able to use cmp & cmp2 functions
 };
 
@@ -100,10 +116,8 @@ hashfunc_t to_hashfunc(const char* const str)
 }
 
 
-BLOOM* const bloom_init(const unsigned short size, const hashset_t hs)
+static BLOOM* const bloom_init_ex(BLOOM* const b, const hashset_t hs)
 {
-	assert(size <= sizeof(void*) *8);
-	BLOOM* const b = bloom_create((size_t) POW(2, size));
 	if (b == NULL) return NULL;
 
 	switch (hs)
@@ -120,6 +134,18 @@ BLOOM* const bloom_init(const unsigned short size, const hashset_t hs)
 		bloom_set_hashfuncs_ex(b, HASHSET_MURMUR);
 		break;
 
+	case HASHES_MIX:
+		bloom_set_hashfuncs_ex(b, HASHSET_MIX);
+		break;
+
+	case HASHES_DIRECT:
+		bloom_set_hashfuncs_ex(b, HASHSET_DIRECT);
+		break;
+
+	case HASHES_CRC:
+		bloom_set_hashfuncs_ex(b, HASHSET_CRC);
+		break;
+
 	default:
 		bloom_destroy(b);
 		return NULL;
@@ -127,6 +153,18 @@ BLOOM* const bloom_init(const unsigned short size, const hashset_t hs)
 	return b;
 }
 
+BLOOM* const bloom_init(const unsigned short size, const hashset_t hs)
+{
+	assert(size <= sizeof(void*) *8);
+	return bloom_init_ex(bloom_create((size_t) POW(2, size)), hs);
+}
+
+BLOOM* const bloom_init_counting(const unsigned short size, const hashset_t hs)
+{
+	assert(size <= sizeof(void*) *8);
+	return bloom_init_ex(bloom_create_counting((size_t) POW(2, size)), hs);
+}
+
 const int bloomfct_equal(BLOOM* const bloom, hashfunc_t* const funcs, const uint8_t nfuncs)
 {
 	for (uint8_t i = 0; i < nfuncs; i++)
@@ -156,5 +194,29 @@ const int bloomfct_cmp(BLOOM* const bloom, ...)
 			return i;
 		}
 	}
+	va_end(args);
 	return -1;
 }
+
+const hashset_t bloom_hashset(const BLOOM* const bloom)
+{
+	assert(bloom != NULL);
+	const int i = bloomfct_cmp((BLOOM*) bloom, HASHSET_SIMPLE, HASHSET_SIMPLE2, HASHSET_MURMUR, HASHSET_MIX, HASHSET_DIRECT, HASHSET_CRC, NULL);
+
+	switch (i)
+	{
+	case 0: return HASHES_SIMPLE;
+	case 1: return HASHES_SIMPLE2;
+	case 2: return HASHES_MURMUR;
+	case 3: return HASHES_MIX;
+	case 4: return HASHES_DIRECT;
+	case 5: return HASHES_CRC;
+	}
+	return HASHES_UNDEFINED;
+}
+
+const int bloom_hashes_tokens(const BLOOM* const bloom)
+{
+	assert(bloom != NULL);
+	return (bloom->nfuncs == 3 && bloomfct_equal((BLOOM*) bloom, HASHSET_MIX));
+}
@@ -26,19 +26,23 @@
 #include "hash.h"
 
 
-#define NUM_HASHFCTS 7
+#define NUM_HASHFCTS 14
 extern hashfunc_t HASH_FCTS[NUM_HASHFCTS];
 
 #define HASHSET_SIMPLE (hashfunc_t[]) {sax_hash_n, sdbm_hash_n, djb_hash_n}, 3
 #define HASHSET_SIMPLE2 (hashfunc_t[]) {sax_hash_n, sdbm_hash_n, djb2_hash_n}, 3
 #define HASHSET_MURMUR (hashfunc_t[]) {murmur_hash0_n, murmur_hash1_n, murmur_hash2_n}, 3
+#define HASHSET_MIX (hashfunc_t[]) {mix_hash0_n, mix_hash1_n, mix_hash2_n}, 3
+// Exact for byte n-grams with 8n bits of index at most, i.e., n <= 3 by default
+#define HASHSET_DIRECT (hashfunc_t[]) {direct_hash_n}, 1
+#define HASHSET_CRC (hashfunc_t[]) {crc_hash0_n, crc_hash1_n, crc_hash2_n}, 3
 
 const int to_hashid(hashfunc_t h);
 const char* to_hashname(hashfunc_t h);
 hashfunc_t to_hashfunc(const char* const str);
 
-typedef enum { HASHES_UNDEFINED, HASHES_SIMPLE, HASHES_SIMPLE2, HASHES_MURMUR } hashset_t;
-#define VALID_HASHES "'simple' or 'murmur'"
+typedef enum { HASHES_UNDEFINED, HASHES_SIMPLE, HASHES_SIMPLE2, HASHES_MURMUR, HASHES_MIX, HASHES_DIRECT, HASHES_CRC } hashset_t;
+#define VALID_HASHES "'simple', 'simple2', 'murmur', 'mix', 'direct' or 'crc'"
 
 const hashset_t to_hashset(const char* const str);
 const char* const hashset_to_string(hashset_t hs);
@@ -48,7 +52,21 @@ const char* const hashset_to_string(hashset_t hs);
 #define DEFAULT_HASHSET HASHES_SIMPLE2
 
 BLOOM* const bloom_init(const unsigned short size, const hashset_t hs);
+BLOOM* const bloom_init_counting(const unsigned short size, const hashset_t hs);
 const int bloomfct_cmp(BLOOM* const bloom, ...);
+const hashset_t bloom_hashset(const BLOOM* const bloom);
+// Token n-grams are represented by the combination of their token hashes
+const int bloom_hashes_tokens(const BLOOM* const bloom);
+
+// Kernels specialized for byte n-grams of a fixed length, i.e., for all
+// n-grams of a string at once. The check returns the number of known ones.
+#define BLOOM_KERNEL_MAXN 8
+typedef void (*FN_BLOOM_ADD_BYTEGRAMS)(BLOOM* const bloom, const char* const str, const size_t len);
+typedef const size_t (*FN_BLOOM_CHECK_BYTEGRAMS)(BLOOM* const bloom, const char* const str, const size_t len);
+
+// Returns NULL if no kernel exists for the hash set, bit size and n
+FN_BLOOM_ADD_BYTEGRAMS bloom_add_bytegrams_fct(const BLOOM* const bloom, const size_t n);
+FN_BLOOM_CHECK_BYTEGRAMS bloom_check_bytegrams_fct(const BLOOM* const bloom, const size_t n);
 
 
 #endif /* SALAD_CONTAINER_BLOOM_H_ */
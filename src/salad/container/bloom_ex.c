@@ -16,6 +16,8 @@
  */
 
 #include "bloom_ex.h"
+#include "bloom.h"
+#include "hash.h"
 
 #include <assert.h>
 #include <ctype.h>
@@ -23,12 +25,22 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <util/cpu.h>
 #include <util/util.h>
 
 static const size_t CHAR_HIGHBIT = (((char) 1) << (sizeof(unsigned char) * 8 -1));
 
 #define SETBIT(a, n)  ((a)[(n)/CHAR_BIT] |= ((unsigned char) (CHAR_HIGHBIT>>((n)%CHAR_BIT))))
 #define GETBIT(a, n)  ((a)[(n)/CHAR_BIT] &  ((unsigned char) (CHAR_HIGHBIT>>((n)%CHAR_BIT))))
+#define CLRBIT(a, n)  ((a)[(n)/CHAR_BIT] &= ((unsigned char) ~(CHAR_HIGHBIT>>((n)%CHAR_BIT))))
+
+// Two 4-bit counters per byte, the first one in the high nibble
+#define COUNTERS_SIZE(bitsize) (((bitsize) +1)/2)
+#define COUNTER_SHIFT(n) ((n) %2 == 0 ? 4 : 0)
+#define GETCOUNTER(c, n) (((c)[(n)/2] >> COUNTER_SHIFT(n)) & BLOOM_COUNTER_MAX)
+#define SETCOUNTER(c, n, x) ((c)[(n)/2] = (unsigned char) (((c)[(n)/2] & ~(BLOOM_COUNTER_MAX << COUNTER_SHIFT(n))) | ((x) << COUNTER_SHIFT(n))))
+
+static void bloom_resolve_kernels(BLOOM* const bloom);
 
 BLOOM* const bloom_create(const size_t bitsize)
 {
@@ -53,10 +65,60 @@ BLOOM* const bloom_create(const size_t bitsize)
 	bloom->nfuncs = 0;
 	bloom->bitsize = bitsize;
 	bloom->size = size;
+	bloom->counters = NULL;
+	bloom->kernels = 0;
 
 	return bloom;
 }
 
+BLOOM* const bloom_create_counting(const size_t bitsize)
+{
+	BLOOM* const bloom = bloom_create(bitsize);
+	if (bloom == NULL)
+	{
+		return NULL;
+	}
+
+	// The bit array is kept as is, such that checking n-grams does not
+	// need to touch the (four times larger) counters at all.
+	bloom->counters = (unsigned char*) calloc(MAX(1, COUNTERS_SIZE(bitsize)), sizeof(unsigned char));
+	if (bloom->counters == NULL)
+	{
+		bloom_destroy(bloom);
+		return NULL;
+	}
+	return bloom;
+}
+
+const int bloom_is_counting(const BLOOM* const bloom)
+{
+	return (bloom != NULL && bloom->counters != NULL);
+}
+
+static inline void bloom_counters_to_bits(BLOOM* const bloom)
+{
+	memset(bloom->a, 0x00, bloom->size);
+	for (size_t i = 0; i < bloom->bitsize; i++)
+	{
+		if (GETCOUNTER(bloom->counters, i) != 0)
+		{
+			SETBIT(bloom->a, i);
+		}
+	}
+}
+
+static inline void bloom_bits_to_counters(BLOOM* const bloom)
+{
+	memset(bloom->counters, 0x00, COUNTERS_SIZE(bloom->bitsize));
+	for (size_t i = 0; i < bloom->bitsize; i++)
+	{
+		if (GETBIT(bloom->a, i))
+		{
+			SETCOUNTER(bloom->counters, i, 1);
+		}
+	}
+}
+
 const int bloom_set_hashfuncs(BLOOM* const bloom, const uint8_t nfuncs, ...)
 {
 	va_list args;
@@ -97,6 +159,7 @@ const int bloom_set_hashfuncs_ex(BLOOM* const bloom, hashfunc_t* const funcs, co
 	{
 		bloom->funcs[i] = funcs[i];
 	}
+	bloom_resolve_kernels(bloom);
 	return EXIT_SUCCESS;
 }
 
@@ -124,6 +187,19 @@ const int __bloom_set(BLOOM* const bloom, FN_COPYBYTES cpy, const size_t bitsize
 	}
 	bloom->bitsize = bitsize;
 	bloom->size = size;
+	bloom_resolve_kernels(bloom);
+
+	if (bloom->counters != NULL)
+	{
+		// Plain bits carry no counts, hence, every n-gram is assumed once
+		unsigned char* const c = (unsigned char*) realloc(bloom->counters, MAX(1, COUNTERS_SIZE(bitsize)));
+		if (c == NULL)
+		{
+			return FALSE;
+		}
+		bloom->counters = c;
+		bloom_bits_to_counters(bloom);
+	}
 	return TRUE;
 }
 
@@ -162,10 +238,75 @@ const int bloom_set_ex(BLOOM* const bloom, FN_READBYTE fct, const size_t size, v
 	return __bloom_set(bloom, __fctcpy, size, &x);
 }
 
+// Only the size of the bit array is set, the bits themselves are assigned
+// by the caller, e.g., as kept in shared memory.
+const int bloom_set_size(BLOOM* const bloom, const size_t bitsize)
+{
+	assert(bloom != NULL && bloom->counters == NULL);
+
+	free(bloom->a);
+	bloom->a = NULL;
+	bloom->bitsize = bitsize;
+	bloom->size = (bitsize +CHAR_BIT -1)/CHAR_BIT;
+	bloom_resolve_kernels(bloom);
+	return TRUE;
+}
+
+const int bloom_set_counters_ex(BLOOM* const bloom, FN_READBYTE fct, const size_t size, void* usr)
+{
+	assert(bloom != NULL);
+
+	// The size refers to the bits of the counter data, i.e., 4 bits per counter
+	const size_t bitsize = size/4;
+	const size_t csize = COUNTERS_SIZE(bitsize);
+
+	unsigned char* const c = (unsigned char*) calloc(MAX(1, csize), sizeof(unsigned char));
+	if (c == NULL)
+	{
+		return FALSE;
+	}
+
+	for (size_t i = 0; i < csize; i++)
+	{
+		const int ch = fct(usr);
+		if (ch < 0)
+		{
+			free(c);
+			return FALSE;
+		}
+		c[i] = (unsigned char) ch;
+	}
+
+	const size_t bsize = (bitsize +CHAR_BIT -1)/CHAR_BIT;
+	const size_t intsize = (bsize +sizeof(unsigned int) -1)/ sizeof(unsigned int);
+
+	unsigned char* const b = (unsigned char*) calloc(intsize, sizeof(unsigned int));
+	if (b == NULL)
+	{
+		free(c);
+		return FALSE;
+	}
+
+	free(bloom->a);
+	free(bloom->counters);
+	bloom->a = b;
+	bloom->counters = c;
+	bloom->bitsize = bitsize;
+	bloom->size = bsize;
+	bloom_resolve_kernels(bloom);
+
+	bloom_counters_to_bits(bloom);
+	return TRUE;
+}
+
 
 void bloom_clear(BLOOM* const bloom)
 {
 	memset(bloom->a, 0x00, bloom->size);
+	if (bloom->counters != NULL)
+	{
+		memset(bloom->counters, 0x00, COUNTERS_SIZE(bloom->bitsize));
+	}
 
 	// depending on the bloom filters size, reallocating the
 	// filter's memory with calloc might be faster.
@@ -177,31 +318,46 @@ void bloom_destroy(BLOOM* const bloom)
 
 	free(bloom->a);
 	free(bloom->funcs);
+	free(bloom->counters);
 	free(bloom);
 }
 
-void bloom_add_str(BLOOM* const bloom, const char* s, const size_t len)
+static inline void bloom_inc(BLOOM* const bloom, const size_t h)
 {
-	assert(bloom != NULL);
-
-	for(size_t n = 0; n < bloom->nfuncs; ++n)
+	const unsigned char x = GETCOUNTER(bloom->counters, h);
+	// Saturated counters stick, otherwise we would lose n-grams on removal
+	if (x < BLOOM_COUNTER_MAX)
 	{
-		const size_t h = bloom->funcs[n](s, len) % bloom->bitsize;
-		SETBIT(bloom->a, h);
+		SETCOUNTER(bloom->counters, h, x +1);
 	}
 }
 
-void bloom_add_num(BLOOM* const bloom, const size_t num)
+static inline void bloom_add(BLOOM* const bloom, const char* s, const size_t len)
 {
 	assert(bloom != NULL);
 
 	for(size_t n = 0; n < bloom->nfuncs; ++n)
 	{
-		const size_t h = bloom->funcs[n]((char*) &num, sizeof(size_t)) % bloom->bitsize;
+		const size_t h = bloom->funcs[n](s, len) % bloom->bitsize;
 		SETBIT(bloom->a, h);
+
+		if (bloom->counters != NULL)
+		{
+			bloom_inc(bloom, h);
+		}
 	}
 }
 
+void bloom_add_str(BLOOM* const bloom, const char* s, const size_t len)
+{
+	bloom_add(bloom, s, len);
+}
+
+void bloom_add_num(BLOOM* const bloom, const size_t num)
+{
+	bloom_add(bloom, (const char*) &num, sizeof(size_t));
+}
+
 static inline int bloom_check(BLOOM* const bloom, const char* s, const size_t len)
 {
 	assert(bloom != NULL);
@@ -227,25 +383,467 @@ const int bloom_check_num(BLOOM* const bloom, const size_t num)
 	return bloom_check(bloom, (const char*) &num, sizeof(size_t));
 }
 
+// Bloom filters using the 'mix' hash set derive all indices from one 64-bit
+// hash of the n-gram, i.e., from murmur64_hash_n or a hash provided up front.
+void bloom_add_hash(BLOOM* const bloom, const uint64_t hash)
+{
+	assert(bloom != NULL);
+
+	for(size_t n = 0; n < bloom->nfuncs; ++n)
+	{
+		const size_t h = MIX_HASH(hash, n) % bloom->bitsize;
+		SETBIT(bloom->a, h);
+
+		if (bloom->counters != NULL)
+		{
+			bloom_inc(bloom, h);
+		}
+	}
+}
+
+const int bloom_check_hash(BLOOM* const bloom, const uint64_t hash)
+{
+	assert(bloom != NULL);
+
+	for(size_t n = 0; n < bloom->nfuncs; ++n)
+	{
+		const size_t h = MIX_HASH(hash, n) % bloom->bitsize;
+		if (!GETBIT(bloom->a, h))
+		{
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+// Byte n-gram kernels for the hash sets of bloom_init. The n-gram length
+// is a compile-time constant, hence, the hashing loops are fully unrolled
+// and the three hashes are computed in a single pass. For bit sizes that
+// are powers of two the modulo reduces to a mask.
+static inline void bloom_setbit(BLOOM* const bloom, const size_t h)
+{
+	SETBIT(bloom->a, h);
+	if (bloom->counters != NULL)
+	{
+		bloom_inc(bloom, h);
+	}
+}
+
+static inline void bloom_add_simple_n(BLOOM* const bloom, const char* const str, const size_t len, const size_t n, const int use_djb2)
+{
+	const size_t mask = bloom->bitsize -1;
+	uint32_t h[3];
+
+	for (size_t i = 0; i +n <= len; i++)
+	{
+		simple_hashes_n(str +i, n, use_djb2, h);
+		bloom_setbit(bloom, h[0] & mask);
+		bloom_setbit(bloom, h[1] & mask);
+		bloom_setbit(bloom, h[2] & mask);
+	}
+}
+
+static inline const size_t bloom_check_simple_n(BLOOM* const bloom, const char* const str, const size_t len, const size_t n, const int use_djb2)
+{
+	const size_t mask = bloom->bitsize -1;
+	uint32_t h[3];
+
+	size_t known = 0;
+	for (size_t i = 0; i +n <= len; i++)
+	{
+		simple_hashes_n(str +i, n, use_djb2, h);
+		known += (GETBIT(bloom->a, h[0] & mask) && GETBIT(bloom->a, h[1] & mask) && GETBIT(bloom->a, h[2] & mask));
+	}
+	return known;
+}
+
+static inline void bloom_add_mix_n(BLOOM* const bloom, const char* const str, const size_t len, const size_t n)
+{
+	const size_t mask = bloom->bitsize -1;
+
+	for (size_t i = 0; i +n <= len; i++)
+	{
+		const uint64_t h = murmur64_hash_n(str +i, n);
+		bloom_setbit(bloom, MIX_HASH(h, 0) & mask);
+		bloom_setbit(bloom, MIX_HASH(h, 1) & mask);
+		bloom_setbit(bloom, MIX_HASH(h, 2) & mask);
+	}
+}
+
+static inline const size_t bloom_check_mix_n(BLOOM* const bloom, const char* const str, const size_t len, const size_t n)
+{
+	const size_t mask = bloom->bitsize -1;
+
+	size_t known = 0;
+	for (size_t i = 0; i +n <= len; i++)
+	{
+		const uint64_t h = murmur64_hash_n(str +i, n);
+		known += (GETBIT(bloom->a, MIX_HASH(h, 0) & mask) && GETBIT(bloom->a, MIX_HASH(h, 1) & mask) && GETBIT(bloom->a, MIX_HASH(h, 2) & mask));
+	}
+	return known;
+}
+
+// The 'direct' hash set indexes the n-gram itself, hence, sliding the
+// window is a single shift-and-mask. The mask also drops the bytes that
+// precede the n-gram, cf. direct_hash_n.
+static inline const size_t bloom_direct_mask(const BLOOM* const bloom, const size_t n)
+{
+	const size_t mask = bloom->bitsize -1;
+	return (n < sizeof(uint32_t) ? mask & ((((size_t) 1) << (n *CHAR_BIT)) -1) : mask);
+}
+
+static inline void bloom_add_direct_n(BLOOM* const bloom, const char* const str, const size_t len, const size_t n)
+{
+	const size_t mask = bloom_direct_mask(bloom, n);
+	const unsigned char* const x = (const unsigned char*) str;
+	if (len < n) return;
+
+	uint32_t h = 0;
+	for (size_t i = 0; i +1 < n; i++)
+	{
+		h = (h << CHAR_BIT) | x[i];
+	}
+	for (size_t i = n -1; i < len; i++)
+	{
+		h = (h << CHAR_BIT) | x[i];
+		bloom_setbit(bloom, h & mask);
+	}
+}
+
+static inline const size_t bloom_check_direct_n(BLOOM* const bloom, const char* const str, const size_t len, const size_t n)
+{
+	const size_t mask = bloom_direct_mask(bloom, n);
+	const unsigned char* const x = (const unsigned char*) str;
+	if (len < n) return 0;
+
+	uint32_t h = 0;
+	for (size_t i = 0; i +1 < n; i++)
+	{
+		h = (h << CHAR_BIT) | x[i];
+	}
+
+	size_t known = 0;
+	for (size_t i = n -1; i < len; i++)
+	{
+		h = (h << CHAR_BIT) | x[i];
+		known += (GETBIT(bloom->a, h & mask) != 0);
+	}
+	return known;
+}
+
+static inline void bloom_add_crc_n(BLOOM* const bloom, const char* const str, const size_t len, const size_t n)
+{
+	const size_t mask = bloom->bitsize -1;
+
+	for (size_t i = 0; i +n <= len; i++)
+	{
+		const uint32_t h = crc32c_n(str +i, n);
+		bloom_setbit(bloom, crc_fmix(h, CRC_SEED0) & mask);
+		bloom_setbit(bloom, crc_fmix(h, CRC_SEED1) & mask);
+		bloom_setbit(bloom, crc_fmix(h, CRC_SEED2) & mask);
+	}
+}
+
+static inline const size_t bloom_check_crc_n(BLOOM* const bloom, const char* const str, const size_t len, const size_t n)
+{
+	const size_t mask = bloom->bitsize -1;
+
+	size_t known = 0;
+	for (size_t i = 0; i +n <= len; i++)
+	{
+		const uint32_t h = crc32c_n(str +i, n);
+		known += (GETBIT(bloom->a, crc_fmix(h, CRC_SEED0) & mask) && GETBIT(bloom->a, crc_fmix(h, CRC_SEED1) & mask) && GETBIT(bloom->a, crc_fmix(h, CRC_SEED2) & mask));
+	}
+	return known;
+}
+
+#define BLOOM_BYTEGRAM_KERNELS(N)                                                                   \
+static void bloom_add_simple_##N(BLOOM* const bloom, const char* const str, const size_t len)       \
+{	bloom_add_simple_n(bloom, str, len, N, FALSE); }                                                \
+static void bloom_add_simple2_##N(BLOOM* const bloom, const char* const str, const size_t len)      \
+{	bloom_add_simple_n(bloom, str, len, N, TRUE); }                                                 \
+static void bloom_add_mix_##N(BLOOM* const bloom, const char* const str, const size_t len)          \
+{	bloom_add_mix_n(bloom, str, len, N); }                                                          \
+static const size_t bloom_check_simple_##N(BLOOM* const bloom, const char* const str, const size_t len)  \
+{	return bloom_check_simple_n(bloom, str, len, N, FALSE); }                                       \
+static const size_t bloom_check_simple2_##N(BLOOM* const bloom, const char* const str, const size_t len) \
+{	return bloom_check_simple_n(bloom, str, len, N, TRUE); }                                        \
+static const size_t bloom_check_mix_##N(BLOOM* const bloom, const char* const str, const size_t len)     \
+{	return bloom_check_mix_n(bloom, str, len, N); }                                                 \
+static void bloom_add_direct_##N(BLOOM* const bloom, const char* const str, const size_t len)       \
+{	bloom_add_direct_n(bloom, str, len, N); }                                                       \
+static const size_t bloom_check_direct_##N(BLOOM* const bloom, const char* const str, const size_t len)  \
+{	return bloom_check_direct_n(bloom, str, len, N); }                                              \
+static void bloom_add_crc_##N(BLOOM* const bloom, const char* const str, const size_t len)          \
+{	bloom_add_crc_n(bloom, str, len, N); }                                                          \
+static const size_t bloom_check_crc_##N(BLOOM* const bloom, const char* const str, const size_t len)     \
+{	return bloom_check_crc_n(bloom, str, len, N); }
+
+BLOOM_BYTEGRAM_KERNELS(1)
+BLOOM_BYTEGRAM_KERNELS(2)
+BLOOM_BYTEGRAM_KERNELS(3)
+BLOOM_BYTEGRAM_KERNELS(4)
+BLOOM_BYTEGRAM_KERNELS(5)
+BLOOM_BYTEGRAM_KERNELS(6)
+BLOOM_BYTEGRAM_KERNELS(7)
+BLOOM_BYTEGRAM_KERNELS(8)
+
+#define BLOOM_KERNEL_TABLE(F, X) { \
+		F##_##X##_1, F##_##X##_2, F##_##X##_3, F##_##X##_4, \
+		F##_##X##_5, F##_##X##_6, F##_##X##_7, F##_##X##_8 }
+
+static const FN_BLOOM_ADD_BYTEGRAMS BLOOM_ADD_KERNELS[5][BLOOM_KERNEL_MAXN] = {
+		BLOOM_KERNEL_TABLE(bloom_add, simple),
+		BLOOM_KERNEL_TABLE(bloom_add, simple2),
+		BLOOM_KERNEL_TABLE(bloom_add, mix),
+		BLOOM_KERNEL_TABLE(bloom_add, direct),
+		BLOOM_KERNEL_TABLE(bloom_add, crc)
+};
+
+static const FN_BLOOM_CHECK_BYTEGRAMS BLOOM_CHECK_KERNELS[5][BLOOM_KERNEL_MAXN] = {
+		BLOOM_KERNEL_TABLE(bloom_check, simple),
+		BLOOM_KERNEL_TABLE(bloom_check, simple2),
+		BLOOM_KERNEL_TABLE(bloom_check, mix),
+		BLOOM_KERNEL_TABLE(bloom_check, direct),
+		BLOOM_KERNEL_TABLE(bloom_check, crc)
+};
+
+// Identifying the hash set compares the hash functions against all known
+// sets, hence, it is done once whenever the functions or the size change
+// rather than for every string.
+static void bloom_resolve_kernels(BLOOM* const bloom)
+{
+	assert(bloom != NULL);
+	bloom->kernels = 0;
+
+	if (bloom->bitsize == 0 || (bloom->bitsize & (bloom->bitsize -1)) != 0)
+	{
+		return;
+	}
+
+	switch (bloom_hashset(bloom))
+	{
+	case HASHES_SIMPLE:  bloom->kernels = 1; break;
+	case HASHES_SIMPLE2: bloom->kernels = 2; break;
+	case HASHES_MIX:     bloom->kernels = 3; break;
+	case HASHES_DIRECT:  bloom->kernels = 4; break;
+	case HASHES_CRC:     bloom->kernels = 5; break;
+	default:             break;
+	}
+}
+
+FN_BLOOM_ADD_BYTEGRAMS bloom_add_bytegrams_fct(const BLOOM* const bloom, const size_t n)
+{
+	assert(bloom != NULL);
+	if (bloom->kernels == 0 || n < 1 || n > BLOOM_KERNEL_MAXN) return NULL;
+	return BLOOM_ADD_KERNELS[bloom->kernels -1][n -1];
+}
+
+FN_BLOOM_CHECK_BYTEGRAMS bloom_check_bytegrams_fct(const BLOOM* const bloom, const size_t n)
+{
+	assert(bloom != NULL);
+	if (bloom->kernels == 0 || n < 1 || n > BLOOM_KERNEL_MAXN) return NULL;
+	return BLOOM_CHECK_KERNELS[bloom->kernels -1][n -1];
+}
+
+static inline const uint16_t bloom_spread(const unsigned char x)
+{
+	// Moves bit i to bit 2i
+	uint16_t y = x;
+	y = (uint16_t) ((y | (y << 4)) & 0x0F0F);
+	y = (uint16_t) ((y | (y << 2)) & 0x3333);
+	y = (uint16_t) ((y | (y << 1)) & 0x5555);
+	return y;
+}
+
+BLOOM* const bloom_interleave(BLOOM* const good, BLOOM* const bad)
+{
+	assert(good != NULL && bad != NULL);
+
+	if (good->bitsize != bad->bitsize || good->nfuncs != bad->nfuncs
+			|| memcmp(good->funcs, bad->funcs, good->nfuncs *sizeof(hashfunc_t)) != 0)
+	{
+		return NULL;
+	}
+
+	// Bit 2i holds bit i of the good and bit 2i+1 the one of the bad filter
+	BLOOM* const bloom = bloom_create(2 *good->bitsize);
+	if (bloom == NULL)
+	{
+		return NULL;
+	}
+	bloom_set_hashfuncs_ex(bloom, good->funcs, good->nfuncs);
+
+	for (size_t i = 0; i < good->size; i++)
+	{
+		const uint16_t x = (uint16_t) ((bloom_spread(good->a[i]) << 1) | bloom_spread(bad->a[i]));
+
+		bloom->a[2*i] = (unsigned char) (x >> CHAR_BIT);
+		if (2*i +1 < bloom->size)
+		{
+			bloom->a[2*i +1] = (unsigned char) x;
+		}
+	}
+	return bloom;
+}
+
+const int bloom_check2_str(BLOOM* const bloom, const char* s, const size_t len)
+{
+	assert(bloom != NULL);
+	const size_t m = bloom->bitsize/2;
+
+	int ret = BLOOM_GOOD | BLOOM_BAD;
+	for(size_t n = 0; n < bloom->nfuncs && ret != 0; ++n)
+	{
+		// The index is even, hence, both bits share the same byte
+		const size_t h = 2*(bloom->funcs[n](s, len) % m);
+		const unsigned char x = (unsigned char) (bloom->a[h/CHAR_BIT] << (h%CHAR_BIT));
+
+		ret &= ((x >> 7) & BLOOM_GOOD) | ((x >> 5) & BLOOM_BAD);
+	}
+	return ret;
+}
+
+const int bloom_check2_hash(BLOOM* const bloom, const uint64_t hash)
+{
+	assert(bloom != NULL);
+	const size_t m = bloom->bitsize/2;
+
+	int ret = BLOOM_GOOD | BLOOM_BAD;
+	for(size_t n = 0; n < bloom->nfuncs && ret != 0; ++n)
+	{
+		const size_t h = 2*(MIX_HASH(hash, n) % m);
+		const unsigned char x = (unsigned char) (bloom->a[h/CHAR_BIT] << (h%CHAR_BIT));
+
+		ret &= ((x >> 7) & BLOOM_GOOD) | ((x >> 5) & BLOOM_BAD);
+	}
+	return ret;
+}
+
+const int bloom_remove_str(BLOOM* const bloom, const char* s, const size_t len)
+{
+	assert(bloom != NULL);
+
+	// Removing n-grams that have never been added would corrupt the counts
+	// of others. Plain bloom filters do not support removal at all.
+	if (bloom->counters == NULL || !bloom_check(bloom, s, len))
+	{
+		return FALSE;
+	}
+
+	for(size_t n = 0; n < bloom->nfuncs; ++n)
+	{
+		const size_t h = bloom->funcs[n](s, len) % bloom->bitsize;
+		const unsigned char x = GETCOUNTER(bloom->counters, h);
+
+		if (x <= 0 || x >= BLOOM_COUNTER_MAX) continue;
+
+		SETCOUNTER(bloom->counters, h, x -1);
+		if (x == 1)
+		{
+			CLRBIT(bloom->a, h);
+		}
+	}
+	return TRUE;
+}
+
+const int bloom_remove_hash(BLOOM* const bloom, const uint64_t hash)
+{
+	assert(bloom != NULL);
+
+	if (bloom->counters == NULL || !bloom_check_hash(bloom, hash))
+	{
+		return FALSE;
+	}
+
+	for(size_t n = 0; n < bloom->nfuncs; ++n)
+	{
+		const size_t h = MIX_HASH(hash, n) % bloom->bitsize;
+		const unsigned char x = GETCOUNTER(bloom->counters, h);
+
+		if (x <= 0 || x >= BLOOM_COUNTER_MAX) continue;
+
+		SETCOUNTER(bloom->counters, h, x -1);
+		if (x == 1)
+		{
+			CLRBIT(bloom->a, h);
+		}
+	}
+	return TRUE;
+}
+
+void bloom_decay(BLOOM* const bloom)
+{
+	assert(bloom != NULL);
+	if (bloom->counters == NULL) return;
+
+	// Halve both counters of a byte at once, the mask drops the bit shifted
+	// from the high into the low nibble. Saturated counters stay saturated
+	// since their true count is unknown, cf. bloom_remove.
+	for (size_t i = 0; i < COUNTERS_SIZE(bloom->bitsize); i++)
+	{
+		const unsigned char x = bloom->counters[i];
+		unsigned char y = (unsigned char) ((x >> 1) & 0x77);
+
+		if ((x & BLOOM_COUNTER_MAX) == BLOOM_COUNTER_MAX) y |= BLOOM_COUNTER_MAX;
+		if ((x >> 4) == BLOOM_COUNTER_MAX) y |= (BLOOM_COUNTER_MAX << 4);
+		bloom->counters[i] = y;
+	}
+	bloom_counters_to_bits(bloom);
+}
+
 /**
  * GCC: int __builtin_popcount (unsigned int x);
  * VC:  unsigned int __popcnt(unsigned int value);
  *
+ * Without the POPCNT instruction in the baseline target the builtin falls
+ * back to a software implementation, hence, a variant using the
+ * instruction is selected at run-time if available.
  */
-const size_t bloom_count(BLOOM* const bloom)
+static const size_t bloom_popcount(const unsigned char* const a, const size_t size)
 {
-	assert(bloom != NULL);
 	size_t count = 0;
-
-	for (size_t i = 0; i < bloom->size; i += sizeof(unsigned int))
+	for (size_t i = 0; i < size; i += sizeof(unsigned int))
 	{
-		unsigned int* foo = (unsigned int*) (bloom->a +i);
+		unsigned int* foo = (unsigned int*) (a +i);
 		// __builtin_popcount: Returns the number of 1-bits in x
 		count += (size_t) __builtin_popcount(*foo);
 	}
 	return count;
 }
 
+#ifdef HAVE_CPU_DISPATCH
+CPU_TARGET("popcnt") static const size_t bloom_popcount_popcnt(const unsigned char* const a, const size_t size)
+{
+	size_t count = 0, i = 0;
+	for (; i +sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+	{
+		uint64_t x;
+		memcpy(&x, a +i, sizeof(uint64_t));
+		count += (size_t) __builtin_popcountll(x);
+	}
+	for (; i < size; i += sizeof(unsigned int))
+	{
+		unsigned int* foo = (unsigned int*) (a +i);
+		count += (size_t) __builtin_popcount(*foo);
+	}
+	return count;
+}
+#endif
+
+const size_t bloom_count(BLOOM* const bloom)
+{
+	assert(bloom != NULL);
+
+#ifdef HAVE_CPU_DISPATCH
+	if (cpu_features() & CPU_POPCNT)
+	{
+		return bloom_popcount_popcnt(bloom->a, bloom->size);
+	}
+#endif
+	return bloom_popcount(bloom->a, bloom->size);
+}
+
 const int bloom_compare(BLOOM* const a, BLOOM* const b)
 {
 	if (a == b)
@@ -40,13 +40,26 @@ typedef struct {
 
 	uint8_t nfuncs;
 	hashfunc_t* funcs;
+
+	unsigned char* counters; ///< Packed 4-bit counters per bit or NULL
+	uint8_t kernels; ///< The byte n-gram kernels plus one or 0, cf. bloom_add_bytegrams_fct
 } BLOOM;
 
+#define BLOOM_COUNTER_MAX 0x0F
+
+// The classes of an interleaved two-class bloom filter, cf. bloom_interleave
+#define BLOOM_GOOD 0x01
+#define BLOOM_BAD  0x02
+
 BLOOM* const bloom_create(const size_t bitsize);
+BLOOM* const bloom_create_counting(const size_t bitsize);
+const int bloom_is_counting(const BLOOM* const bloom);
 
 typedef const int (*FN_READBYTE)(void* usr);
 const int bloom_set(BLOOM* const bloom, const uint8_t* const buf, const size_t n);
 const int bloom_set_ex(BLOOM* const bloom, FN_READBYTE fct, const size_t n, void* usr);
+const int bloom_set_counters_ex(BLOOM* const bloom, FN_READBYTE fct, const size_t n, void* usr);
+const int bloom_set_size(BLOOM* const bloom, const size_t bitsize);
 
 const int bloom_set_hashfuncs(BLOOM* const bloom, const uint8_t nfuncs, ...);
 const int vbloom_set_hashfuncs(BLOOM* const bloom, const uint8_t nfuncs, va_list args);
@@ -57,7 +70,17 @@ void bloom_destroy(BLOOM* const bloom);
 void bloom_add_str(BLOOM* const bloom, const char *s, const size_t len);
 void bloom_add_num(BLOOM* const bloom, const size_t num);
 const int bloom_check_str(BLOOM* const bloom, const char *s, const size_t len);
+const int bloom_remove_str(BLOOM* const bloom, const char *s, const size_t len);
+void bloom_decay(BLOOM* const bloom);
 const int bloom_check_num(BLOOM* const bloom, const size_t num);
+BLOOM* const bloom_interleave(BLOOM* const good, BLOOM* const bad);
+const int bloom_check2_str(BLOOM* const bloom, const char* s, const size_t len);
+
+// Hashes of n-grams as computed for the 'mix' hash set, cf. MIX_HASH
+void bloom_add_hash(BLOOM* const bloom, const uint64_t hash);
+const int bloom_check_hash(BLOOM* const bloom, const uint64_t hash);
+const int bloom_check2_hash(BLOOM* const bloom, const uint64_t hash);
+const int bloom_remove_hash(BLOOM* const bloom, const uint64_t hash);
 const size_t bloom_count(BLOOM* const bloom);
 const int bloom_compare(BLOOM* const a, BLOOM* const b);
 void bloom_print(BLOOM* const bloom);
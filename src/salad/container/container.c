@@ -23,13 +23,38 @@
 #include <inttypes.h>
 #include <stdlib.h>
 
+extern inline void container_add_str(const container_t* const c, const char* const s, const size_t len);
+extern inline const int container_check_str(const container_t* const c, const char* const s, const size_t len);
+extern inline const int container_remove_str(const container_t* const c, const char* const s, const size_t len);
+extern inline void container_add_hash(const container_t* const c, const uint64_t h);
+extern inline const int container_check_hash(const container_t* const c, const uint64_t h);
+extern inline const int container_remove_hash(const container_t* const c, const uint64_t h);
+
 const char* const container_to_string(container_type_t t)
 {
 	switch (t)
 	{
-	case CONTAINER_BLOOMFILTER: return "bloom-filter";
-	default:                    return "unknown";
+	case CONTAINER_BLOOMFILTER:         return "bloom-filter";
+	case CONTAINER_COUNTINGBLOOMFILTER: return "counting-bloom-filter";
+	case CONTAINER_CUCKOOFILTER:        return "cuckoo-filter";
+	case CONTAINER_XORFILTER:           return "xor-filter";
+	case CONTAINER_TWOCLASSBLOOMFILTER: return "two-class-bloom-filter";
+	default:                            return "unknown";
+	}
+}
+
+const container_type_t to_containertype(const char* const str)
+{
+	switch (cmp(str, "bloom-filter", "counting-bloom-filter", "cuckoo-filter", "xor-filter", "two-class-bloom-filter", NULL))
+	{
+	case 0: return CONTAINER_BLOOMFILTER;
+	case 1: return CONTAINER_COUNTINGBLOOMFILTER;
+	case 2: return CONTAINER_CUCKOOFILTER;
+	case 3: return CONTAINER_XORFILTER;
+	case 4: return CONTAINER_TWOCLASSBLOOMFILTER;
+	default: break;
 	}
+	return CONTAINER_UNKNOWN;
 }
 
 container_t* const container_create()
@@ -51,6 +76,24 @@ const int container_init_bloomfilter(container_t* const c, const unsigned int fi
 	return container_set_bloomfilter(c, bloom_init((unsigned short) filter_size, to_hashset(hashset)));
 }
 
+const int container_init_countingbloomfilter(container_t* const c, const unsigned int filter_size, const char* const hashset)
+{
+	assert(c != NULL);
+	*c = EMPTY_CONTAINER;
+
+	assert(filter_size <= USHRT_MAX);
+	return container_set_countingbloomfilter(c, bloom_init_counting((unsigned short) filter_size, to_hashset(hashset)));
+}
+
+const int container_init_cuckoofilter(container_t* const c, const unsigned int filter_size)
+{
+	assert(c != NULL);
+	*c = EMPTY_CONTAINER;
+
+	assert(filter_size <= USHRT_MAX);
+	return container_set_cuckoofilter(c, cuckoo_init((unsigned short) filter_size));
+}
+
 const int container_isvalid(container_t* const c)
 {
 	if (c == NULL || c->data == NULL) return FALSE;
@@ -60,6 +103,20 @@ const int container_isvalid(container_t* const c)
 	case CONTAINER_BLOOMFILTER:
 		if (((BLOOM*) c->data)->size <= 0) return FALSE;
 		break;
+	case CONTAINER_COUNTINGBLOOMFILTER:
+		if (((BLOOM*) c->data)->size <= 0) return FALSE;
+		if (!bloom_is_counting(c->data)) return FALSE;
+		break;
+	case CONTAINER_CUCKOOFILTER:
+		if (((CUCKOO*) c->data)->nbuckets <= 0) return FALSE;
+		break;
+	case CONTAINER_XORFILTER:
+		if (((XORFILTER*) c->data)->blocklength <= 0) return FALSE;
+		break;
+	case CONTAINER_TWOCLASSBLOOMFILTER:
+		if (((BLOOM*) c->data)->size <= 0) return FALSE;
+		if (((BLOOM*) c->data)->bitsize %2 != 0) return FALSE;
+		break;
 	default:
 		break;
 	}
@@ -95,6 +152,89 @@ const int container_set_bloomfilter(container_t* const c, void* const b)
 	return TRUE;
 }
 
+const int container_set_countingbloomfilter(container_t* const c, void* const b)
+{
+	assert(c != NULL);
+	container_destroy(c);
+
+	if (b == NULL || !bloom_is_counting(b))
+	{
+		*c = ERROR_CONTAINER;
+		return FALSE;
+	}
+
+	c->data = b;
+	c->type = CONTAINER_COUNTINGBLOOMFILTER;
+	return TRUE;
+}
+
+const int container_set_cuckoofilter(container_t* const c, void* const x)
+{
+	assert(c != NULL);
+	container_destroy(c);
+
+	if (x == NULL)
+	{
+		*c = ERROR_CONTAINER;
+		return FALSE;
+	}
+
+	c->data = x;
+	c->type = CONTAINER_CUCKOOFILTER;
+	return TRUE;
+}
+
+const int container_set_xorfilter(container_t* const c, void* const x)
+{
+	assert(c != NULL);
+	container_destroy(c);
+
+	if (x == NULL)
+	{
+		*c = ERROR_CONTAINER;
+		return FALSE;
+	}
+
+	c->data = x;
+	c->type = CONTAINER_XORFILTER;
+	return TRUE;
+}
+
+const int container_set_twoclassbloomfilter(container_t* const c, void* const b)
+{
+	assert(c != NULL);
+	container_destroy(c);
+
+	if (b == NULL || ((BLOOM*) b)->bitsize %2 != 0)
+	{
+		*c = ERROR_CONTAINER;
+		return FALSE;
+	}
+
+	c->data = b;
+	c->type = CONTAINER_TWOCLASSBLOOMFILTER;
+	return TRUE;
+}
+
+const int container_interleave(container_t* const c, const container_t* const good, const container_t* const bad)
+{
+	assert(c != NULL && good != NULL && bad != NULL);
+
+	// Only the bits are interleaved, hence, counting filters are fine as well
+	if (!IS_BLOOMFILTER(good->type) || good->type == CONTAINER_TWOCLASSBLOOMFILTER
+			|| !IS_BLOOMFILTER(bad->type) || bad->type == CONTAINER_TWOCLASSBLOOMFILTER)
+	{
+		return FALSE;
+	}
+
+	BLOOM* const b = bloom_interleave(good->data, bad->data);
+	if (b == NULL)
+	{
+		return FALSE;
+	}
+	return container_set_twoclassbloomfilter(c, b);
+}
+
 void container_destroy(container_t* const c)
 {
 	assert(c != NULL);
@@ -104,9 +244,19 @@ void container_destroy(container_t* const c)
 		switch (c->type)
 		{
 		case CONTAINER_BLOOMFILTER:
+		case CONTAINER_COUNTINGBLOOMFILTER:
+		case CONTAINER_TWOCLASSBLOOMFILTER:
 			bloom_destroy(c->data);
 			break;
 
+		case CONTAINER_CUCKOOFILTER:
+			cuckoo_destroy(c->data);
+			break;
+
+		case CONTAINER_XORFILTER:
+			xor_destroy(c->data);
+			break;
+
 		default: break;
 		}
 	}
@@ -118,3 +268,66 @@ void container_free(container_t* const c)
 	container_destroy(c);
 	free(c);
 }
+
+const int container_supports_removal(const container_t* const c)
+{
+	assert(c != NULL);
+	// Cuckoo filters store an n-gram once only, such that removing it would
+	// also drop it for any other data that contributed it, cf. cuckoo_add_str
+	return (c->type == CONTAINER_COUNTINGBLOOMFILTER);
+}
+
+const int container_is_static(const container_t* const c)
+{
+	assert(c != NULL);
+	return (c->type == CONTAINER_XORFILTER || c->type == CONTAINER_TWOCLASSBLOOMFILTER);
+}
+
+const int container_hashes_tokens(const container_t* const c)
+{
+	assert(c != NULL);
+	return (IS_BLOOMFILTER(c->type) && bloom_hashes_tokens((BLOOM*) c->data));
+}
+
+const size_t container_bitsize(const container_t* const c)
+{
+	assert(c != NULL);
+
+	switch (c->type)
+	{
+	case CONTAINER_BLOOMFILTER:
+	case CONTAINER_COUNTINGBLOOMFILTER:
+	case CONTAINER_TWOCLASSBLOOMFILTER:
+		return ((BLOOM*) c->data)->bitsize;
+	case CONTAINER_CUCKOOFILTER:
+		return cuckoo_bitsize((CUCKOO*) c->data);
+	case CONTAINER_XORFILTER:
+		return xor_bitsize((XORFILTER*) c->data);
+	default:
+		return 0;
+	}
+}
+
+const int container_compare(const container_t* const a, const container_t* const b)
+{
+	assert(a != NULL && b != NULL);
+
+	if (a->type != b->type)
+	{
+		return (a->type < b->type ? -1 : 1);
+	}
+
+	switch (a->type)
+	{
+	case CONTAINER_BLOOMFILTER:
+	case CONTAINER_COUNTINGBLOOMFILTER:
+	case CONTAINER_TWOCLASSBLOOMFILTER:
+		return bloom_compare(a->data, b->data);
+	case CONTAINER_CUCKOOFILTER:
+		return cuckoo_compare(a->data, b->data);
+	case CONTAINER_XORFILTER:
+		return xor_compare(a->data, b->data);
+	default:
+		return 0;
+	}
+}
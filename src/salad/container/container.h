@@ -22,14 +22,25 @@
 #ifndef SALAD_CONTAINER_CONTAINER_H_
 #define SALAD_CONTAINER_CONTAINER_H_
 
+#include "bloom_ex.h"
+#include "cuckoo.h"
+#include "xor.h"
+
 #include <util/util.h>
 
+#include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
 
-typedef enum { CONTAINER_BLOOMFILTER, CONTAINER_UNKNOWN, CONTAINER_ERROR } container_type_t;
+typedef enum { CONTAINER_BLOOMFILTER, CONTAINER_COUNTINGBLOOMFILTER, CONTAINER_CUCKOOFILTER, CONTAINER_XORFILTER, CONTAINER_TWOCLASSBLOOMFILTER, CONTAINER_UNKNOWN, CONTAINER_ERROR } container_type_t;
+// The containers that can be trained, i.e., static filters are not listed
+#define VALID_CONTAINERS "'bloom-filter', 'counting-bloom-filter' or 'cuckoo-filter'"
+
+// All types of bloom filters share the same data structure
+#define IS_BLOOMFILTER(t) ((t) == CONTAINER_BLOOMFILTER || (t) == CONTAINER_COUNTINGBLOOMFILTER || (t) == CONTAINER_TWOCLASSBLOOMFILTER)
 
 const char* const container_to_string(container_type_t t);
+const container_type_t to_containertype(const char* const str);
 
 
 typedef struct
@@ -59,13 +70,98 @@ static const container_t ERROR_CONTAINER = ERROR_CONTAINER_INITIALIZER;
 container_t* const container_create();
 
 const int container_init_bloomfilter(container_t* const c, const unsigned int filter_size, const char* const hashset);
+const int container_init_countingbloomfilter(container_t* const c, const unsigned int filter_size, const char* const hashset);
 const int container_set(container_t* const c, container_t* const other);
 const int container_set_bloomfilter(container_t* const c, void* const b);
+const int container_set_countingbloomfilter(container_t* const c, void* const b);
+const int container_init_cuckoofilter(container_t* const c, const unsigned int filter_size);
+const int container_set_cuckoofilter(container_t* const c, void* const x);
+const int container_set_xorfilter(container_t* const c, void* const x);
+const int container_set_twoclassbloomfilter(container_t* const c, void* const b);
+const int container_interleave(container_t* const c, const container_t* const good, const container_t* const bad);
 
 void container_destroy(container_t* const c);
 void container_free(container_t* const c);
 
 
+// Generic access to the elements of the container
+inline void container_add_str(const container_t* const c, const char* const s, const size_t len)
+{
+	switch (c->type)
+	{
+	case CONTAINER_CUCKOOFILTER:
+		cuckoo_add_str((CUCKOO*) c->data, s, len);
+		break;
+	case CONTAINER_XORFILTER:
+	case CONTAINER_TWOCLASSBLOOMFILTER:
+		// Static filters cannot be updated
+		break;
+	default:
+		bloom_add_str((BLOOM*) c->data, s, len);
+		break;
+	}
+}
+
+inline const int container_check_str(const container_t* const c, const char* const s, const size_t len)
+{
+	switch (c->type)
+	{
+	case CONTAINER_CUCKOOFILTER:
+		return cuckoo_check_str((CUCKOO*) c->data, s, len);
+	case CONTAINER_XORFILTER:
+		return xor_check_str((XORFILTER*) c->data, s, len);
+	case CONTAINER_TWOCLASSBLOOMFILTER:
+		return (bloom_check2_str((BLOOM*) c->data, s, len) & BLOOM_GOOD) != 0;
+	default:
+		return bloom_check_str((BLOOM*) c->data, s, len);
+	}
+}
+
+inline const int container_remove_str(const container_t* const c, const char* const s, const size_t len)
+{
+	switch (c->type)
+	{
+	case CONTAINER_COUNTINGBLOOMFILTER:
+		return bloom_remove_str((BLOOM*) c->data, s, len);
+	default:
+		return FALSE;
+	}
+}
+
+// Adding, checking and removing n-grams by their 64-bit hash is limited to
+// bloom filters hashing n-grams by value, cf. container_hashes_tokens
+inline void container_add_hash(const container_t* const c, const uint64_t h)
+{
+	assert(IS_BLOOMFILTER(c->type));
+	if (c->type != CONTAINER_TWOCLASSBLOOMFILTER)
+	{
+		bloom_add_hash((BLOOM*) c->data, h);
+	}
+}
+
+inline const int container_check_hash(const container_t* const c, const uint64_t h)
+{
+	assert(IS_BLOOMFILTER(c->type));
+	if (c->type == CONTAINER_TWOCLASSBLOOMFILTER)
+	{
+		return (bloom_check2_hash((BLOOM*) c->data, h) & BLOOM_GOOD) != 0;
+	}
+	return bloom_check_hash((BLOOM*) c->data, h);
+}
+
+inline const int container_remove_hash(const container_t* const c, const uint64_t h)
+{
+	assert(IS_BLOOMFILTER(c->type));
+	return (c->type == CONTAINER_COUNTINGBLOOMFILTER ? bloom_remove_hash((BLOOM*) c->data, h) : FALSE);
+}
+
+const int container_supports_removal(const container_t* const c);
+const int container_is_static(const container_t* const c);
+const int container_hashes_tokens(const container_t* const c);
+const size_t container_bitsize(const container_t* const c);
+const int container_compare(const container_t* const a, const container_t* const b);
+
+
 typedef struct
 {
 	const char* filename;
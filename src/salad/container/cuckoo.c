@@ -0,0 +1,352 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "cuckoo.h"
+#include "hash.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+
+#include <util/util.h>
+
+// Every 16-bit lane of a bucket at once
+#define LANES_LO 0x0001000100010001ULL
+#define LANES_HI 0x8000800080008000ULL
+
+#define LANE_SHIFT(i) ((i) *CUCKOO_FPBITS)
+#define GETLANE(b, i) ((uint16_t) ((b) >> LANE_SHIFT(i)))
+#define CLRLANE(b, i) ((b) & ~(((uint64_t) 0xFFFF) << LANE_SHIFT(i)))
+#define SETLANE(b, i, fp) (CLRLANE(b, i) | (((uint64_t) (fp)) << LANE_SHIFT(i)))
+
+static inline const int has_zerolane(const uint64_t x)
+{
+	return ((x -LANES_LO) & ~x & LANES_HI) != 0;
+}
+
+static inline const int bucket_contains(const uint64_t b, const uint16_t fp)
+{
+	return has_zerolane(b ^ (LANES_LO *fp));
+}
+
+static inline const uint16_t to_fingerprint(const uint64_t h)
+{
+	// 0 marks an empty lane, hence, it is folded onto another fingerprint
+	const uint16_t fp = (uint16_t) (h >> (64 -CUCKOO_FPBITS));
+	return (fp == 0 ? 1 : fp);
+}
+
+static inline const size_t alt_index(const CUCKOO* const c, const size_t i, const uint16_t fp)
+{
+	// Partial-key cuckoo hashing: alt_index(alt_index(i, fp), fp) == i
+	return (i ^ (size_t) (fp *0x5BD1E995U)) & c->mask;
+}
+
+static inline const uint64_t next_random(CUCKOO* const c)
+{
+	// xorshift64
+	c->seed ^= c->seed << 13;
+	c->seed ^= c->seed >> 7;
+	c->seed ^= c->seed << 17;
+	return c->seed;
+}
+
+
+CUCKOO* const cuckoo_create(const size_t nbuckets)
+{
+	CUCKOO* const c = (CUCKOO*) malloc(sizeof(CUCKOO));
+	if (c == NULL)
+	{
+		return NULL;
+	}
+
+	size_t m = 1;
+	while (m < nbuckets)
+	{
+		m <<= 1;
+	}
+
+	c->buckets = (uint64_t*) calloc(m, sizeof(uint64_t));
+	if (c->buckets == NULL)
+	{
+		free(c);
+		return NULL;
+	}
+
+	c->nbuckets = m;
+	c->mask = m -1;
+	c->count = 0;
+	c->victim = 0;
+	c->victim_idx = 0;
+	c->seed = 0x9E3779B97F4A7C15ULL;
+	return c;
+}
+
+CUCKOO* const cuckoo_init(const unsigned short size)
+{
+	assert(size <= sizeof(void*) *8);
+	// Use as much memory as a bloom filter of the same size would
+	const size_t bitsize = (size_t) POW(2, size);
+	return cuckoo_create(MAX(1, bitsize/ (CUCKOO_BUCKETSIZE *CUCKOO_FPBITS)));
+}
+
+void cuckoo_destroy(CUCKOO* const c)
+{
+	if (c == NULL) return;
+
+	free(c->buckets);
+	free(c);
+}
+
+void cuckoo_clear(CUCKOO* const c)
+{
+	assert(c != NULL);
+
+	memset(c->buckets, 0x00, c->nbuckets *sizeof(uint64_t));
+	c->count = 0;
+	c->victim = 0;
+}
+
+const int cuckoo_set_ex(CUCKOO* const c, FN_READBYTE fct, const size_t bitsize, void* usr)
+{
+	assert(c != NULL);
+
+	const size_t nbuckets = bitsize/ (CUCKOO_BUCKETSIZE *CUCKOO_FPBITS);
+	if (nbuckets == 0 || (nbuckets & (nbuckets -1)) != 0)
+	{
+		return FALSE;
+	}
+
+	uint64_t* const buckets = (uint64_t*) calloc(nbuckets, sizeof(uint64_t));
+	if (buckets == NULL)
+	{
+		return FALSE;
+	}
+
+	// Buckets are stored in little-endian byte order
+	size_t count = 0;
+	for (size_t i = 0; i < nbuckets; i++)
+	{
+		uint64_t b = 0;
+		for (size_t j = 0; j < sizeof(uint64_t); j++)
+		{
+			const int ch = fct(usr);
+			if (ch < 0)
+			{
+				free(buckets);
+				return FALSE;
+			}
+			b |= ((uint64_t) ch) << (j *CHAR_BIT);
+		}
+		buckets[i] = b;
+
+		for (int k = 0; k < CUCKOO_BUCKETSIZE; k++)
+		{
+			count += (GETLANE(b, k) != 0);
+		}
+	}
+
+	free(c->buckets);
+	c->buckets = buckets;
+	c->nbuckets = nbuckets;
+	c->mask = nbuckets -1;
+	c->count = count +(c->victim != 0);
+	return TRUE;
+}
+
+const int cuckoo_set_victim(CUCKOO* const c, const uint16_t fp, const size_t idx)
+{
+	assert(c != NULL);
+	if (fp == 0 || idx >= c->nbuckets)
+	{
+		return FALSE;
+	}
+
+	c->count += (c->victim == 0);
+	c->victim = fp;
+	c->victim_idx = idx;
+	return TRUE;
+}
+
+
+static inline const int bucket_insert(CUCKOO* const c, const size_t i, const uint16_t fp)
+{
+	const uint64_t b = c->buckets[i];
+	if (!has_zerolane(b))
+	{
+		return FALSE;
+	}
+
+	for (int k = 0; k < CUCKOO_BUCKETSIZE; k++)
+	{
+		if (GETLANE(b, k) == 0)
+		{
+			c->buckets[i] = SETLANE(b, k, fp);
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static inline const int bucket_delete(CUCKOO* const c, const size_t i, const uint16_t fp)
+{
+	const uint64_t b = c->buckets[i];
+	for (int k = 0; k < CUCKOO_BUCKETSIZE; k++)
+	{
+		if (GETLANE(b, k) == fp)
+		{
+			c->buckets[i] = CLRLANE(b, k);
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static inline const int cuckoo_check(const CUCKOO* const c, const size_t i1, const uint16_t fp)
+{
+	const size_t i2 = alt_index(c, i1, fp);
+
+	if (bucket_contains(c->buckets[i1], fp)) return TRUE;
+	if (bucket_contains(c->buckets[i2], fp)) return TRUE;
+
+	return (c->victim == fp && (c->victim_idx == i1 || c->victim_idx == i2));
+}
+
+const int cuckoo_check_str(const CUCKOO* const c, const char* const s, const size_t len)
+{
+	assert(c != NULL);
+
+	const uint64_t h = murmur64_hash_n(s, len);
+	return cuckoo_check(c, (size_t) h & c->mask, to_fingerprint(h));
+}
+
+const int cuckoo_add_str(CUCKOO* const c, const char* const s, const size_t len)
+{
+	assert(c != NULL);
+
+	const uint64_t h = murmur64_hash_n(s, len);
+	uint16_t fp = to_fingerprint(h);
+	size_t i = (size_t) h & c->mask;
+
+	// N-grams are stored once only, otherwise frequent n-grams would
+	// quickly fill up their buckets.
+	if (cuckoo_check(c, i, fp)) return TRUE;
+
+	if (bucket_insert(c, i, fp) || bucket_insert(c, alt_index(c, i, fp), fp))
+	{
+		c->count++;
+		return TRUE;
+	}
+
+	// A victim left over means the filter is full
+	if (c->victim != 0) return FALSE;
+
+	i = ((next_random(c) & 1) ? alt_index(c, i, fp) : i);
+	for (int n = 0; n < CUCKOO_MAXKICKS; n++)
+	{
+		const int k = (int) (next_random(c) % CUCKOO_BUCKETSIZE);
+		const uint16_t other = GETLANE(c->buckets[i], k);
+
+		c->buckets[i] = SETLANE(c->buckets[i], k, fp);
+		fp = other;
+		i = alt_index(c, i, fp);
+
+		if (bucket_insert(c, i, fp))
+		{
+			c->count++;
+			return TRUE;
+		}
+	}
+
+	// Keep the last homeless fingerprint in order not to lose any n-gram
+	c->victim = fp;
+	c->victim_idx = i;
+	c->count++;
+	return TRUE;
+}
+
+const int cuckoo_remove_str(CUCKOO* const c, const char* const s, const size_t len)
+{
+	assert(c != NULL);
+
+	const uint64_t h = murmur64_hash_n(s, len);
+	const uint16_t fp = to_fingerprint(h);
+	const size_t i1 = (size_t) h & c->mask;
+	const size_t i2 = alt_index(c, i1, fp);
+
+	if (c->victim == fp && (c->victim_idx == i1 || c->victim_idx == i2))
+	{
+		c->victim = 0;
+		c->count--;
+		return TRUE;
+	}
+
+	if (!bucket_delete(c, i1, fp) && !bucket_delete(c, i2, fp))
+	{
+		return FALSE;
+	}
+	c->count--;
+
+	// There is room for the victim now
+	if (c->victim != 0)
+	{
+		const uint16_t v = c->victim;
+		const size_t vi = c->victim_idx;
+
+		if (bucket_insert(c, vi, v) || bucket_insert(c, alt_index(c, vi, v), v))
+		{
+			c->victim = 0;
+		}
+	}
+	return TRUE;
+}
+
+const size_t cuckoo_bitsize(const CUCKOO* const c)
+{
+	assert(c != NULL);
+	return c->nbuckets *CUCKOO_BUCKETSIZE *CUCKOO_FPBITS;
+}
+
+const size_t cuckoo_capacity(const CUCKOO* const c)
+{
+	assert(c != NULL);
+	return c->nbuckets *CUCKOO_BUCKETSIZE;
+}
+
+const int cuckoo_compare(const CUCKOO* const a, const CUCKOO* const b)
+{
+	if (a == b)
+	{
+		return 0;
+	}
+
+	if (a == NULL || b == NULL)
+	{
+		return (a < b ? -1 : 1);
+	}
+
+	if (a->nbuckets != b->nbuckets)
+	{
+		return (a->nbuckets < b->nbuckets ? -1 : 1);
+	}
+
+	if (a->victim != b->victim)
+	{
+		return (a->victim < b->victim ? -1 : 1);
+	}
+	return memcmp(a->buckets, b->buckets, a->nbuckets *sizeof(uint64_t));
+}
@@ -0,0 +1,66 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+/**
+ * @file
+ *
+ * A cuckoo filter (Fan et al., CoNEXT 2014) with buckets of four 16-bit
+ * fingerprints. Each bucket is packed into a single 64-bit word, such
+ * that a bucket is probed with a handful of word operations (SWAR) and
+ * every lookup touches at most two cache lines.
+ */
+
+#ifndef SALAD_CONTAINER_CUCKOO_H_
+#define SALAD_CONTAINER_CUCKOO_H_
+
+#include "bloom_ex.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define CUCKOO_BUCKETSIZE 4 ///< The number of fingerprints per bucket
+#define CUCKOO_FPBITS 16 ///< The bits per fingerprint
+#define CUCKOO_MAXKICKS 500
+
+typedef struct {
+	size_t nbuckets; ///< The number of buckets (a power of two)
+	size_t mask;
+	size_t count; ///< The number of fingerprints stored
+	uint64_t* buckets;
+
+	uint16_t victim; ///< A fingerprint that could not be placed or 0
+	size_t victim_idx;
+	uint64_t seed; ///< State of the PRNG picking fingerprints to relocate
+} CUCKOO;
+
+CUCKOO* const cuckoo_create(const size_t nbuckets);
+CUCKOO* const cuckoo_init(const unsigned short size);
+void cuckoo_destroy(CUCKOO* const c);
+void cuckoo_clear(CUCKOO* const c);
+
+const int cuckoo_set_ex(CUCKOO* const c, FN_READBYTE fct, const size_t bitsize, void* usr);
+const int cuckoo_set_victim(CUCKOO* const c, const uint16_t fp, const size_t idx);
+
+const int cuckoo_add_str(CUCKOO* const c, const char* const s, const size_t len);
+const int cuckoo_check_str(const CUCKOO* const c, const char* const s, const size_t len);
+const int cuckoo_remove_str(CUCKOO* const c, const char* const s, const size_t len);
+
+const size_t cuckoo_bitsize(const CUCKOO* const c);
+const size_t cuckoo_capacity(const CUCKOO* const c);
+const int cuckoo_compare(const CUCKOO* const a, const CUCKOO* const b);
+
+#endif /* SALAD_CONTAINER_CUCKOO_H_ */
@@ -0,0 +1,219 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "dict.h"
+#include "hash.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include <util/util.h>
+
+#define DICT_MIN_SLOTS 16
+#define TO_SLOT(d, hash) ((size_t) ((hash) ^ ((hash) >> 32)) & (d)->mask)
+
+static inline const size_t dict_numslots(const size_t n)
+{
+	// Keep the load factor at or below 75%
+	size_t m = DICT_MIN_SLOTS;
+	while (3*m < 4*n)
+	{
+		m <<= 1;
+	}
+	return m;
+}
+
+DICT* const dict_create(const size_t n)
+{
+	DICT* const d = (DICT*) calloc(1, sizeof(DICT));
+	if (d == NULL)
+	{
+		return NULL;
+	}
+
+	const size_t m = dict_numslots(n);
+	d->slots = (dict_slot_t*) calloc(m, sizeof(dict_slot_t));
+	d->offsets = (size_t*) malloc((n +1) *sizeof(size_t));
+	if (d->slots == NULL || d->offsets == NULL)
+	{
+		dict_destroy(d);
+		return NULL;
+	}
+	d->mask = m -1;
+	d->offsets_capacity = n +1;
+
+	// The string of id i ranges from offsets[i-1] to offsets[i]
+	d->offsets[0] = 0;
+	return d;
+}
+
+void dict_destroy(DICT* const d)
+{
+	if (d == NULL) return;
+
+	free(d->slots);
+	free(d->pool);
+	free(d->offsets);
+	free(d);
+}
+
+static inline const int dict_equals(const DICT* const d, const dict_slot_t* const slot, const uint64_t hash, const char* const str, const size_t len)
+{
+	if (slot->hash != hash) return FALSE;
+
+	const size_t offset = d->offsets[slot->id -1];
+	return (d->offsets[slot->id] -offset == len && memcmp(d->pool +offset, str, len) == 0);
+}
+
+// Robin Hood: Whoever is closer to its slot has to move on
+static inline void dict_place(DICT* const d, dict_slot_t x)
+{
+	for (size_t i = TO_SLOT(d, x.hash);; i = (i +1) & d->mask, x.dist++)
+	{
+		dict_slot_t* const slot = &d->slots[i];
+		if (slot->id == DICT_UNKNOWN)
+		{
+			*slot = x;
+			return;
+		}
+
+		if (slot->dist < x.dist)
+		{
+			const dict_slot_t y = *slot;
+			*slot = x;
+			x = y;
+		}
+	}
+}
+
+static const int dict_grow(DICT* const d)
+{
+	const size_t oldsize = d->mask +1;
+	dict_slot_t* const old = d->slots;
+
+	d->slots = (dict_slot_t*) calloc(2*oldsize, sizeof(dict_slot_t));
+	if (d->slots == NULL)
+	{
+		d->slots = old;
+		return EXIT_FAILURE;
+	}
+	d->mask = 2*oldsize -1;
+
+	for (size_t i = 0; i < oldsize; i++)
+	{
+		if (old[i].id != DICT_UNKNOWN)
+		{
+			dict_slot_t x = old[i];
+			x.dist = 0;
+			dict_place(d, x);
+		}
+	}
+	free(old);
+	return EXIT_SUCCESS;
+}
+
+static const int dict_append(DICT* const d, const char* const str, const size_t len)
+{
+	if (d->count +2 > d->offsets_capacity)
+	{
+		const size_t m = 2*d->offsets_capacity;
+		size_t* const x = (size_t*) realloc(d->offsets, m *sizeof(size_t));
+		if (x == NULL) return EXIT_FAILURE;
+
+		d->offsets = x;
+		d->offsets_capacity = m;
+	}
+
+	if (d->pool_size +len > d->pool_capacity)
+	{
+		const size_t m = MAX(d->pool_size +len, 2*d->pool_capacity);
+		char* const x = (char*) realloc(d->pool, m);
+		if (x == NULL) return EXIT_FAILURE;
+
+		d->pool = x;
+		d->pool_capacity = m;
+	}
+
+	memcpy(d->pool +d->pool_size, str, len);
+	d->pool_size += len;
+	d->offsets[d->count +1] = d->pool_size;
+	return EXIT_SUCCESS;
+}
+
+const uint32_t dict_insert(DICT* const d, const char* const str, const size_t len)
+{
+	assert(d != NULL && str != NULL);
+	const uint64_t hash = murmur64_hash_n(str, len);
+
+	size_t i = TO_SLOT(d, hash);
+	for (uint32_t dist = 0; d->slots[i].id != DICT_UNKNOWN && d->slots[i].dist >= dist; i = (i +1) & d->mask, dist++)
+	{
+		if (dict_equals(d, &d->slots[i], hash, str, len))
+		{
+			return d->slots[i].id;
+		}
+	}
+
+	if (d->count >= UINT32_MAX -1)
+	{
+		return DICT_UNKNOWN;
+	}
+
+	if (4*(d->count +1) > 3*(d->mask +1) && dict_grow(d) != EXIT_SUCCESS)
+	{
+		return DICT_UNKNOWN;
+	}
+
+	if (dict_append(d, str, len) != EXIT_SUCCESS)
+	{
+		return DICT_UNKNOWN;
+	}
+
+	const dict_slot_t x = {(uint32_t) ++d->count, 0, hash};
+	dict_place(d, x);
+	return x.id;
+}
+
+const uint32_t dict_lookup(const DICT* const d, const char* const str, const size_t len)
+{
+	assert(d != NULL && str != NULL);
+	const uint64_t hash = murmur64_hash_n(str, len);
+
+	// Unlike with linear probing the search ends at the first string that
+	// is closer to its slot than the one looked for would be
+	size_t i = TO_SLOT(d, hash);
+	for (uint32_t dist = 0; d->slots[i].id != DICT_UNKNOWN && d->slots[i].dist >= dist; i = (i +1) & d->mask, dist++)
+	{
+		if (dict_equals(d, &d->slots[i], hash, str, len))
+		{
+			return d->slots[i].id;
+		}
+	}
+	return DICT_UNKNOWN;
+}
+
+const char* const dict_get(const DICT* const d, const uint32_t id, size_t* const len)
+{
+	assert(d != NULL && len != NULL);
+	if (id == DICT_UNKNOWN || id > d->count)
+	{
+		return NULL;
+	}
+
+	*len = d->offsets[id] -d->offsets[id -1];
+	return d->pool +d->offsets[id -1];
+}
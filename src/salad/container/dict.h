@@ -0,0 +1,62 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+/**
+ * @file
+ *
+ * A dictionary that interns strings, i.e., it maps each distinct string
+ * to a consecutive 32-bit id starting at 1. It is implemented as
+ * open-addressing hash table with Robin Hood hashing, while the strings
+ * themselves are kept in a single pool in the order of their ids.
+ */
+
+#ifndef SALAD_CONTAINER_DICT_H_
+#define SALAD_CONTAINER_DICT_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+// The id of strings that are not part of the dictionary
+#define DICT_UNKNOWN 0
+
+typedef struct {
+	uint32_t id; ///< The id of the string or DICT_UNKNOWN for empty slots
+	uint32_t dist; ///< The distance to the slot the string is hashed to
+	uint64_t hash;
+} dict_slot_t;
+
+typedef struct {
+	size_t mask; ///< The number of slots minus one (a power of two)
+	size_t count; ///< The number of strings stored
+	dict_slot_t* slots;
+
+	char* pool; ///< The strings one after the other
+	size_t pool_size;
+	size_t pool_capacity;
+
+	size_t* offsets; ///< The offsets of the strings in the pool by id
+	size_t offsets_capacity;
+} DICT;
+
+DICT* const dict_create(const size_t n);
+void dict_destroy(DICT* const d);
+
+const uint32_t dict_insert(DICT* const d, const char* const str, const size_t len);
+const uint32_t dict_lookup(const DICT* const d, const char* const str, const size_t len);
+const char* const dict_get(const DICT* const d, const uint32_t id, size_t* const len);
+
+#endif /* SALAD_CONTAINER_DICT_H_ */
@@ -0,0 +1,206 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "fpset.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include <util/util.h>
+
+#define FPSET_MIN_SLOTS 16
+// 0 marks an empty slot, hence, it is folded onto another fingerprint
+#define TO_KEY(fp) ((fp) == 0 ? 1 : (fp))
+#define TO_SLOT(set, key) ((size_t) ((key) ^ ((key) >> 32)) & (set)->mask)
+
+static inline const size_t fpset_numslots(const size_t n)
+{
+	// Keep the load factor at or below 50%
+	size_t m = FPSET_MIN_SLOTS;
+	while (m < 2*n)
+	{
+		m <<= 1;
+	}
+	return m;
+}
+
+FPSET* const fpset_create(const size_t n)
+{
+	FPSET* const set = (FPSET*) malloc(sizeof(FPSET));
+	if (set == NULL)
+	{
+		return NULL;
+	}
+
+	set->capacity = fpset_numslots(n);
+	set->slots = (uint64_t*) calloc(set->capacity, sizeof(uint64_t));
+	if (set->slots == NULL)
+	{
+		free(set);
+		return NULL;
+	}
+	set->mask = set->capacity -1;
+	set->count = 0;
+	set->dropped = 0;
+	return set;
+}
+
+void fpset_destroy(FPSET* const set)
+{
+	if (set == NULL) return;
+
+	free(set->slots);
+	free(set);
+}
+
+const int fpset_reset(FPSET* const set, const size_t n)
+{
+	assert(set != NULL);
+	const size_t m = fpset_numslots(n);
+
+	if (m > set->capacity)
+	{
+		uint64_t* const slots = (uint64_t*) calloc(m, sizeof(uint64_t));
+		if (slots == NULL)
+		{
+			// The set remains usable with the slots allocated so far
+			memset(set->slots, 0x00, set->capacity *sizeof(uint64_t));
+			set->mask = set->capacity -1;
+			set->count = 0;
+			return EXIT_FAILURE;
+		}
+		free(set->slots);
+		set->slots = slots;
+		set->capacity = m;
+	}
+	else
+	{
+		// Only the slots that possibly were in use need to be cleared
+		memset(set->slots, 0x00, MAX(m, set->mask +1) *sizeof(uint64_t));
+	}
+
+	set->mask = m -1;
+	set->count = 0;
+	return EXIT_SUCCESS;
+}
+
+static inline void fpset_insert(FPSET* const set, const uint64_t key)
+{
+	size_t i = TO_SLOT(set, key);
+	while (set->slots[i] != 0)
+	{
+		i = (i +1) & set->mask;
+	}
+	set->slots[i] = key;
+}
+
+static const int fpset_grow(FPSET* const set)
+{
+	const size_t m = (set->mask +1) << 1;
+	uint64_t* const old = set->slots;
+	const size_t oldsize = set->mask +1;
+
+	uint64_t* const slots = (uint64_t*) calloc(MAX(m, set->capacity), sizeof(uint64_t));
+	if (slots == NULL)
+	{
+		return EXIT_FAILURE;
+	}
+
+	set->slots = slots;
+	set->capacity = MAX(m, set->capacity);
+	set->mask = m -1;
+
+	for (size_t i = 0; i < oldsize; i++)
+	{
+		if (old[i] != 0)
+		{
+			fpset_insert(set, old[i]);
+		}
+	}
+	free(old);
+	return EXIT_SUCCESS;
+}
+
+const int fpset_add(FPSET* const set, const uint64_t fp)
+{
+	assert(set != NULL);
+	const uint64_t key = TO_KEY(fp);
+
+	size_t i = TO_SLOT(set, key);
+	for (; set->slots[i] != 0; i = (i +1) & set->mask)
+	{
+		if (set->slots[i] == key)
+		{
+			return FALSE;
+		}
+	}
+
+	// The expected number of elements was underestimated
+	if (2*(set->count +1) > set->mask +1 && fpset_grow(set) == EXIT_SUCCESS)
+	{
+		fpset_insert(set, key);
+	}
+	// Beyond the load factor as long as a slot remains that ends probing
+	else if (set->count +1 < set->mask +1)
+	{
+		set->slots[i] = key;
+	}
+	else
+	{
+		set->dropped++;
+		return FALSE;
+	}
+	set->count++;
+	return TRUE;
+}
+
+const int fpset_contains(const FPSET* const set, const uint64_t fp)
+{
+	assert(set != NULL);
+	const uint64_t key = TO_KEY(fp);
+
+	for (size_t i = TO_SLOT(set, key); set->slots[i] != 0; i = (i +1) & set->mask)
+	{
+		if (set->slots[i] == key)
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+uint64_t* const fpset_to_array(const FPSET* const set)
+{
+	assert(set != NULL);
+
+	uint64_t* const a = (uint64_t*) malloc(MAX(set->count, 1) *sizeof(uint64_t));
+	if (a == NULL)
+	{
+		return NULL;
+	}
+
+	size_t n = 0;
+	for (size_t i = 0; i <= set->mask; i++)
+	{
+		if (set->slots[i] != 0)
+		{
+			a[n++] = set->slots[i];
+		}
+	}
+	assert(n == set->count);
+	return a;
+}
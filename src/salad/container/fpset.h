@@ -0,0 +1,51 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+/**
+ * @file
+ *
+ * A set of 64-bit fingerprints implemented as open-addressing hash
+ * table with linear probing. The set is meant to be reused: Resetting
+ * it only touches as many slots as required for the expected number
+ * of elements rather than the whole allocated table.
+ */
+
+#ifndef SALAD_CONTAINER_FPSET_H_
+#define SALAD_CONTAINER_FPSET_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define DEFAULT_FPSET_SIZE 0x1000 ///< The number of elements expected initially
+
+typedef struct {
+	size_t capacity; ///< The number of allocated slots
+	size_t mask; ///< The number of slots in use minus one (a power of two)
+	size_t count; ///< The number of elements currently stored
+	size_t dropped; ///< The number of elements lost since the set could not grow
+	uint64_t* slots;
+} FPSET;
+
+FPSET* const fpset_create(const size_t n);
+void fpset_destroy(FPSET* const set);
+const int fpset_reset(FPSET* const set, const size_t n);
+
+const int fpset_add(FPSET* const set, const uint64_t fp);
+const int fpset_contains(const FPSET* const set, const uint64_t fp);
+uint64_t* const fpset_to_array(const FPSET* const set);
+
+#endif /* SALAD_CONTAINER_FPSET_H_ */
@@ -38,6 +38,10 @@ uint32_t djb_hash_n(const char* const key, const size_t len);
 uint32_t djb2_hash(const char* const key);
 uint32_t djb2_hash_n(const char* const key, const size_t len);
 
+// The (last 4 bytes of the) key as big-endian number, i.e., an exact index
+uint32_t direct_hash(const char* const key);
+uint32_t direct_hash_n(const char* const key, const size_t len);
+
 
 uint32_t murmur_hash0(const char* const key);
 uint32_t murmur_hash0_n(const char* const key, const size_t len);
@@ -49,4 +53,55 @@ uint32_t murmur_hash2(const char* const key);
 uint32_t murmur_hash2_n(const char* const key, const size_t len);
 
 
+uint64_t murmur64_hash_n(const char* const key, const size_t len);
+
+// The hashes of HASHSET_SIMPLE or HASHSET_SIMPLE2 (use_djb2) in a single pass
+inline void simple_hashes_n(const char* const key, const size_t len, const int use_djb2, uint32_t* const h)
+{
+	uint32_t a = 0, b = 0, c = (use_djb2 ? 5381 : 0);
+	const unsigned char* const x = (const unsigned char*) key;
+
+	for(size_t i = 0; i < len; i++)
+	{
+		a ^= (a<<5) + (a>>2) + x[i];
+		b = x[i] + (b<<6) + (b<<16) - b;
+		c = (use_djb2 ? (33*c ^ x[i]) : 33*c + x[i]);
+	}
+	h[0] = a;
+	h[1] = b;
+	h[2] = c;
+}
+
+// Double hashing (Kirsch & Mitzenmacher, 2006) based on murmur64_hash_n
+#define MIX_HASH(h, i) ((uint32_t) ((h) +(i) *((h) >> 32)))
+
+uint32_t mix_hash0_n(const char* const key, const size_t len);
+uint32_t mix_hash1_n(const char* const key, const size_t len);
+uint32_t mix_hash2_n(const char* const key, const size_t len);
+
+// CRC-32C, computed by the crc32 instruction of SSE4.2 if available
+uint32_t crc32c_n(const char* const key, const size_t len);
+
+// CRCs of the same input under different seeds differ by a constant,
+// hence, the seeds are applied to a non-linear finalizer (MurmurHash3)
+#define CRC_SEED0 0x3956c25b // SHA-256 k[4]
+#define CRC_SEED1 0x59f111f1 // SHA-256 k[5]
+#define CRC_SEED2 0x923f82a4 // SHA-256 k[6]
+
+inline uint32_t crc_fmix(uint32_t h, const uint32_t seed)
+{
+	h ^= seed;
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+	return h;
+}
+
+uint32_t crc_hash0_n(const char* const key, const size_t len);
+uint32_t crc_hash1_n(const char* const key, const size_t len);
+uint32_t crc_hash2_n(const char* const key, const size_t len);
+
+
 #endif /* SALAD_HASH_H_ */
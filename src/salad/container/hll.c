@@ -0,0 +1,132 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "hll.h"
+#include "hash.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include <util/util.h>
+
+
+HLL* const hll_create(const uint8_t p)
+{
+	if (p < HLL_MIN_PRECISION || p > HLL_MAX_PRECISION)
+	{
+		return NULL;
+	}
+
+	HLL* const hll = (HLL*) malloc(sizeof(HLL));
+	if (hll == NULL)
+	{
+		return NULL;
+	}
+
+	hll->p = p;
+	hll->m = ((size_t) 1) << p;
+	hll->registers = (uint8_t*) calloc(hll->m, sizeof(uint8_t));
+	if (hll->registers == NULL)
+	{
+		free(hll);
+		return NULL;
+	}
+	return hll;
+}
+
+void hll_destroy(HLL* const hll)
+{
+	if (hll == NULL) return;
+
+	free(hll->registers);
+	free(hll);
+}
+
+void hll_clear(HLL* const hll)
+{
+	assert(hll != NULL);
+	memset(hll->registers, 0x00, hll->m);
+}
+
+void hll_add_hash(HLL* const hll, const uint64_t h)
+{
+	assert(hll != NULL);
+
+	const size_t idx = (size_t) (h >> (64 -hll->p));
+	// The guard bit limits the rank to 64 -p +1 and keeps clz well-defined
+	const uint64_t w = (h << hll->p) | (((uint64_t) 1) << (hll->p -1));
+	const uint8_t rank = (uint8_t) (__builtin_clzll(w) +1);
+
+	if (rank > hll->registers[idx])
+	{
+		hll->registers[idx] = rank;
+	}
+}
+
+void hll_add_str(HLL* const hll, const char* const s, const size_t len)
+{
+	hll_add_hash(hll, murmur64_hash_n(s, len));
+}
+
+const int hll_merge(HLL* const dst, const HLL* const src)
+{
+	assert(dst != NULL && src != NULL);
+	if (dst->p != src->p)
+	{
+		return EXIT_FAILURE;
+	}
+
+	for (size_t i = 0; i < dst->m; i++)
+	{
+		dst->registers[i] = MAX(dst->registers[i], src->registers[i]);
+	}
+	return EXIT_SUCCESS;
+}
+
+static inline const double hll_alpha(const size_t m)
+{
+	switch (m)
+	{
+	case 16: return 0.673;
+	case 32: return 0.697;
+	case 64: return 0.709;
+	}
+	return 0.7213/ (1.0 +1.079/ (double) m);
+}
+
+const double hll_estimate(const HLL* const hll)
+{
+	assert(hll != NULL);
+	const double m = (double) hll->m;
+
+	double sum = 0.0;
+	size_t zeros = 0;
+	for (size_t i = 0; i < hll->m; i++)
+	{
+		sum += ldexp(1.0, -hll->registers[i]);
+		zeros += (hll->registers[i] == 0);
+	}
+
+	const double e = hll_alpha(hll->m) *m *m/ sum;
+	if (e <= 2.5 *m && zeros > 0)
+	{
+		// small range correction, i.e., linear counting
+		return m *log(m/ (double) zeros);
+	}
+	return e;
+}
@@ -0,0 +1,50 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+/**
+ * @file
+ *
+ * A HyperLogLog cardinality estimator (Flajolet et al., 2007) operating
+ * on 64-bit hash values, hence, no large range correction is required.
+ */
+
+#ifndef SALAD_CONTAINER_HLL_H_
+#define SALAD_CONTAINER_HLL_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define HLL_MIN_PRECISION 4
+#define HLL_MAX_PRECISION 18
+#define DEFAULT_HLL_PRECISION 14 ///< 2^14 registers, i.e., a standard error of ~0.8%
+
+typedef struct {
+	uint8_t p; ///< The precision, i.e., the log2 of the number of registers
+	size_t m; ///< The number of registers
+	uint8_t* registers;
+} HLL;
+
+HLL* const hll_create(const uint8_t p);
+void hll_destroy(HLL* const hll);
+void hll_clear(HLL* const hll);
+
+void hll_add_hash(HLL* const hll, const uint64_t h);
+void hll_add_str(HLL* const hll, const char* const s, const size_t len);
+const int hll_merge(HLL* const dst, const HLL* const src);
+const double hll_estimate(const HLL* const hll);
+
+#endif /* SALAD_CONTAINER_HLL_H_ */
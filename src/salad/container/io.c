@@ -17,6 +17,8 @@
 
 #include "io.h"
 #include "io/bloom.h"
+#include "io/cuckoo.h"
+#include "io/xor.h"
 #include "io/common.h"
 #include "bloom.h"
 
@@ -63,7 +65,13 @@ const BOOL fwrite_containerconfig_ex(FILE* const f, const container_t* const c)
 	switch (c->type)
 	{
 	case CONTAINER_BLOOMFILTER:
+	case CONTAINER_COUNTINGBLOOMFILTER:
+	case CONTAINER_TWOCLASSBLOOMFILTER:
 		return fwrite_bloomconfig_ex(f, c->data);
+	case CONTAINER_CUCKOOFILTER:
+		return fwrite_cuckooconfig_ex(f, c->data);
+	case CONTAINER_XORFILTER:
+		return fwrite_xorconfig_ex(f, c->data);
 	default:
 		return FALSE;
 	}
@@ -74,7 +82,20 @@ const BOOL fwrite_containerdata(const container_outputspec_t* const out, const c
 	assert(out != NULL);
 	assert(c != NULL);
 
-	return fwrite_bloomdata(out, c->data, state);
+	switch (c->type)
+	{
+	case CONTAINER_BLOOMFILTER:
+	case CONTAINER_TWOCLASSBLOOMFILTER:
+		return fwrite_bloomdata(out, c->data, state);
+	case CONTAINER_COUNTINGBLOOMFILTER:
+		return fwrite_countingbloomdata(out, c->data, state);
+	case CONTAINER_CUCKOOFILTER:
+		return fwrite_cuckoodata(out, c->data, state);
+	case CONTAINER_XORFILTER:
+		return fwrite_xordata(out, c->data, state);
+	default:
+		return FALSE;
+	}
 }
 
 
@@ -89,24 +110,30 @@ const BOOL fread_containerconfig(FILE* const f, const char* const key, const cha
 	{
 	case 0:
 	{
-		switch (cmp(value, "bloom-filter", NULL))
+		container->type = to_containertype(value);
+		if (container->type == CONTAINER_UNKNOWN)
 		{
-		case 0:
-			container->type = CONTAINER_BLOOMFILTER;
-			break;
-		default:
 			container->type = CONTAINER_ERROR;
-			break;
 		}
 		break;
 	}
 	default:
 		// Unknown identifier
-		if (container->type == CONTAINER_BLOOMFILTER)
+		if (IS_BLOOMFILTER(container->type))
 		{
-			container_iodata_t state = {container, x->request_file, x->host};
+			container_iodata_t state = {container, x->request_file, x->host, x->spec_only};
 			return fread_bloomconfig(f, key, value, &state);
 		}
+		if (container->type == CONTAINER_CUCKOOFILTER)
+		{
+			container_iodata_t state = {container, x->request_file, x->host, x->spec_only};
+			return fread_cuckooconfig(f, key, value, &state);
+		}
+		if (container->type == CONTAINER_XORFILTER)
+		{
+			container_iodata_t state = {container, x->request_file, x->host, x->spec_only};
+			return fread_xorconfig(f, key, value, &state);
+		}
 		return FALSE;
 	}
 	return TRUE;
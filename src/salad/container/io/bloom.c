@@ -25,6 +25,7 @@
 
 #include <assert.h>
 #include <ctype.h>
+#include <limits.h>
 
 
 const BOOL fwrite_bloomconfig(const container_outputspec_t* const out, const BLOOM* const b)
@@ -99,6 +100,20 @@ const BOOL fwrite_bloomdata(const container_outputspec_t* const out, const BLOOM
 	}
 }
 
+const BOOL fwrite_countingbloomdata(const container_outputspec_t* const out, const BLOOM* const b, container_outputstate_t* const state)
+{
+	assert(b != NULL && b->counters != NULL);
+
+	// The counters are stored instead of the bits, which can be derived
+	// from them. The size specification hence covers 4 bits per counter.
+	BLOOM counters = *b;
+	counters.a = b->counters;
+	counters.bitsize = b->bitsize *4;
+	counters.size = (b->bitsize +1)/2;
+
+	return fwrite_bloomdata(out, &counters, state);
+}
+
 const BOOL fwrite_bloomdata_asis(FILE* const f, const BLOOM* const b, container_outputstate_t* const state)
 {
 	assert(f != NULL);
@@ -216,31 +231,29 @@ const BOOL fwrite_bloom_032(FILE* const f, const BLOOM* const b)
 }
 
 
-static inline const int read_hexbyte(void* usr)
+static const int set_bloomdata(void* const obj, FN_READBYTE fct, const size_t size, void* usr)
 {
-	FILE* f = (FILE*) usr;
-	assert(f != NULL);
-
-	int b1 = 0, b2;
-	while ((b1 = fgetc(f)) != EOF && !isxdigit(b1));
-	while ((b2 = fgetc(f)) != EOF && !isxdigit(b1));
-
-	if (b2 < 0) return EOF;
-
-	char buf[3] = {(char) b1, (char) b2, 0};
-
-	unsigned int ch;
-	sscanf(buf, "%x", &ch);
-
-	return (int) ch;
+	BLOOM* const b = (BLOOM*) obj;
+	return (bloom_is_counting(b) ? bloom_set_counters_ex(b, fct, size, usr) : bloom_set_ex(b, fct, size, usr));
 }
 
-static inline const int read_byte(void* usr)
+// Takes on the size of the bit array without reading it, cf. fread_model_spec.
+// The counters of counting bloom filters cannot be skipped.
+static const int skip_bloomdata(void* const obj, FN_READBYTE fct, const size_t size, void* usr)
 {
-	FILE* f = (FILE*) usr;
-	assert(f != NULL);
+	BLOOM* const b = (BLOOM*) obj;
+	if (bloom_is_counting(b)) return FALSE;
 
-	return fgetc(f);
+	const size_t n = (size +CHAR_BIT -1)/CHAR_BIT;
+	if (fct == read_byte)
+	{
+		if (fseek((FILE*) usr, (long) n, SEEK_CUR) != 0) return FALSE;
+	}
+	else for (size_t i = 0; i < n; i++)
+	{
+		if (fct(usr) < 0) return FALSE;
+	}
+	return bloom_set_size(b, size);
 }
 
 const BOOL fread_bloomconfig(FILE* const f, const char* const key, const char* const value, void* const usr)
@@ -251,11 +264,20 @@ const BOOL fread_bloomconfig(FILE* const f, const char* const key, const char* c
 
 	if (container->data == NULL)
 	{
-		BLOOM* const b = bloom_create(0);
-		container_set_bloomfilter(container, b);
+		if (container->type == CONTAINER_COUNTINGBLOOMFILTER)
+		{
+			container_set_countingbloomfilter(container, bloom_create_counting(0));
+		}
+		else if (container->type == CONTAINER_TWOCLASSBLOOMFILTER)
+		{
+			container_set_twoclassbloomfilter(container, bloom_create(0));
+		}
+		else
+		{
+			container_set_bloomfilter(container, bloom_create(0));
+		}
 	}
 
-	char* tail;
 	switch (cmp(key, "hashes", "data", NULL))
 	{
 	case 0:
@@ -285,62 +307,8 @@ const BOOL fread_bloomconfig(FILE* const f, const char* const key, const char* c
 		break;
 	}
 	case 1:
-	{
-		size_t size = strtoul(value, &tail, 10);
-		int has_validsize = (value != tail && (*tail == '\0' || strcmp(tail, "raw") == 0));
-
-		if (has_validsize)
-		{
-			// We assume it is an inline bloom specification
-			// with the specified size.
-
-			BLOOM* const b = (BLOOM*) container->data;
-			FN_READBYTE read = (*tail == 'r' ? read_byte : read_hexbyte);
-			if (!bloom_set_ex(b, read, size, f)) return FALSE;
-
-			break;
-		}
-
-		const char* const filename = tail;
-		if (x->request_file == NULL || x->host == NULL)
-		{
-			// Illegal configuration or programming error
-			return FALSE;
-		}
-
-		char* const slash = strrchr(tail, '/');
-		if (slash != NULL)
-		{
-			size = strtoul(slash +1, &tail, 10);
-			has_validsize = (tail != slash +1 && *tail == '\0');
-			if (has_validsize)
-			{
-				// all read
-				*slash = '\0';
-			}
-		}
-
-		FILE* const f = x->request_file(filename, x->host);
-		if (f == NULL) return FALSE;
+		return fread_containerdata_ex(f, value, x, (x->spec_only ? skip_bloomdata : set_bloomdata), container->data);
 
-		if (!has_validsize)
-		{
-			// No size specification let's use the file size and
-			// assume the bit size equals the number of bytes *8
-			fseek_s(f, 0, SEEK_END);
-			size = ftell_s(f) * 8;
-			fseek_s(f, 0, SEEK_SET);
-
-			has_validsize = TRUE;
-		}
-
-
-		BLOOM* const b = (BLOOM*) container->data;
-		if (!bloom_set_ex(b, read_byte, size, f)) return FALSE;
-		fclose(f);
-
-		break;
-	}
 	default:
 		// Unknown identifier
 		return FALSE;
@@ -36,6 +36,7 @@
 const BOOL fwrite_bloomconfig(const container_outputspec_t* const out, const BLOOM* const b);
 const BOOL fwrite_bloomconfig_ex(FILE* const f, const BLOOM* const b);
 const BOOL fwrite_bloomdata(const container_outputspec_t* const out, const BLOOM* const b, container_outputstate_t* const state);
+const BOOL fwrite_countingbloomdata(const container_outputspec_t* const out, const BLOOM* const b, container_outputstate_t* const state);
 
 const BOOL fwrite_bloom(FILE* const f, const BLOOM* const b);
 const BOOL fwrite_bloom_ex(FILE* const f, const BLOOM* const b, const container_outputformat_t fmt);
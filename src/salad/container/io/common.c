@@ -0,0 +1,101 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "common.h"
+
+#include <util/util.h>
+
+#include <assert.h>
+#include <ctype.h>
+#include <string.h>
+
+
+const int read_hexbyte(void* usr)
+{
+	FILE* f = (FILE*) usr;
+	assert(f != NULL);
+
+	int b1 = 0, b2;
+	while ((b1 = fgetc(f)) != EOF && !ISHEX(b1));
+	while ((b2 = fgetc(f)) != EOF && !ISHEX(b1));
+
+	if (b2 < 0) return EOF;
+
+	// Same as sscanf(.., "%x", ..), i.e., a non-hex digit ends the number
+	return (ISHEX(b2) ? (HEXVAL(b1) << 4) | HEXVAL(b2) : HEXVAL(b1));
+}
+
+const int read_byte(void* usr)
+{
+	FILE* f = (FILE*) usr;
+	assert(f != NULL);
+
+	return fgetc(f);
+}
+
+
+const BOOL fread_containerdata_ex(FILE* const f, const char* const value, const container_iodata_t* const x, FN_SETDATA set, void* const obj)
+{
+	assert(f != NULL && value != NULL && x != NULL);
+
+	char* tail;
+	size_t size = strtoul(value, &tail, 10);
+	int has_validsize = (value != tail && (*tail == '\0' || strcmp(tail, "raw") == 0));
+
+	if (has_validsize)
+	{
+		// We assume it is an inline specification
+		// with the specified size.
+		FN_READBYTE read = (*tail == 'r' ? read_byte : read_hexbyte);
+		return set(obj, read, size, f);
+	}
+
+	const char* const filename = tail;
+	if (x->request_file == NULL || x->host == NULL)
+	{
+		// Illegal configuration or programming error
+		return FALSE;
+	}
+
+	char* const slash = strrchr(tail, '/');
+	if (slash != NULL)
+	{
+		size = strtoul(slash +1, &tail, 10);
+		has_validsize = (tail != slash +1 && *tail == '\0');
+		if (has_validsize)
+		{
+			// all read
+			*slash = '\0';
+		}
+	}
+
+	FILE* const g = x->request_file(filename, x->host);
+	if (g == NULL) return FALSE;
+
+	if (!has_validsize)
+	{
+		// No size specification let's use the file size and
+		// assume the bit size equals the number of bytes *8
+		fseek_s(g, 0, SEEK_END);
+		size = ftell_s(g) * 8;
+		fseek_s(g, 0, SEEK_SET);
+	}
+
+	const int ret = set(obj, read_byte, size, g);
+	fclose(g);
+	return ret;
+}
@@ -22,6 +22,7 @@
 #ifndef SALAD_CONTAINER_IO_COMMON_H_
 #define SALAD_CONTAINER_IO_COMMON_H_
 
+#include <container/bloom_ex.h>
 #include <util/io.h>
 
 typedef enum {
@@ -60,14 +61,28 @@ typedef struct
 
 	FN_REQUESTFILE request_file;
 	void* host;
+
+	int spec_only; // Skip the data of bloom filters, cf. fread_model_spec
 } container_iodata_t;
 
 
 #define EMPTY_CONTAINER_IODATA_INITIALIZER { \
 		.data = NULL, \
-		.request_file = NULL \
+		.request_file = NULL, \
+		.spec_only = 0 \
 }
 
 #define CONTAINER_IODATA_T(state) container_iostate_t state = EMPTY_CONTAINER_IODATA_INITIALIZER
 
+
+const int read_hexbyte(void* usr);
+const int read_byte(void* usr);
+
+typedef const int (*FN_SETDATA)(void* const obj, FN_READBYTE fct, const size_t bitsize, void* usr);
+/**
+ * Reads the data of a container as specified by the value of the 'data'
+ * key, i.e., inline as hex or raw bytes or in a separate file.
+ */
+const BOOL fread_containerdata_ex(FILE* const f, const char* const value, const container_iodata_t* const x, FN_SETDATA set, void* const obj);
+
 #endif /* SALAD_CONTAINER_IO_COMMON_H_ */
@@ -0,0 +1,126 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "cuckoo.h"
+#include "bloom.h"
+
+#include "common.h"
+
+#include <util/util.h>
+#include <util/simple_conf.h>
+
+#include <assert.h>
+#include <limits.h>
+
+
+const BOOL fwrite_cuckooconfig_ex(FILE* const f, const CUCKOO* const c)
+{
+	assert(f != NULL);
+	assert(c != NULL);
+
+	if (fprintf(f, "fingerprint = %d/%d\n", CUCKOO_FPBITS, CUCKOO_BUCKETSIZE) <= 0) return FALSE;
+
+	if (c->victim != 0)
+	{
+		// A fingerprint that did not find a place in the table
+		const int n = fprintf(f, "victim = %u/%"ZU"\n", (unsigned int) c->victim, (SIZE_T) c->victim_idx);
+		if (n <= 0) return FALSE;
+	}
+	return TRUE;
+}
+
+const BOOL fwrite_cuckoodata(const container_outputspec_t* const out, const CUCKOO* const c, container_outputstate_t* const state)
+{
+	assert(c != NULL);
+
+	const size_t size = c->nbuckets *sizeof(uint64_t);
+	unsigned char* const buf = (unsigned char*) malloc(size);
+	if (buf == NULL) return FALSE;
+
+	// The buckets are stored in little-endian byte order, cf. cuckoo_set_ex
+	for (size_t i = 0; i < c->nbuckets; i++)
+	{
+		for (size_t j = 0; j < sizeof(uint64_t); j++)
+		{
+			buf[i *sizeof(uint64_t) +j] = (unsigned char) (c->buckets[i] >> (j *CHAR_BIT));
+		}
+	}
+
+	// The data is written just as the bits of a bloom filter
+	BLOOM data = {
+			.bitsize = cuckoo_bitsize(c),
+			.size = size,
+			.a = buf,
+			.nfuncs = 0,
+			.funcs = NULL,
+			.counters = NULL
+	};
+
+	const BOOL ret = fwrite_bloomdata(out, &data, state);
+	free(buf);
+	return ret;
+}
+
+
+static const int set_cuckoodata(void* const obj, FN_READBYTE fct, const size_t size, void* usr)
+{
+	return cuckoo_set_ex((CUCKOO*) obj, fct, size, usr);
+}
+
+const BOOL fread_cuckooconfig(FILE* const f, const char* const key, const char* const value, void* const usr)
+{
+	assert(usr != NULL);
+	container_iodata_t* const x = (container_iodata_t*) usr;
+	container_t* const container = (container_t*) x->data;
+
+	if (container->data == NULL)
+	{
+		container_set_cuckoofilter(container, cuckoo_create(1));
+	}
+
+	char* tail;
+	switch (cmp(key, "fingerprint", "victim", "data", NULL))
+	{
+	case 0:
+	{
+		const unsigned long bits = strtoul(value, &tail, 10);
+		if (bits != CUCKOO_FPBITS || *tail != '/') return FALSE;
+
+		const unsigned long bucketsize = strtoul(tail +1, &tail, 10);
+		return (bucketsize == CUCKOO_BUCKETSIZE);
+	}
+	case 1:
+	{
+		const unsigned long fp = strtoul(value, &tail, 10);
+		if (fp > UINT16_MAX || *tail != '/') return FALSE;
+
+		const size_t idx = (size_t) strtoul(tail +1, &tail, 10);
+		// The table might not have been read yet, hence, no range check
+		CUCKOO* const c = (CUCKOO*) container->data;
+		c->count += (c->victim == 0);
+		c->victim = (uint16_t) fp;
+		c->victim_idx = idx;
+		return (fp != 0);
+	}
+	case 2:
+		return fread_containerdata_ex(f, value, x, set_cuckoodata, container->data);
+
+	default:
+		// Unknown identifier
+		return FALSE;
+	}
+}
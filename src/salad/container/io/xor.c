@@ -0,0 +1,107 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "xor.h"
+#include "bloom.h"
+
+#include "common.h"
+
+#include <util/util.h>
+#include <util/simple_conf.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <limits.h>
+
+
+const BOOL fwrite_xorconfig_ex(FILE* const f, const XORFILTER* const x)
+{
+	assert(f != NULL);
+	assert(x != NULL);
+
+	if (fprintf(f, "seed = %"PRIu64"\n", x->seed) <= 0) return FALSE;
+	if (fprintf(f, "keys = %"ZU"\n", (SIZE_T) x->count) <= 0) return FALSE;
+	return TRUE;
+}
+
+const BOOL fwrite_xordata(const container_outputspec_t* const out, const XORFILTER* const x, container_outputstate_t* const state)
+{
+	assert(x != NULL);
+
+	const size_t n = 3 *x->blocklength;
+	unsigned char* const buf = (unsigned char*) malloc(n *sizeof(uint16_t));
+	if (buf == NULL) return FALSE;
+
+	// The fingerprints are stored in little-endian byte order, cf. xor_set_ex
+	for (size_t i = 0; i < n; i++)
+	{
+		buf[2*i]    = (unsigned char) (x->fingerprints[i]);
+		buf[2*i +1] = (unsigned char) (x->fingerprints[i] >> CHAR_BIT);
+	}
+
+	// The data is written just as the bits of a bloom filter
+	BLOOM data = {
+			.bitsize = xor_bitsize(x),
+			.size = n *sizeof(uint16_t),
+			.a = buf,
+			.nfuncs = 0,
+			.funcs = NULL,
+			.counters = NULL
+	};
+
+	const BOOL ret = fwrite_bloomdata(out, &data, state);
+	free(buf);
+	return ret;
+}
+
+
+static const int set_xordata(void* const obj, FN_READBYTE fct, const size_t size, void* usr)
+{
+	return xor_set_ex((XORFILTER*) obj, fct, size, usr);
+}
+
+const BOOL fread_xorconfig(FILE* const f, const char* const key, const char* const value, void* const usr)
+{
+	assert(usr != NULL);
+	container_iodata_t* const x = (container_iodata_t*) usr;
+	container_t* const container = (container_t*) x->data;
+
+	if (container->data == NULL)
+	{
+		container_set_xorfilter(container, xor_create(0));
+	}
+	XORFILTER* const filter = (XORFILTER*) container->data;
+
+	char* tail;
+	switch (cmp(key, "seed", "keys", "data", NULL))
+	{
+	case 0:
+		filter->seed = (uint64_t) strtoull(value, &tail, 10);
+		return (tail != value);
+
+	case 1:
+		filter->count = (size_t) strtoull(value, &tail, 10);
+		return (tail != value);
+
+	case 2:
+		return fread_containerdata_ex(f, value, x, set_xordata, filter);
+
+	default:
+		// Unknown identifier
+		return FALSE;
+	}
+}
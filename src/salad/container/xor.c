@@ -0,0 +1,299 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "xor.h"
+#include "hash.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+
+#include <util/util.h>
+
+#define XOR_SEED 0x726B2B9D438B9D4DULL
+#define XOR_MAXATTEMPTS 100
+
+// The keys are n-gram hashes with 0 folded onto 1, cf. fpset.c
+#define TO_KEY(h) ((h) == 0 ? 1 : (h))
+
+static inline const uint64_t xor_mix(const uint64_t key, const uint64_t seed)
+{
+	// The finalizer of MurmurHash3, i.e., a bijection
+	uint64_t h = key +seed;
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+static inline const uint16_t to_fingerprint(const uint64_t h)
+{
+	return (uint16_t) (h ^ (h >> 32));
+}
+
+static inline const size_t reduce(const uint32_t h, const size_t n)
+{
+	// Maps h onto [0, n) without division (Lemire, 2016)
+	return (size_t) (((uint64_t) h *n) >> 32);
+}
+
+static inline const uint64_t rotl64(const uint64_t h, const int r)
+{
+	return (h << r) | (h >> (64 -r));
+}
+
+static inline const size_t xor_index(const XORFILTER* const x, const uint64_t h, const int i)
+{
+	// Each of the three probes lands in another third of the table
+	const uint32_t r = (uint32_t) (i == 0 ? h : rotl64(h, 21 *i));
+	return reduce(r, x->blocklength) +i *x->blocklength;
+}
+
+
+XORFILTER* const xor_create(const size_t n)
+{
+	XORFILTER* const x = (XORFILTER*) malloc(sizeof(XORFILTER));
+	if (x == NULL)
+	{
+		return NULL;
+	}
+
+	const size_t capacity = 32 +(size_t) (1.23 *n);
+	x->blocklength = capacity/ 3;
+	x->fingerprints = (uint16_t*) calloc(3 *x->blocklength, sizeof(uint16_t));
+	if (x->fingerprints == NULL)
+	{
+		free(x);
+		return NULL;
+	}
+
+	x->seed = XOR_SEED;
+	x->count = n;
+	return x;
+}
+
+void xor_destroy(XORFILTER* const x)
+{
+	if (x == NULL) return;
+
+	free(x->fingerprints);
+	free(x);
+}
+
+
+typedef struct {
+	uint64_t mask; ///< The xor of all hashes mapped to the slot
+	uint32_t count;
+} xorset_t;
+
+typedef struct {
+	uint64_t h;
+	size_t idx;
+} xorkey_t;
+
+/**
+ * Peels the 3-hypergraph of the keys, i.e., repeatedly removes keys
+ * that are the only ones mapped to a particular slot. If all keys are
+ * removed, the returned stack defines the order of assignment.
+ */
+static const size_t xor_peel(const XORFILTER* const x, const uint64_t* const keys, const size_t n,
+		xorset_t* const sets, size_t* const queue, xorkey_t* const stack)
+{
+	const size_t capacity = 3 *x->blocklength;
+	memset(sets, 0x00, capacity *sizeof(xorset_t));
+
+	for (size_t i = 0; i < n; i++)
+	{
+		const uint64_t h = xor_mix(keys[i], x->seed);
+		for (int j = 0; j < 3; j++)
+		{
+			xorset_t* const s = &sets[xor_index(x, h, j)];
+			s->mask ^= h;
+			s->count++;
+		}
+	}
+
+	size_t qlen = 0;
+	for (size_t i = 0; i < capacity; i++)
+	{
+		if (sets[i].count == 1) queue[qlen++] = i;
+	}
+
+	size_t slen = 0;
+	while (qlen > 0)
+	{
+		const size_t idx = queue[--qlen];
+		if (sets[idx].count != 1) continue;
+
+		const uint64_t h = sets[idx].mask;
+		stack[slen].h = h;
+		stack[slen].idx = idx;
+		slen++;
+
+		for (int j = 0; j < 3; j++)
+		{
+			const size_t k = xor_index(x, h, j);
+			sets[k].mask ^= h;
+			if (--sets[k].count == 1)
+			{
+				queue[qlen++] = k;
+			}
+		}
+	}
+	return slen;
+}
+
+XORFILTER* const xor_build(const uint64_t* const keys, const size_t n)
+{
+	assert(keys != NULL || n == 0);
+
+	XORFILTER* const x = xor_create(n);
+	if (x == NULL)
+	{
+		return NULL;
+	}
+
+	const size_t capacity = 3 *x->blocklength;
+	xorset_t* const sets = (xorset_t*) malloc(capacity *sizeof(xorset_t));
+	size_t* const queue = (size_t*) malloc(capacity *sizeof(size_t));
+	xorkey_t* const stack = (xorkey_t*) malloc(MAX(n, 1) *sizeof(xorkey_t));
+
+	int ok = (sets != NULL && queue != NULL && stack != NULL);
+	if (ok)
+	{
+		// The keys need to be distinct, otherwise peeling never succeeds
+		int attempt = 0;
+		for (; xor_peel(x, keys, n, sets, queue, stack) != n; attempt++)
+		{
+			if (attempt >= XOR_MAXATTEMPTS)
+			{
+				ok = FALSE;
+				break;
+			}
+			x->seed = xor_mix(x->seed, XOR_SEED);
+		}
+	}
+
+	if (ok)
+	{
+		// Assign in reverse order, such that the slot of each key is
+		// the last one out of its three to be written.
+		for (size_t i = n; i-- > 0;)
+		{
+			const uint64_t h = stack[i].h;
+			uint16_t fp = to_fingerprint(h);
+			for (int j = 0; j < 3; j++)
+			{
+				fp ^= x->fingerprints[xor_index(x, h, j)];
+			}
+			x->fingerprints[stack[i].idx] = fp;
+		}
+	}
+
+	free(sets);
+	free(queue);
+	free(stack);
+
+	if (!ok)
+	{
+		xor_destroy(x);
+		return NULL;
+	}
+	return x;
+}
+
+
+const int xor_set_ex(XORFILTER* const x, FN_READBYTE fct, const size_t bitsize, void* usr)
+{
+	assert(x != NULL);
+
+	const size_t capacity = bitsize/ XOR_FPBITS;
+	if (capacity == 0 || capacity %3 != 0)
+	{
+		return FALSE;
+	}
+
+	uint16_t* const fingerprints = (uint16_t*) malloc(capacity *sizeof(uint16_t));
+	if (fingerprints == NULL)
+	{
+		return FALSE;
+	}
+
+	// Fingerprints are stored in little-endian byte order
+	for (size_t i = 0; i < capacity; i++)
+	{
+		const int lo = fct(usr);
+		const int hi = fct(usr);
+		if (lo < 0 || hi < 0)
+		{
+			free(fingerprints);
+			return FALSE;
+		}
+		fingerprints[i] = (uint16_t) (lo | (hi << CHAR_BIT));
+	}
+
+	free(x->fingerprints);
+	x->fingerprints = fingerprints;
+	x->blocklength = capacity/ 3;
+	return TRUE;
+}
+
+
+const int xor_check_str(const XORFILTER* const x, const char* const s, const size_t len)
+{
+	assert(x != NULL);
+
+	const uint64_t key = murmur64_hash_n(s, len);
+	const uint64_t h = xor_mix(TO_KEY(key), x->seed);
+
+	const uint16_t fp = x->fingerprints[xor_index(x, h, 0)]
+	                  ^ x->fingerprints[xor_index(x, h, 1)]
+	                  ^ x->fingerprints[xor_index(x, h, 2)];
+
+	return (fp == to_fingerprint(h));
+}
+
+const size_t xor_bitsize(const XORFILTER* const x)
+{
+	assert(x != NULL);
+	return 3 *x->blocklength *XOR_FPBITS;
+}
+
+const int xor_compare(const XORFILTER* const a, const XORFILTER* const b)
+{
+	if (a == b)
+	{
+		return 0;
+	}
+
+	if (a == NULL || b == NULL)
+	{
+		return (a < b ? -1 : 1);
+	}
+
+	if (a->blocklength != b->blocklength)
+	{
+		return (a->blocklength < b->blocklength ? -1 : 1);
+	}
+	if (a->seed != b->seed)
+	{
+		return (a->seed < b->seed ? -1 : 1);
+	}
+	return memcmp(a->fingerprints, b->fingerprints, 3 *a->blocklength *sizeof(uint16_t));
+}
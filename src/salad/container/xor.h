@@ -0,0 +1,55 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+/**
+ * @file
+ *
+ * A static xor filter (Graf & Lemire, 2020) with 16-bit fingerprints.
+ * The filter is built once from a set of 64-bit keys and answers each
+ * query with three probes, one in each third of the table. It uses
+ * ~1.23 fingerprints per key and cannot be updated afterwards.
+ */
+
+#ifndef SALAD_CONTAINER_XOR_H_
+#define SALAD_CONTAINER_XOR_H_
+
+#include "bloom_ex.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define XOR_FPBITS 16 ///< The bits per fingerprint
+
+typedef struct {
+	uint64_t seed;
+	size_t blocklength; ///< A third of the number of fingerprints
+	size_t count; ///< The number of keys the filter has been built from
+	uint16_t* fingerprints;
+} XORFILTER;
+
+XORFILTER* const xor_create(const size_t n);
+XORFILTER* const xor_build(const uint64_t* const keys, const size_t n);
+void xor_destroy(XORFILTER* const x);
+
+const int xor_set_ex(XORFILTER* const x, FN_READBYTE fct, const size_t bitsize, void* usr);
+
+const int xor_check_str(const XORFILTER* const x, const char* const s, const size_t len);
+
+const size_t xor_bitsize(const XORFILTER* const x);
+const int xor_compare(const XORFILTER* const a, const XORFILTER* const b);
+
+#endif /* SALAD_CONTAINER_XOR_H_ */
@@ -22,9 +22,11 @@
 #include <container/io/common.h>
 
 #include <util/util.h>
+#include <util/getline.h>
 #include <util/simple_conf.h>
 
 #include <assert.h>
+#include <ctype.h>
 #include <limits.h>
 #include <stdlib.h>
 #include <string.h>
@@ -105,6 +107,28 @@ const BOOL fwrite_modelconfig(const container_outputspec_t* const out, const sal
 	return (CONTAINER_TXT(out) ? fwrite_modelconfig_ex(out->config, s) : FALSE);
 }
 
+// The interned tokens follow the key line, one per line in the order of
+// their ids. Non-printable characters are percent-encoded (cf. inline_decode).
+static const BOOL fwrite_tokens(FILE* const f, const DICT* const d)
+{
+	if (fprintf(f, "tokens = %"ZU"\n", (SIZE_T) d->count) <= 0) return FALSE;
+
+	for (uint32_t id = 1; id <= d->count; id++)
+	{
+		size_t len;
+		const char* const str = dict_get(d, id, &len);
+
+		for (size_t i = 0; i < len; i++)
+		{
+			const unsigned char ch = (unsigned char) str[i];
+			const int n = (isgraph(ch) && ch != '%' ? fputc(ch, f) : fprintf(f, "%%%02X", ch));
+			if (n < 0) return FALSE;
+		}
+		if (fputc('\n', f) == EOF) return FALSE;
+	}
+	return TRUE;
+}
+
 const BOOL fwrite_modelconfig_ex(FILE* const f, const salad_t* const s)
 {
 	int n = fprintf(f, "%s\n\n", CONFIG_HEADER);
@@ -119,6 +143,8 @@ const BOOL fwrite_modelconfig_ex(FILE* const f, const salad_t* const s)
 	n = fprintf(f, "n = %"ZU"\n", (SIZE_T) s->ngram_length);
 	if (n <= 0) return FALSE;
 
+	if (_(s)->tokens != NULL && !fwrite_tokens(f, _(s)->tokens)) return FALSE;
+
 	const container_t* const c = (container_t*) s->model.x;
 	return fwrite_containerconfig_ex(f, c);
 }
@@ -202,6 +228,9 @@ const BOOL fwrite_model_zip(FILE* const f, const salad_t* const s)
 }
 
 
+static const BOOL fread_model_txt_ex(FILE* const f, salad_t* const s, const int spec_only);
+static const BOOL fread_model_zip_ex(FILE* const f, salad_t* const s, const int spec_only);
+
 const BOOL fread_model(FILE* const f, salad_t* const s)
 {
 	if (fread_model_zip(f, s)) return TRUE;
@@ -214,11 +243,19 @@ const BOOL fread_model(FILE* const f, salad_t* const s)
 	return fread_model_032(f, s);
 }
 
+const BOOL fread_model_spec(FILE* const f, salad_t* const s)
+{
+	// The old format is read in one go
+	return fread_model_zip_ex(f, s, TRUE) || fread_model_txt_ex(f, s, TRUE);
+}
+
 
 typedef struct
 {
 	salad_t* s;
 	int ngramlen_specified;
+	int tokens_corrupt;
+	int spec_only; // cf. fread_model_spec
 
 	int has_container;
 	container_t container;
@@ -228,6 +265,8 @@ typedef struct
 #define EMPTY_MODELCONF_SPEC_INITIALIZER { \
 		.s = NULL, \
 		.ngramlen_specified = 0, \
+		.tokens_corrupt = 0, \
+		.spec_only = 0, \
 		.has_container = 0, \
 		.container = EMPTY_CONTAINER \
 }
@@ -235,6 +274,32 @@ typedef struct
 #define MODELCONF_SPEC_T(spec) modelconf_spec_t spec = EMPTY_MODELCONF_SPEC_INITIALIZER
 
 
+static const BOOL fread_tokens(FILE* const f, const char* const value, salad_t* const s)
+{
+	char* tail;
+	const size_t count = (size_t) strtoul(value, &tail, 10);
+	if (tail == value || salad_intern_tokens(s, TRUE) != EXIT_SUCCESS) return FALSE;
+
+	char* line = NULL;
+	size_t size = 0, i = 0;
+
+	for (; i < count; i++)
+	{
+		const ssize_t n = getline(&line, &size, f);
+		if (n <= 0) break;
+
+		size_t len = (size_t) n;
+		if (line[len -1] == '\n') len--;
+		if (len > 0 && line[len -1] == '\r') len--;
+
+		len = inline_decode(line, len);
+		// The ids need to be restored exactly as they were assigned
+		if (dict_insert(_(s)->tokens, line, len) != i +1) break;
+	}
+	free(line);
+	return (i == count);
+}
+
 const BOOL fread_modelconfig(FILE* const f, const char* const key, const char* const value, void* const usr)
 {
 	assert(usr != NULL);
@@ -242,7 +307,7 @@ const BOOL fread_modelconfig(FILE* const f, const char* const key, const char* c
 	modelconf_spec_t* const conf = (modelconf_spec_t*) x->data;
 
 	char* tail;
-	switch (cmp(key, "binary", "delimiter", "n", NULL))
+	switch (cmp(key, "binary", "delimiter", "n", "tokens", NULL))
 	{
 	case 0:
 	{
@@ -266,10 +331,19 @@ const BOOL fread_modelconfig(FILE* const f, const char* const key, const char* c
 		conf->ngramlen_specified = TRUE;
 		break;
 	}
+	case 3:
+	{
+		if (!fread_tokens(f, value, conf->s))
+		{
+			conf->tokens_corrupt = TRUE;
+			return FALSE;
+		}
+		break;
+	}
 	default:
 	{
 		// Unknown identifier
-		container_iodata_t state = {&conf->container, x->request_file, x->host};
+		container_iodata_t state = {&conf->container, x->request_file, x->host, conf->spec_only};
 		if (fread_containerconfig(f, key, value, &state))
 		{
 			salad_set_container(conf->s, &conf->container);
@@ -281,22 +355,29 @@ const BOOL fread_modelconfig(FILE* const f, const char* const key, const char* c
 }
 
 const BOOL fread_model_txt(FILE* const f, salad_t* const s)
+{
+	return fread_model_txt_ex(f, s, FALSE);
+}
+
+static const BOOL fread_model_txt_ex(FILE* const f, salad_t* const s, const int spec_only)
 {
 	assert(f != NULL && s != NULL);
 
 	// Set default values
 	salad_use_binary_ngrams(s, FALSE);
 	salad_set_delimiter(s, "");
+	salad_intern_tokens(s, FALSE);
 
 	MODELCONF_SPEC_T(conf);
 	conf.s = s;
+	conf.spec_only = spec_only;
 
 	container_iodata_t state = {&conf, NULL, NULL};
 	const size_t n = fread_config(f, CONFIG_HEADER, fread_modelconfig, &state);
 	if (n <= 0) return FALSE;
 
 	// The bloom filter and the n-gram length are mandatory, though
-	if (!conf.ngramlen_specified) return FALSE;
+	if (!conf.ngramlen_specified || conf.tokens_corrupt) return FALSE;
 
 	return TRUE;
 }
@@ -336,6 +417,11 @@ FILE* const request_input(const char* const filename, void* const host)
 #endif
 
 const BOOL fread_model_zip(FILE* const f, salad_t* const s)
+{
+	return fread_model_zip_ex(f, s, FALSE);
+}
+
+static const BOOL fread_model_zip_ex(FILE* const f, salad_t* const s, const int spec_only)
 {
 #ifndef USE_ARCHIVES
 	return FALSE;
@@ -375,9 +461,11 @@ const BOOL fread_model_zip(FILE* const f, salad_t* const s)
 	// Set default values
 	salad_use_binary_ngrams(s, FALSE);
 	salad_set_delimiter(s, "");
+	salad_intern_tokens(s, FALSE);
 
 	MODELCONF_SPEC_T(conf);
 	conf.s = s;
+	conf.spec_only = spec_only;
 
 	requested_input_t x = {f, 0};
 	container_iodata_t state = {&conf, request_input, &x};
@@ -387,7 +475,7 @@ const BOOL fread_model_zip(FILE* const f, salad_t* const s)
 	if (m <= 0) return FALSE;
 
 	// The bloom filter and the n-gram length are mandatory, though
-	if (!conf.ngramlen_specified) return FALSE;
+	if (!conf.ngramlen_specified || conf.tokens_corrupt) return FALSE;
 
 	return TRUE;
 #endif
@@ -401,6 +489,7 @@ const BOOL fread_model_032(FILE* const f, salad_t* const s)
 	// Set default values
 	salad_use_binary_ngrams(s, FALSE);
 	salad_set_delimiter(s, "");
+	salad_intern_tokens(s, FALSE);
 
 	char* const delimiter = fread_str(f);
 	if (delimiter != NULL)
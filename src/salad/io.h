@@ -57,6 +57,8 @@ const BOOL fwrite_model_zip(FILE* const f, const salad_t* const s);
 // READING
 const BOOL fread_modelconfig(FILE* const f, const char* const key, const char* const value, void* const usr);
 const BOOL fread_model(FILE* const f, salad_t* const s);
+// Same as fread_model, but skips the bit array of bloom filters
+const BOOL fread_model_spec(FILE* const f, salad_t* const s);
 const BOOL fread_model_txt(FILE* const f, salad_t* const s);
 const BOOL fread_model_zip(FILE* const f, salad_t* const s);
 const BOOL fread_model_032(FILE* const f, salad_t* const s);
@@ -17,8 +17,21 @@
 
 #include "ngrams.h"
 
+#include <util/cpu.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef HAVE_CPU_DISPATCH
+#include <immintrin.h>
+#endif
+
 // bit n-grams
+extern inline uint64_t bitgram_mix(uint64_t x);
+extern inline uint64_t bitgram_load(const char* const x, const size_t avail);
+extern inline void extract_bitgrams_ex(const char* const str, const size_t len, const size_t n, FN_PROCESS_NGRAM fct, FN_PROCESS_HASH hfct, void* const data);
 extern inline void extract_bitgrams(const char* const str, const size_t len, const size_t n, FN_PROCESS_NGRAM fct, void* const data);
+extern inline void extract_bitgrams_hashed(const char* const str, const size_t len, const size_t n, FN_PROCESS_HASH hfct, void* const data);
 extern inline void extract_bgrams(const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, FN_PROCESS_NGRAM fct, void* const data);
 
 // byte or character n-grams
@@ -27,5 +40,141 @@ extern inline void extract_ngrams(const char* const str, const size_t len, const
 
 // token or word n-grams
 extern inline const char pick_delimiterchar(const delimiter_array_t delim);
-extern inline char* const uniquify(const char** const str, size_t* const len, const delimiter_array_t delim, const char ch);
+extern inline void wcursor_init(wcursor_t* const c, const char* const str, const size_t len, const delimiter_array_t delim);
+extern inline const size_t wcursor_find(wcursor_t* const c, size_t x, const int delimiter);
+extern inline const int next_wtoken(wcursor_t* const c, size_t* const x, wtoken_t* const tok);
 extern inline void extract_wgrams(const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, FN_PROCESS_NGRAM fct, void* const data);
+extern inline void extract_igrams(const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, DICT* const dict, const int learn, FN_PROCESS_NGRAM fct, void* const data);
+extern inline void extract_hgrams(const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, FN_PROCESS_NGRAM fct, void* const data);
+
+// n-grams as represented by the given model
+extern inline void extract_bgrams_for(const container_t* const model, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, FN_PROCESS_NGRAM fct, void* const data);
+extern inline void extract_ngrams_for(const container_t* const model, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, FN_PROCESS_NGRAM fct, void* const data);
+extern inline void extract_wgrams_for(const container_t* const model, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, FN_PROCESS_NGRAM fct, void* const data);
+
+
+// Grows only, such that the extraction of n-grams does not allocate memory
+// in the steady state. It is kept for the lifetime of the thread.
+static __thread void* scratch = NULL;
+static __thread size_t scratch_size = 0;
+
+void* const ngrams_scratch(const size_t size)
+{
+	if (size > scratch_size)
+	{
+		const size_t m = MAX(size, 2*scratch_size);
+		void* const x = realloc(scratch, m);
+		if (x == NULL)
+		{
+			return NULL;
+		}
+		scratch = x;
+		scratch_size = m;
+	}
+	return scratch;
+}
+
+void ngrams_scratch_free()
+{
+	free(scratch);
+	scratch = NULL;
+	scratch_size = 0;
+}
+
+
+static __thread DELIM(scan_delim) = {0};
+static __thread delimscan_t scan = {NULL, {0}, 0};
+
+const delimscan_t* const ngrams_delimscan(const delimiter_array_t delim)
+{
+	if (scan.table != NULL && memcmp(scan_delim, delim, DELIM_SIZE) == 0)
+	{
+		return &scan;
+	}
+	memcpy(scan_delim, delim, DELIM_SIZE);
+
+	scan.table = scan_delim;
+	scan.num_chars = 0;
+#if defined(__SSE2__) || defined(HAVE_CPU_DISPATCH)
+	for (size_t i = 0; i < DELIM_SIZE; i++)
+	{
+		if (!delim[i]) continue;
+
+		if (scan.num_chars >= DELIMSCAN_MAX_CHARS)
+		{
+			// Too many to compare against, the array is looked up instead
+			scan.num_chars = 0;
+			break;
+		}
+		scan.chars[scan.num_chars++] = (uint8_t) i;
+	}
+#endif
+	return &scan;
+}
+
+#ifdef HAVE_CPU_DISPATCH
+// Full blocks are compared 32 or 64 bytes at a time if the CPU allows to
+CPU_TARGET("avx2") static uint64_t delimscan_block_avx2(const delimscan_t* const scan, const char* const str)
+{
+	uint64_t mask = 0;
+	for (size_t i = 0; i < DELIMSCAN_BLOCK; i += 32)
+	{
+		const __m256i x = _mm256_loadu_si256((const __m256i*) (str +i));
+
+		__m256i m = _mm256_setzero_si256();
+		for (size_t j = 0; j < scan->num_chars; j++)
+		{
+			m = _mm256_or_si256(m, _mm256_cmpeq_epi8(x, _mm256_set1_epi8((char) scan->chars[j])));
+		}
+		mask |= (uint64_t) (uint32_t) _mm256_movemask_epi8(m) << i;
+	}
+	return mask;
+}
+
+CPU_TARGET("avx512bw") static uint64_t delimscan_block_avx512(const delimscan_t* const scan, const char* const str)
+{
+	const __m512i x = _mm512_loadu_si512((const void*) str);
+
+	uint64_t mask = 0;
+	for (size_t j = 0; j < scan->num_chars; j++)
+	{
+		mask |= (uint64_t) _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8((char) scan->chars[j]));
+	}
+	return mask;
+}
+#endif
+
+uint64_t delimscan_mask(const delimscan_t* const scan, const char* const str, const size_t len)
+{
+#ifdef HAVE_CPU_DISPATCH
+	if (scan->num_chars > 0 && len >= DELIMSCAN_BLOCK)
+	{
+		const unsigned int cpu = cpu_features();
+		if (cpu & CPU_AVX512BW) return delimscan_block_avx512(scan, str);
+		if (cpu & CPU_AVX2)     return delimscan_block_avx2(scan, str);
+	}
+#endif
+	const size_t n = MIN(len, DELIMSCAN_BLOCK);
+	uint64_t mask = (n < DELIMSCAN_BLOCK ? ~UINT64_C(0) << n : 0);
+
+	size_t i = 0;
+#ifdef __SSE2__
+	// Full chunks of 16 bytes are compared at once, the rest byte by byte
+	for (; scan->num_chars > 0 && i +16 <= n; i += 16)
+	{
+		const __m128i x = _mm_loadu_si128((const __m128i*) (str +i));
+
+		__m128i m = _mm_setzero_si128();
+		for (size_t j = 0; j < scan->num_chars; j++)
+		{
+			m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8((char) scan->chars[j])));
+		}
+		mask |= (uint64_t) (uint16_t) _mm_movemask_epi8(m) << i;
+	}
+#endif
+	for (; i < n; i++)
+	{
+		mask |= (uint64_t) (scan->table[(unsigned char) str[i]] != 0) << i;
+	}
+	return mask;
+}
@@ -25,8 +25,13 @@
 #include "common.h"
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <limits.h>
 
+#include <container/container.h>
+#include <container/dict.h>
+#include <container/hash.h>
 #include <util/util.h>
 
 typedef void(*FN_PROCESS_NGRAM)(const char* const ngram, const size_t len, void* const data);
@@ -36,40 +41,98 @@ typedef void(*FN_PROCESS_NGRAM)(const char* const ngram, const size_t len, void*
 #define TO_CHARPTR(x, m) ((char*) &(x))
 #else
 #define TO_BITGRAM(x) REVERSE_REG((*(bitgram_t*) x))
-#define TO_CHARPTR(x, m) ((char*) &(x) +(BITGRAM_SIZE -(m)))
+#define TO_CHARPTR(x, m) ((char*) &(x) +(sizeof(bitgram_t) -(m)))
 #endif
 
 
 // bit n-grams
-inline void extract_bitgrams(const char* const str, const size_t len, const size_t n, FN_PROCESS_NGRAM fct, void* const data)
+typedef void(*FN_PROCESS_HASH)(const uint64_t hash, void* const data);
+
+// Seed and finalizer (cf. MurmurHash3) for hashing bit n-grams by value
+#define BITGRAM_SEED 0x2545f4914f6cdd1dULL
+
+inline uint64_t bitgram_mix(uint64_t x)
 {
-	const ngram_mask_t mask = ((ngram_mask_t) -1) << (int) MAX(BITGRAM_BITSIZE -n, 0);
-	const size_t m = (n + BITGRAM_SIZE - 1) / BITGRAM_SIZE;
+	x ^= BITGRAM_SEED;
+	x = (x ^ (x >> 33)) *0xff51afd7ed558ccdULL;
+	x = (x ^ (x >> 33)) *0xc4ceb9fe1a85ec53ULL;
+	return x ^ (x >> 33);
+}
 
-	const char* x = str;
-	for (; x < str +len -BITGRAM_SIZE; x++)
+// Loads up to 8 bytes such that the first bit of the input is the most
+// significant one. Missing bytes at the end of the input are zero.
+inline uint64_t bitgram_load(const char* const x, const size_t avail)
+{
+	uint64_t w = 0;
+	if (avail >= sizeof(uint64_t))
 	{
-		bitgram_t u = TO_BITGRAM(x);
-		for (int i = 0; i < CHAR_BIT; i++)
-		{
-			bitgram_t cur = (u & mask);
-			fct(TO_CHARPTR(cur, m), m, data);
-			u <<= 1;
-		}
+		memcpy(&w, x, sizeof(uint64_t));
+#ifndef IS_BIGENDIAN
+		w = REVERSE_UINT64(w);
+#endif
+		return w;
 	}
 
-	const ptrdiff_t d = x -str;
-	const size_t remainder = (len -((size_t) d)) *8;
+	for (size_t i = 0; i < avail; i++)
+	{
+		w |= ((uint64_t) (unsigned char) x[i]) << (56 -CHAR_BIT*i);
+	}
+	return w;
+}
+
+/**
+ * Extracts all bit n-grams of the given string. The input is read word by
+ * word into a 128-bit window (hi, lo), from which 64 consecutive bit n-grams
+ * are shifted out before the window advances. Either the bit n-grams are
+ * passed on as keys of one to eight bytes or, if hfct is given, as 64-bit
+ * hashes of their value.
+ */
+inline void extract_bitgrams_ex(const char* const str, const size_t len, const size_t n, FN_PROCESS_NGRAM fct, FN_PROCESS_HASH hfct, void* const data)
+{
+	assert(n > 0 && n <= 64);
+	if (len *CHAR_BIT < n) return;
+
+	const uint64_t mask = ((uint64_t) -1) << (64 -n);
+	const size_t m = (n + CHAR_BIT -1)/ CHAR_BIT;
+	const size_t num = len *CHAR_BIT -n +1;
 
-	bitgram_t u = TO_BITGRAM(x);
-	for (size_t i = 0; i < remainder -n +1; i++)
+	uint64_t hi = bitgram_load(str, len);
+	uint64_t lo = (len > 8 ? bitgram_load(str +8, len -8) : 0);
+
+	for (size_t x = 16, p = 0; p < num; x += 8, p += 64)
 	{
-		bitgram_t cur = (u & mask);
-		fct(TO_CHARPTR(cur, m), m, data);
-		u <<= 1;
+		const size_t k = MIN(num -p, 64);
+		for (size_t i = 0; i < k; i++)
+		{
+			// The bits of lo are shifted in twice to avoid shifting by 64
+			const uint64_t cur = ((hi << i) | ((lo >> 1) >> (63 -i))) & mask;
+
+			if (hfct != NULL)
+			{
+				hfct(bitgram_mix(cur), data);
+			}
+			else
+			{
+				// Keys are compatible with the byte-wise extraction of former versions
+				bitgram_t key = (bitgram_t) (cur >> (64 -sizeof(bitgram_t) *CHAR_BIT));
+				fct(TO_CHARPTR(key, m), m, data);
+			}
+		}
+		hi = lo;
+		lo = (x < len ? bitgram_load(str +x, len -x) : 0);
 	}
 }
 
+inline void extract_bitgrams(const char* const str, const size_t len, const size_t n, FN_PROCESS_NGRAM fct, void* const data)
+{
+	extract_bitgrams_ex(str, len, n, fct, NULL, data);
+}
+
+inline void extract_bitgrams_hashed(const char* const str, const size_t len, const size_t n, FN_PROCESS_HASH hfct, void* const data)
+{
+	extract_bitgrams_ex(str, len, n, NULL, hfct, data);
+}
+
 inline void extract_bgrams(const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, FN_PROCESS_NGRAM fct, void* const data)
 {
 	extract_bitgrams(str, len, n, fct, data);
@@ -105,82 +168,288 @@ inline const char pick_delimiterchar(const delimiter_array_t delim)
 	return -1;
 }
 
-inline char* const uniquify(const char** const str, size_t* const len, const delimiter_array_t delim, const char ch)
+/**
+ * Returns a buffer of at least the given size that is owned by the calling
+ * thread and reused by subsequent calls, i.e., the content is only valid
+ * until the next call.
+ */
+void* const ngrams_scratch(const size_t size);
+/**
+ * Releases the buffer of the calling thread, e.g., before the thread exits.
+ */
+void ngrams_scratch_free();
+
+typedef struct {
+	const char* start;
+	size_t len;
+	int single_delim; ///< Whether the token is followed by exactly one delimiter character
+	uint64_t hash;
+} wtoken_t;
+
+#define WGRAMS_SCRATCH(n, len) ((n) *sizeof(wtoken_t) +(len) +1)
+#define WTOKENS(scratch) ((wtoken_t*) (scratch))
+#define WBUFFER(scratch, n) ((char*) (scratch) +(n) *sizeof(wtoken_t))
+
+/**
+ * A delimiter array compiled for locating delimiter characters in blocks
+ * of 64 bytes at once rather than looking up every single byte.
+ */
+#define DELIMSCAN_BLOCK    64
+#define DELIMSCAN_MAX_CHARS 16
+
+typedef struct {
+	const uint8_t* table; ///< The delimiter array itself
+	uint8_t chars[DELIMSCAN_MAX_CHARS]; ///< The delimiter characters to compare against
+	size_t num_chars; ///< The number of delimiter characters or 0 if they are looked up one by one
+} delimscan_t;
+
+/**
+ * Returns the compiled form of the given delimiter array. It is cached per
+ * thread and only compiled anew if the delimiters differ from the last call.
+ */
+const delimscan_t* const ngrams_delimscan(const delimiter_array_t delim);
+
+/**
+ * Returns a bit mask of the delimiter characters among the first (up to)
+ * 64 bytes of the given string. Bits beyond the end of the string are set.
+ */
+uint64_t delimscan_mask(const delimscan_t* const scan, const char* const str, const size_t len);
+
+typedef struct {
+	const delimscan_t* scan;
+	const char* str;
+	size_t len;
+	size_t block; ///< The offset of the block described by the mask
+	uint64_t mask;
+} wcursor_t;
+
+inline void wcursor_init(wcursor_t* const c, const char* const str, const size_t len, const delimiter_array_t delim)
+{
+	c->scan = ngrams_delimscan(delim);
+	c->str = str;
+	c->len = len;
+	c->block = 0;
+	c->mask = (c->scan->num_chars > 0 ? delimscan_mask(c->scan, str, len) : 0);
+}
+
+// The offset of the first (non-)delimiter character at or after x
+inline const size_t wcursor_find(wcursor_t* const c, size_t x, const int delimiter)
 {
-	assert(str != NULL && *str != NULL && len != NULL);
+	if (c->scan->num_chars == 0)
+	{
+		const uint8_t* const table = c->scan->table;
+		if (delimiter)
+		{
+			while (x < c->len && !table[(unsigned char) c->str[x]]) x++;
+		}
+		else
+		{
+			while (x < c->len && table[(unsigned char) c->str[x]]) x++;
+		}
+		return x;
+	}
 
-	size_t slen = 0;
-	char* s = (char*) malloc(*len +2);
+	while (x < c->len)
+	{
+		if (x >= c->block +DELIMSCAN_BLOCK)
+		{
+			c->block = x;
+			c->mask = delimscan_mask(c->scan, c->str +x, c->len -x);
+		}
 
-	char prev = ch;
-    for (const char* x = *str; x < *str +*len; x++)
-    {
-		if (delim[(unsigned char) *x])
+		const uint64_t m = (delimiter ? c->mask : ~c->mask) >> (x -c->block);
+		if (m != 0)
 		{
-			if (prev != ch)
+			return MIN(x +(size_t) __builtin_ctzll(m), c->len);
+		}
+		x = c->block +DELIMSCAN_BLOCK;
+	}
+	return c->len;
+}
+
+/**
+ * Moves on to the next token of the input string, where subsequent delimiter
+ * characters are treated as one.
+ */
+inline const int next_wtoken(wcursor_t* const c, size_t* const x, wtoken_t* const tok)
+{
+	const size_t start = wcursor_find(c, *x, FALSE);
+	if (start >= c->len) return FALSE;
+
+	const size_t end = wcursor_find(c, start, TRUE);
+	tok->start = c->str +start;
+	tok->len = end -start;
+	tok->single_delim = (end +1 >= c->len || !c->scan->table[(unsigned char) c->str[end +1]]);
+
+	*x = end;
+	return TRUE;
+}
+
+inline void extract_wgrams(const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, FN_PROCESS_NGRAM fct, void* const data)
+{
+	assert(n > 0);
+	const char ch = pick_delimiterchar(delim);
+
+	// The window of the last n tokens followed by a buffer for joining them
+	void* const scratch = ngrams_scratch(WGRAMS_SCRATCH(n, len));
+	if (scratch == NULL) return;
+
+	wtoken_t* const window = WTOKENS(scratch);
+	char* const buf = WBUFFER(scratch, n);
+
+	wcursor_t c;
+	wcursor_init(&c, str, len, delim);
+
+	size_t num_tokens = 0;
+	wtoken_t tok;
+	for (size_t x = 0; next_wtoken(&c, &x, &tok);)
+	{
+		window[num_tokens %n] = tok;
+		num_tokens++;
+
+		if (num_tokens >= n)
+		{
+			const wtoken_t* const first = &window[num_tokens %n];
+
+			// The n-gram can be passed as is, if the tokens are joined by
+			// exactly the delimiter character used for separating them
+			int in_place = TRUE;
+			for (size_t i = 0; i < n -1 && in_place; i++)
+			{
+				const wtoken_t* const t = &window[(num_tokens +i) %n];
+				in_place = (t->single_delim && t->start[t->len] == ch);
+			}
+
+			if (in_place)
 			{
-				prev = s[slen++] = ch;
+				fct(first->start, (size_t) (tok.start +tok.len -first->start), data);
+			}
+			else
+			{
+				size_t wlen = 0;
+				for (size_t i = 0; i < n; i++)
+				{
+					const wtoken_t* const t = &window[(num_tokens +i) %n];
+					if (i > 0) buf[wlen++] = ch;
+
+					memcpy(buf +wlen, t->start, t->len);
+					wlen += t->len;
+				}
+				fct(buf, wlen, data);
 			}
 		}
-		else
+	}
+}
+
+// Combines the hash of the current token with the ones of its predecessors
+#define WGRAM_SEED 0x9e3779b97f4a7c15ULL
+#define WGRAM_MIX(h, x) (((h) ^ (x)) *0xff51afd7ed558ccdULL)
+
+/**
+ * Extracts token n-grams as extract_wgrams does, but represents each of
+ * them by a 64-bit key that is combined from the hashes of its tokens
+ * rather than by its characters. Hence, each token is hashed once only
+ * and the n-grams are never copied.
+ */
+inline void extract_hgrams(const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, FN_PROCESS_NGRAM fct, void* const data)
+{
+	assert(n > 0);
+	wtoken_t* const window = WTOKENS(ngrams_scratch(WGRAMS_SCRATCH(n, 0)));
+	if (window == NULL) return;
+
+	wcursor_t c;
+	wcursor_init(&c, str, len, delim);
+
+	size_t num_tokens = 0;
+	wtoken_t tok;
+	for (size_t x = 0; next_wtoken(&c, &x, &tok);)
+	{
+		window[num_tokens %n].hash = murmur64_hash_n(tok.start, tok.len);
+		num_tokens++;
+
+		if (num_tokens >= n)
 		{
-			prev = s[slen++] = *x;
+			uint64_t h = WGRAM_SEED;
+			for (size_t i = 0; i < n; i++)
+			{
+				h = WGRAM_MIX(h, window[(num_tokens +i) %n].hash);
+			}
+			h ^= h >> 33;
+
+			// The byte order of the key is fixed to keep models portable
+			unsigned char key[sizeof(uint64_t)];
+			for (size_t i = 0; i < sizeof(uint64_t); i++)
+			{
+				key[i] = (unsigned char) (h >> (8*i));
+			}
+			fct((const char*) key, sizeof(uint64_t), data);
 		}
-    }
-    // make sure to end with a separator character
-    if (prev != ch)
-    {
-    	s[slen++] = ch;
-    }
+	}
+}
 
-    *str = s;
-    *len = slen;
-    return s;
+/**
+ * Extracts token n-grams as extract_wgrams does, but represents each token
+ * by its id in the given dictionary. Hence, the n-grams are tuples of n
+ * 32-bit ids of a fixed width. Tokens that are not part of the dictionary
+ * are added if requested and map to DICT_UNKNOWN otherwise.
+ */
+inline void extract_igrams(const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, DICT* const dict, const int learn, FN_PROCESS_NGRAM fct, void* const data)
+{
+	assert(n > 0 && dict != NULL);
+
+	// The ids of the last n tokens followed by the n-gram's key
+	uint32_t* const window = (uint32_t*) ngrams_scratch(2*n *sizeof(uint32_t));
+	if (window == NULL) return;
+	unsigned char* const key = (unsigned char*) (window +n);
+
+	wcursor_t c;
+	wcursor_init(&c, str, len, delim);
+
+	size_t num_tokens = 0;
+	wtoken_t tok;
+	for (size_t x = 0; next_wtoken(&c, &x, &tok);)
+	{
+		window[num_tokens %n] = (learn ? dict_insert(dict, tok.start, tok.len) : dict_lookup(dict, tok.start, tok.len));
+		num_tokens++;
+
+		if (num_tokens >= n)
+		{
+			// The byte order of the ids is fixed to keep models portable
+			for (size_t i = 0; i < n; i++)
+			{
+				const uint32_t id = window[(num_tokens +i) %n];
+				for (size_t j = 0; j < sizeof(uint32_t); j++)
+				{
+					key[i*sizeof(uint32_t) +j] = (unsigned char) (id >> (8*j));
+				}
+			}
+			fct((const char*) key, n *sizeof(uint32_t), data);
+		}
+	}
 }
 
-inline void extract_wgrams(const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, FN_PROCESS_NGRAM fct, void* const data)
+
+// n-grams as represented by the given model
+inline void extract_bgrams_for(const container_t* const model, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, FN_PROCESS_NGRAM fct, void* const data)
+{
+	extract_bitgrams(str, len, n, fct, data);
+}
+
+inline void extract_ngrams_for(const container_t* const model, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, FN_PROCESS_NGRAM fct, void* const data)
 {
-	char ch = pick_delimiterchar(delim);
-
-	const char* s = str;
-	size_t slen = len;
-	// ATTENTION! "uniquify" allocates new memory stored in &s
-	uniquify(&s, &slen, delim, ch);
-
-    const char** wgrams = (const char**) malloc(sizeof(char*) *(n +1));
-    wgrams[0] = s;
-
-    // Initialize sliding window
-	const char* x = s;
-    for (size_t i = 1; x < s +slen && i < n; x++)
-    {
-    	if (*x == ch)
-    	{
-    		wgrams[i++] = x +1;
-    	}
-    }
-
-    size_t i = n -1, a = n +1;
-    for (; x < s +slen; x++)
-    {
-    	if (*x == ch)
-    	{
-    		i = (i+1) % a;
-    		wgrams[i] = x +1;
-
-    		const size_t y = (i +1) % a;
-    		const char* const next = wgrams[y];
-
-    		const ptrdiff_t d = wgrams[i] -next;
-    		assert(d > 0); // and also > 1 due to construction of wgrams array
-    		const size_t wlen = ((size_t) d) -1;
-
-    		fct(next, wlen, data);
-    	}
-    }
-
-    free(wgrams);
-    free((void*) s);
+	extract_bytegrams(str, len, n, fct, data);
+}
+
+inline void extract_wgrams_for(const container_t* const model, const char* const str, const size_t len, const size_t n, const delimiter_array_t delim, FN_PROCESS_NGRAM fct, void* const data)
+{
+	if (container_hashes_tokens(model))
+	{
+		extract_hgrams(str, len, n, delim, fct, data);
+	}
+	else
+	{
+		extract_wgrams(str, len, n, delim, fct, data);
+	}
 }
 
 #endif /* SALAD_NGRAMS_H_ */
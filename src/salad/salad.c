@@ -74,6 +74,34 @@ const int salad_set_bloomfilter(salad_t* const s, const unsigned int filter_size
 	return EXIT_SUCCESS;
 }
 
+const int salad_set_countingbloomfilter(salad_t* const s, const unsigned int filter_size, const char* const hashset)
+{
+	salad_create_container(s);
+
+	if (!container_init_countingbloomfilter(s->model.x, filter_size, hashset))
+	{
+		SET_NOTSPECIFIED(s->model);
+		return EXIT_FAILURE;
+	}
+
+	s->model.type = SALAD_MODEL_BLOOMFILTER;
+	return EXIT_SUCCESS;
+}
+
+const int salad_set_cuckoofilter(salad_t* const s, const unsigned int filter_size)
+{
+	salad_create_container(s);
+
+	if (!container_init_cuckoofilter(s->model.x, filter_size))
+	{
+		SET_NOTSPECIFIED(s->model);
+		return EXIT_FAILURE;
+	}
+
+	s->model.type = SALAD_MODEL_CUCKOOFILTER;
+	return EXIT_SUCCESS;
+}
+
 void salad_use_binary_ngrams(salad_t* const s, const int b)
 {
 	assert(s != NULL);
@@ -93,6 +121,26 @@ void salad_set_delimiter(salad_t* const s, const char* const d)
 	_(s)->use_tokens = (_(s)->delimiter.str != NULL && _(s)->delimiter.str[0] != 0x00);
 }
 
+const int salad_intern_tokens(salad_t* const s, const int b)
+{
+	assert(s != NULL);
+
+	if (!b)
+	{
+		dict_destroy(_(s)->tokens);
+		_(s)->tokens = NULL;
+	}
+	else if (_(s)->tokens == NULL)
+	{
+		_(s)->tokens = dict_create(0x1000);
+		if (_(s)->tokens == NULL)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
 void salad_set_ngramlength(salad_t* const s, const size_t n)
 {
 	assert(s != NULL);
@@ -123,6 +171,7 @@ void salad_destroy(salad_t* const s)
 		free(ctx->delimiter.str);
 		ctx->delimiter.str = NULL;
 	}
+	dict_destroy(ctx->tokens);
 	free(ctx);
 }
 
@@ -130,29 +179,41 @@ void salad_destroy(salad_t* const s)
 const int salad_train(salad_t* const s, const saladdata_t* const data, const size_t n)
 {
 	assert(s != NULL && data != NULL);
-	BLOOM* const bloom = GET_BLOOMFILTER(s->model);
+	container_t* const model = GET_CONTAINER(s->model);
+
+	if (container_is_static(model))
+	{
+		return EXIT_FAILURE;
+	}
 
 	// TODO: Let's check whether we can optimize away the function calls
-	switch (to_model_type(s->as_binary, _(s)->use_tokens))
+	switch (to_model_type(s->as_binary, _(s)->use_tokens, _(s)->tokens != NULL))
 	{
 	case BIT_NGRAM:
 		for (size_t i = 0; i < n; i++)
 		{
-			bloomizeb_ex(bloom, data[i].buf, data[i].len, s->ngram_length);
+			bloomizeb_ex(model, data[i].buf, data[i].len, s->ngram_length);
 		}
 		break;
 
 	case BYTE_NGRAM:
 		for (size_t i = 0; i < n; i++)
 		{
-			bloomize_ex(bloom, data[i].buf, data[i].len, s->ngram_length);
+			bloomize_ex(model, data[i].buf, data[i].len, s->ngram_length);
 		}
 		break;
 
 	case TOKEN_NGRAM:
 		for (size_t i = 0; i < n; i++)
 		{
-			bloomizew_ex(bloom, data[i].buf, data[i].len, s->ngram_length, _(s)->delimiter.d);
+			bloomizew_ex(model, data[i].buf, data[i].len, s->ngram_length, _(s)->delimiter.d);
+		}
+		break;
+
+	case TOKENID_NGRAM:
+		for (size_t i = 0; i < n; i++)
+		{
+			bloomizei_ex(model, _(s)->tokens, data[i].buf, data[i].len, s->ngram_length, _(s)->delimiter.d);
 		}
 		break;
 
@@ -162,37 +223,229 @@ const int salad_train(salad_t* const s, const saladdata_t* const data, const siz
 	return EXIT_SUCCESS;
 }
 
-const int salad_predict_ex(salad_t* const s, const saladdata_t* const data, const size_t n, double* const out)
+const int salad_forget(salad_t* const s, const saladdata_t* const data, const size_t n)
+{
+	assert(s != NULL && data != NULL);
+	if (s->model.x == NULL || !container_supports_removal(s->model.x))
+	{
+		return EXIT_FAILURE;
+	}
+	container_t* const model = GET_CONTAINER(s->model);
+
+	switch (to_model_type(s->as_binary, _(s)->use_tokens, _(s)->tokens != NULL))
+	{
+	case BIT_NGRAM:
+		for (size_t i = 0; i < n; i++)
+		{
+			forgetb_ex(model, data[i].buf, data[i].len, s->ngram_length);
+		}
+		break;
+
+	case BYTE_NGRAM:
+		for (size_t i = 0; i < n; i++)
+		{
+			forget_ex(model, data[i].buf, data[i].len, s->ngram_length);
+		}
+		break;
+
+	case TOKEN_NGRAM:
+		for (size_t i = 0; i < n; i++)
+		{
+			forgetw_ex(model, data[i].buf, data[i].len, s->ngram_length, _(s)->delimiter.d);
+		}
+		break;
+
+	case TOKENID_NGRAM:
+		for (size_t i = 0; i < n; i++)
+		{
+			forgeti_ex(model, _(s)->tokens, data[i].buf, data[i].len, s->ngram_length, _(s)->delimiter.d);
+		}
+		break;
+
+	default:
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+const int salad_collect_ex(const salad_t* const s, FPSET* const keys, const saladdata_t* const data, const size_t n)
+{
+	assert(s != NULL && keys != NULL && data != NULL);
+	const container_t* const model = GET_CONTAINER(s->model);
+
+	switch (to_model_type(s->as_binary, _(s)->use_tokens, _(s)->tokens != NULL))
+	{
+	case BIT_NGRAM:
+		// Neither can they tell bit n-grams hashed by value apart
+		if (container_hashes_tokens(model))
+		{
+			return EXIT_FAILURE;
+		}
+		for (size_t i = 0; i < n; i++)
+		{
+			collectb_ex(model, keys, data[i].buf, data[i].len, s->ngram_length);
+		}
+		break;
+
+	case BYTE_NGRAM:
+		for (size_t i = 0; i < n; i++)
+		{
+			collect_ex(model, keys, data[i].buf, data[i].len, s->ngram_length);
+		}
+		break;
+
+	case TOKEN_NGRAM:
+		// Static models cannot tell hashed tokens apart from plain n-grams
+		if (container_hashes_tokens(model))
+		{
+			return EXIT_FAILURE;
+		}
+		for (size_t i = 0; i < n; i++)
+		{
+			collectw_ex(model, keys, data[i].buf, data[i].len, s->ngram_length, _(s)->delimiter.d);
+		}
+		break;
+
+	case TOKENID_NGRAM:
+		for (size_t i = 0; i < n; i++)
+		{
+			collecti_ex(model, _(s)->tokens, keys, data[i].buf, data[i].len, s->ngram_length, _(s)->delimiter.d);
+		}
+		break;
+
+	default:
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+const int salad_freeze_ex(salad_t* const s, const FPSET* const keys)
+{
+	assert(s != NULL && keys != NULL);
+
+	uint64_t* const a = fpset_to_array(keys);
+	if (a == NULL)
+	{
+		return EXIT_FAILURE;
+	}
+
+	XORFILTER* const x = xor_build(a, keys->count);
+	free(a);
+
+	if (x == NULL)
+	{
+		return EXIT_FAILURE;
+	}
+	salad_set_xorfilter_ex(s, x);
+	return EXIT_SUCCESS;
+}
+
+const int salad_freeze(salad_t* const s, const saladdata_t* const data, const size_t n)
 {
 	assert(s != NULL && data != NULL);
+
+	FPSET* const keys = fpset_create(DEFAULT_FPSET_SIZE);
+	if (keys == NULL)
+	{
+		return EXIT_FAILURE;
+	}
+
+	int ret = salad_collect_ex(s, keys, data, n);
+	// A static filter lacking some of the n-grams is of no use
+	if (keys->dropped > 0)
+	{
+		ret = EXIT_FAILURE;
+	}
+
+	if (ret == EXIT_SUCCESS)
+	{
+		ret = salad_freeze_ex(s, keys);
+	}
+
+	fpset_destroy(keys);
+	return ret;
+}
+
+const int salad_interleave(salad_t* const s, const salad_t* const bad)
+{
+	assert(s != NULL && bad != NULL);
+	// The ids of interned tokens differ between the models
+	if (s->model.x == NULL || bad->model.x == NULL || salad_spec_diff(s, bad) || _(s)->tokens != NULL)
+	{
+		return EXIT_FAILURE;
+	}
+
+	CONTAINER_T(c);
+	if (!container_interleave(&c, s->model.x, bad->model.x))
+	{
+		return EXIT_FAILURE;
+	}
+	salad_set_twoclassbloomfilter_ex(s, c.data);
+	return EXIT_SUCCESS;
+}
+
+const int salad_decay(salad_t* const s)
+{
+	assert(s != NULL);
+	if (!IS_COUNTINGBLOOMFILTER(s->model))
+	{
+		return EXIT_FAILURE;
+	}
+
 	BLOOM* const bloom = GET_BLOOMFILTER(s->model);
 
+	bloom_decay(bloom);
+	return EXIT_SUCCESS;
+}
+
+const int salad_predict_ex(salad_t* const s, const saladdata_t* const data, const size_t n, double* const out)
+{
+	assert(s != NULL && data != NULL);
+	container_t* const model = GET_CONTAINER(s->model);
+
 	if (out == NULL)
 	{
 		return EXIT_FAILURE;
 	}
 
+	// An interleaved model holds both classes, cf. salad_interleave
+	const int two_class = (model->type == CONTAINER_TWOCLASSBLOOMFILTER);
+
 	// TODO: Let's check whether we can optimize away the function calls
-	switch (to_model_type(s->as_binary, _(s)->use_tokens))
+	switch (to_model_type(s->as_binary, _(s)->use_tokens, _(s)->tokens != NULL))
 	{
 	case BIT_NGRAM:
 		for (size_t i = 0; i < n; i++)
 		{
-			out[i] = classify_1class_b_ex(bloom, data[i].buf, data[i].len, s->ngram_length);
+			out[i] = (two_class ?
+					classify_2class_b_ex(model, model, data[i].buf, data[i].len, s->ngram_length) :
+					classify_1class_b_ex(model, data[i].buf, data[i].len, s->ngram_length));
 		}
 		break;
 
 	case BYTE_NGRAM:
 		for (size_t i = 0; i < n; i++)
 		{
-			out[i] = classify_1class_ex(bloom, data[i].buf, data[i].len, s->ngram_length);
+			out[i] = (two_class ?
+					classify_2class_ex(model, model, data[i].buf, data[i].len, s->ngram_length) :
+					classify_1class_ex(model, data[i].buf, data[i].len, s->ngram_length));
 		}
 		break;
 
 	case TOKEN_NGRAM:
 		for (size_t i = 0; i < n; i++)
 		{
-			out[i] = classify_1class_w_ex(bloom, data[i].buf, data[i].len, s->ngram_length, _(s)->delimiter.d);
+			out[i] = (two_class ?
+					classify_2class_w_ex(model, model, data[i].buf, data[i].len, s->ngram_length, _(s)->delimiter.d) :
+					classify_1class_w_ex(model, data[i].buf, data[i].len, s->ngram_length, _(s)->delimiter.d));
+		}
+		break;
+
+	case TOKENID_NGRAM:
+		// Interleaved models do not support interned tokens, cf. salad_interleave
+		for (size_t i = 0; i < n; i++)
+		{
+			out[i] = classify_1class_i_ex(model, _(s)->tokens, data[i].buf, data[i].len, s->ngram_length, _(s)->delimiter.d);
 		}
 		break;
 
@@ -212,23 +465,207 @@ const double* const salad_predict(salad_t* const s, const saladdata_t* const dat
 
 	if (salad_predict_ex(s, data, n, scores) != EXIT_SUCCESS)
 	{
+		free(scores);
 		return NULL;
 	}
 	return scores;
 }
 
 
+// Appends the chunk to the tail kept from the previous one
+static const int salad_stream_append(salad_stream_t* const st, const saladdata_t* const chunk)
+{
+	if (st->len +chunk->len > st->capacity)
+	{
+		const size_t capacity = MAX(st->len +chunk->len, st->capacity *2);
+		char* const buf = (char*) realloc(st->buf, capacity);
+		if (buf == NULL)
+		{
+			return EXIT_FAILURE;
+		}
+		st->buf = buf;
+		st->capacity = capacity;
+	}
+
+	memcpy(st->buf +st->len, chunk->buf, chunk->len);
+	st->len += chunk->len;
+	return EXIT_SUCCESS;
+}
+
+// Determines how much of the buffer can be processed right away (returned)
+// and where the part starts that is needed for upcoming n-grams (keep).
+static const size_t salad_stream_cut(const salad_t* const s, const model_type_t t, const salad_stream_t* const st, const int last, size_t* const keep)
+{
+	const size_t n = s->ngram_length;
+	*keep = st->len;
+
+	if (last)
+	{
+		return st->len;
+	}
+
+	switch (t)
+	{
+	case BYTE_NGRAM:
+		*keep = st->len -MIN(st->len, n -1);
+		return st->len;
+
+	case TOKEN_NGRAM:
+	case TOKENID_NGRAM:
+	{
+		const uint8_t* const d = _(s)->delimiter.d;
+		const char* const x = st->buf;
+
+		// The last token might continue in the next chunk
+		size_t end = st->len;
+		while (end > 0 && !d[(uint8_t) x[end -1]]) end--;
+
+		// ... and is preceded by the n-1 tokens it forms n-grams with
+		size_t k = end;
+		for (size_t i = 0; i +1 < n; i++)
+		{
+			while (k > 0 &&  d[(uint8_t) x[k -1]]) k--;
+			while (k > 0 && !d[(uint8_t) x[k -1]]) k--;
+		}
+		*keep = k;
+		return end;
+	}
+
+	default:
+		// Bit n-grams cross byte boundaries, hence, the item is kept as a whole
+		*keep = 0;
+		return 0;
+	}
+}
+
+static void salad_stream_shift(salad_stream_t* const st, const size_t keep, const int last)
+{
+	st->len = (last ? 0 : st->len -keep);
+	if (st->len > 0)
+	{
+		memmove(st->buf, st->buf +keep, st->len);
+	}
+}
+
+const int salad_stream_train(salad_t* const s, salad_stream_t* const st, const saladdata_t* const chunk, const int last)
+{
+	assert(s != NULL && st != NULL && chunk != NULL);
+	container_t* const model = GET_CONTAINER(s->model);
+
+	if (container_is_static(model) || salad_stream_append(st, chunk) != EXIT_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	const model_type_t t = to_model_type(s->as_binary, _(s)->use_tokens, _(s)->tokens != NULL);
+
+	size_t keep;
+	const size_t end = salad_stream_cut(s, t, st, last, &keep);
+
+	if (end > 0)
+	{
+		switch (t)
+		{
+		case BIT_NGRAM:
+			bloomizeb_ex(model, st->buf, end, s->ngram_length);
+			break;
+		case BYTE_NGRAM:
+			bloomize_ex(model, st->buf, end, s->ngram_length);
+			break;
+		case TOKEN_NGRAM:
+			bloomizew_ex(model, st->buf, end, s->ngram_length, _(s)->delimiter.d);
+			break;
+		case TOKENID_NGRAM:
+			bloomizei_ex(model, _(s)->tokens, st->buf, end, s->ngram_length, _(s)->delimiter.d);
+			break;
+		}
+	}
+
+	salad_stream_shift(st, keep, last);
+	return EXIT_SUCCESS;
+}
+
+const int salad_stream_predict(salad_t* const s, salad_stream_t* const st, const saladdata_t* const chunk, const int last, double* const out)
+{
+	assert(s != NULL && st != NULL && chunk != NULL);
+	container_t* const model = GET_CONTAINER(s->model);
+
+	if (model->type == CONTAINER_TWOCLASSBLOOMFILTER || salad_stream_append(st, chunk) != EXIT_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	const model_type_t t = to_model_type(s->as_binary, _(s)->use_tokens, _(s)->tokens != NULL);
+
+	size_t keep;
+	const size_t end = salad_stream_cut(s, t, st, last, &keep);
+
+	size_t num = 0;
+	switch (t)
+	{
+	case BIT_NGRAM:
+		// The item has been kept as a whole, cf. salad_stream_cut
+		if (last && out != NULL)
+		{
+			*out = classify_1class_b_ex(model, st->buf, st->len, s->ngram_length);
+		}
+		salad_stream_shift(st, keep, last);
+		return EXIT_SUCCESS;
+
+	case BYTE_NGRAM:
+		st->known += classify_1class_known_ex(model, st->buf, end, s->ngram_length);
+		st->total += (end < s->ngram_length ? 0 : end -s->ngram_length +1);
+		break;
+
+	case TOKEN_NGRAM:
+		st->known += classify_1class_w_known_ex(model, st->buf, end, s->ngram_length, _(s)->delimiter.d, &num);
+		st->total += num;
+		break;
+
+	case TOKENID_NGRAM:
+		st->known += classify_1class_i_known_ex(model, _(s)->tokens, st->buf, end, s->ngram_length, _(s)->delimiter.d, &num);
+		st->total += num;
+		break;
+	}
+
+	if (last)
+	{
+		if (out != NULL)
+		{
+			*out = ((double) (st->total -st->known))/ st->total;
+		}
+		st->known = 0;
+		st->total = 0;
+	}
+
+	salad_stream_shift(st, keep, last);
+	return EXIT_SUCCESS;
+}
+
+void salad_stream_destroy(salad_stream_t* const st)
+{
+	assert(st != NULL);
+	free(st->buf);
+	*st = (salad_stream_t) EMPTY_SALAD_STREAM_INITIALIZER;
+}
+
+
 const int salad_spec_diff(const salad_t* const a, const salad_t* const b)
 {
 	assert(a != NULL);
 	assert(b != NULL);
 
-	return (a->model.type != b->model.type
+	const int container_diff = (a->model.x != NULL && b->model.x != NULL
+			&& (((container_t*) a->model.x)->type != ((container_t*) b->model.x)->type
+			|| container_hashes_tokens(a->model.x) != container_hashes_tokens(b->model.x)));
+
+	return (a->model.type != b->model.type || container_diff
 			|| strcmp(_(a)->delimiter.str, _(b)->delimiter.str) != 0
 			|| memcmp(_(a)->delimiter.d, _(b)->delimiter.d, 256) != 0
 			|| a->as_binary != b->as_binary
 			|| a->ngram_length != b->ngram_length
-			|| _(a)->use_tokens != _(b)->use_tokens);
+			|| _(a)->use_tokens != _(b)->use_tokens
+			|| (_(a)->tokens != NULL) != (_(b)->tokens != NULL));
 }
 
 const int salad_from_file(const char* const filename, salad_t* const out)
@@ -253,6 +690,23 @@ const int salad_from_file_ex(FILE* const f, salad_t* const out)
 	return (fread_model(f, out) ? EXIT_SUCCESS : EXIT_FAILURE);
 }
 
+const int salad_spec_from_file(const char* const filename, salad_t* const out)
+{
+	assert(filename != NULL && out != NULL);
+
+	FILE* const f = fopen(filename, "rb");
+	if (f == NULL)
+	{
+		return EXIT_FAILURE +1;
+	}
+
+	salad_init(out);
+	const int ret = (fread_model_spec(f, out) ? EXIT_SUCCESS : EXIT_FAILURE +2);
+	fclose(f);
+
+	return ret;
+}
+
 const int salad_to_file(const salad_t* const s, const char* const filename)
 {
 	FILE* const f = fopen(filename, "wb+");
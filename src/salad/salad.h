@@ -85,6 +85,18 @@ typedef enum
 	 * Communications of the ACM 13 (7): 422–426
 	 */
 	SALAD_MODEL_BLOOMFILTER,
+	/*!
+	 * Cuckoo filter as described by Fan et al. in "Cuckoo Filter:
+	 * Practically Better Than Bloom" (2014), Proceedings of the
+	 * 10th ACM CoNEXT, 75–88
+	 */
+	SALAD_MODEL_CUCKOOFILTER,
+	/*!
+	 * Xor filter as described by Graf and Lemire in "Xor Filters:
+	 * Faster and Smaller Than Bloom and Cuckoo Filters" (2020),
+	 * ACM Journal of Experimental Algorithmics 25: 1–16
+	 */
+	SALAD_MODEL_XORFILTER,
 	SALAD_MODEL_NOTSPECIFIED //!< An unspecified/ not initialized model.
 } saladmodel_type_t;
 
@@ -161,13 +173,44 @@ PUBLIC const int salad_allocate(saladdata_t* const d, const size_t n);
  * @param[inout] s The salad object to be modified.
  * @param[in] filter_size The size of the bloom filter.
  * @param[in] hashset The hash set to be used for the bloom filter.
- *                    Possible values are: "simple" & "murmur".
+ *                    Possible values are: "simple", "murmur" & "mix".
  *
  * @return An error indicator for whether the operation was
  *         successful or not. Zero means that that the operation
  *         was successful anything else indicates a particular error.
  */
 PUBLIC const int salad_set_bloomfilter(salad_t* const s, const unsigned int filter_size, const char* const hashset);
+/**
+ * Set the model of the given salad object to a counting bloom filter
+ * with the given parameters. Besides the bits of a regular bloom filter
+ * it keeps 4-bit counters that allow to remove n-grams from the model
+ * (cf. salad_forget) and to age the model (cf. salad_decay).
+ *
+ * @param[inout] s The salad object to be modified.
+ * @param[in] filter_size The size of the bloom filter.
+ * @param[in] hashset The hash set to be used for the bloom filter.
+ *                    Possible values are: "simple", "murmur" & "mix".
+ *
+ * @return An error indicator for whether the operation was
+ *         successful or not. Zero means that that the operation
+ *         was successful anything else indicates a particular error.
+ */
+PUBLIC const int salad_set_countingbloomfilter(salad_t* const s, const unsigned int filter_size, const char* const hashset);
+/**
+ * Set the model of the given salad object to a cuckoo filter that
+ * occupies the same amount of memory as a bloom filter of the given
+ * size. The filter stores 16-bit fingerprints in buckets of four and
+ * thus yields lower false-positive rates per bit than a bloom filter
+ * for the common load factors.
+ *
+ * @param[inout] s The salad object to be modified.
+ * @param[in] filter_size The size of the filter in bits as power of 2.
+ *
+ * @return An error indicator for whether the operation was
+ *         successful or not. Zero means that that the operation
+ *         was successful anything else indicates a particular error.
+ */
+PUBLIC const int salad_set_cuckoofilter(salad_t* const s, const unsigned int filter_size);
 /**
  * Use binary n-grams rather than n-grams based on character/bytes.
  *
@@ -184,6 +227,21 @@ PUBLIC void salad_use_binary_ngrams(salad_t* const s, const int b);
  * @param[in] d The delimiter that should be used for extracting n-grams.
  */
 PUBLIC void salad_set_delimiter(salad_t* const s, const char* const d);
+/**
+ * Set whether the tokens of token n-grams should be interned, i.e., be
+ * represented by ids in a dictionary that is part of the model. Thus,
+ * n-grams are tuples of ids of a fixed width, no matter how long the
+ * tokens are. The dictionary is populated while training; tokens that
+ * are unknown at prediction time map to a reserved id.
+ *
+ * @param[inout] s The salad object to be modified.
+ * @param[in] b Whether or not to intern tokens.
+ *
+ * @return An error indicator for whether the operation was
+ *         successful or not. Zero means that that the operation
+ *         was successful anything else indicates a particular error.
+ */
+PUBLIC const int salad_intern_tokens(salad_t* const s, const int b);
 /**
  * Set the n-gram length that should be used for the model.
  *
@@ -218,6 +276,66 @@ PUBLIC void salad_destroy(salad_t* const s);
  *         was successful anything else indicates a particular error.
  */
 PUBLIC const int salad_train(salad_t* const s, const saladdata_t* const data, const size_t n);
+/**
+ * Removes the n-grams extracted from the provided data from the model.
+ * This requires a model based on a counting bloom filter.
+ *
+ * @param[inout] s The salad object to be modified.
+ * @param[in] data The input data to processed.
+ * @param[in] n The number of data elements in the input as defined
+ *              by parameter \p data.
+ *
+ * @return An error indicator for whether the operation was
+ *         successful or not. Zero means that that the operation
+ *         was successful anything else indicates a particular error.
+ */
+PUBLIC const int salad_forget(salad_t* const s, const saladdata_t* const data, const size_t n);
+/**
+ * Freezes the model, i.e., replaces it by a static xor filter that
+ * holds all n-grams of the provided data that are contained in the
+ * current model. Usually, this is the data the model has been trained
+ * on. The resulting model is smaller and faster to query, but cannot
+ * be updated anymore.
+ *
+ * @param[inout] s The salad object to be modified.
+ * @param[in] data The input data to processed.
+ * @param[in] n The number of data elements in the input as defined
+ *              by parameter \p data.
+ *
+ * @return An error indicator for whether the operation was
+ *         successful or not. Zero means that that the operation
+ *         was successful anything else indicates a particular error.
+ */
+PUBLIC const int salad_freeze(salad_t* const s, const saladdata_t* const data, const size_t n);
+/**
+ * Ages the model by halving the counts of all n-grams. N-grams that
+ * have been seen once only since the last call are dropped from the
+ * model. This requires a model based on a counting bloom filter.
+ *
+ * @param[inout] s The salad object to be modified.
+ *
+ * @return An error indicator for whether the operation was
+ *         successful or not. Zero means that that the operation
+ *         was successful anything else indicates a particular error.
+ */
+PUBLIC const int salad_decay(salad_t* const s);
+/**
+ * Combines the model of the given salad object with the one of a
+ * second class, e.g. bad content, into a single two-class model. The
+ * bits of both bloom filters are interleaved such that one pass over
+ * the hash functions and a single memory access per hash answer both
+ * queries. Predictions of the resulting model yield classification
+ * values rather than anomaly scores. This requires two bloom filters
+ * of the same size and hash functions as models.
+ *
+ * @param[inout] s The salad object to be modified, i.e., the 1st class.
+ * @param[in] bad The salad object of the 2nd class.
+ *
+ * @return An error indicator for whether the operation was
+ *         successful or not. Zero means that that the operation
+ *         was successful anything else indicates a particular error.
+ */
+PUBLIC const int salad_interleave(salad_t* const s, const salad_t* const bad);
 /**
  * Predicts the anomaly score or the classification value respectively
  * of the provided data.
@@ -249,6 +367,130 @@ PUBLIC const int salad_predict_ex(salad_t* const s, const saladdata_t* const dat
  */
 PUBLIC const double* const salad_predict(salad_t* const s, const saladdata_t* const data, const size_t n);
 
+/**
+ * A read-only handle of a trained model for the use in several threads.
+ *
+ * Predictions never modify a salad object, hence, any number of threads may
+ * call salad_predict_ex, salad_predict_batch and salad_stream_predict (with
+ * a stream state per thread) at the same time. The salad object must however
+ * neither be modified (salad_train, salad_forget, salad_decay, salad_freeze,
+ * salad_interleave, salad_set_*) nor destroyed while handles to it exist.
+ * The handle itself is immutable and may be shared without locking.
+ */
+typedef struct salad_handle salad_handle_t;
+
+/**
+ * A non-owning view of a string to be scored.
+ */
+typedef struct
+{
+	const char* buf; //!< The raw data, which is neither copied nor freed.
+	size_t len; //!< The length of the raw data.
+} salad_view_t;
+
+/**
+ * Creates a read-only handle of the model of the given salad object.
+ *
+ * @param[in] s The trained salad object, which needs to outlive the handle.
+ *
+ * @return The handle or NULL in case of an error.
+ */
+PUBLIC salad_handle_t* const salad_handle_create(const salad_t* const s);
+/**
+ * Destroys a handle created by salad_handle_create. The salad object it
+ * refers to is left untouched.
+ *
+ * @param[inout] h The handle to be destroyed.
+ */
+PUBLIC void salad_handle_destroy(salad_handle_t* const h);
+/**
+ * Predicts the anomaly score or the classification value respectively of
+ * the given strings using up to \p nthreads threads, including the calling
+ * one. Each thread starts with an equal share of the strings and takes over
+ * those of other threads once its share is done. The threads are started
+ * on first use and kept for later calls, also of other handles. The results
+ * are identical to those of salad_predict_ex.
+ *
+ * @param[in] h The handle of the model to be used.
+ * @param[in] views The strings to be scored.
+ * @param[in] n The number of strings as defined by parameter \p views.
+ * @param[out] out An array of size \p n to write the resulting scores to.
+ * @param[in] nthreads The maximal number of threads to be used. Zero or one
+ *                     score all strings on the calling thread.
+ *
+ * @return An error indicator for whether the operation was
+ *         successful or not. Zero means that that the operation
+ *         was successful anything else indicates a particular error.
+ */
+PUBLIC const int salad_predict_batch(const salad_handle_t* const h, const salad_view_t* const views, const size_t n, double* const out, const size_t nthreads);
+
+/**
+ * The state of a single item, e.g., a large file, that is processed in
+ * several consecutive chunks rather than at once. Between chunks only the
+ * end of the previous chunk that is still part of upcoming n-grams is kept,
+ * i.e., n-1 bytes or the last n-1 tokens followed by a partial one.
+ */
+typedef struct
+{
+	char* buf; //!< The tail of the previous chunk followed by the current one.
+	size_t len; //!< The length of the tail.
+	size_t capacity; //!< The capacity of the buffer.
+	size_t known; //!< The number of known n-grams of the item so far.
+	size_t total; //!< The number of n-grams of the item so far.
+} salad_stream_t;
+
+#define EMPTY_SALAD_STREAM_INITIALIZER { \
+		.buf = NULL, \
+		.len = 0, \
+		.capacity = 0, \
+		.known = 0, \
+		.total = 0 \
+}
+
+/**
+ * The preferred way of initializing the salad_stream_t object/ struct.
+ */
+#define SALAD_STREAM_T(m) salad_stream_t m = EMPTY_SALAD_STREAM_INITIALIZER
+
+/**
+ * Trains the model on the next chunk of an item that is split into several
+ * chunks. The n-grams spanning the boundaries of chunks are considered
+ * exactly once.
+ *
+ * @param[inout] s The salad object to be modified.
+ * @param[inout] st The state of the item the chunk belongs to.
+ * @param[in] chunk The next chunk of the item.
+ * @param[in] last Whether or not this is the last chunk of the item.
+ *
+ * @return An error indicator for whether the operation was
+ *         successful or not. Zero means that that the operation
+ *         was successful anything else indicates a particular error.
+ */
+PUBLIC const int salad_stream_train(salad_t* const s, salad_stream_t* const st, const saladdata_t* const chunk, const int last);
+/**
+ * Accumulates the known n-grams of the next chunk of an item that is split
+ * into several chunks. Once the last chunk has been processed, the anomaly
+ * score of the item as a whole is written to \p out and the state is reset
+ * for the next item. Only one-class models are supported.
+ *
+ * @param[inout] s The salad object to be used.
+ * @param[inout] st The state of the item the chunk belongs to.
+ * @param[in] chunk The next chunk of the item.
+ * @param[in] last Whether or not this is the last chunk of the item.
+ * @param[out] out The anomaly score of the item (only if \p last is set).
+ *
+ * @return An error indicator for whether the operation was
+ *         successful or not. Zero means that that the operation
+ *         was successful anything else indicates a particular error.
+ */
+PUBLIC const int salad_stream_predict(salad_t* const s, salad_stream_t* const st, const saladdata_t* const chunk, const int last, double* const out);
+/**
+ * Frees the memory held by the given stream state.
+ *
+ * @param[inout] st The stream state to be destroyed.
+ */
+PUBLIC void salad_stream_destroy(salad_stream_t* const st);
+
 /**
  * Checks whether the specification of the given salad models
  * differentiates or not.
@@ -283,6 +525,20 @@ PUBLIC const int salad_from_file(const char* const filename, salad_t* const out)
  *         was successful anything else indicates a particular error.
  */
 PUBLIC const int salad_from_file_ex(FILE* const f, salad_t* const out);
+/**
+ * Loads the specification of a salad model from the file with the given
+ * name, but not its bit array. The array of the bloom filter is left NULL
+ * and needs to be assigned before the model is used, e.g., as mapped from
+ * shared memory. Counting bloom filters are not supported.
+ *
+ * @param[in] filename The name of the file that contains the salad spec.
+ * @param[out] out The salad object to write the model specification to.
+ *
+ * @return An error indicator for whether the operation was
+ *         successful or not. Zero means that that the operation
+ *         was successful anything else indicates a particular error.
+ */
+PUBLIC const int salad_spec_from_file(const char* const filename, salad_t* const out);
 /**
  * Write a salad model and its specification to the file with the given name.
  *
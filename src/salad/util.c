@@ -37,8 +37,12 @@ const saladmodel_type_t to_saladmodeltype(const container_type_t t)
 {
 	switch (t)
 	{
-	case CONTAINER_BLOOMFILTER: return SALAD_MODEL_BLOOMFILTER;
-	default:                    return SALAD_MODEL_NOTSPECIFIED;
+	case CONTAINER_BLOOMFILTER:
+	case CONTAINER_COUNTINGBLOOMFILTER: return SALAD_MODEL_BLOOMFILTER;
+	case CONTAINER_TWOCLASSBLOOMFILTER: return SALAD_MODEL_BLOOMFILTER;
+	case CONTAINER_CUCKOOFILTER:        return SALAD_MODEL_CUCKOOFILTER;
+	case CONTAINER_XORFILTER:           return SALAD_MODEL_XORFILTER;
+	default:                            return SALAD_MODEL_NOTSPECIFIED;
 	}
 }
 
@@ -62,3 +66,39 @@ void salad_set_bloomfilter_ex(salad_t* const s, BLOOM* const b)
 	container_set_bloomfilter(s->model.x, b);
 	s->model.type = SALAD_MODEL_BLOOMFILTER;
 }
+
+void salad_set_countingbloomfilter_ex(salad_t* const s, BLOOM* const b)
+{
+	assert(s != NULL);
+	salad_create_container(s);
+
+	container_set_countingbloomfilter(s->model.x, b);
+	s->model.type = SALAD_MODEL_BLOOMFILTER;
+}
+
+void salad_set_cuckoofilter_ex(salad_t* const s, CUCKOO* const c)
+{
+	assert(s != NULL);
+	salad_create_container(s);
+
+	container_set_cuckoofilter(s->model.x, c);
+	s->model.type = SALAD_MODEL_CUCKOOFILTER;
+}
+
+void salad_set_xorfilter_ex(salad_t* const s, XORFILTER* const x)
+{
+	assert(s != NULL);
+	salad_create_container(s);
+
+	container_set_xorfilter(s->model.x, x);
+	s->model.type = SALAD_MODEL_XORFILTER;
+}
+
+void salad_set_twoclassbloomfilter_ex(salad_t* const s, BLOOM* const b)
+{
+	assert(s != NULL);
+	salad_create_container(s);
+
+	container_set_twoclassbloomfilter(s->model.x, b);
+	s->model.type = SALAD_MODEL_BLOOMFILTER;
+}
@@ -27,18 +27,42 @@
 
 #include <container/common.h>
 #include <container/container.h>
+#include <container/dict.h>
+#include <container/fpset.h>
 
 void salad_create_container(salad_t* const s);
 void salad_set_container(salad_t* const s, container_t* const c);
 void salad_set_bloomfilter_ex(salad_t* const s, BLOOM* const b);
+void salad_set_countingbloomfilter_ex(salad_t* const s, BLOOM* const b);
+void salad_set_cuckoofilter_ex(salad_t* const s, CUCKOO* const c);
+void salad_set_xorfilter_ex(salad_t* const s, XORFILTER* const x);
+void salad_set_twoclassbloomfilter_ex(salad_t* const s, BLOOM* const b);
+
+const int salad_collect_ex(const salad_t* const s, FPSET* const keys, const saladdata_t* const data, const size_t n);
+const int salad_freeze_ex(salad_t* const s, const FPSET* const keys);
 
 
 #define GET_BLOOMFILTER(model) \
 	(BLOOM*) (model.x == NULL ? NULL : ((container_t*) model.x)->data); \
 	assert(model.type == SALAD_MODEL_BLOOMFILTER); \
-    assert(((container_t*) model.x)->type == CONTAINER_BLOOMFILTER)
+    assert(IS_BLOOMFILTER(((container_t*) model.x)->type))
 
 #define TO_BLOOMFILTER(model) (BLOOM*) (model.x == NULL ? NULL : ((container_t*) model.x)->data)
+#define TO_CONTAINER(model) ((container_t*) model.x)
+
+#define GET_CONTAINER(model) \
+	TO_CONTAINER(model); \
+	assert(model.type != SALAD_MODEL_NOTSPECIFIED); \
+	assert(model.x != NULL)
+
+#define IS_COUNTINGBLOOMFILTER(model) \
+	(model.x != NULL && ((container_t*) model.x)->type == CONTAINER_COUNTINGBLOOMFILTER)
+
+#define IS_CUCKOOFILTER(model) \
+	(model.x != NULL && ((container_t*) model.x)->type == CONTAINER_CUCKOOFILTER)
+
+#define IS_TWOCLASSBLOOMFILTER(model) \
+	(model.x != NULL && ((container_t*) model.x)->type == CONTAINER_TWOCLASSBLOOMFILTER)
 
 
 #define SET_NOTSPECIFIED(model) { \
@@ -48,11 +72,13 @@ void salad_set_bloomfilter_ex(salad_t* const s, BLOOM* const b);
 
 
 typedef struct {
-	BLOOM* const bloom1; // e.g. good content filter
-	BLOOM* const bloom2; // e.g. bad content filter
+	container_t* const model1; // e.g. good content filter
+	container_t* const model2; // e.g. bad content filter
 	const size_t n;      // n-gram length
 	const delimiter_array_t delim;
-} bloom_param_t;
+	DICT* const tokens1; // interned tokens of the 1st model (optional)
+	DICT* const tokens2; // interned tokens of the 2nd model (optional)
+} model_param_t;
 
 
 #endif /* SALAD_UTIL_H_ */
@@ -0,0 +1,112 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "main.h"
+
+#include <salad/salad.h>
+#include <salad/util.h>
+#include <util/log.h>
+
+#include <assert.h>
+
+typedef struct {
+	const salad_t* const model;
+	FPSET* const keys;
+} freeze_t;
+
+
+const int salad_freeze_callback(data_t* data, const size_t n, void* const usr)
+{
+	assert(data != NULL);
+	assert(usr != NULL);
+
+	freeze_t* const x = (freeze_t*) usr;
+
+	for (size_t i = 0; i < n; i++)
+	{
+		const saladdata_t d = { data[i].buf, data[i].len };
+		if (salad_collect_ex(x->model, x->keys, &d, 1) != EXIT_SUCCESS)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+
+const int salad_freeze_stub(const config_t* const c, const data_processor_t* const dp, file_t* const f_in, FILE* const f_out)
+{
+	salad_header("Freeze salad on", &f_in->meta, c);
+	SALAD_T(s);
+
+	if (salad_from_file_v("training", c->bloom, &s) != EXIT_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	const container_t* const model = GET_CONTAINER(s.model);
+	if (container_is_static(model))
+	{
+		error("The provided model is static already.");
+		salad_destroy(&s);
+		return EXIT_FAILURE;
+	}
+
+	if ((s.as_binary || (__(s).use_tokens && __(s).tokens == NULL)) && container_hashes_tokens(model))
+	{
+		error("Bit and token models using the 'mix' hash set cannot be frozen.");
+		salad_destroy(&s);
+		return EXIT_FAILURE;
+	}
+
+	FPSET* const keys = fpset_create(0x1000);
+	if (keys == NULL)
+	{
+		error("Unable to allocate memory for collecting the n-grams.");
+		salad_destroy(&s);
+		return EXIT_FAILURE;
+	}
+
+	freeze_t context = {
+			.model = &s,
+			.keys = keys
+	};
+	dp->recv(f_in, salad_freeze_callback, c->batch_size, &context);
+
+	if (salad_freeze_ex(&s, keys) != EXIT_SUCCESS)
+	{
+		error("Unable to build the static filter.");
+		fpset_destroy(keys);
+		salad_destroy(&s);
+		return EXIT_FAILURE;
+	}
+
+	const XORFILTER* const x = (XORFILTER*) TO_CONTAINER(s.model)->data;
+	info("Keys: %"ZU" (%.2f bits/ key)", (SIZE_T) x->count,
+	     ((double) xor_bitsize(x))/ ((double) MAX(x->count, 1)));
+
+	const int ret = salad_to_file_ex(&s, f_out, c->output_type);
+
+	fpset_destroy(keys);
+	salad_destroy(&s);
+	return ret;
+}
+
+const int _salad_freeze_(const config_t* const c)
+{
+	return salad_heart(c, salad_freeze_stub);
+}
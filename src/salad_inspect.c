@@ -27,34 +27,44 @@
 #include <string.h>
 #include <math.h>
 
-void bloomizeb_ex3_wrapper(bloom_param_t* const p, const char* const str, const size_t len, bloomize_stats_t* const out)
+void bloomizeb_ex3_wrapper(bloomize_param_t* const p, const char* const str, const size_t len, bloomize_stats_t* const out)
 {
-	bloomizeb_ex3(p->bloom1, p->bloom2, str, len, p->n, out);
+	bloomizeb_ex3(p->model, p->uniq, p->hll, str, len, p->n, out);
 }
 
-void bloomize_ex3_wrapper(bloom_param_t* const p, const char* const str, const size_t len, bloomize_stats_t* const out)
+void bloomize_ex3_wrapper(bloomize_param_t* const p, const char* const str, const size_t len, bloomize_stats_t* const out)
 {
-	bloomize_ex3(p->bloom1, p->bloom2, str, len, p->n, out);
+	bloomize_ex3(p->model, p->uniq, p->hll, str, len, p->n, out);
 }
 
-void bloomizew_ex3_wrapper(bloom_param_t* const p, const char* const str, const size_t len, bloomize_stats_t* const out)
+void bloomizew_ex3_wrapper(bloomize_param_t* const p, const char* const str, const size_t len, bloomize_stats_t* const out)
 {
-	bloomizew_ex3(p->bloom1, p->bloom2, str, len, p->n, p->delim, out);
+	bloomizew_ex3(p->model, p->uniq, p->hll, str, len, p->n, p->delim, out);
 }
 
-void bloomizeb_ex4_wrapper(bloom_param_t* const p, const char* const str, const size_t len, bloomize_stats_t* const out)
+void bloomizei_ex3_wrapper(bloomize_param_t* const p, const char* const str, const size_t len, bloomize_stats_t* const out)
 {
-	bloomizeb_ex4(p->bloom1, p->bloom2, str, len, p->n, out);
+	bloomizei_ex3(p->model, p->tokens, p->uniq, p->hll, str, len, p->n, p->delim, out);
 }
 
-void bloomize_ex4_wrapper(bloom_param_t* const p, const char* const str, const size_t len, bloomize_stats_t* const out)
+void bloomizeb_ex4_wrapper(bloomize_param_t* const p, const char* const str, const size_t len, bloomize_stats_t* const out)
 {
-	bloomize_ex4(p->bloom1, p->bloom2, str, len, p->n, out);
+	bloomizeb_ex4(p->model, p->uniq, p->hll, str, len, p->n, out);
 }
 
-void bloomizew_ex4_wrapper(bloom_param_t* const p, const char* const str, const size_t len, bloomize_stats_t* const out)
+void bloomize_ex4_wrapper(bloomize_param_t* const p, const char* const str, const size_t len, bloomize_stats_t* const out)
 {
-	bloomizew_ex4(p->bloom1, p->bloom2, str, len, p->n, p->delim, out);
+	bloomize_ex4(p->model, p->uniq, p->hll, str, len, p->n, out);
+}
+
+void bloomizew_ex4_wrapper(bloomize_param_t* const p, const char* const str, const size_t len, bloomize_stats_t* const out)
+{
+	bloomizew_ex4(p->model, p->uniq, p->hll, str, len, p->n, p->delim, out);
+}
+
+void bloomizei_ex4_wrapper(bloomize_param_t* const p, const char* const str, const size_t len, bloomize_stats_t* const out)
+{
+	bloomizei_ex4(p->model, p->tokens, p->uniq, p->hll, str, len, p->n, p->delim, out);
 }
 
 
@@ -70,13 +80,16 @@ FN_BLOOMIZE pick_wrapper(const model_type_t t, const int use_new)
 
 	case TOKEN_NGRAM:
 		return (use_new ? bloomizew_ex3_wrapper : bloomizew_ex4_wrapper);
+
+	case TOKENID_NGRAM:
+		return (use_new ? bloomizei_ex3_wrapper : bloomizei_ex4_wrapper);
 	}
 	return NULL;
 }
 
 typedef struct {
 	FN_BLOOMIZE fct;
-	bloom_param_t param;
+	bloomize_param_t param;
 
 	char buf[0x100];
 	bloomize_stats_t* stats;
@@ -118,8 +131,7 @@ const int salad_inspect_stub(const config_t* const c, const data_processor_t* co
 		return EXIT_FAILURE;
 	}
 
-	// TODO: right now only bloom filters are possible
-	const int newBloomFilter = (TO_BLOOMFILTER(training.model) == NULL);
+	const int newBloomFilter = (TO_CONTAINER(training.model) == NULL);
 	if (newBloomFilter)
 	{
 		salad_from_config(&training, c);
@@ -128,11 +140,24 @@ const int salad_inspect_stub(const config_t* const c, const data_processor_t* co
 	SALAD_T(cur);
 	salad_from_config(&cur, c);
 
-	const model_type_t t = to_model_type(cur.as_binary, __(cur).use_tokens);
+	// Tokens are looked up in the dictionary of the model checked against
+	const model_type_t t = to_model_type(cur.as_binary, __(cur).use_tokens, __(training).tokens != NULL);
+
+	FPSET* const uniq = fpset_create(DEFAULT_FPSET_SIZE);
+	HLL* const hll = hll_create(DEFAULT_HLL_PRECISION);
+	if (uniq == NULL || hll == NULL)
+	{
+		error("Unable to allocate memory for counting the n-grams.");
+		fpset_destroy(uniq);
+		hll_destroy(hll);
+		salad_destroy(&training);
+		salad_destroy(&cur);
+		return EXIT_FAILURE;
+	}
 
 	inspect_t context = {
 			.fct = pick_wrapper(t, newBloomFilter),
-			.param = {TO_BLOOMFILTER(training.model), TO_BLOOMFILTER(cur.model), cur.ngram_length, __(cur).delimiter.d},
+			.param = {TO_CONTAINER(training.model), uniq, hll, cur.ngram_length, __(cur).delimiter.d, __(training).tokens},
 			.buf = {0},
 			.stats = (bloomize_stats_t*) calloc(c->batch_size, sizeof(bloomize_stats_t)),
 			.num_uniq = 0,
@@ -141,17 +166,58 @@ const int salad_inspect_stub(const config_t* const c, const data_processor_t* co
 
 	dp->recv(f_in, salad_inspect_callback, c->batch_size, &context);
 
-	BLOOM* const cur_model = TO_BLOOMFILTER(cur.model);
-
-	const size_t N = bloom_count(cur_model);
-	info("Saturation: %.3f%%", (((double)N)/ ((double)cur_model->bitsize))*100);
+	// The estimates refer to the model the n-grams are checked against
+	const container_t* const cur_model = TO_CONTAINER(training.model);
 
-	const uint8_t k = cur_model->nfuncs;
+	// The share of a filter of the given size all distinct n-grams would occupy
+	const long double N = (long double) hll_estimate(hll);
 	const long double n = (long double) context.num_uniq;
-	const long double m = (long double) cur_model->bitsize;
-	info("Expected error: %.3Lf%%", pow(1 - exp(-(k*n)/ m), k) *100);
+	info("Distinct n-grams: ~%.0Lf", N);
+
+	if (cur_model->type == CONTAINER_CUCKOOFILTER)
+	{
+		// Each lookup compares against the fingerprints of two buckets
+		const long double m = (long double) cuckoo_capacity(cur_model->data);
+		const long double f = ldexpl(1.0, -CUCKOO_FPBITS);
+		const long double lookups = 2 *CUCKOO_BUCKETSIZE;
+
+		info("Load: %.3Lf%%", (N/ m) *100);
+		info("Expected error: %.3Lf%%", (1 - powl(1 - f, lookups *MIN(n/ m, 1.0))) *100);
+	}
+	else if (cur_model->type == CONTAINER_XORFILTER)
+	{
+		// The error of static filters does not depend on the data checked
+		info("Expected error: %.3Lf%%", ldexpl(1.0, -XOR_FPBITS) *100);
+	}
+	else
+	{
+		const BLOOM* const bloom = (BLOOM*) cur_model->data;
+		const uint8_t k = bloom->nfuncs;
+		// The bits of an interleaved filter are shared by both classes
+		const size_t classes = (cur_model->type == CONTAINER_TWOCLASSBLOOMFILTER ? 2 : 1);
+		const long double m = (long double) (bloom->bitsize/ classes);
+
+		if (t == BYTE_NGRAM && bloom_hashset(bloom) == HASHES_DIRECT && m >= ldexpl(1.0, (int) (cur.ngram_length *CHAR_BIT)))
+		{
+			// Each n-gram has a bit of its own
+			info("Saturation: %.3Lf%%", (N/ m) *100);
+			info("Expected error: %.3Lf%%", 0.0L);
+		}
+		else
+		{
+			info("Saturation: %.3Lf%%", (1 - exp(-(k*N)/ m)) *100);
+			info("Expected error: %.3Lf%%", pow(1 - exp(-(k*n)/ m), k) *100);
+		}
+	}
+
+	if (uniq->dropped > 0)
+	{
+		warn("Unable to track %"ZU" n-grams, the unique counts are too low.", (SIZE_T) uniq->dropped);
+	}
 
 	free(context.stats);
+	fpset_destroy(uniq);
+	hll_destroy(hll);
 
 	salad_destroy(&training);
 	salad_destroy(&cur);
@@ -16,6 +16,8 @@
  */
 
 #include "main.h"
+#include "serve.h"
+#include "shared.h"
 #include <salad/salad.h>
 #include <salad/classify.h>
 #include <salad/util.h>
@@ -31,14 +33,29 @@
 
 typedef struct {
 	FN_CLASSIFIER fct;
-	bloom_param_t param;
+	model_param_t param;
 
 	const config_t* const config;
 	double* const scores;
+	window_t* const windows; // cf. --window
 	FILE* const out;
 	double total_time;
+	size_t num_streams; // cf. --stream
+
+	serve_loader_t* loader; // Network data only, cf. --watch
 } predict_t;
 
+// Returns the model that a batch is scored with. Models that are reloaded
+// are referenced until the batch is done, cf. serve_release.
+static serve_models_t* predict_acquire(predict_t* const x, FN_CLASSIFIER* const fct, model_param_t** const param)
+{
+	serve_models_t* const m = (x->loader != NULL ? serve_acquire(x->loader) : NULL);
+
+	*fct = (m != NULL ? m->m.fcts[0] : x->fct);
+	*param = (m != NULL ? &m->m.params[0] : &x->param);
+	return m;
+}
+
 
 #define TO_STRING(score) (isnan(score) ? \
 			x->config->nan : \
@@ -58,10 +75,26 @@ const int salad_predict_callback(data_t* data, const size_t n, void* const usr)
 	struct timeval start, end;
 	gettimeofday(&start, NULL);
 
-	for (size_t i = 0; i < n; i++)
+	FN_CLASSIFIER fct;
+	model_param_t* p;
+	serve_models_t* const m = predict_acquire(x, &fct, &p);
+
+	if (x->windows != NULL)
 	{
-		x->scores[i] = x->fct(&x->param, data[i].buf, data[i].len);
+		for (size_t i = 0; i < n; i++)
+		{
+			x->windows[i] = classify_1class_window_ex(p->model1, data[i].buf, data[i].len, p->n, x->config->window);
+		}
 	}
+	else
+	{
+		for (size_t i = 0; i < n; i++)
+		{
+			x->scores[i] = fct(p, data[i].buf, data[i].len);
+		}
+	}
+
+	if (m != NULL) serve_release(m);
 
 	// Clock the calculation procedure
 	gettimeofday(&end, NULL);
@@ -71,6 +104,16 @@ const int salad_predict_callback(data_t* data, const size_t n, void* const usr)
 	// Write scores
 	char buf[0x100];
 
+	if (x->windows != NULL)
+	{
+		for (size_t j = 0; j < n; j++)
+		{
+			fputs(TO_STRING(x->windows[j].score), x->out);
+			fprintf(x->out, " %"ZU" %"ZU"\n", (SIZE_T) x->windows[j].offset, (SIZE_T) x->windows[j].len);
+		}
+		return EXIT_SUCCESS;
+	}
+
 #ifdef GROUPED_INPUT
 	if (x->config->group_input)
 	{
@@ -118,7 +161,7 @@ const int salad_predict_callback2(data_t* data, const size_t n, void* const usr)
 		for (size_t j = 1; j < n; j++)
 		{
 			fputs(prev == data[j].meta.group ? " " : "\n", x->out);
-			fputs(TO_STRING(x->scores[1]), x->out);
+			fputs(TO_STRING(x->scores[j]), x->out);
 			prev = data[j].meta.group;
 		}
 	}
@@ -127,21 +170,326 @@ const int salad_predict_callback2(data_t* data, const size_t n, void* const usr)
 	{
 		for (size_t j = 0; j < n;  j++)
 		{
-			fputs(TO_STRING(x->scores[1]), x->out);
+			fputs(TO_STRING(x->scores[j]), x->out);
+			fputs("\n", x->out);
+		}
+	}
+	return EXIT_SUCCESS;
+}
+#endif
+
+#ifdef USE_NETWORK
+// Called concurrently by the scoring threads of net_workers, hence the
+// scores are kept locally and every line is written in one go. The lines
+// finish in any order and thus carry the number of the stream or datagram
+// in the order of arrival, as with --stream.
+const int salad_predict_concurrent_callback(data_t* data, const size_t n, void* const usr)
+{
+	assert(data != NULL);
+	assert(usr != NULL);
+
+	predict_t* const x = (predict_t*) usr;
+
+	FN_CLASSIFIER fct;
+	model_param_t* p;
+	serve_models_t* const m = predict_acquire(x, &fct, &p);
+
+	char buf[0x100];
+	for (size_t i = 0; i < n; i++)
+	{
+		const double score = fct(p, data[i].buf, data[i].len);
+
+		flockfile(x->out);
+		fputs(TO_STRING(score), x->out);
+		fprintf(x->out, " %"ZU"\n", (SIZE_T) data[i].id);
+		funlockfile(x->out);
+	}
+
+	if (m != NULL) serve_release(m);
+	return EXIT_SUCCESS;
+}
+#endif
+
+typedef struct {
+	serve_loader_t* const loader;
+	const size_t num;
+
+	const config_t* const config;
+	double* const scores;
+	FILE* const out;
+	double total_time;
+} predict_multi_t;
+
+
+// Scores every string of the batch with all models and writes one
+// space-separated column per model.
+const int salad_predict_multi_callback(data_t* data, const size_t n, void* const usr)
+{
+	assert(data != NULL);
+	assert(n > 0);
+	assert(usr != NULL);
+
+	predict_multi_t* const x = (predict_multi_t*) usr;
+
+	struct timeval start, end;
+	gettimeofday(&start, NULL);
+
+	// Reloaded models match the current ones in number, cf. serve_loader_start
+	serve_models_t* const m = serve_acquire(x->loader);
+	for (size_t k = 0; k < x->num; k++)
+	{
+		for (size_t i = 0; i < n; i++)
+		{
+			x->scores[i *x->num +k] = m->m.fcts[k](&m->m.params[k], data[i].buf, data[i].len);
+		}
+	}
+	serve_release(m);
+
+	// Clock the calculation procedure
+	gettimeofday(&end, NULL);
+	double diff = TO_SEC(end) -TO_SEC(start);
+	x->total_time += diff;
+
+	// Write scores
+	char buf[0x100];
+
+	for (size_t j = 0; j < n; j++)
+	{
+		for (size_t k = 0; k < x->num; k++)
+		{
+			if (k > 0) fputs(" ", x->out);
+			fputs(TO_STRING(x->scores[j *x->num +k]), x->out);
+		}
+		fputs("\n", x->out);
+	}
+	return EXIT_SUCCESS;
+}
+
+// Loads the model with its bit array in the shared memory segment of the
+// given suffix if requested, cf. --shared-model
+static const int salad_predict_load(const config_t* const c, const char* const id, const char* const filename, const char* const suffix, salad_t* const out, shared_t* const sh)
+{
+	char name[0x100];
+	snprintf(name, sizeof(name), "%s%s", (c->shared_model != NULL ? c->shared_model : ""), suffix);
+	return salad_from_shared(id, filename, (c->shared_model != NULL ? name : NULL), out, sh);
+}
+
+static void salad_predict_destroy(salad_t* const s, shared_t* const sh)
+{
+	salad_unshare(sh);
+	if (TO_CONTAINER(s->model) != NULL)
+	{
+		salad_destroy(s);
+	}
+}
+
+// Network data is scored with models that are loaded anew on SIGHUP, or once
+// their files change, cf. --watch. Models in shared memory are kept as they are.
+static const int salad_predict_reloads(const config_t* const c)
+{
+#ifdef USE_NETWORK
+	return (c->shared_model == NULL && (c->input_type == IOMODE_NETWORK || c->input_type == IOMODE_NETWORK_DUMP));
+#else
+	return FALSE;
+#endif
+}
+
+static const int salad_predict_multi(const config_t* const c, const data_processor_t* const dp, file_t* const f_in, FILE* const f_out)
+{
+	if (c->bbloom != NULL || c->group_input)
+	{
+		error("Several models can neither be combined with a bad content model");
+		error("nor with grouped input.");
+		return EXIT_FAILURE;
+	}
+
+	serve_loader_t loader;
+	if (serve_loader_init(&loader, c->bloom, c->shared_model, c->serve_watch, c->echo_params) != EXIT_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	// The models as loaded, they are replaced only once the loader is started
+	models_t* const m = &loader.models->m;
+	double* const scores = (double*) calloc(c->batch_size *m->num, sizeof(double));
+
+	if (scores != NULL)
+	{
+		predict_multi_t context = {
+				.loader = &loader,
+				.num = m->num,
+				.config = c,
+				.scores = scores,
+				.out = f_out,
+				.total_time = 0.0
+		};
+
+		if (salad_predict_reloads(c))
+		{
+			serve_loader_start(&loader);
+		}
+
+		dp->recv(f_in, salad_predict_multi_callback, c->batch_size, &context);
+		info("Net calculation time: %.4f seconds", context.total_time);
+	}
+
+	const int ok = (scores != NULL);
+	serve_loader_destroy(&loader);
+	free(scores);
+	return (ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+typedef struct {
+	salad_t* const s;
+	salad_stream_t stream;
+
+	const config_t* const config;
+	FILE* const out;
+	double total_time;
+} predict_chunk_t;
+
+// Items might be split into several chunks, cf. --chunk-size. The score of
+// an item is written once its last chunk has been processed.
+const int salad_predict_chunk_callback(data_t* data, const size_t n, void* const usr)
+{
+	assert(data != NULL);
+	assert(usr != NULL);
+
+	predict_chunk_t* const x = (predict_chunk_t*) usr;
+	char buf[0x100];
+
+	for (size_t i = 0; i < n; i++)
+	{
+		struct timeval start, end;
+		gettimeofday(&start, NULL);
+
+		double score = 0.0;
+		const saladdata_t chunk = {data[i].buf, data[i].len};
+		if (salad_stream_predict(x->s, &x->stream, &chunk, !data[i].partial, &score) != EXIT_SUCCESS)
+		{
+			return EXIT_FAILURE;
+		}
+
+		// Clock the calculation procedure
+		gettimeofday(&end, NULL);
+		x->total_time += TO_SEC(end) -TO_SEC(start);
+
+		if (!data[i].partial)
+		{
+			fputs(TO_STRING(score), x->out);
 			fputs("\n", x->out);
 		}
 	}
 	return EXIT_SUCCESS;
 }
+
+#ifdef USE_NETWORK
+typedef struct {
+	size_t id;
+	size_t known;
+	size_t total;
+	size_t bytes; // since the last report
+	double last;  // time of the last report
+} stream_score_t;
+
+// Accumulates the counts of a stream chunk by chunk and reports its score
+// at the checkpoints and once the stream ends. Consecutive chunks overlap
+// by n-1 bytes, cf. net_stream, such that every n-gram is counted once.
+const int salad_predict_stream_callback(data_t* data, const size_t n, void* const usr)
+{
+	assert(data != NULL);
+	assert(usr != NULL);
+
+	predict_t* const x = (predict_t*) usr;
+	const config_t* const c = x->config;
+
+	struct timeval start, end;
+	gettimeofday(&start, NULL);
+	const double now = TO_SEC(start);
+
+	FN_CLASSIFIER fct;
+	model_param_t* p;
+	serve_models_t* const m = predict_acquire(x, &fct, &p);
+
+	char buf[0x100];
+	for (size_t i = 0; i < n; i++)
+	{
+		// Items without a slot, e.g., UDP datagrams, are complete already
+		stream_score_t single;
+		stream_score_t* st = (data[i].state != NULL ? (stream_score_t*) *data[i].state : NULL);
+
+		if (st == NULL)
+		{
+			st = (data[i].state != NULL ? (stream_score_t*) calloc(1, sizeof(stream_score_t)) : &single);
+			if (st == NULL)
+			{
+				if (m != NULL) serve_release(m);
+				return EXIT_FAILURE;
+			}
+			memset(st, 0x00, sizeof(stream_score_t));
+
+			// Workers number their streams interleaved, cf. salad_heart_sharded
+			st->id = x->num_streams;
+			x->num_streams += c->net_workers;
+			st->last = now;
+			if (data[i].state != NULL)
+			{
+				*data[i].state = st;
+			}
+		}
+
+		st->known += classify_1class_known_ex(p->model1, data[i].buf, data[i].len, p->n);
+		st->total += (data[i].len < p->n ? 0 : data[i].len -p->n +1);
+		st->bytes += data[i].len;
+
+		const int checkpoint = (c->net_checkpoint > 0 && st->bytes >= c->net_checkpoint)
+		                    || (c->net_checkpoint_time > 0.0 && now -st->last >= c->net_checkpoint_time);
+
+		if (!data[i].partial || checkpoint)
+		{
+			const double score = ((double) (st->total -st->known))/ st->total;
+			fputs(TO_STRING(score), x->out);
+			fprintf(x->out, " %"ZU"\n", (SIZE_T) st->id);
+			fflush(x->out);
+
+			st->bytes = 0;
+			st->last = now;
+		}
+
+		if (!data[i].partial && data[i].state != NULL)
+		{
+			free(st);
+			*data[i].state = NULL;
+		}
+	}
+
+	if (m != NULL) serve_release(m);
+
+	gettimeofday(&end, NULL);
+	x->total_time += TO_SEC(end) -TO_SEC(start);
+	return EXIT_SUCCESS;
+}
 #endif
 
 const int salad_predict_stub(const config_t* const c, const data_processor_t* const dp, file_t* const f_in, FILE* const f_out)
 {
 	salad_header("Predict scores of", &f_in->meta, c);
+
+	if (strchr(c->bloom, ',') != NULL)
+	{
+		if (c->window > 0 || c->chunk_size > 0)
+		{
+			error("Windows and chunks cannot be combined with several models.");
+			return EXIT_FAILURE;
+		}
+		return salad_predict_multi(c, dp, f_in, f_out);
+	}
 	SALAD_T(good);
 	SALAD_T(bad);
+	// The bit arrays of shared models are mapped rather than loaded
+	shared_t shared = EMPTY_SHARED_INITIALIZER, bshared = EMPTY_SHARED_INITIALIZER;
 
-	if (salad_from_file_v("training", c->bloom, &good) != EXIT_SUCCESS)
+	if (salad_predict_load(c, "training", c->bloom, "", &good, &shared) != EXIT_SUCCESS)
 	{
 		return EXIT_FAILURE;
 	}
@@ -149,73 +497,164 @@ const int salad_predict_stub(const config_t* const c, const data_processor_t* co
 
 	if (c->bbloom)
 	{
-		if (salad_from_file_v("bad content", c->bbloom, &bad) != EXIT_SUCCESS)
+		if (salad_predict_load(c, "bad content", c->bbloom, ".bad", &bad, &bshared) != EXIT_SUCCESS)
 		{
-			salad_destroy(&good);
+			salad_predict_destroy(&good, &shared);
 			return EXIT_FAILURE;
 		}
 
 		if (salad_spec_diff(&good, &bad))
 		{
-			salad_destroy(&good);
-			salad_destroy(&bad);
+			salad_predict_destroy(&good, &shared);
+			salad_predict_destroy(&bad, &bshared);
 			status("The normal and the bad content filter were not generated with the same parameters.");
 			return EXIT_FAILURE;
 		}
 		// XXX: Just checking the validity of the model ;)
-		// GET_BLOOMFILTER(bad.model);
-		assert(bad.model.type == SALAD_MODEL_BLOOMFILTER);
+		assert(bad.model.type == good.model.type);
+
+		// Both classes are answered at once if the filters can be interleaved.
+		// Shared filters are kept as they are, though.
+		if (c->shared_model == NULL && salad_interleave(&good, &bad) == EXIT_SUCCESS)
+		{
+			salad_destroy(&bad);
+		}
 	}
 
-	// TODO: right now there only are bloom filters!
-	BLOOM* const good_model = GET_BLOOMFILTER(good.model);
-	BLOOM* const bad_model = TO_BLOOMFILTER(bad.model);
+	container_t* const good_model = GET_CONTAINER(good.model);
+	// An interleaved model serves as both, the good and the bad content model
+	container_t* const bad_model = (good_model->type == CONTAINER_TWOCLASSBLOOMFILTER ? good_model : TO_CONTAINER(bad.model));
 
 
 	if (c->echo_params)
 	{
-		config_t cfg;
+		config_t cfg = DEFAULT_CONFIG;
 		cfg.ngram_length = good.ngram_length;
+		cfg.container = good_model->type;
+		cfg.hash_set = HASHES_UNDEFINED;
+
+		if (IS_BLOOMFILTER(good_model->type))
+		{
+			cfg.hash_set = bloom_hashset((BLOOM*) good_model->data);
+		}
 
-		const long double d = ceill(log2l((long double) good_model->bitsize));
+		// The filter size refers to a single class
+		const size_t classes = (good_model->type == CONTAINER_TWOCLASSBLOOMFILTER ? 2 : 1);
+		const long double d = ceill(log2l((long double) (container_bitsize(good_model)/ classes)));
 		assert(d <= UINT_MAX);
 		cfg.filter_size = (unsigned int) d;
 
-		switch (bloomfct_cmp(good_model, HASHSET_SIMPLE, HASHSET_SIMPLE2, HASHSET_MURMUR))
-		{
-		case 0:
-			cfg.hash_set = HASHES_SIMPLE;
-			break;
-		case 1:
-			cfg.hash_set = HASHES_SIMPLE2;
-			break;
-		case 2:
-			cfg.hash_set = HASHES_MURMUR;
-			break;
-		default:
-			cfg.hash_set = HASHES_UNDEFINED;
-			break;
-		}
+		cfg.intern_tokens = (__(good).tokens != NULL);
 
 		STRDUP(__(good).delimiter.str, cfg.delimiter);
 		echo_options(&cfg);
 		free(cfg.delimiter);
 	}
 
-	const model_type_t t = to_model_type(good.as_binary, __(good).use_tokens);
+	const model_type_t t = to_model_type(good.as_binary, __(good).use_tokens, __(good).tokens != NULL);
+	// Models of interned tokens are never interleaved and keep their own dictionary
+	DICT* const bad_tokens = (TO_CONTAINER(bad.model) != NULL ? __(bad).tokens : NULL);
+
+	if (c->window > 0 && (t != BYTE_NGRAM || bad_model != NULL || c->group_input))
+	{
+		error("Windowed scoring requires a one-class model of byte n-grams");
+		error("and cannot be combined with grouped input.");
+		salad_predict_destroy(&bad, &bshared);
+		salad_predict_destroy(&good, &shared);
+		return EXIT_FAILURE;
+	}
+
+	if (c->chunk_size > 0)
+	{
+		const int ret = (bad_model != NULL || c->window > 0 || c->group_input || dp->recv2 == NULL ? EXIT_FAILURE : EXIT_SUCCESS);
+		if (ret != EXIT_SUCCESS)
+		{
+			error("Processing strings in chunks requires a one-class model, an");
+			error("input that can be chunked, and neither windows nor groups.");
+		}
+		else
+		{
+			predict_chunk_t context = {
+					.s = &good,
+					.stream = EMPTY_SALAD_STREAM_INITIALIZER,
+					.config = c,
+					.out = f_out,
+					.total_time = 0.0
+			};
+
+			dp->recv2(f_in, salad_predict_chunk_callback, c->chunk_size, &context);
+			salad_stream_destroy(&context.stream);
+			info("Net calculation time: %.4f seconds", context.total_time);
+		}
+
+		salad_predict_destroy(&bad, &bshared);
+		salad_predict_destroy(&good, &shared);
+		return ret;
+	}
+
+	FN_DATA callback = salad_predict_callback;
+#ifdef USE_NETWORK
+	if (c->net_stream && (c->input_type == IOMODE_NETWORK || c->input_type == IOMODE_NETWORK_DUMP))
+	{
+		if (t != BYTE_NGRAM || bad_model != NULL || c->window > 0)
+		{
+			error("Streaming requires a one-class model of byte n-grams.");
+			salad_predict_destroy(&bad, &bshared);
+			salad_predict_destroy(&good, &shared);
+			return EXIT_FAILURE;
+		}
+
+		net_stream(f_in, good.ngram_length -1);
+		callback = salad_predict_stream_callback;
+	}
+	else if (c->net_workers > 1 && c->input_type == IOMODE_NETWORK)
+	{
+		if (c->window > 0)
+		{
+			error("Scoring windows is not supported with several workers.");
+			salad_predict_destroy(&bad, &bshared);
+			salad_predict_destroy(&good, &shared);
+			return EXIT_FAILURE;
+		}
+
+		net_workers(f_in, c->net_workers);
+		callback = salad_predict_concurrent_callback;
+	}
+#endif
 
 	predict_t context = {
 			.fct = pick_classifier(t, bad_model == NULL),
-			.param = {good_model, bad_model, good.ngram_length, __(good).delimiter.d},
+			.param = {good_model, bad_model, good.ngram_length, __(good).delimiter.d, __(good).tokens, bad_tokens},
 			.config = c,
 			// TODO: we do not know the batch size of the recv function
 			.scores = (double*) calloc(c->batch_size, sizeof(double)),
+			.windows = (c->window > 0 ? (window_t*) calloc(c->batch_size, sizeof(window_t)) : NULL),
 			.out = f_out,
-			.total_time = 0.0
+			.total_time = 0.0,
+			.num_streams = c->net_shard,
+			.loader = NULL
 	};
 
-	dp->recv(f_in, salad_predict_callback, c->batch_size, &context);
+#ifdef USE_NETWORK
+	if (c->input_type == IOMODE_NETWORK || c->input_type == IOMODE_NETWORK_DUMP)
+	{
+		net_latency(f_in, c->net_batch_latency);
+	}
+#endif
+
+	// The loader takes over the model and keeps it until the last batch that
+	// was started on it is done.
+	serve_loader_t loader;
+	if (bad_model == NULL && salad_predict_reloads(c)
+	    && serve_loader_adopt(&loader, &good, c->bloom, c->serve_watch) == EXIT_SUCCESS)
+	{
+		context.loader = &loader;
+		serve_loader_start(&loader);
+	}
+
+	dp->recv(f_in, callback, c->batch_size, &context);
 	free(context.scores);
+	free(context.windows);
 
 #ifdef USE_NETWORK
 	if (c->input_type != IOMODE_NETWORK)
@@ -232,11 +671,13 @@ const int salad_predict_stub(const config_t* const c, const data_processor_t* co
 		}
 	}
 
-	if (bad_model != NULL)
+	salad_predict_destroy(&bad, &bshared);
+
+	if (context.loader != NULL)
 	{
-		salad_destroy(&bad);
+		serve_loader_destroy(&loader);
 	}
-	salad_destroy(&good);
+	else salad_predict_destroy(&good, &shared);
 	return EXIT_SUCCESS;
 }
 
@@ -0,0 +1,440 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "main.h"
+#include "serve.h"
+
+#include <salad/salad.h>
+#include <salad/classify.h>
+#include <salad/util.h>
+#include <util/log.h>
+
+#ifdef USE_SERVE
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define SERVE_BUFSIZE 0x10000
+
+
+static volatile sig_atomic_t serve_stop = FALSE;
+
+static void serve_signal(int sig)
+{
+	serve_stop = TRUE;
+}
+
+
+typedef struct serve_conn
+{
+	int fd;
+	struct serve_conn* prev;
+	struct serve_conn* next;
+
+	uint8_t* buf;
+	size_t len;
+	size_t capacity;
+	serve_parser_t parser;
+
+	// The response that the client did not take yet, cf. serve_flush
+	uint8_t* out;
+	size_t out_len;
+	size_t out_sent;
+	size_t out_capacity;
+} serve_conn_t;
+
+typedef struct
+{
+	serve_loader_t models;
+
+	int listener;
+	int epoll;
+
+	// Open connections, such that they can be released on shutdown
+	serve_conn_t* conns;
+	pthread_mutex_t lock;
+} serve_t;
+
+
+static const int reserve(uint8_t** const buf, size_t* const capacity, const size_t n)
+{
+	if (n <= *capacity) return EXIT_SUCCESS;
+
+	size_t x = MAX(*capacity, SERVE_BUFSIZE);
+	while (x < n) x *= 2;
+
+	uint8_t* const y = (uint8_t*) realloc(*buf, x);
+	if (y == NULL) return EXIT_FAILURE;
+
+	*buf = y;
+	*capacity = x;
+	return EXIT_SUCCESS;
+}
+
+// Sends as much of the pending response as the socket takes without
+// blocking. Returns FALSE if the connection ought to be closed.
+static const int serve_flush(serve_conn_t* const c)
+{
+	while (c->out_sent < c->out_len)
+	{
+		const ssize_t x = send(c->fd, c->out +c->out_sent, c->out_len -c->out_sent, MSG_NOSIGNAL);
+		if (x < 0)
+		{
+			if (errno == EINTR) continue;
+			return (errno == EAGAIN || errno == EWOULDBLOCK);
+		}
+		c->out_sent += (size_t) x;
+	}
+
+	c->out_len = c->out_sent = 0;
+	return TRUE;
+}
+
+// Scores all payloads of a request with every model. The response holds the
+// number of payloads and models followed by the scores in row-major order,
+// and is left in the output buffer of the connection.
+static const int serve_request(const models_t* const m, serve_conn_t* const c, const uint8_t* const req)
+{
+	uint32_t n, l;
+	memcpy(&n, req, sizeof(uint32_t));
+
+	const size_t size = 2*sizeof(uint32_t) +((size_t) n) *m->num *sizeof(double);
+	if (reserve(&c->out, &c->out_capacity, size) != EXIT_SUCCESS)
+	{
+		error("Unable to allocate the response for %"ZU" strings.", (SIZE_T) n);
+		return EXIT_FAILURE;
+	}
+
+	const uint32_t num = (uint32_t) m->num;
+	memcpy(c->out, &n, sizeof(uint32_t));
+	memcpy(c->out +sizeof(uint32_t), &num, sizeof(uint32_t));
+
+	uint8_t* out = c->out +2*sizeof(uint32_t);
+	const uint8_t* x = req +sizeof(uint32_t);
+
+	for (uint32_t i = 0; i < n; i++)
+	{
+		memcpy(&l, x, sizeof(uint32_t));
+		x += sizeof(uint32_t);
+
+		for (size_t k = 0; k < m->num; k++)
+		{
+			// cf. TO_STRING in salad_predict.c
+			const double score = m->fcts[k](&m->params[k], (const char*) x, l);
+			const double y = (isnan(score) ? score : 1.0 -((float) score));
+
+			memcpy(out, &y, sizeof(double));
+			out += sizeof(double);
+		}
+		x += l;
+	}
+
+	c->out_len = size;
+	c->out_sent = 0;
+	return EXIT_SUCCESS;
+}
+
+static void serve_close(serve_t* const s, serve_conn_t* const c)
+{
+	pthread_mutex_lock(&s->lock);
+	if (c->prev != NULL) c->prev->next = c->next;
+	else s->conns = c->next;
+	if (c->next != NULL) c->next->prev = c->prev;
+	pthread_mutex_unlock(&s->lock);
+
+	epoll_ctl(s->epoll, EPOLL_CTL_DEL, c->fd, NULL);
+	close(c->fd);
+	free(c->buf);
+	free(c->out);
+	free(c);
+}
+
+// Answers the complete requests in the buffer one after the other, as long
+// as the client takes the responses. Returns FALSE if the connection ought to
+// be closed.
+static const int serve_process(serve_t* const s, serve_conn_t* const c)
+{
+	size_t pos = 0, n;
+	while (c->out_len == 0 && (n = serve_parse(&c->parser, c->buf +pos, c->len -pos)) > 0)
+	{
+		if (n == SIZE_MAX)
+		{
+			warn("Dropping a client due to a malformed request.");
+			return FALSE;
+		}
+		serve_models_t* const m = serve_acquire(&s->models);
+		const int ret = serve_request(&m->m, c, c->buf +pos);
+		serve_release(m);
+
+		if (ret != EXIT_SUCCESS || !serve_flush(c)) return FALSE;
+		pos += n;
+	}
+
+	if (pos > 0)
+	{
+		memmove(c->buf, c->buf +pos, c->len -pos);
+		c->len -= pos;
+	}
+	return TRUE;
+}
+
+// Reads whatever is available and answers all complete requests. Reading
+// pauses while a response is pending, such that slow clients are throttled
+// rather than buffered for. Returns FALSE if the connection ought to be
+// closed.
+static const int serve_read(serve_t* const s, serve_conn_t* const c)
+{
+	while (TRUE)
+	{
+		if (!serve_process(s, c)) return FALSE;
+		if (c->out_len > 0) return TRUE;
+
+		if (reserve(&c->buf, &c->capacity, c->len +SERVE_BUFSIZE) != EXIT_SUCCESS)
+		{
+			return FALSE;
+		}
+
+		const ssize_t x = recv(c->fd, c->buf +c->len, c->capacity -c->len, 0);
+		if (x == 0) return FALSE;
+		if (x < 0)
+		{
+			if (errno == EINTR) continue;
+			return (errno == EAGAIN || errno == EWOULDBLOCK);
+		}
+		c->len += (size_t) x;
+	}
+}
+
+static void serve_accept(serve_t* const s)
+{
+	int fd;
+	while ((fd = accept(s->listener, NULL, NULL)) >= 0)
+	{
+		serve_conn_t* const c = (serve_conn_t*) calloc(1, sizeof(serve_conn_t));
+		if (c == NULL || fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0)
+		{
+			free(c);
+			close(fd);
+			continue;
+		}
+		c->fd = fd;
+
+		pthread_mutex_lock(&s->lock);
+		c->next = s->conns;
+		if (s->conns != NULL) s->conns->prev = c;
+		s->conns = c;
+		pthread_mutex_unlock(&s->lock);
+
+		struct epoll_event e = {EPOLLIN | EPOLLRDHUP | EPOLLONESHOT, {.ptr = c}};
+		if (epoll_ctl(s->epoll, EPOLL_CTL_ADD, fd, &e) < 0)
+		{
+			serve_close(s, c);
+		}
+	}
+}
+
+// All workers wait on the same epoll instance. Since every descriptor is
+// registered as one-shot, a connection is served by one worker at a time.
+static void* serve_worker(void* const usr)
+{
+	serve_t* const s = (serve_t*) usr;
+
+	struct epoll_event e;
+	while (!serve_stop)
+	{
+		const int n = epoll_wait(s->epoll, &e, 1, SERVE_TIMEOUT);
+		if (n <= 0) continue;
+
+		if (e.data.ptr == NULL)
+		{
+			serve_accept(s);
+
+			struct epoll_event x = {EPOLLIN | EPOLLONESHOT, {.ptr = NULL}};
+			epoll_ctl(s->epoll, EPOLL_CTL_MOD, s->listener, &x);
+			continue;
+		}
+
+		serve_conn_t* const c = (serve_conn_t*) e.data.ptr;
+		if (!serve_flush(c) || !serve_read(s, c) || (e.events & (EPOLLERR | EPOLLHUP)))
+		{
+			serve_close(s, c);
+			continue;
+		}
+
+		// A pending response is continued once the client reads again.
+		const uint32_t events = (c->out_len > 0 ? EPOLLOUT : EPOLLIN | EPOLLRDHUP);
+		struct epoll_event x = {events | EPOLLONESHOT, {.ptr = c}};
+		epoll_ctl(s->epoll, EPOLL_CTL_MOD, c->fd, &x);
+	}
+	return NULL;
+}
+
+static const int serve_listen(const char* const path)
+{
+	struct sockaddr_un addr;
+	memset(&addr, 0x00, sizeof(struct sockaddr_un));
+	addr.sun_family = AF_UNIX;
+
+	if (strlen(path) >= sizeof(addr.sun_path))
+	{
+		error("The socket path '%s' is too long.", path);
+		return -1;
+	}
+	strcpy(addr.sun_path, path);
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+	{
+		error("Unable to create the socket.");
+		return -1;
+	}
+
+	int ret = bind(fd, (struct sockaddr*) &addr, sizeof(struct sockaddr_un));
+	if (ret < 0 && errno == EADDRINUSE)
+	{
+		// A stale socket of a previous instance, unless somebody answers.
+		const int x = socket(AF_UNIX, SOCK_STREAM, 0);
+		const int alive = (x >= 0 && connect(x, (struct sockaddr*) &addr, sizeof(struct sockaddr_un)) == 0);
+		if (x >= 0) close(x);
+
+		if (alive)
+		{
+			error("There already is a server listening on '%s'.", path);
+			close(fd);
+			return -1;
+		}
+		unlink(path);
+		ret = bind(fd, (struct sockaddr*) &addr, sizeof(struct sockaddr_un));
+	}
+
+	if (ret < 0 || listen(fd, SOMAXCONN) < 0
+	    || fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0)
+	{
+		error("Unable to listen on '%s': %s", path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+
+const int _salad_serve_(const config_t* const c)
+{
+	serve_t s;
+	memset(&s, 0x00, sizeof(serve_t));
+
+	if (serve_loader_init(&s.models, c->bloom, NULL, c->serve_watch, c->echo_params) != EXIT_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	s.listener = serve_listen(c->socket);
+	s.epoll = epoll_create(1);
+	if (s.listener < 0 || s.epoll < 0)
+	{
+		if (s.listener >= 0)
+		{
+			close(s.listener);
+			unlink(c->socket);
+		}
+		if (s.epoll >= 0) close(s.epoll);
+		serve_loader_destroy(&s.models);
+		return EXIT_FAILURE;
+	}
+	pthread_mutex_init(&s.lock, NULL);
+
+	struct epoll_event e = {EPOLLIN | EPOLLONESHOT, {.ptr = NULL}};
+	epoll_ctl(s.epoll, EPOLL_CTL_ADD, s.listener, &e);
+
+	struct sigaction sa;
+	memset(&sa, 0x00, sizeof(struct sigaction));
+	sa.sa_handler = serve_signal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	sa.sa_handler = SIG_IGN;
+	sigaction(SIGPIPE, &sa, NULL);
+
+	pthread_t* const threads = (pthread_t*) calloc(c->serve_workers, sizeof(pthread_t));
+	size_t num = 0;
+	for (; threads != NULL && num < c->serve_workers; num++)
+	{
+		if (pthread_create(&threads[num], NULL, serve_worker, &s) != 0) break;
+	}
+
+	int ret = EXIT_SUCCESS;
+	if (num == 0)
+	{
+		error("Unable to start the workers.");
+		ret = EXIT_FAILURE;
+	}
+	else
+	{
+		status("Serving %"ZU" model(s) on '%s' with %"ZU" worker(s).", (SIZE_T) s.models.models->m.num, c->socket, (SIZE_T) num);
+	}
+
+	// The workers keep answering requests while new models are loaded.
+	if (num > 0 && serve_loader_start(&s.models) != EXIT_SUCCESS)
+	{
+		warn("Unable to watch the models, they are not reloaded.");
+	}
+
+	while (num > 0 && !serve_stop)
+	{
+		poll(NULL, 0, SERVE_TIMEOUT);
+	}
+
+	for (size_t i = 0; i < num; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+	free(threads);
+
+	while (s.conns != NULL)
+	{
+		serve_close(&s, s.conns);
+	}
+	pthread_mutex_destroy(&s.lock);
+
+	close(s.epoll);
+	close(s.listener);
+	unlink(c->socket);
+
+	serve_loader_destroy(&s.models);
+	return ret;
+}
+
+#else
+
+const int _salad_serve_(const config_t* const c)
+{
+	error("Salad was compiled without support for the serve mode.");
+	return EXIT_FAILURE;
+}
+
+#endif
@@ -19,6 +19,7 @@
 
 #include <salad/salad.h>
 #include <salad/io.h>
+#include <salad/util.h>
 #include <util/log.h>
 
 const int _salad_stats_(const config_t* const c)
@@ -39,9 +40,35 @@ const int _salad_stats_(const config_t* const c)
 		return EXIT_FAILURE;
 	}
 
-	BLOOM* bloom = GET_BLOOMFILTER(s.model);
-	const size_t set = bloom_count(bloom);
-	status("Saturation: %.3f%%", (((double)set)/ ((double)bloom->bitsize))*100);
+	const container_t* const model = GET_CONTAINER(s.model);
+	switch (model->type)
+	{
+	case CONTAINER_CUCKOOFILTER:
+	{
+		const CUCKOO* const cuckoo = (CUCKOO*) model->data;
+		status("Load: %.3f%%", (((double)cuckoo->count)/ ((double)cuckoo_capacity(cuckoo)))*100);
+		break;
+	}
+	case CONTAINER_XORFILTER:
+	{
+		const XORFILTER* const x = (XORFILTER*) model->data;
+		status("Keys: %"ZU" (%.2f bits/ key)", (SIZE_T) x->count,
+		       ((double) xor_bitsize(x))/ ((double) MAX(x->count, 1)));
+		break;
+	}
+	default:
+	{
+		BLOOM* bloom = (BLOOM*) model->data;
+		const size_t set = bloom_count(bloom);
+		status("Saturation: %.3f%%", (((double)set)/ ((double)bloom->bitsize))*100);
+		break;
+	}
+	}
+
+	if (__(s).tokens != NULL)
+	{
+		status("Interned tokens: %"ZU, (SIZE_T) __(s).tokens->count);
+	}
 
 	salad_destroy(&s);
 	return EXIT_SUCCESS;
@@ -36,79 +36,182 @@ typedef struct {
 } train_t;
 
 
-#define TRAINING_CALLBACK(X, _data_, _n_, _usr_)                                                                  \
-static inline const int salad_train_callback##X(data_t* data, const size_t n, void* usr)                          \
-{	                                                                                                              \
-	salad_t* const s = (salad_t*) usr;                                                                            \
-	                                                                                                              \
-	for (size_t i = 0; i < n; i++)                                                                                \
-	{                                                                                                             \
-		switch (#X[0]) /* This is a static check and will be optimized away */                                    \
-		{                                                                                                         \
-		case 'b':                                                                                                 \
-			bloomizeb_ex(TO_BLOOMFILTER(s->model), data[i].buf, data[i].len, s->ngram_length);                    \
-			break;                                                                                                \
-		case 'w':                                                                                                 \
-			bloomizew_ex(TO_BLOOMFILTER(s->model), data[i].buf, data[i].len, s->ngram_length, _(s)->delimiter.d); \
-			break;                                                                                                \
-		default:                                                                                                  \
-			bloomize_ex (TO_BLOOMFILTER(s->model), data[i].buf, data[i].len, s->ngram_length);                    \
-			break;                                                                                                \
-		}                                                                                                         \
-	}                                                                                                             \
-	return EXIT_SUCCESS;                                                                                          \
+#define TRAINING_CALLBACK(F, X, _data_, _n_, _usr_)                                                           \
+static inline const int salad_##F##_callback##X(data_t* data, const size_t n, void* usr)                     \
+{	                                                                                                          \
+	salad_t* const s = (salad_t*) usr;                                                                        \
+	                                                                                                          \
+	for (size_t i = 0; i < n; i++)                                                                            \
+	{                                                                                                         \
+		switch (#X[0]) /* This is a static check and will be optimized away */                                \
+		{                                                                                                     \
+		case 'b':                                                                                             \
+			F##b_ex(TO_CONTAINER(s->model),   data[i].buf, data[i].len, s->ngram_length);                     \
+			break;                                                                                            \
+		case 'w':                                                                                             \
+			F##w_ex(TO_CONTAINER(s->model),   data[i].buf, data[i].len, s->ngram_length, _(s)->delimiter.d);  \
+			break;                                                                                            \
+		case 'i':                                                                                             \
+			F##i_ex(TO_CONTAINER(s->model), _(s)->tokens, data[i].buf, data[i].len, s->ngram_length,          \
+			        _(s)->delimiter.d);                                                                       \
+			break;                                                                                            \
+		default:                                                                                              \
+			F##_ex (TO_CONTAINER(s->model),   data[i].buf, data[i].len, s->ngram_length);                     \
+			break;                                                                                            \
+		}                                                                                                     \
+	}                                                                                                         \
+	return EXIT_SUCCESS;                                                                                      \
 }
 
-#define TRAINING_NET_CALLBACK(X, _data_, _n_, _usr_)                                                              \
-static inline const int salad_train_net_callback##X(data_t* data, const size_t n, void* usr)                      \
-{	                                                                                                              \
-	assert(n == 1);                                                                                               \
-	salad_t* const s = (salad_t*) usr;                                                                            \
-	switch (#X[0]) /* This is a static check and will be optimized away */                                        \
-	{                                                                                                             \
-	case 'b':                                                                                                     \
-		bloomizeb_ex(TO_BLOOMFILTER(s->model), data[0].buf, data[0].len, s->ngram_length);                        \
-		break;                                                                                                    \
-	case 'w':                                                                                                     \
-		bloomizew_ex(TO_BLOOMFILTER(s->model), data[0].buf, data[0].len, s->ngram_length, _(s)->delimiter.d);     \
-		break;                                                                                                    \
-	default:                                                                                                      \
-		bloomize_ex (TO_BLOOMFILTER(s->model), data[0].buf, data[0].len, s->ngram_length);                        \
-		break;                                                                                                    \
-	}                                                                                                             \
-	return EXIT_SUCCESS;                                                                                          \
-}
-
-TRAINING_CALLBACK(b, data, n, usr)
-TRAINING_NET_CALLBACK(b, data, n, usr)
-
-TRAINING_CALLBACK(, data, n, usr)
-TRAINING_NET_CALLBACK(, data, n, usr)
+// Network streams are passed on in batches just as other inputs, cf. --batch-size
+TRAINING_CALLBACK(bloomize, b, data, n, usr)
+TRAINING_CALLBACK(bloomize, , data, n, usr)
+TRAINING_CALLBACK(bloomize, w, data, n, usr)
+TRAINING_CALLBACK(bloomize, i, data, n, usr)
 
-TRAINING_CALLBACK(w, data, n, usr)
-TRAINING_NET_CALLBACK(w, data, n, usr)
+// Removing n-grams rather than adding them, cf. --forget
+TRAINING_CALLBACK(forget, b, data, n, usr)
+TRAINING_CALLBACK(forget, , data, n, usr)
+TRAINING_CALLBACK(forget, w, data, n, usr)
+TRAINING_CALLBACK(forget, i, data, n, usr)
 
 
-FN_DATA pick_callback(const model_type_t t, const int use_network)
+FN_DATA pick_callback(const model_type_t t, const int forget)
 {
 	switch (t)
 	{
 	case BIT_NGRAM:
-		return (use_network ? salad_train_net_callbackb : salad_train_callbackb);
+		if (forget) return salad_forget_callbackb;
+		return salad_bloomize_callbackb;
 
 	case BYTE_NGRAM:
-		return (use_network ? salad_train_net_callback  : salad_train_callback );
+		if (forget) return salad_forget_callback;
+		return salad_bloomize_callback;
 
 	case TOKEN_NGRAM:
-		return (use_network ? salad_train_net_callbackw : salad_train_callbackw);
+		if (forget) return salad_forget_callbackw;
+		return salad_bloomize_callbackw;
+
+	case TOKENID_NGRAM:
+		if (forget) return salad_forget_callbacki;
+		return salad_bloomize_callbacki;
 	}
 	return NULL;
 }
 
+typedef struct {
+	salad_t* const s;
+	salad_stream_t stream;
+} train_chunk_t;
+
+// Items might be split into several chunks, cf. --chunk-size
+static const int salad_train_chunk_callback(data_t* data, const size_t n, void* usr)
+{
+	train_chunk_t* const x = (train_chunk_t*) usr;
+
+	for (size_t i = 0; i < n; i++)
+	{
+		const saladdata_t chunk = {data[i].buf, data[i].len};
+		if (salad_stream_train(x->s, &x->stream, &chunk, !data[i].partial) != EXIT_SUCCESS)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+typedef struct {
+	salad_t* const models;
+	const size_t num;
+	const FN_DATA fct;
+} train_multi_t;
+
+// Feeds each batch to all models in turn while it is still hot in cache.
+static const int salad_train_multi_callback(data_t* data, const size_t n, void* usr)
+{
+	train_multi_t* const x = (train_multi_t*) usr;
+
+	for (size_t k = 0; k < x->num; k++)
+	{
+		const int ret = x->fct(data, n, &x->models[k]);
+		if (ret != EXIT_SUCCESS) return ret;
+	}
+	return EXIT_SUCCESS;
+}
+
+static const int salad_train_multi(const config_t* const c, const data_processor_t* const dp, file_t* const f_in)
+{
+	const size_t num = c->num_ngram_lengths;
+	salad_t* const models = (salad_t*) calloc(num, sizeof(salad_t));
+	char* const fname = (char*) malloc(strlen(c->output) +0x20);
+
+	if (models == NULL || fname == NULL)
+	{
+		free(models);
+		free(fname);
+		error("Unable to allocate the models.");
+		return EXIT_FAILURE;
+	}
+
+	for (size_t k = 0; k < num; k++)
+	{
+		config_t cfg = *c;
+		cfg.ngram_length = c->ngram_lengths[k];
+		config_pick_hashset(&cfg);
+		salad_from_config(&models[k], &cfg);
+	}
+
+	const model_type_t t = to_model_type(models[0].as_binary, __(models[0]).use_tokens, __(models[0]).tokens != NULL);
+	train_multi_t context = {
+			.models = models,
+			.num = num,
+			.fct = pick_callback(t, FALSE)
+	};
+	dp->recv(f_in, salad_train_multi_callback, c->batch_size, &context);
+
+	int ret = EXIT_SUCCESS;
+	for (size_t k = 0; k < num; k++)
+	{
+		if (IS_CUCKOOFILTER(models[k].model) && ((CUCKOO*) TO_CONTAINER(models[k].model)->data)->victim != 0)
+		{
+			warn("The cuckoo filter for n = %"ZU" is full and some n-grams might have been dropped.", (SIZE_T) c->ngram_lengths[k]);
+		}
+
+		// One output file per n-gram length, e.g., model.ssd.3
+		snprintf(fname, strlen(c->output) +0x20, "%s.%"ZU, c->output, (SIZE_T) c->ngram_lengths[k]);
+		FILE* const f_out = fopen(fname, "wb+");
+
+		if (f_out == NULL || salad_to_file_ex(&models[k], f_out, c->output_type) != EXIT_SUCCESS)
+		{
+			error("Unable to write the model to %s.", fname);
+			ret = EXIT_FAILURE;
+		}
+		else
+		{
+			info("Model for n = %"ZU" written to %s", (SIZE_T) c->ngram_lengths[k], fname);
+		}
+
+		if (f_out != NULL)
+		{
+			fclose(f_out);
+		}
+		salad_destroy(&models[k]);
+	}
+
+	free(models);
+	free(fname);
+	return ret;
+}
+
 const int salad_train_stub(const config_t* const c, const data_processor_t* const dp, file_t* const f_in, FILE* const f_out)
 {
 	salad_header("Train salad on", &f_in->meta, c);
 
+	if (c->num_ngram_lengths > 1)
+	{
+		return salad_train_multi(c, dp, f_in);
+	}
+
 	SALAD_T(s1);
 	salad_from_config(&s1, c);
 
@@ -140,17 +243,55 @@ const int salad_train_stub(const config_t* const c, const data_processor_t* cons
 		}
 	}
 
-	const model_type_t t = to_model_type(s1.as_binary, __(s1).use_tokens);
+	if (s1.model.x != NULL && container_is_static(s1.model.x))
+	{
+		error("Static models, i.e., frozen or two-class ones, cannot be updated.");
+		salad_destroy(&s1);
+		return EXIT_FAILURE;
+	}
+
+	if (c->forget && (s1.model.x == NULL || !container_supports_removal(s1.model.x)))
+	{
+		error("Forgetting n-grams requires a counting bloom filter.");
+		salad_destroy(&s1);
+		return EXIT_FAILURE;
+	}
+
+	if (c->decay > 0 && !IS_COUNTINGBLOOMFILTER(s1.model))
+	{
+		error("Aging n-grams requires a counting bloom filter.");
+		salad_destroy(&s1);
+		return EXIT_FAILURE;
+	}
+
+	for (size_t i = 0; i < c->decay; i++)
+	{
+		salad_decay(&s1);
+	}
+
+	const model_type_t t = to_model_type(s1.as_binary, __(s1).use_tokens, __(s1).tokens != NULL);
 
-#ifdef USE_NETWORK
-	if (c->input_type == IOMODE_NETWORK || c->input_type == IOMODE_NETWORK_DUMP)
+	if (c->chunk_size > 0)
 	{
-		dp->recv(f_in, pick_callback(t, 1), c->batch_size, &s1);
+		if (dp->recv2 == NULL)
+		{
+			error("This type of input cannot be processed in chunks.");
+			salad_destroy(&s1);
+			return EXIT_FAILURE;
+		}
+
+		train_chunk_t context = {&s1, EMPTY_SALAD_STREAM_INITIALIZER};
+		dp->recv2(f_in, salad_train_chunk_callback, c->chunk_size, &context);
+		salad_stream_destroy(&context.stream);
 	}
 	else
-#endif
 	{
-		dp->recv(f_in, pick_callback(t, 0), c->batch_size, &s1);
+		dp->recv(f_in, pick_callback(t, c->forget), c->batch_size, &s1);
+	}
+
+	if (IS_CUCKOOFILTER(s1.model) && ((CUCKOO*) TO_CONTAINER(s1.model)->data)->victim != 0)
+	{
+		warn("The cuckoo filter is full and some n-grams might have been dropped.");
 	}
 
 	const int ret = salad_to_file_ex(&s1, f_out, c->output_type);
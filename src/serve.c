@@ -0,0 +1,261 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "serve.h"
+
+#include <salad/util.h>
+#include <util/log.h>
+
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+
+#include <sys/stat.h>
+
+
+static volatile sig_atomic_t serve_hangup = FALSE;
+
+static void serve_signal(int sig)
+{
+	serve_hangup = TRUE;
+}
+
+
+const size_t serve_parse(serve_parser_t* const p, const uint8_t* const buf, const size_t len)
+{
+	if (p->pos == 0)
+	{
+		if (len < sizeof(uint32_t)) return 0;
+		memcpy(&p->remaining, buf, sizeof(uint32_t));
+		p->pos = sizeof(uint32_t);
+	}
+
+	// The length prefixes that were parsed already are skipped over
+	uint32_t l;
+	for (; p->remaining > 0; p->remaining--)
+	{
+		if (p->pos +sizeof(uint32_t) > SERVE_MAX_REQUEST) return SIZE_MAX;
+		if (p->pos +sizeof(uint32_t) > len) return 0;
+		memcpy(&l, buf +p->pos, sizeof(uint32_t));
+
+		p->pos += sizeof(uint32_t) +l;
+		if (p->pos > SERVE_MAX_REQUEST) return SIZE_MAX;
+	}
+
+	if (p->pos > len) return 0;
+
+	const size_t n = p->pos;
+	p->pos = 0;
+	return n;
+}
+
+
+serve_models_t* serve_acquire(serve_loader_t* const l)
+{
+	pthread_mutex_lock(&l->lock);
+	serve_models_t* const x = l->models;
+	__atomic_add_fetch(&x->refs, 1, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&l->lock);
+	return x;
+}
+
+void serve_release(serve_models_t* const x)
+{
+	if (__atomic_sub_fetch(&x->refs, 1, __ATOMIC_ACQ_REL) == 0)
+	{
+		models_destroy(&x->m);
+		free(x);
+	}
+}
+
+
+static serve_models_t* serve_load(const char* const names, const char* const shared, const int echo)
+{
+	serve_models_t* const x = (serve_models_t*) calloc(1, sizeof(serve_models_t));
+	if (x == NULL) return NULL;
+
+	if (models_from_files(names, shared, &x->m, echo) != EXIT_SUCCESS)
+	{
+		free(x);
+		return NULL;
+	}
+	x->refs = 1;
+	return x;
+}
+
+// Summarizes the modification times and sizes of all model files, cf. --watch
+static const serve_stamp_t serve_stamp(const char* const names)
+{
+	serve_stamp_t x = {0, 0};
+
+	char* y = NULL;
+	STRDUP(names, y);
+	if (y == NULL) return x;
+
+	// The loader might run on a thread of its own, cf. serve_loader_start
+	char* save = NULL;
+	struct stat st;
+	for (char* name = strtok_r(y, ",", &save); name != NULL; name = strtok_r(NULL, ",", &save))
+	{
+		if (stat(name, &st) != 0) continue;
+
+		x.mtime = MAX(x.mtime, st.st_mtime);
+		x.size += st.st_size;
+	}
+	free(y);
+	return x;
+}
+
+// Loads the models anew and swaps them in if they match the specification of
+// the current ones. The current models are kept if anything goes wrong.
+static void serve_swap(serve_loader_t* const l)
+{
+	serve_models_t* const x = serve_load(l->names, l->shared, FALSE);
+	if (x == NULL)
+	{
+		warn("Unable to reload the models, keeping the current ones.");
+		return;
+	}
+
+	// Only the polling thread replaces the models, cf. serve_loader_poll
+	const models_t* const cur = &l->models->m;
+	int ok = (x->m.num == cur->num);
+	for (size_t k = 0; ok && k < cur->num; k++)
+	{
+		ok = !salad_spec_diff(&cur->models[k], &x->m.models[k]);
+	}
+
+	if (!ok)
+	{
+		warn("The reloaded models were not generated with the same parameters.");
+		serve_release(x);
+		return;
+	}
+
+	pthread_mutex_lock(&l->lock);
+	serve_models_t* const old = l->models;
+	l->models = x;
+	pthread_mutex_unlock(&l->lock);
+
+	serve_release(old);
+	status("Reloaded %"ZU" model(s).", (SIZE_T) x->m.num);
+}
+
+static void serve_loader_setup(serve_loader_t* const l, serve_models_t* const x, const char* const names, const char* const shared, const int watch)
+{
+	memset(l, 0x00, sizeof(serve_loader_t));
+	l->models = x;
+	pthread_mutex_init(&l->lock, NULL);
+
+	l->names = names;
+	l->shared = shared;
+	l->watch = watch;
+	l->loaded = l->last = serve_stamp(names);
+}
+
+const int serve_loader_init(serve_loader_t* const l, const char* const names, const char* const shared, const int watch, const int echo)
+{
+	assert(l != NULL && names != NULL);
+
+	serve_models_t* const x = serve_load(names, shared, echo);
+	if (x == NULL) return EXIT_FAILURE;
+
+	serve_loader_setup(l, x, names, shared, watch);
+	return EXIT_SUCCESS;
+}
+
+const int serve_loader_adopt(serve_loader_t* const l, salad_t* const s, const char* const name, const int watch)
+{
+	assert(l != NULL && s != NULL && name != NULL);
+
+	serve_models_t* const x = (serve_models_t*) calloc(1, sizeof(serve_models_t));
+	if (x == NULL || models_from_salad(s, &x->m) != EXIT_SUCCESS)
+	{
+		free(x);
+		return EXIT_FAILURE;
+	}
+	x->refs = 1;
+
+	serve_loader_setup(l, x, name, NULL, watch);
+	return EXIT_SUCCESS;
+}
+
+void serve_loader_destroy(serve_loader_t* const l)
+{
+	if (l->running)
+	{
+		__atomic_store_n(&l->stop, TRUE, __ATOMIC_RELAXED);
+		pthread_join(l->thread, NULL);
+		l->running = FALSE;
+	}
+
+	serve_release(l->models);
+	l->models = NULL;
+	pthread_mutex_destroy(&l->lock);
+}
+
+// Reloads the models if SIGHUP was received or their files changed
+static void serve_loader_poll(serve_loader_t* const l)
+{
+	int reload = serve_hangup;
+	if (l->watch)
+	{
+		// Wait until the files did not change for one period, such that
+		// models that are being written are not picked up.
+		const serve_stamp_t now = serve_stamp(l->names);
+		if ((now.mtime != l->loaded.mtime || now.size != l->loaded.size)
+		    && now.mtime == l->last.mtime && now.size == l->last.size)
+		{
+			reload = TRUE;
+		}
+		l->last = now;
+	}
+
+	if (reload)
+	{
+		serve_hangup = FALSE;
+		serve_swap(l);
+		l->loaded = l->last = serve_stamp(l->names);
+	}
+}
+
+static void* serve_loader_thread(void* const usr)
+{
+	serve_loader_t* const l = (serve_loader_t*) usr;
+	while (!__atomic_load_n(&l->stop, __ATOMIC_RELAXED))
+	{
+		poll(NULL, 0, SERVE_TIMEOUT);
+		serve_loader_poll(l);
+	}
+	return NULL;
+}
+
+const int serve_loader_start(serve_loader_t* const l)
+{
+	assert(!l->running);
+
+	struct sigaction sa;
+	memset(&sa, 0x00, sizeof(struct sigaction));
+	sa.sa_handler = serve_signal;
+	sigaction(SIGHUP, &sa, NULL);
+
+	l->stop = FALSE;
+	l->running = (pthread_create(&l->thread, NULL, serve_loader_thread, l) == 0);
+	return (l->running ? EXIT_SUCCESS : EXIT_FAILURE);
+}
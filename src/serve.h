@@ -0,0 +1,139 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+/**
+ * @file
+ */
+
+#ifndef SERVE_H_
+#define SERVE_H_
+
+#include "common.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <sys/types.h>
+
+// Upper bound for the size of a single request, cf. _salad_serve_ in main.h
+#define SERVE_MAX_REQUEST (64 *1024 *1024)
+// The period of checking for changed models, cf. --watch
+#define SERVE_TIMEOUT 500 // ms
+
+// The progress of parsing the request at the front of a connection's buffer,
+// such that received data is looked at only once.
+typedef struct
+{
+	size_t pos;         // The end of the parsed part of the request
+	uint32_t remaining; // The number of strings that are yet to be parsed
+} serve_parser_t;
+
+#define EMPTY_SERVE_PARSER_INITIALIZER {0, 0}
+
+/**
+ * Continues parsing the request at the beginning of the given buffer. The
+ * buffer needs to start with the same request on every call until the request
+ * is complete, but may have grown in between.
+ *
+ * @param[inout] p The state of the parser.
+ * @param[in] buf The buffer starting with the request.
+ * @param[in] len The number of bytes in the buffer.
+ * @return The size of the request once it is complete, 0 if it is not yet
+ *         complete and SIZE_MAX if it is malformed. The parser is reset for
+ *         the next request in the first case.
+ */
+const size_t serve_parse(serve_parser_t* const p, const uint8_t* const buf, const size_t len);
+
+
+// The models currently in use. Every user holds a reference, such that
+// classifications in flight finish on the old models after a reload.
+typedef struct
+{
+	models_t m;
+	size_t refs;
+} serve_models_t;
+
+typedef struct
+{
+	time_t mtime;
+	off_t size;
+} serve_stamp_t;
+
+// Models that are loaded anew on SIGHUP, or once their files change if
+// requested, while they are in use, cf. salad serve and network mode.
+typedef struct
+{
+	serve_models_t* models;
+	pthread_mutex_t lock;
+
+	const char* names; // The comma-separated files of the models
+	const char* shared; // cf. models_from_files
+	int watch;
+	serve_stamp_t loaded;
+	serve_stamp_t last;
+
+	// cf. serve_loader_start
+	pthread_t thread;
+	int running;
+	int stop;
+} serve_loader_t;
+
+/**
+ * Loads the given models, which are not replaced before serve_loader_start.
+ *
+ * @param[out] l The loader to be initialized.
+ * @param[in] names The comma-separated files of the models.
+ * @param[in] shared The name of the shared models or NULL, cf. --shared-model.
+ * @param[in] watch Whether or not to reload models once their files change.
+ * @param[in] echo Whether or not to echo the loaded models.
+ * @return EXIT_SUCCESS if the models were loaded, EXIT_FAILURE otherwise.
+ */
+const int serve_loader_init(serve_loader_t* const l, const char* const names, const char* const shared, const int watch, const int echo);
+
+/**
+ * Same as serve_loader_init, but takes over a one-class model that was loaded
+ * from the given file already. The model is left empty on success.
+ */
+const int serve_loader_adopt(serve_loader_t* const l, salad_t* const s, const char* const name, const int watch);
+
+/**
+ * Stops the background thread if there is one and releases the models once
+ * the last reference is gone.
+ */
+void serve_loader_destroy(serve_loader_t* const l);
+
+/**
+ * Catches SIGHUP and checks for new models every SERVE_TIMEOUT milliseconds on
+ * a background thread until the loader is destroyed. The new models replace
+ * the current ones only if they match their specification.
+ */
+const int serve_loader_start(serve_loader_t* const l);
+
+/**
+ * Returns the current models along with a reference to them.
+ */
+serve_models_t* serve_acquire(serve_loader_t* const l);
+
+/**
+ * Drops a reference to the given models, which are freed with the last one.
+ */
+void serve_release(serve_models_t* const x);
+
+
+#endif /* SERVE_H_ */
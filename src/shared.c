@@ -0,0 +1,319 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "shared.h"
+#include "common.h"
+
+#include <salad/util.h>
+#include <util/log.h>
+
+#include <string.h>
+
+#ifdef USE_SHM
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Seconds to wait for another process that is publishing the model
+#define SHARED_WAIT  10
+// Seconds after which a segment without publisher is considered left behind
+#define SHARED_GRACE 2
+
+typedef enum
+{
+	SHARED_ATTACHED,
+	SHARED_STALE,  // To be replaced, cf. shared_remove
+	SHARED_FAILED  // To be left alone, a private copy is loaded instead
+} shared_state_t;
+
+
+static void shared_sleep()
+{
+	const struct timespec t = {0, 100 *1000 *1000};
+	nanosleep(&t, NULL);
+}
+
+static const int shared_alive(const uint64_t pid)
+{
+	// EPERM means that the process exists but belongs to someone else
+	return (kill((pid_t) pid, 0) == 0 || errno == EPERM);
+}
+
+static const int shared_same_file(const shared_header_t* const h, const struct stat* const st)
+{
+	return (h->dev == (uint64_t) st->st_dev && h->ino == (uint64_t) st->st_ino
+	        && h->fsize == (uint64_t) st->st_size && h->mtime == (int64_t) st->st_mtime);
+}
+
+// The bit array is allocated in blocks of integers, cf. bloom_create
+static const size_t shared_size(const BLOOM* const b)
+{
+	return (b->size +sizeof(unsigned int) -1)/ sizeof(unsigned int) *sizeof(unsigned int);
+}
+
+// Removes the segment unless it has been replaced in the meantime already
+static void shared_remove(const char* const path, const int fd)
+{
+	const int g = shm_open(path, O_RDONLY, 0);
+	if (g < 0) return;
+
+	struct stat a, b;
+	if (fstat(fd, &a) == 0 && fstat(g, &b) == 0 && a.st_ino == b.st_ino)
+	{
+		warn("Replacing the stale shared model '%s'.", path);
+		shm_unlink(path);
+	}
+	close(g);
+}
+
+// Maps a segment that another process publishes or has published, waiting
+// for it to be complete as long as the publisher is alive.
+static const shared_state_t shared_map(const int fd, const struct stat* const file, uint8_t** const out, size_t* const len)
+{
+	struct stat st;
+	for (size_t i = 0; ; i++)
+	{
+		if (fstat(fd, &st) != 0) return SHARED_FAILED;
+		if (st.st_size != 0) break;
+
+		// The publisher sizes the segment right after creating it
+		if (time(NULL) -st.st_ctime >= SHARED_GRACE) return SHARED_STALE;
+		if (i >= SHARED_WAIT *10) return SHARED_FAILED;
+		shared_sleep();
+	}
+
+	if (st.st_size < SHARED_OFFSET) return SHARED_STALE;
+
+	uint8_t* const x = (uint8_t*) mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (x == MAP_FAILED) return SHARED_FAILED;
+
+	// The publisher records itself once the rest of the header is written
+	const shared_header_t* const h = (shared_header_t*) x;
+	shared_state_t ret = SHARED_FAILED;
+	for (size_t i = 0; i < SHARED_WAIT *10; i++)
+	{
+		const uint64_t pid = __atomic_load_n(&h->pid, __ATOMIC_ACQUIRE);
+		if (pid == 0)
+		{
+			if (time(NULL) -st.st_ctime >= SHARED_GRACE) ret = SHARED_STALE;
+		}
+		else if (h->magic != SHARED_MAGIC || h->version != SHARED_VERSION)
+		{
+			ret = SHARED_STALE;
+		}
+		else if (__atomic_load_n(&h->ready, __ATOMIC_ACQUIRE))
+		{
+			// A segment of another model is replaced once nobody publishes it
+			ret = (!shared_same_file(h, file) ? (shared_alive(pid) ? SHARED_FAILED : SHARED_STALE)
+			       : (SHARED_OFFSET +h->size <= (uint64_t) st.st_size ? SHARED_ATTACHED : SHARED_STALE));
+			break;
+		}
+		else if (!shared_alive(pid))
+		{
+			ret = SHARED_STALE;
+		}
+
+		if (ret == SHARED_STALE) break;
+		shared_sleep();
+	}
+
+	if (ret != SHARED_ATTACHED)
+	{
+		munmap(x, (size_t) st.st_size);
+		return ret;
+	}
+
+	*out = x;
+	*len = (size_t) st.st_size;
+	return ret;
+}
+
+// Loads the specification of the model only and assigns it the mapped array
+static const int shared_assign(const char* const filename, uint8_t* const x, const size_t len, salad_t* const out, shared_t* const sh)
+{
+	if (salad_spec_from_file(filename, out) != EXIT_SUCCESS)
+	{
+		salad_destroy(out);
+		return EXIT_FAILURE;
+	}
+
+	const shared_header_t* const h = (shared_header_t*) x;
+	container_t* const c = TO_CONTAINER(out->model);
+	BLOOM* const b = (c != NULL && IS_BLOOMFILTER(c->type) ? (BLOOM*) c->data : NULL);
+
+	if (b == NULL || bloom_is_counting(b) || h->bitsize != b->bitsize || h->size != shared_size(b))
+	{
+		salad_destroy(out);
+		return EXIT_FAILURE;
+	}
+
+	b->a = x +SHARED_OFFSET;
+
+	sh->addr = x;
+	sh->len = len;
+	sh->bloom = b;
+	return EXIT_SUCCESS;
+}
+
+// Moves the bit array of the loaded model to the segment that was created
+static const int shared_publish(const int fd, const struct stat* const file, salad_t* const s, shared_t* const sh)
+{
+	container_t* const c = TO_CONTAINER(s->model);
+	BLOOM* const b = (c != NULL && IS_BLOOMFILTER(c->type) ? (BLOOM*) c->data : NULL);
+	if (b == NULL || bloom_is_counting(b))
+	{
+		warn("Only bloom filters without counters can be shared among processes.");
+		return EXIT_FAILURE;
+	}
+
+	const size_t size = shared_size(b);
+	const size_t len = SHARED_OFFSET +size;
+	if (ftruncate(fd, (off_t) len) != 0) return EXIT_FAILURE;
+
+	uint8_t* const x = (uint8_t*) mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (x == MAP_FAILED) return EXIT_FAILURE;
+
+	shared_header_t* const h = (shared_header_t*) x;
+	h->magic = SHARED_MAGIC;
+	h->version = SHARED_VERSION;
+	h->bitsize = b->bitsize;
+	h->size = size;
+	h->dev = (uint64_t) file->st_dev;
+	h->ino = (uint64_t) file->st_ino;
+	h->fsize = (uint64_t) file->st_size;
+	h->mtime = (int64_t) file->st_mtime;
+	__atomic_store_n(&h->pid, (uint64_t) getpid(), __ATOMIC_RELEASE);
+
+	memcpy(x +SHARED_OFFSET, b->a, size);
+	__atomic_store_n(&h->ready, 1, __ATOMIC_RELEASE);
+	mprotect(x, len, PROT_READ);
+
+	free(b->a);
+	b->a = x +SHARED_OFFSET;
+
+	sh->addr = x;
+	sh->len = len;
+	sh->bloom = b;
+	return EXIT_SUCCESS;
+}
+
+const int salad_from_shared(const char* const id, const char* const filename, const char* const name, salad_t* const out, shared_t* const sh)
+{
+	assert(id != NULL && filename != NULL && out != NULL && sh != NULL);
+	memset(sh, 0x00, sizeof(shared_t));
+
+	struct stat file;
+	if (name == NULL || stat(filename, &file) != 0)
+	{
+		return salad_from_file_v(id, filename, out);
+	}
+
+	char path[0x100];
+	snprintf(path, sizeof(path), "%s%s", (name[0] == '/' ? "" : "/"), name);
+
+	// A stale segment is replaced once, another process might have been
+	// quicker to do so, though.
+	for (int retry = 0; retry < 2; retry++)
+	{
+		int fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+		if (fd >= 0)
+		{
+			const int ret = salad_from_file_v(id, filename, out);
+			if (ret == EXIT_SUCCESS && shared_publish(fd, &file, out, sh) == EXIT_SUCCESS)
+			{
+				info("Published the shared model '%s'.", path);
+			}
+			else
+			{
+				shm_unlink(path);
+			}
+			close(fd);
+			return ret;
+		}
+
+		if (errno == EEXIST)
+		{
+			fd = shm_open(path, O_RDONLY, 0);
+		}
+
+		if (fd < 0)
+		{
+			// The segment might have been replaced in the meantime
+			if (errno == ENOENT) continue;
+			break;
+		}
+
+		uint8_t* x = NULL;
+		size_t len = 0;
+		const shared_state_t r = shared_map(fd, &file, &x, &len);
+
+		if (r == SHARED_ATTACHED)
+		{
+			close(fd);
+			if (shared_assign(filename, x, len, out, sh) == EXIT_SUCCESS)
+			{
+				info("Attached to the shared model '%s'.", path);
+				return EXIT_SUCCESS;
+			}
+			munmap(x, len);
+			warn("The shared model '%s' does not match the model file.", path);
+			break;
+		}
+
+		if (r == SHARED_STALE) shared_remove(path, fd);
+		close(fd);
+		if (r == SHARED_FAILED) break;
+	}
+
+	warn("Unable to share the model '%s', using a private copy.", path);
+	return salad_from_file_v(id, filename, out);
+}
+
+void salad_unshare(shared_t* const sh)
+{
+	if (sh == NULL || sh->addr == NULL) return;
+
+	// The bloom filter must not release memory that it does not own.
+	sh->bloom->a = NULL;
+	munmap(sh->addr, sh->len);
+	memset(sh, 0x00, sizeof(shared_t));
+}
+
+#else
+
+const int salad_from_shared(const char* const id, const char* const filename, const char* const name, salad_t* const out, shared_t* const sh)
+{
+	memset(sh, 0x00, sizeof(shared_t));
+	if (name != NULL)
+	{
+		warn("Salad was compiled without support for shared models.");
+	}
+	return salad_from_file_v(id, filename, out);
+}
+
+void salad_unshare(shared_t* const sh)
+{
+}
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+/**
+ * @file
+ */
+
+#ifndef SHARED_H_
+#define SHARED_H_
+
+#include <config.h>
+
+#include <salad/salad.h>
+#include <salad/container/bloom.h>
+
+#include <stdint.h>
+
+// The bit array of a bloom filter that lives in a named shared memory
+// segment rather than in the memory of the process, cf. --shared-model
+typedef struct
+{
+	void* addr;
+	size_t len;
+	BLOOM* bloom;
+} shared_t;
+
+#define EMPTY_SHARED_INITIALIZER {NULL, 0, NULL}
+
+#define SHARED_MAGIC   0x53414C44 // "SALD"
+#define SHARED_VERSION 2
+// The bit array starts at a fixed offset, such that it is suitably aligned
+#define SHARED_OFFSET  128
+
+// The header of a segment. The model file is recorded, such that processes
+// loading a retrained model do not attach to the old one, and the publisher,
+// such that segments left behind by a crashed publisher are recognized.
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t bitsize;
+	uint64_t size;
+
+	uint64_t pid;
+	uint64_t dev;
+	uint64_t ino;
+	uint64_t fsize;
+	int64_t mtime;
+
+	uint32_t ready; // Set once the bit array is complete
+} shared_header_t;
+
+/**
+ * Loads the model from the given file with its bit array in the shared memory
+ * segment of the given name. If the segment exists, only the specification
+ * is read from the file and the bit array is mapped read-only. Otherwise,
+ * the model is loaded as usual and published to the segment. Segments that
+ * hold another model or that were left incomplete by a crashed publisher
+ * are replaced. If the model cannot be shared, a private copy is loaded.
+ *
+ * @param[in] id The kind of model for error messages, cf. salad_from_file_v.
+ * @param[in] filename The file of the model.
+ * @param[in] name The name of the segment or NULL to not share the model.
+ * @param[out] out The model.
+ * @param[out] sh The mapping to be released by salad_unshare.
+ * @return EXIT_SUCCESS if the model was loaded, shared or not.
+ */
+const int salad_from_shared(const char* const id, const char* const filename, const char* const name, salad_t* const out, shared_t* const sh);
+
+/**
+ * Releases the mapping of a shared model before the model itself is
+ * destroyed. Nothing happens if the model is not shared.
+ */
+void salad_unshare(shared_t* const sh);
+
+
+#endif /* SHARED_H_ */
@@ -19,6 +19,7 @@
 #include <ctest.h>
 
 #include <container/bloom.h>
+#include <util/cpu.h>
 #include <util/util.h>
 
 #include <string.h>
@@ -133,6 +134,11 @@ CTEST2(bloom, count)
 	data->b1->a[0] = 0x03;
 	data->b1->a[data->b1->size -1] = 0x80;
 	ASSERT_EQUAL_U(3, bloom_count(data->b1));
+
+	// The baseline implementation agrees with the one picked at run-time
+	cpu_restrict_features(0);
+	ASSERT_EQUAL_U(3, bloom_count(data->b1));
+	cpu_restrict_features(~0u);
 }
 
 CTEST2(bloom, clear)
@@ -152,3 +158,148 @@ CTEST2(bloom, hash_collisions)
 	ASSERT_EQUAL_U(3, bloom_count(data->x2));
 }
 
+CTEST(bloom, crc32c)
+{
+	// The check value of CRC-32C
+	const char* const check = "123456789";
+	ASSERT_EQUAL_U(0xe3069283, crc32c_n(check, strlen(check)));
+
+	// The instruction and the software fallback agree for all tail lengths
+	const char* const str = "The quick brown fox jumps over the lazy dog";
+	for (size_t n = 0; n <= strlen(str); n++)
+	{
+		const uint32_t h = crc32c_n(str, n);
+		cpu_restrict_features(0);
+		ASSERT_EQUAL_U(h, crc32c_n(str, n));
+		cpu_restrict_features(~0u);
+	}
+
+	BLOOM* const b = bloom_init(DEFAULT_BFSIZE, to_hashset("crc"));
+	ASSERT_EQUAL(HASHES_CRC, bloom_hashset(b));
+	bloom_add_str(b, "abc", 3);
+	ASSERT_EQUAL_U(3, bloom_count(b));
+	ASSERT_TRUE(bloom_check_str(b, "abc", 3));
+	ASSERT_FALSE(bloom_check_str(b, "abd", 3));
+	bloom_destroy(b);
+}
+
+CTEST2(bloom, interleave)
+{
+	bloom_add_str(data->b1, "abc", 3);
+	bloom_add_str(data->b1, "xyz", 3);
+	bloom_add_str(data->b2, "xyz", 3);
+	bloom_add_str(data->b2, "123", 3);
+
+	BLOOM* const b = bloom_interleave(data->b1, data->b2);
+	ASSERT_NOT_NULL(b);
+	ASSERT_EQUAL_U(2 *data->BITSIZE, b->bitsize);
+	ASSERT_EQUAL_U(bloom_count(data->b1) +bloom_count(data->b2), bloom_count(b));
+
+	ASSERT_EQUAL(BLOOM_GOOD, bloom_check2_str(b, "abc", 3));
+	ASSERT_EQUAL(BLOOM_GOOD | BLOOM_BAD, bloom_check2_str(b, "xyz", 3));
+	ASSERT_EQUAL(BLOOM_BAD, bloom_check2_str(b, "123", 3));
+	ASSERT_EQUAL(0, bloom_check2_str(b, "ABC", 3));
+	bloom_destroy(b);
+
+	// Both filters need to share the same hash functions
+	ASSERT_NULL(bloom_interleave(data->x1, data->x2));
+}
+
+
+
+CTEST_DATA(cbloom)
+{
+	BLOOM* b;
+};
+
+CTEST_SETUP(cbloom)
+{
+	data->b = bloom_init_counting(DEFAULT_BFSIZE, HASHES_SIMPLE);
+}
+
+CTEST_TEARDOWN(cbloom)
+{
+	bloom_destroy(data->b);
+}
+
+CTEST2(cbloom, create)
+{
+	ASSERT_NOT_NULL(data->b);
+	ASSERT_TRUE(bloom_is_counting(data->b));
+	ASSERT_EQUAL_U(0, bloom_count(data->b));
+}
+
+CTEST2(cbloom, remove)
+{
+	ASSERT_FALSE(bloom_remove_str(data->b, "abc", 3));
+
+	bloom_add_str(data->b, "abc", 3);
+	bloom_add_str(data->b, "abc", 3);
+	ASSERT_EQUAL_U(3, bloom_count(data->b));
+
+	ASSERT_TRUE(bloom_remove_str(data->b, "abc", 3));
+	ASSERT_EQUAL(1, bloom_check_str(data->b, "abc", 3));
+
+	ASSERT_TRUE(bloom_remove_str(data->b, "abc", 3));
+	ASSERT_EQUAL(0, bloom_check_str(data->b, "abc", 3));
+	ASSERT_EQUAL_U(0, bloom_count(data->b));
+}
+
+CTEST2(cbloom, remove_plain)
+{
+	BLOOM* const b = bloom_init(DEFAULT_BFSIZE, HASHES_SIMPLE);
+	bloom_add_str(b, "abc", 3);
+
+	ASSERT_FALSE(bloom_remove_str(b, "abc", 3));
+	ASSERT_EQUAL(1, bloom_check_str(b, "abc", 3));
+	bloom_destroy(b);
+}
+
+CTEST2(cbloom, saturation)
+{
+	for (int i = 0; i < BLOOM_COUNTER_MAX +2; i++)
+	{
+		bloom_add_str(data->b, "abc", 3);
+	}
+	for (int i = 0; i < BLOOM_COUNTER_MAX +2; i++)
+	{
+		bloom_remove_str(data->b, "abc", 3);
+	}
+	ASSERT_EQUAL(1, bloom_check_str(data->b, "abc", 3));
+}
+
+CTEST2(cbloom, decay)
+{
+	bloom_add_str(data->b, "abc", 3);
+	bloom_add_str(data->b, "xyz", 3);
+	bloom_add_str(data->b, "xyz", 3);
+
+	bloom_decay(data->b);
+	ASSERT_EQUAL(0, bloom_check_str(data->b, "abc", 3));
+	ASSERT_EQUAL(1, bloom_check_str(data->b, "xyz", 3));
+
+	bloom_decay(data->b);
+	ASSERT_EQUAL(0, bloom_check_str(data->b, "xyz", 3));
+	ASSERT_EQUAL_U(0, bloom_count(data->b));
+}
+
+CTEST2(cbloom, decay_saturated)
+{
+	for (int i = 0; i < BLOOM_COUNTER_MAX +2; i++)
+	{
+		bloom_add_str(data->b, "abc", 3);
+	}
+	for (int i = 0; i < 8; i++)
+	{
+		bloom_decay(data->b);
+	}
+	ASSERT_EQUAL(1, bloom_check_str(data->b, "abc", 3));
+}
+
+CTEST2(cbloom, clear)
+{
+	bloom_add_str(data->b, "abc", 3);
+	bloom_clear(data->b);
+	ASSERT_EQUAL_U(0, bloom_count(data->b));
+	ASSERT_FALSE(bloom_remove_str(data->b, "abc", 3));
+}
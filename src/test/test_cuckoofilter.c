@@ -0,0 +1,107 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include <ctest.h>
+
+#include <container/bloom.h>
+#include <container/cuckoo.h>
+#include <util/util.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+
+CTEST_DATA(cuckoo)
+{
+	CUCKOO* c;
+};
+
+CTEST_SETUP(cuckoo)
+{
+	data->c = cuckoo_init(DEFAULT_BFSIZE);
+}
+
+CTEST_TEARDOWN(cuckoo)
+{
+	cuckoo_destroy(data->c);
+}
+
+CTEST2(cuckoo, create)
+{
+	ASSERT_NOT_NULL(data->c);
+	// Same amount of memory as a bloom filter of the same size
+	ASSERT_EQUAL_U((size_t) POW(2, DEFAULT_BFSIZE), cuckoo_bitsize(data->c));
+	ASSERT_EQUAL_U(cuckoo_bitsize(data->c)/ CUCKOO_FPBITS, cuckoo_capacity(data->c));
+	ASSERT_EQUAL_U(0, data->c->count);
+}
+
+CTEST2(cuckoo, add)
+{
+	ASSERT_FALSE(cuckoo_check_str(data->c, "abc", 3));
+	ASSERT_TRUE(cuckoo_add_str(data->c, "abc", 3));
+	ASSERT_TRUE(cuckoo_check_str(data->c, "abc", 3));
+
+	// N-grams are stored once only
+	ASSERT_TRUE(cuckoo_add_str(data->c, "abc", 3));
+	ASSERT_EQUAL_U(1, data->c->count);
+}
+
+CTEST2(cuckoo, remove)
+{
+	ASSERT_FALSE(cuckoo_remove_str(data->c, "abc", 3));
+
+	cuckoo_add_str(data->c, "abc", 3);
+	cuckoo_add_str(data->c, "xyz", 3);
+
+	ASSERT_TRUE(cuckoo_remove_str(data->c, "abc", 3));
+	ASSERT_FALSE(cuckoo_check_str(data->c, "abc", 3));
+	ASSERT_TRUE(cuckoo_check_str(data->c, "xyz", 3));
+	ASSERT_EQUAL_U(1, data->c->count);
+}
+
+CTEST2(cuckoo, clear)
+{
+	cuckoo_add_str(data->c, "abc", 3);
+	cuckoo_clear(data->c);
+	ASSERT_EQUAL_U(0, data->c->count);
+	ASSERT_FALSE(cuckoo_check_str(data->c, "abc", 3));
+}
+
+CTEST(cuckoo, overflow)
+{
+	CUCKOO* const c = cuckoo_create(4);
+	const size_t capacity = cuckoo_capacity(c);
+
+	char buf[0x20];
+	size_t i = 0;
+	for (; c->victim == 0; i++)
+	{
+		snprintf(buf, 0x20, "%"ZU, (SIZE_T) i);
+		cuckoo_add_str(c, buf, strlen(buf));
+	}
+	ASSERT_TRUE(c->count <= capacity +1);
+	ASSERT_TRUE(c->count > capacity *3/4);
+
+	// No false negatives, even for the homeless fingerprint
+	for (size_t j = 0; j < i; j++)
+	{
+		snprintf(buf, 0x20, "%"ZU, (SIZE_T) j);
+		ASSERT_TRUE(cuckoo_check_str(c, buf, strlen(buf)));
+	}
+	cuckoo_destroy(c);
+}
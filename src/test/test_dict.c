@@ -0,0 +1,92 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include <ctest.h>
+
+#include <container/dict.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+
+CTEST_DATA(dict)
+{
+	DICT* d;
+};
+
+CTEST_SETUP(dict)
+{
+	data->d = dict_create(4);
+}
+
+CTEST_TEARDOWN(dict)
+{
+	dict_destroy(data->d);
+}
+
+CTEST2(dict, insert)
+{
+	ASSERT_NOT_NULL(data->d);
+	ASSERT_EQUAL_U(0, data->d->count);
+	ASSERT_EQUAL(DICT_UNKNOWN, dict_lookup(data->d, "abc", 3));
+
+	// Ids are assigned in the order of insertion
+	ASSERT_EQUAL(1, dict_insert(data->d, "abc", 3));
+	ASSERT_EQUAL(2, dict_insert(data->d, "ab", 2));
+	ASSERT_EQUAL(1, dict_insert(data->d, "abc", 3));
+	ASSERT_EQUAL_U(2, data->d->count);
+
+	ASSERT_EQUAL(1, dict_lookup(data->d, "abc", 3));
+	ASSERT_EQUAL(2, dict_lookup(data->d, "ab", 2));
+	ASSERT_EQUAL(DICT_UNKNOWN, dict_lookup(data->d, "abcd", 4));
+}
+
+CTEST2(dict, get)
+{
+	// Strings may contain arbitrary bytes
+	static const char bin[] = {'a', 0x00, 'b'};
+	const uint32_t id = dict_insert(data->d, bin, sizeof(bin));
+
+	size_t len = 0;
+	const char* const str = dict_get(data->d, id, &len);
+	ASSERT_DATA((const unsigned char*) bin, sizeof(bin), (const unsigned char*) str, len);
+
+	ASSERT_NULL(dict_get(data->d, DICT_UNKNOWN, &len));
+	ASSERT_NULL(dict_get(data->d, id +1, &len));
+}
+
+CTEST2(dict, grow)
+{
+	char buf[0x20];
+	for (unsigned int i = 0; i < 0x1000; i++)
+	{
+		const int n = snprintf(buf, sizeof(buf), "token%u", i);
+		ASSERT_EQUAL(i +1, dict_insert(data->d, buf, (size_t) n));
+	}
+	ASSERT_EQUAL_U(0x1000, data->d->count);
+
+	for (unsigned int i = 0; i < 0x1000; i++)
+	{
+		const int n = snprintf(buf, sizeof(buf), "token%u", i);
+		ASSERT_EQUAL(i +1, dict_lookup(data->d, buf, (size_t) n));
+
+		size_t len = 0;
+		const char* const str = dict_get(data->d, i +1, &len);
+		ASSERT_DATA((const unsigned char*) buf, (size_t) n, (const unsigned char*) str, len);
+	}
+}
@@ -324,7 +324,7 @@ void CMP_MODELS(const char* const a, const char* const b)
 }
 
 static const char* SALAD_MODES[] = {
-		"train", "predict", "inspect", "stats", "test", NULL
+		"train", "predict", "freeze", "inspect", "stats", "test", NULL
 };
 
 
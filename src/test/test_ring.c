@@ -0,0 +1,192 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include <ctest.h>
+
+#include <util/ring.h>
+#include <util/util.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+CTEST_DATA(ring)
+{
+	ring_t r;
+};
+
+CTEST_SETUP(ring)
+{
+	ring_init(&data->r, 3);
+}
+
+CTEST_TEARDOWN(ring)
+{
+	ring_destroy(&data->r);
+}
+
+CTEST2(ring, fifo)
+{
+	// The capacity is rounded up to the next power of two
+	ASSERT_EQUAL_U(4, ring_capacity(&data->r));
+
+	size_t items[] = {1, 2, 3, 4, 5};
+	void* x = NULL;
+
+	ASSERT_FALSE(ring_pop(&data->r, &x));
+	for (size_t i = 0; i < 4; i++)
+	{
+		ASSERT_TRUE(ring_push(&data->r, &items[i]));
+	}
+	ASSERT_FALSE(ring_push(&data->r, &items[4]));
+	ASSERT_EQUAL_U(4, ring_size(&data->r));
+
+	for (size_t i = 0; i < 4; i++)
+	{
+		ASSERT_TRUE(ring_pop(&data->r, &x));
+		ASSERT_EQUAL_U(items[i], *((size_t*) x));
+	}
+	ASSERT_FALSE(ring_pop(&data->r, &x));
+
+	ASSERT_EQUAL_U(4, data->r.num_pushed);
+	ASSERT_EQUAL_U(1, data->r.num_full);
+	ASSERT_EQUAL_U(4, data->r.max_usage);
+}
+
+CTEST2(ring, wrap_around)
+{
+	size_t items[] = {1, 2, 3};
+	void* x = NULL;
+
+	// Several laps with the ring never running full nor empty
+	ASSERT_TRUE(ring_push(&data->r, &items[0]));
+	for (size_t i = 1; i < 100; i++)
+	{
+		ASSERT_TRUE(ring_push(&data->r, &items[i %3]));
+		ASSERT_TRUE(ring_pop(&data->r, &x));
+		ASSERT_EQUAL_U(items[(i -1) %3], *((size_t*) x));
+	}
+	ASSERT_EQUAL_U(1, ring_size(&data->r));
+	ASSERT_EQUAL_U(2, data->r.max_usage);
+}
+
+
+#define STRESS_PRODUCERS 4
+#define STRESS_CONSUMERS 4
+#define STRESS_ITEMS 100000 // per producer
+
+typedef struct
+{
+	ring_t r;
+	size_t items[STRESS_PRODUCERS *STRESS_ITEMS];
+	uint8_t seen[STRESS_PRODUCERS *STRESS_ITEMS];
+	size_t num_popped;
+	int out_of_order;
+} stress_t;
+
+typedef struct
+{
+	stress_t* s;
+	size_t id;
+} stress_worker_t;
+
+static void* stress_produce(void* usr)
+{
+	const stress_worker_t* const w = (stress_worker_t*) usr;
+	for (size_t i = 0; i < STRESS_ITEMS; i++)
+	{
+		while (!ring_push(&w->s->r, &w->s->items[w->id *STRESS_ITEMS +i]))
+		{
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+static void* stress_consume(void* usr)
+{
+	stress_t* const s = ((stress_worker_t*) usr)->s;
+
+	// The items of each producer arrive in the order they were pushed
+	size_t last[STRESS_PRODUCERS];
+	memset(last, 0x00, sizeof(last));
+
+	while (__atomic_load_n(&s->num_popped, __ATOMIC_RELAXED) < STRESS_PRODUCERS *STRESS_ITEMS)
+	{
+		void* x = NULL;
+		if (!ring_pop(&s->r, &x))
+		{
+			sched_yield();
+			continue;
+		}
+
+		const size_t k = *((size_t*) x);
+		__atomic_add_fetch(&s->seen[k], 1, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&s->num_popped, 1, __ATOMIC_RELAXED);
+
+		if (k +1 <= last[k /STRESS_ITEMS])
+		{
+			s->out_of_order = TRUE;
+		}
+		last[k /STRESS_ITEMS] = k +1;
+	}
+	return NULL;
+}
+
+CTEST(ring, stress)
+{
+	stress_t* const s = (stress_t*) calloc(1, sizeof(stress_t));
+	ASSERT_NOT_NULL(s);
+	ASSERT_EQUAL(EXIT_SUCCESS, ring_init(&s->r, 64));
+
+	for (size_t i = 0; i < STRESS_PRODUCERS *STRESS_ITEMS; i++)
+	{
+		s->items[i] = i;
+	}
+
+	pthread_t threads[STRESS_PRODUCERS +STRESS_CONSUMERS];
+	stress_worker_t workers[STRESS_PRODUCERS +STRESS_CONSUMERS];
+	for (size_t i = 0; i < STRESS_PRODUCERS +STRESS_CONSUMERS; i++)
+	{
+		workers[i].s = s;
+		workers[i].id = i;
+		ASSERT_EQUAL(0, pthread_create(&threads[i], NULL, (i < STRESS_PRODUCERS ? stress_produce : stress_consume), &workers[i]));
+	}
+	for (size_t i = 0; i < STRESS_PRODUCERS +STRESS_CONSUMERS; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+
+	// Every item has been handed over exactly once
+	for (size_t i = 0; i < STRESS_PRODUCERS *STRESS_ITEMS; i++)
+	{
+		ASSERT_EQUAL(1, s->seen[i]);
+	}
+	ASSERT_FALSE(s->out_of_order);
+	ASSERT_EQUAL_U(STRESS_PRODUCERS *STRESS_ITEMS, s->r.num_pushed);
+	ASSERT_EQUAL_U(0, ring_size(&s->r));
+
+	ASSERT_TRUE(s->r.max_usage > 0);
+	ASSERT_TRUE(s->r.max_usage <= ring_capacity(&s->r));
+
+	ring_destroy(&s->r);
+	free(s);
+}
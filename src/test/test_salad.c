@@ -18,16 +18,22 @@
 #include <ctest.h>
 
 #include <salad/analyze.h>
+#include <salad/classify.h>
 #include <salad/io.h>
+#include <salad/ngrams.h>
 #include <salad/salad.h>
 #include <salad/util.h>
 
 #include <container/bloom.h>
+#include <container/fpset.h>
+#include <container/hll.h>
 
+#include <util/cpu.h>
 #include <util/util.h>
 
 #include <string.h>
 #include <limits.h>
+#include <math.h>
 
 #include "common.h"
 
@@ -63,12 +69,6 @@ CTEST_TEARDOWN(salad)
 }
 
 
-static const int bloom_compare_bytes(BLOOM* const a, BLOOM* const b)
-{
-	return memcmp_bytes(a->a, b->a, a->size);
-}
-
-
 CTEST2(salad, bloom_init)
 {
 	ASSERT_NOT_NULL(TO_BLOOMFILTER(data->x.model));
@@ -115,7 +115,8 @@ CTEST(salad, spec_diff)
 	BLOOM* const x = GET_BLOOMFILTER(data->x.model);                                                     \
 	                                                                                                     \
 	ASSERT_EQUAL_U(0, bloom_count(x));                                                                   \
-	BLOOMIZE_EX(#X[0], x, TEST_STR1, strlen(TEST_STR1), data->x.ngram_length, __(data->x).delimiter.d);  \
+	BLOOMIZE_EX(#X[0], TO_CONTAINER(data->x.model), TEST_STR1, strlen(TEST_STR1),                        \
+			data->x.ngram_length, __(data->x).delimiter.d);                                              \
 	ASSERT_DATA((unsigned char*) (bf), 32, x->a, x->size);                                               \
 }
 
@@ -124,42 +125,53 @@ typedef struct {
 	size_t total;
 } count_exp_t;
 
-void TEST_BLOOMIZE_COUNT_EX(const char X, salad_t* const s1, const count_exp_t exp1, salad_t* const s2, const count_exp_t exp2, const size_t new, const size_t n)
+void TEST_BLOOMIZE_COUNT_EX(const char X, salad_t* const s1, const count_exp_t exp1, const count_exp_t exp2, const size_t new, const size_t n)
 {
 	BLOOM* const b1 = GET_BLOOMFILTER(s1->model);
-	BLOOM* const b2 = GET_BLOOMFILTER(s2->model);
+	container_t* const c1 = TO_CONTAINER(s1->model);
+	FPSET* const uniq = fpset_create(0);
+	HLL* const hll = hll_create(DEFAULT_HLL_PRECISION);
 
 	bloomize_stats_t stats;
 	// Adds TEST_STR1 to b1
-	BLOOMIZE_EX(X, b1, TEST_STR1, strlen(TEST_STR1), n, _(s1)->delimiter.d);
+	BLOOMIZE_EX(X, c1, TEST_STR1, strlen(TEST_STR1), n, _(s1)->delimiter.d);
+	const size_t count = bloom_count(b1);
 
-	// Clears b2, adds TEST_STR1 to both
-	BLOOMIZE_EX3(X, b1, b2, TEST_STR1, strlen(TEST_STR1), n, _(s1)->delimiter.d, &stats);
-	ASSERT_EQUAL(0, bloom_compare(b1, b2));
+	// Adds TEST_STR1 to b1 again
+	BLOOMIZE_EX3(X, c1, uniq, hll, TEST_STR1, strlen(TEST_STR1), n, _(s1)->delimiter.d, &stats);
+	ASSERT_EQUAL_U(count, bloom_count(b1));
 	ASSERT_EQUAL_U(0, stats.new);
 	ASSERT_EQUAL_U(exp1.uniq, stats.uniq);
+	ASSERT_EQUAL_U(exp1.uniq, uniq->count);
 	ASSERT_EQUAL_U(exp1.total, stats.total);
 
-	// Clears b2, adds TEST_STR2 to b2 only
-	BLOOMIZE_EX4(X, b1, b2, TEST_STR2, strlen(TEST_STR2), n, _(s1)->delimiter.d, &stats);
-	ASSERT_NOT_EQUAL(0, bloom_compare(b1, b2));
+	// Resets the set, checks TEST_STR2 against b1 only
+	BLOOMIZE_EX4(X, c1, uniq, hll, TEST_STR2, strlen(TEST_STR2), n, _(s1)->delimiter.d, &stats);
+	ASSERT_EQUAL_U(count, bloom_count(b1));
 	ASSERT_EQUAL_U(new, stats.new);
 	ASSERT_EQUAL_U(exp2.uniq, stats.uniq);
+	ASSERT_EQUAL_U(exp2.uniq, uniq->count);
 	ASSERT_EQUAL_U(exp2.total, stats.total);
 
-	// Clears b2, adds TEST_STR2 to both
-	BLOOMIZE_EX3(X, b1, b2, TEST_STR2, strlen(TEST_STR2), n, _(s1)->delimiter.d, &stats);
-	ASSERT_EQUAL((X == 'w' ? 4 : 0), bloom_compare_bytes(b1, b2));
+	// Resets the set, adds TEST_STR2 to b1
+	BLOOMIZE_EX3(X, c1, uniq, hll, TEST_STR2, strlen(TEST_STR2), n, _(s1)->delimiter.d, &stats);
+	ASSERT_NOT_EQUAL(count, bloom_count(b1));
 	ASSERT_EQUAL_U(new, stats.new);
 	ASSERT_EQUAL_U(exp2.uniq, stats.uniq);
 	ASSERT_EQUAL_U(exp2.total, stats.total);
 
-	// Clears b2, adds TEST_STR2 to b2 only
-	BLOOMIZE_EX4(X, b1, b2, TEST_STR2, strlen(TEST_STR2), n, _(s1)->delimiter.d, &stats);
-	ASSERT_EQUAL((X == 'w' ? 4 : 0), bloom_compare_bytes(b1, b2));
+	// Resets the set, nothing new anymore
+	BLOOMIZE_EX4(X, c1, uniq, hll, TEST_STR2, strlen(TEST_STR2), n, _(s1)->delimiter.d, &stats);
 	ASSERT_EQUAL_U(0, stats.new);
 	ASSERT_EQUAL_U(exp2.uniq, stats.uniq);
 	ASSERT_EQUAL_U(exp2.total, stats.total);
+
+	// Both strings share all but the 'new' n-grams
+	const double est = hll_estimate(hll);
+	ASSERT_TRUE(est > 0.95 *(exp1.uniq +new) && est < 1.05 *(exp1.uniq +new));
+
+	fpset_destroy(uniq);
+	hll_destroy(hll);
 }
 
 CTEST2(salad, bloomizeb_ex)
@@ -184,7 +196,7 @@ CTEST2(salad, bloomizeb_ex)
 
 	const count_exp_t exp1 = {312, 8* (strlen(TEST_STR1) -NGRAM_LENGTH) +1};
 	const count_exp_t exp2 = {320, 8* (strlen(TEST_STR2) -NGRAM_LENGTH) +1};
-	TEST_BLOOMIZE_COUNT_EX('b', &data->b1, exp1, &data->b2, exp2, 8, n);
+	TEST_BLOOMIZE_COUNT_EX('b', &data->b1, exp1, exp2, 8, n);
 }
 
 CTEST2(salad, bloomize_ex)
@@ -205,7 +217,7 @@ CTEST2(salad, bloomize_ex)
 
 	const count_exp_t exp1 = {40, strlen(TEST_STR1) -NGRAM_LENGTH +1};
 	const count_exp_t exp2 = {41, strlen(TEST_STR2) -NGRAM_LENGTH +1};
-	TEST_BLOOMIZE_COUNT_EX('n', &data->b1, exp1, &data->b2, exp2, 1, n);
+	TEST_BLOOMIZE_COUNT_EX('n', &data->b1, exp1, exp2, 1, n);
 }
 
 CTEST2(salad, bloomizew_ex)
@@ -239,7 +251,7 @@ CTEST2(salad, bloomizew_ex)
 	}
 
 	const count_exp_t exp = {num_tokens -NGRAM_LENGTH +1, num_tokens -NGRAM_LENGTH +1};
-	TEST_BLOOMIZE_COUNT_EX('w', &data->b1, exp, &data->b2, exp, 1, n);
+	TEST_BLOOMIZE_COUNT_EX('w', &data->b1, exp, exp, 1, n);
 }
 
 
@@ -256,7 +268,7 @@ CTEST(salad, fileformat_consistency)
 	salad_set_ngramlength(&x, NGRAM_LENGTH);
 
 	BLOOM* const xbloom = GET_BLOOMFILTER(x.model);
-	bloomize_ex(xbloom, TEST_STR1, strlen(TEST_STR1), x.ngram_length);
+	bloomize_ex(TO_CONTAINER(x.model), TEST_STR1, strlen(TEST_STR1), x.ngram_length);
 
 
 	FN_WRITEMODEL fcts[] = {
@@ -318,4 +330,735 @@ CTEST(salad, fileformat_consistency)
 	salad_destroy(&x);
 }
 
+CTEST(salad, fileformat_counting)
+{
+	char* TEST_FILE = "test.out";
+
+	SALAD_T(x);
+	salad_init(&x);
+	salad_set_countingbloomfilter_ex(&x, bloom_init_counting(DEFAULT_BFSIZE, HASHES_SIMPLE));
+	salad_set_ngramlength(&x, NGRAM_LENGTH);
+
+	BLOOM* const xbloom = GET_BLOOMFILTER(x.model);
+	bloomize_ex(TO_CONTAINER(x.model), TEST_STR1, strlen(TEST_STR1), x.ngram_length);
+	bloomize_ex(TO_CONTAINER(x.model), TEST_STR1, strlen(TEST_STR1), x.ngram_length);
+
+	FILE* const f_out = fopen(TEST_FILE, "wb+");
+	ASSERT_NOT_NULL(f_out);
+	ASSERT_TRUE(fwrite_model_txt(f_out, &x));
+	fclose(f_out);
+
+	FILE* const f_in = fopen(TEST_FILE, "rb");
+	ASSERT_NOT_NULL(f_in);
+
+	SALAD_T(y);
+	const int ret = salad_from_file_ex(f_in, &y);
+	fclose(f_in);
+	remove(TEST_FILE);
+	ASSERT_EQUAL(0, ret);
+
+	BLOOM* const ybloom = GET_BLOOMFILTER(y.model);
+	ASSERT_TRUE(IS_COUNTINGBLOOMFILTER(y.model));
+	ASSERT_TRUE(!salad_spec_diff(&x, &y));
+	ASSERT_TRUE(bloom_compare(xbloom, ybloom) == 0);
+	ASSERT_DATA(xbloom->counters, (xbloom->bitsize +1)/2, ybloom->counters, (ybloom->bitsize +1)/2);
+
+	// The n-grams have been added twice
+	saladdata_t d = {(char*) TEST_STR1, strlen(TEST_STR1)};
+	ASSERT_EQUAL(0, salad_forget(&y, &d, 1));
+	ASSERT_TRUE(bloom_compare(xbloom, ybloom) == 0);
+	ASSERT_EQUAL(0, salad_forget(&y, &d, 1));
+	ASSERT_EQUAL_U(0, bloom_count(ybloom));
+
+	salad_destroy(&y);
+	salad_destroy(&x);
+}
+
+CTEST(salad, fileformat_cuckoo)
+{
+	char* TEST_FILE = "test.out";
+
+	SALAD_T(x);
+	salad_init(&x);
+	ASSERT_EQUAL(0, salad_set_cuckoofilter(&x, DEFAULT_BFSIZE));
+	salad_set_ngramlength(&x, NGRAM_LENGTH);
+
+	saladdata_t d = {(char*) TEST_STR1, strlen(TEST_STR1)};
+	ASSERT_EQUAL(0, salad_train(&x, &d, 1));
+
+	double score = 1.0;
+	ASSERT_EQUAL(0, salad_predict_ex(&x, &d, 1, &score));
+	ASSERT_TRUE(score == 0.0);
+
+	FILE* const f_out = fopen(TEST_FILE, "wb+");
+	ASSERT_NOT_NULL(f_out);
+	ASSERT_TRUE(fwrite_model_txt(f_out, &x));
+	fclose(f_out);
+
+	FILE* const f_in = fopen(TEST_FILE, "rb");
+	ASSERT_NOT_NULL(f_in);
+
+	SALAD_T(y);
+	const int ret = salad_from_file_ex(f_in, &y);
+	fclose(f_in);
+	remove(TEST_FILE);
+	ASSERT_EQUAL(0, ret);
+
+	ASSERT_TRUE(IS_CUCKOOFILTER(y.model));
+	ASSERT_TRUE(!salad_spec_diff(&x, &y));
+	ASSERT_EQUAL(0, container_compare(TO_CONTAINER(x.model), TO_CONTAINER(y.model)));
+
+	// N-grams are stored once only, hence, they cannot be forgotten
+	ASSERT_NOT_EQUAL(0, salad_forget(&y, &d, 1));
+
+	salad_destroy(&y);
+	salad_destroy(&x);
+}
+
+CTEST(salad, fileformat_xor)
+{
+	char* TEST_FILE = "test.out";
+
+	SALAD_T(x);
+	salad_init(&x);
+	ASSERT_EQUAL(0, salad_set_bloomfilter(&x, DEFAULT_BFSIZE, "simple"));
+	salad_set_ngramlength(&x, NGRAM_LENGTH);
+
+	saladdata_t d = {(char*) TEST_STR1, strlen(TEST_STR1)};
+	ASSERT_EQUAL(0, salad_train(&x, &d, 1));
+	ASSERT_EQUAL(0, salad_freeze(&x, &d, 1));
+	ASSERT_EQUAL(CONTAINER_XORFILTER, TO_CONTAINER(x.model)->type);
+
+	double score = 1.0;
+	ASSERT_EQUAL(0, salad_predict_ex(&x, &d, 1, &score));
+	ASSERT_TRUE(score == 0.0);
+
+	FILE* const f_out = fopen(TEST_FILE, "wb+");
+	ASSERT_NOT_NULL(f_out);
+	ASSERT_TRUE(fwrite_model_txt(f_out, &x));
+	fclose(f_out);
+
+	FILE* const f_in = fopen(TEST_FILE, "rb");
+	ASSERT_NOT_NULL(f_in);
+
+	SALAD_T(y);
+	const int ret = salad_from_file_ex(f_in, &y);
+	fclose(f_in);
+	remove(TEST_FILE);
+	ASSERT_EQUAL(0, ret);
+
+	ASSERT_TRUE(!salad_spec_diff(&x, &y));
+	ASSERT_EQUAL(0, container_compare(TO_CONTAINER(x.model), TO_CONTAINER(y.model)));
+
+	// Frozen models cannot be updated
+	ASSERT_NOT_EQUAL(0, salad_forget(&y, &d, 1));
+
+	salad_destroy(&y);
+	salad_destroy(&x);
+}
+
+CTEST(salad, interleave)
+{
+	SALAD_T(good);
+	salad_init(&good);
+	ASSERT_EQUAL(0, salad_set_bloomfilter(&good, DEFAULT_BFSIZE, "simple"));
+	salad_set_ngramlength(&good, NGRAM_LENGTH);
+
+	SALAD_T(bad);
+	salad_init(&bad);
+	ASSERT_EQUAL(0, salad_set_bloomfilter(&bad, DEFAULT_BFSIZE, "simple"));
+	salad_set_ngramlength(&bad, NGRAM_LENGTH);
+
+	saladdata_t d1 = {(char*) TEST_STR1, strlen(TEST_STR1)};
+	saladdata_t d2 = {(char*) TEST_STR2, strlen(TEST_STR2)};
+	ASSERT_EQUAL(0, salad_train(&good, &d1, 1));
+	ASSERT_EQUAL(0, salad_train(&bad, &d2, 1));
+
+	container_t* const good_model = TO_CONTAINER(good.model);
+	container_t* const bad_model = TO_CONTAINER(bad.model);
+
+	const double expected1 = classify_2class_ex(good_model, bad_model, d1.buf, d1.len, NGRAM_LENGTH);
+	const double expected2 = classify_2class_ex(good_model, bad_model, d2.buf, d2.len, NGRAM_LENGTH);
+
+	ASSERT_EQUAL(0, salad_interleave(&good, &bad));
+	ASSERT_TRUE(IS_TWOCLASSBLOOMFILTER(good.model));
+
+	double score = 0.0;
+	ASSERT_EQUAL(0, salad_predict_ex(&good, &d1, 1, &score));
+	ASSERT_TRUE(score == expected1);
+	ASSERT_EQUAL(0, salad_predict_ex(&good, &d2, 1, &score));
+	ASSERT_TRUE(score == expected2);
+
+	// Interleaved models cannot be trained any further
+	ASSERT_NOT_EQUAL(0, salad_train(&good, &d1, 1));
+
+	salad_destroy(&bad);
+	salad_destroy(&good);
+}
+
+typedef struct {
+	const char* str;
+	size_t n;
+	size_t num;
+	int ok;
+} bitgrams_t;
+
+static void check_bitgram(const char* const ngram, const size_t len, void* const data)
+{
+	bitgrams_t* const x = (bitgrams_t*) data;
+
+	// Bit by bit reference of the bit n-gram starting at bit x->num
+	bitgram_t v = 0;
+	for (size_t i = 0; i < x->n; i++)
+	{
+		const size_t bit = x->num +i;
+		const unsigned char ch = (unsigned char) x->str[bit/ CHAR_BIT];
+		if (ch & (0x80 >> (bit %CHAR_BIT)))
+		{
+			v |= ((bitgram_t) 1) << (sizeof(bitgram_t) *CHAR_BIT -1 -i);
+		}
+	}
+
+	const size_t m = (x->n +CHAR_BIT -1)/ CHAR_BIT;
+	x->ok &= (len == m && memcmp(ngram, TO_CHARPTR(v, m), m) == 0);
+	x->num++;
+}
+
+CTEST(salad, extract_bitgrams)
+{
+	char str[40];
+	for (size_t i = 0; i < sizeof(str); i++)
+	{
+		str[i] = (char) (i *0x9d +0x3b);
+	}
+
+	// Inputs shorter and longer than a word and the window of two words
+	for (size_t len = 0; len <= sizeof(str); len++)
+	{
+		for (size_t n = 1; n <= MASK_BITSIZE; n += 7)
+		{
+			bitgrams_t x = {str, n, 0, TRUE};
+			extract_bitgrams(str, len, n, check_bitgram, &x);
+
+			ASSERT_TRUE(x.ok);
+			ASSERT_EQUAL_U(len *CHAR_BIT >= n ? len *CHAR_BIT -n +1 : 0, x.num);
+		}
+	}
+}
+
+CTEST(salad, bit_hashes)
+{
+	SALAD_T(mix);
+	salad_init(&mix);
+	ASSERT_EQUAL(0, salad_set_countingbloomfilter(&mix, DEFAULT_BFSIZE, "mix"));
+	salad_use_binary_ngrams(&mix, TRUE);
+	salad_set_ngramlength(&mix, 12);
+
+	SALAD_T(plain);
+	salad_init(&plain);
+	ASSERT_EQUAL(0, salad_set_bloomfilter(&plain, DEFAULT_BFSIZE, "murmur"));
+	salad_use_binary_ngrams(&plain, TRUE);
+	salad_set_ngramlength(&plain, 12);
+	ASSERT_TRUE(salad_spec_diff(&mix, &plain));
+
+	saladdata_t d1 = {(char*) TEST_STR1, strlen(TEST_STR1)};
+	saladdata_t d2 = {(char*) TEST_STR2, strlen(TEST_STR2)};
+	ASSERT_EQUAL(0, salad_train(&mix, &d1, 1));
+
+	// Hashing bit n-grams by value does not change which are known
+	double score = 1.0;
+	ASSERT_EQUAL(0, salad_predict_ex(&mix, &d1, 1, &score));
+	ASSERT_TRUE(score == 0.0);
+	ASSERT_EQUAL(0, salad_predict_ex(&mix, &d2, 1, &score));
+	ASSERT_TRUE(score > 0.0);
+
+	BLOOM* const bloom = GET_BLOOMFILTER(mix.model);
+	ASSERT_EQUAL(0, salad_forget(&mix, &d1, 1));
+	ASSERT_EQUAL_U(0, bloom_count(bloom));
+
+	// Bit n-grams hashed by value cannot be told apart in a frozen model
+	ASSERT_EQUAL(0, salad_train(&mix, &d1, 1));
+	ASSERT_NOT_EQUAL(0, salad_freeze(&mix, &d1, 1));
+
+	salad_destroy(&plain);
+	salad_destroy(&mix);
+}
+
+CTEST(salad, bytegram_kernels)
+{
+	const char* const hashsets[] = {"simple", "simple2", "murmur", "mix", "direct", "crc"};
+	const char* const str1 = TEST_STR1;
+	const char* const str2 = TEST_STR2;
+
+	for (size_t i = 0; i < sizeof(hashsets)/sizeof(hashsets[0]); i++)
+	for (int counting = 0; counting < 2; counting++)
+	for (size_t n = 1; n <= BLOOM_KERNEL_MAXN +1; n++)
+	{
+		const hashset_t hs = to_hashset(hashsets[i]);
+		BLOOM* const a = (counting ? bloom_init_counting(16, hs) : bloom_init(16, hs));
+		BLOOM* const b = (counting ? bloom_init_counting(16, hs) : bloom_init(16, hs));
+		container_t c = {(counting ? CONTAINER_COUNTINGBLOOMFILTER : CONTAINER_BLOOMFILTER), a};
+
+		// The specialized kernels must match n-gram wise processing
+		bloomize_ex(&c, str1, strlen(str1), n);
+		for (size_t k = 0; k +n <= strlen(str1); k++)
+		{
+			bloom_add_str(b, str1 +k, n);
+		}
+		ASSERT_EQUAL(0, bloom_compare(a, b));
+		if (counting)
+		{
+			ASSERT_EQUAL(0, memcmp(a->counters, b->counters, (a->bitsize +1)/2));
+		}
+
+		unsigned int num = 0, known = 0;
+		for (size_t k = 0; k +n <= strlen(str2); k++, num++)
+		{
+			if (bloom_check_str(b, str2 +k, n)) known++;
+		}
+		ASSERT_TRUE(classify_1class_ex(&c, str2, strlen(str2), n) == ((double) (num -known))/ num);
+
+		bloom_destroy(a);
+		bloom_destroy(b);
+	}
+}
+
+CTEST(salad, direct_bitmap)
+{
+	const char* const str1 = TEST_STR1;
+	const char* const str2 = TEST_STR2;
+
+	for (size_t n = 1; n <= 3; n++)
+	{
+		BLOOM* const bloom = bloom_init((unsigned short) (n *CHAR_BIT), HASHES_DIRECT);
+		ASSERT_NOT_NULL(bloom);
+		ASSERT_EQUAL(HASHES_DIRECT, bloom_hashset(bloom));
+
+		container_t c = {CONTAINER_BLOOMFILTER, bloom};
+		bloomize_ex(&c, str1, strlen(str1), n);
+
+		// Every n-gram has a bit of its own, i.e., there are no false positives
+		for (size_t k = 0; k +n <= strlen(str2); k++)
+		{
+			int known = FALSE;
+			for (size_t j = 0; j +n <= strlen(str1) && !known; j++)
+			{
+				known = (memcmp(str1 +j, str2 +k, n) == 0);
+			}
+			ASSERT_EQUAL(known, bloom_check_str(bloom, str2 +k, n));
+		}
+		bloom_destroy(bloom);
+	}
+}
+
+CTEST(salad, stream_chunks)
+{
+	const char* const delims[] = {NULL, " .", " ."};
+	const char* const str1 = TEST_STR1;
+	const char* const str2 = TEST_STR2;
+
+	for (size_t k = 0; k < sizeof(delims)/sizeof(delims[0]); k++)
+	for (size_t chunk_size = 1; chunk_size <= 17; chunk_size += 4)
+	{
+		SALAD_T(a); salad_init(&a);
+		SALAD_T(b); salad_init(&b);
+
+		for (salad_t* x = &a; x != NULL; x = (x == &a ? &b : NULL))
+		{
+			salad_set_countingbloomfilter(x, 16, "simple2");
+			salad_set_delimiter(x, delims[k]);
+			salad_set_ngramlength(x, 2);
+			salad_intern_tokens(x, k == 2);
+		}
+
+		// Training chunk by chunk corresponds to training at once
+		const saladdata_t whole = {(char*) str1, strlen(str1)};
+		salad_train(&a, &whole, 1);
+
+		SALAD_STREAM_T(st);
+		for (size_t i = 0; i < whole.len; i += chunk_size)
+		{
+			const saladdata_t chunk = {whole.buf +i, MIN(chunk_size, whole.len -i)};
+			ASSERT_EQUAL(EXIT_SUCCESS, salad_stream_train(&b, &st, &chunk, i +chunk_size >= whole.len));
+		}
+		ASSERT_EQUAL(0, st.len);
+
+		container_t* const ca = (container_t*) a.model.x;
+		container_t* const cb = (container_t*) b.model.x;
+		ASSERT_EQUAL(0, bloom_compare((BLOOM*) ca->data, (BLOOM*) cb->data));
+		ASSERT_EQUAL(0, memcmp(((BLOOM*) ca->data)->counters, ((BLOOM*) cb->data)->counters, (((BLOOM*) ca->data)->bitsize +1)/2));
+
+		// ... and so does the prediction
+		const saladdata_t other = {(char*) str2, strlen(str2)};
+		double expected, score = -1.0;
+		salad_predict_ex(&a, &other, 1, &expected);
+
+		for (size_t i = 0; i < other.len; i += chunk_size)
+		{
+			const saladdata_t chunk = {other.buf +i, MIN(chunk_size, other.len -i)};
+			ASSERT_EQUAL(EXIT_SUCCESS, salad_stream_predict(&a, &st, &chunk, i +chunk_size >= other.len, &score));
+		}
+		ASSERT_TRUE(score == expected);
+
+		salad_stream_destroy(&st);
+		salad_destroy(&a);
+		salad_destroy(&b);
+	}
+}
+
+CTEST(salad, window_scoring)
+{
+	const char* const benign = "abcabcabcabcabcabcabcabcabcabcabcabcabcabcabc";
+	char str[0x100];
+	snprintf(str, sizeof(str), "%.*s%s%s", 20, benign, "XYZW", benign +20);
+
+	BLOOM* const bloom = bloom_init(16, HASHES_SIMPLE);
+	container_t c = {CONTAINER_BLOOMFILTER, bloom};
+	bloomize_ex(&c, benign, strlen(benign), 3);
+
+	// The window with the most unknown n-grams covers the injected bytes
+	const window_t x = classify_1class_window_ex(&c, str, strlen(str), 3, 4);
+	ASSERT_EQUAL(18, x.offset);
+	ASSERT_EQUAL(6, x.len);
+	ASSERT_TRUE(x.score == 1.0);
+	ASSERT_TRUE(x.score > classify_1class_ex(&c, str, strlen(str), 3));
+
+	// A window spanning the whole string corresponds to the overall score
+	const window_t y = classify_1class_window_ex(&c, str, strlen(str), 3, 1000);
+	ASSERT_EQUAL(0, y.offset);
+	ASSERT_EQUAL(strlen(str), y.len);
+	ASSERT_TRUE(y.score == classify_1class_ex(&c, str, strlen(str), 3));
+
+	// Strings shorter than n have no score
+	ASSERT_TRUE(isnan(classify_1class_window_ex(&c, "ab", 2, 3, 4).score));
+
+	bloom_destroy(bloom);
+}
+
+CTEST(salad, chunked_counts)
+{
+	const char* const str1 = TEST_STR1;
+	const char* const str2 = TEST_STR2;
+	const size_t len = strlen(str2);
+
+	BLOOM* const bloom = bloom_init(16, HASHES_SIMPLE);
+	container_t c = {CONTAINER_BLOOMFILTER, bloom};
+	bloomize_ex(&c, str1, strlen(str1), 3);
+
+	const size_t known = classify_1class_known_ex(&c, str2, len, 3);
+	ASSERT_TRUE(classify_1class_ex(&c, str2, len, 3) == ((double) (len -2 -known))/ (len -2));
+
+	// Chunks overlapping by n-1 bytes see every n-gram exactly once
+	for (size_t chunk = 3; chunk < len; chunk++)
+	{
+		size_t sum = 0;
+		for (size_t pos = 0; pos +2 < len; pos += chunk -2)
+		{
+			sum += classify_1class_known_ex(&c, str2 +pos, MIN(chunk, len -pos), 3);
+		}
+		ASSERT_EQUAL(known, sum);
+	}
+	bloom_destroy(bloom);
+}
+
+static void append_wgram(const char* const ngram, const size_t len, void* const data)
+{
+	char* const out = (char*) data;
+	strncat(out, ngram, len);
+	strcat(out, "|");
+}
+
+static void expected_wgrams(const char* const str, const size_t n, const delimiter_array_t delim, char* const out)
+{
+	const char* tokens[64];
+	size_t lens[64], num_tokens = 0;
+
+	for (const char* x = str; *x != 0x00;)
+	{
+		while (*x != 0x00 && delim[(unsigned char) *x]) x++;
+		if (*x == 0x00) break;
+
+		tokens[num_tokens] = x;
+		while (*x != 0x00 && !delim[(unsigned char) *x]) x++;
+		lens[num_tokens] = (size_t) (x -tokens[num_tokens]);
+		num_tokens++;
+	}
+
+	const char ch = pick_delimiterchar(delim);
+	for (size_t i = 0; i +n <= num_tokens; i++)
+	{
+		for (size_t j = 0; j < n; j++)
+		{
+			if (j > 0) strncat(out, &ch, 1);
+			strncat(out, tokens[i +j], lens[i +j]);
+		}
+		strcat(out, "|");
+	}
+}
+
+CTEST(salad, delimscan_dispatch)
+{
+	char str[200];
+	for (size_t i = 0; i < sizeof(str); i++)
+	{
+		str[i] = (char) ((i *7919) % 13 == 0 ? " ./"[i % 3] : 'a' +(i % 26));
+	}
+
+	DELIM(delim) = {0};
+	to_delimiter_array(" ./", delim);
+	const delimscan_t* const scan = ngrams_delimscan(delim);
+
+	const unsigned int masks[] = {~0u, CPU_AVX2 | CPU_SSE2, CPU_SSE2, 0};
+	for (size_t i = 0; i < sizeof(str); i++)
+	{
+		const size_t len = sizeof(str) -i;
+
+		uint64_t expected = (len < DELIMSCAN_BLOCK ? ~UINT64_C(0) << len : 0);
+		for (size_t j = 0; j < MIN(len, DELIMSCAN_BLOCK); j++)
+		{
+			expected |= (uint64_t) (delim[(unsigned char) str[i +j]] != 0) << j;
+		}
+
+		// Each kernel selected at run-time yields the same mask
+		for (size_t k = 0; k < sizeof(masks)/sizeof(masks[0]); k++)
+		{
+			cpu_restrict_features(masks[k]);
+			ASSERT_TRUE(expected == delimscan_mask(scan, str +i, len));
+		}
+	}
+	cpu_restrict_features(~0u);
+}
+
+CTEST(salad, extract_wgrams)
+{
+	// Runs of delimiters and tokens crossing the blocks scanned at once
+	static const char* const str =
+			"GET /index.php?id=1&x=2 HTTP/1.1  Host: example.com\r\n"
+			"User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:38.0) Gecko/20100101\r\n"
+			"Accept:      text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8";
+
+	static const char* const delimiters[] = {
+			"%20", "%20%0d%0a", "%20%0d%0a/:;,=", "%20%0d%0a%09()[]{};,.:=+-*/<>!&?"
+	};
+
+	DELIM(delim);
+	char expected[0x400], actual[0x400];
+	for (size_t i = 0; i < sizeof(delimiters)/ sizeof(delimiters[0]); i++)
+	{
+		to_delimiter_array(delimiters[i], delim);
+		for (size_t n = 1; n <= 3; n++)
+		{
+			expected[0] = actual[0] = 0x00;
+			expected_wgrams(str, n, delim, expected);
+			extract_wgrams(str, strlen(str), n, delim, append_wgram, actual);
+			ASSERT_STR(expected, actual);
+		}
+	}
+}
+
+CTEST(salad, token_hashes)
+{
+	SALAD_T(mix);
+	salad_init(&mix);
+	ASSERT_EQUAL(0, salad_set_bloomfilter(&mix, DEFAULT_BFSIZE, "mix"));
+	salad_set_delimiter(&mix, TOKEN_DELIMITER);
+	salad_set_ngramlength(&mix, 2);
+
+	SALAD_T(plain);
+	salad_init(&plain);
+	ASSERT_EQUAL(0, salad_set_bloomfilter(&plain, DEFAULT_BFSIZE, "murmur"));
+	salad_set_delimiter(&plain, TOKEN_DELIMITER);
+	salad_set_ngramlength(&plain, 2);
+
+	ASSERT_TRUE(container_hashes_tokens(TO_CONTAINER(mix.model)));
+	ASSERT_FALSE(container_hashes_tokens(TO_CONTAINER(plain.model)));
+	ASSERT_TRUE(salad_spec_diff(&mix, &plain));
+
+	saladdata_t d1 = {(char*) TEST_STR1, strlen(TEST_STR1)};
+	saladdata_t d2 = {(char*) TEST_STR2, strlen(TEST_STR2)};
+	ASSERT_EQUAL(0, salad_train(&mix, &d1, 1));
+	ASSERT_EQUAL(0, salad_train(&plain, &d1, 1));
+
+	// Hashing the tokens does not change which n-grams are known
+	double score = 1.0;
+	ASSERT_EQUAL(0, salad_predict_ex(&mix, &d1, 1, &score));
+	ASSERT_TRUE(score == 0.0);
+
+	double expected = 0.0;
+	ASSERT_EQUAL(0, salad_predict_ex(&plain, &d2, 1, &expected));
+	ASSERT_EQUAL(0, salad_predict_ex(&mix, &d2, 1, &score));
+	ASSERT_TRUE(score == expected && score > 0.0);
+
+	// Neither do runs of delimiters between the tokens
+	saladdata_t d3 = {(char*) "The  quick brown\t\tfox", 21};
+	ASSERT_EQUAL(0, salad_predict_ex(&plain, &d3, 1, &expected));
+	ASSERT_EQUAL(0, salad_predict_ex(&mix, &d3, 1, &score));
+	ASSERT_TRUE(score == expected && score == 0.0);
+
+	// Hashed tokens cannot be told apart in a frozen model
+	ASSERT_NOT_EQUAL(0, salad_freeze(&mix, &d1, 1));
+
+	salad_destroy(&plain);
+	salad_destroy(&mix);
+}
+
+CTEST(salad, interned_tokens)
+{
+	char* TEST_FILE = "test.out";
+
+	SALAD_T(x);
+	salad_init(&x);
+	ASSERT_EQUAL(0, salad_set_bloomfilter(&x, DEFAULT_BFSIZE, "simple2"));
+	salad_set_delimiter(&x, TOKEN_DELIMITER);
+	salad_set_ngramlength(&x, 2);
+	ASSERT_EQUAL(0, salad_intern_tokens(&x, TRUE));
+
+	SALAD_T(plain);
+	salad_init(&plain);
+	ASSERT_EQUAL(0, salad_set_bloomfilter(&plain, DEFAULT_BFSIZE, "simple2"));
+	salad_set_delimiter(&plain, TOKEN_DELIMITER);
+	salad_set_ngramlength(&plain, 2);
+	ASSERT_TRUE(salad_spec_diff(&x, &plain));
+
+	// Tokens containing characters that need to be escaped in the model
+	static const char TEST_STR3[] = "50% of\x01 the quick brown fox";
+	saladdata_t d1 = {(char*) TEST_STR1, strlen(TEST_STR1)};
+	saladdata_t d2 = {(char*) TEST_STR2, strlen(TEST_STR2)};
+	saladdata_t d3 = {(char*) TEST_STR3, strlen(TEST_STR3)};
+	ASSERT_EQUAL(0, salad_train(&x, &d1, 1));
+	ASSERT_EQUAL(0, salad_train(&x, &d3, 1));
+	ASSERT_EQUAL(0, salad_train(&plain, &d1, 1));
+	ASSERT_EQUAL(0, salad_train(&plain, &d3, 1));
+
+	// Mapping the tokens to ids does not change which n-grams are known
+	double score = 1.0, expected = 0.0;
+	ASSERT_EQUAL(0, salad_predict_ex(&x, &d1, 1, &score));
+	ASSERT_TRUE(score == 0.0);
+
+	const size_t num_tokens = __(x).tokens->count;
+	ASSERT_EQUAL(0, salad_predict_ex(&plain, &d2, 1, &expected));
+	ASSERT_EQUAL(0, salad_predict_ex(&x, &d2, 1, &score));
+	ASSERT_TRUE(score == expected && score > 0.0);
+
+	// Unknown tokens are not learned while predicting
+	ASSERT_EQUAL_U(num_tokens, __(x).tokens->count);
+
+	FILE* const f_out = fopen(TEST_FILE, "wb+");
+	ASSERT_NOT_NULL(f_out);
+	ASSERT_TRUE(fwrite_model_txt(f_out, &x));
+	fclose(f_out);
+
+	FILE* const f_in = fopen(TEST_FILE, "rb");
+	ASSERT_NOT_NULL(f_in);
+
+	SALAD_T(y);
+	const int ret = salad_from_file_ex(f_in, &y);
+	fclose(f_in);
+	remove(TEST_FILE);
+	ASSERT_EQUAL(0, ret);
+
+	// The ids of the tokens are restored as well
+	ASSERT_TRUE(!salad_spec_diff(&x, &y));
+	ASSERT_NOT_NULL(__(y).tokens);
+	ASSERT_EQUAL_U(num_tokens, __(y).tokens->count);
+	for (uint32_t id = 1; id <= num_tokens; id++)
+	{
+		size_t xlen, ylen;
+		const char* const xstr = dict_get(__(x).tokens, id, &xlen);
+		const char* const ystr = dict_get(__(y).tokens, id, &ylen);
+		ASSERT_DATA((const unsigned char*) xstr, xlen, (const unsigned char*) ystr, ylen);
+	}
+
+	ASSERT_EQUAL(0, salad_predict_ex(&y, &d2, 1, &score));
+	ASSERT_TRUE(score == expected);
+	ASSERT_EQUAL(0, salad_predict_ex(&y, &d3, 1, &score));
+	ASSERT_TRUE(score == 0.0);
+
+	// Each model comes with its own dictionary
+	ASSERT_NOT_EQUAL(0, salad_interleave(&x, &y));
+
+	salad_destroy(&y);
+	salad_destroy(&plain);
+	salad_destroy(&x);
+}
+
+CTEST(salad, predict_batch)
+{
+	static const char TEST_STR3[] = "Pack my box with five dozen liquor jugs";
+	const char* const strs[] = {TEST_STR1, TEST_STR2, TEST_STR3};
+
+	// Substrings of all lengths, including ones too short to be scored
+	salad_view_t views[300];
+	saladdata_t data[300];
+	for (size_t i = 0; i < 300; i++)
+	{
+		const char* const str = strs[i %3];
+		const size_t len = strlen(str);
+		const size_t offset = (i *7) %len;
+
+		views[i].buf = str +offset;
+		views[i].len = MIN(i %23, len -offset);
+		data[i].buf = (char*) views[i].buf;
+		data[i].len = views[i].len;
+	}
+
+	for (size_t k = 0; k < 5; k++)
+	{
+		SALAD_T(x);
+		salad_init(&x);
+		ASSERT_EQUAL(0, salad_set_bloomfilter(&x, DEFAULT_BFSIZE, "simple2"));
+		salad_use_binary_ngrams(&x, k == 1);
+		salad_set_delimiter(&x, (k == 2 || k == 3 ? TOKEN_DELIMITER : NULL));
+		salad_set_ngramlength(&x, (k == 2 || k == 3 ? 2 : NGRAM_LENGTH));
+		ASSERT_EQUAL(0, salad_intern_tokens(&x, k == 3));
+
+		saladdata_t d1 = {(char*) TEST_STR1, strlen(TEST_STR1)};
+		ASSERT_EQUAL(0, salad_train(&x, &d1, 1));
+
+		SALAD_T(bad);
+		if (k == 4)
+		{
+			// A two-class model yields classification values instead
+			salad_init(&bad);
+			ASSERT_EQUAL(0, salad_set_bloomfilter(&bad, DEFAULT_BFSIZE, "simple2"));
+			salad_set_ngramlength(&bad, NGRAM_LENGTH);
+
+			saladdata_t d3 = {(char*) TEST_STR3, strlen(TEST_STR3)};
+			ASSERT_EQUAL(0, salad_train(&bad, &d3, 1));
+			ASSERT_EQUAL(0, salad_interleave(&x, &bad));
+		}
+
+		double expected[300];
+		ASSERT_EQUAL(0, salad_predict_ex(&x, data, 300, expected));
+
+		salad_handle_t* const h = salad_handle_create(&x);
+		ASSERT_NOT_NULL(h);
+
+		const size_t nthreads[] = {0, 1, 3, 8, 64};
+		for (size_t j = 0; j < sizeof(nthreads)/sizeof(nthreads[0]); j++)
+		{
+			double scores[300];
+			memset(scores, 0x00, sizeof(scores));
+			ASSERT_EQUAL(0, salad_predict_batch(h, views, 300, scores, nthreads[j]));
+
+			int ok = TRUE;
+			for (size_t i = 0; i < 300; i++)
+			{
+				ok &= (scores[i] == expected[i] || (isnan(scores[i]) && isnan(expected[i])));
+			}
+			ASSERT_TRUE(ok);
+		}
+
+		ASSERT_EQUAL(0, salad_predict_batch(h, NULL, 0, NULL, 4));
+		ASSERT_NOT_EQUAL(0, salad_predict_batch(NULL, views, 300, expected, 4));
+
+		salad_handle_destroy(h);
+		if (k == 4)
+		{
+			salad_destroy(&bad);
+		}
+		salad_destroy(&x);
+	}
+}
+
 // Test salad's modes (train, predict, inspect, ...)
@@ -0,0 +1,106 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include <ctest.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "common.h"
+#include "../serve.h"
+
+// Appends a request of the given strings to the buffer
+static size_t to_request(uint8_t* const buf, const char* const strs[], const uint32_t n)
+{
+	memcpy(buf, &n, sizeof(uint32_t));
+	size_t pos = sizeof(uint32_t);
+
+	for (uint32_t i = 0; i < n; i++)
+	{
+		const uint32_t l = (uint32_t) strlen(strs[i]);
+		memcpy(buf +pos, &l, sizeof(uint32_t));
+		memcpy(buf +pos +sizeof(uint32_t), strs[i], l);
+		pos += sizeof(uint32_t) +l;
+	}
+	return pos;
+}
+
+CTEST(serve, parse)
+{
+	const char* const strs[] = {"abc", "", TEST_STR1};
+	uint8_t buf[0x100];
+	const size_t len = to_request(buf, strs, 3);
+
+	serve_parser_t p = EMPTY_SERVE_PARSER_INITIALIZER;
+	ASSERT_EQUAL_U(0, serve_parse(&p, buf, 0));
+	ASSERT_EQUAL_U(len, serve_parse(&p, buf, len));
+
+	// The parser is ready for the next request
+	ASSERT_EQUAL_U(0, p.pos);
+	ASSERT_EQUAL_U(len, serve_parse(&p, buf, len));
+
+	// A request without strings
+	const size_t empty = to_request(buf, strs, 0);
+	ASSERT_EQUAL_U(sizeof(uint32_t), empty);
+	ASSERT_EQUAL_U(empty, serve_parse(&p, buf, empty));
+}
+
+CTEST(serve, parse_incremental)
+{
+	const char* const strs[] = {"abc", "", TEST_STR1};
+	uint8_t buf[0x100];
+	const size_t len = to_request(buf, strs, 3);
+	const size_t next = to_request(buf +len, strs, 1);
+
+	// Bytes arrive one at a time
+	serve_parser_t p = EMPTY_SERVE_PARSER_INITIALIZER;
+	for (size_t i = 0; i < len; i++)
+	{
+		ASSERT_EQUAL_U(0, serve_parse(&p, buf, i));
+	}
+	ASSERT_EQUAL_U(len, serve_parse(&p, buf, len +next));
+	ASSERT_EQUAL_U(next, serve_parse(&p, buf +len, next));
+
+	// Length prefixes that were parsed already are not looked at again
+	ASSERT_EQUAL_U(0, serve_parse(&p, buf, 2*sizeof(uint32_t) +strlen(strs[0]) +2));
+	memset(buf +sizeof(uint32_t), 0xFF, sizeof(uint32_t));
+	ASSERT_EQUAL_U(len, serve_parse(&p, buf, len));
+}
+
+CTEST(serve, parse_malformed)
+{
+	uint8_t buf[0x10];
+	const uint32_t x[] = {2, 0, SERVE_MAX_REQUEST};
+	memcpy(buf, x, sizeof(x));
+
+	serve_parser_t p = EMPTY_SERVE_PARSER_INITIALIZER;
+	ASSERT_EQUAL_U(0, serve_parse(&p, buf, 2*sizeof(uint32_t)));
+	ASSERT_EQUAL_U(SIZE_MAX, serve_parse(&p, buf, sizeof(x)));
+
+	// Requests up to the limit are fine
+	const uint32_t y[] = {1, SERVE_MAX_REQUEST -2*sizeof(uint32_t)};
+	memcpy(buf, y, sizeof(y));
+
+	serve_parser_t q = EMPTY_SERVE_PARSER_INITIALIZER;
+	ASSERT_EQUAL_U(0, serve_parse(&q, buf, sizeof(y)));
+
+	const uint32_t z[] = {1, SERVE_MAX_REQUEST -2*sizeof(uint32_t) +1};
+	memcpy(buf, z, sizeof(z));
+
+	serve_parser_t r = EMPTY_SERVE_PARSER_INITIALIZER;
+	ASSERT_EQUAL_U(SIZE_MAX, serve_parse(&r, buf, sizeof(z)));
+}
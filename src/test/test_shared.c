@@ -0,0 +1,165 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctest.h>
+
+#include "common.h"
+#include "../shared.h"
+
+#ifdef USE_SHM
+#include <salad/analyze.h>
+#include <salad/util.h>
+
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+CTEST_DATA(shared)
+{
+	char file[0x100];
+	char name[0x100];
+	BLOOM* bloom;
+};
+
+CTEST_SETUP(shared)
+{
+	snprintf(data->file, sizeof(data->file), "test_shared.%d.out", (int) getpid());
+	snprintf(data->name, sizeof(data->name), "/salad-test-%d", (int) getpid());
+	shm_unlink(data->name);
+
+	SALAD_T(x);
+	salad_init(&x);
+	salad_set_bloomfilter_ex(&x, bloom_init(DEFAULT_BFSIZE, HASHES_SIMPLE));
+	salad_set_delimiter(&x, DELIMITER);
+	salad_set_ngramlength(&x, NGRAM_LENGTH);
+	bloomize_ex(TO_CONTAINER(x.model), TEST_STR1, strlen(TEST_STR1), x.ngram_length);
+
+	salad_to_file(&x, data->file);
+	data->bloom = bloom_init(DEFAULT_BFSIZE, HASHES_SIMPLE);
+	BLOOM* const b = GET_BLOOMFILTER(x.model);
+	memcpy(data->bloom->a, b->a, data->bloom->size);
+	salad_destroy(&x);
+}
+
+CTEST_TEARDOWN(shared)
+{
+	remove(data->file);
+	shm_unlink(data->name);
+	bloom_destroy(data->bloom);
+}
+
+CTEST2(shared, spec_only)
+{
+	SALAD_T(x);
+	ASSERT_EQUAL(EXIT_SUCCESS, salad_spec_from_file(data->file, &x));
+
+	BLOOM* const b = GET_BLOOMFILTER(x.model);
+	ASSERT_NULL(b->a);
+	ASSERT_EQUAL_U(data->bloom->bitsize, b->bitsize);
+	ASSERT_EQUAL_U(data->bloom->size, b->size);
+	ASSERT_EQUAL_U(NGRAM_LENGTH, x.ngram_length);
+	salad_destroy(&x);
+}
+
+CTEST2(shared, publish_attach)
+{
+	SALAD_T(x);
+	shared_t sx = EMPTY_SHARED_INITIALIZER;
+	ASSERT_EQUAL(EXIT_SUCCESS, salad_from_shared("training", data->file, data->name, &x, &sx));
+	ASSERT_NOT_NULL(sx.addr);
+
+	// The second one attaches to the array of the first one
+	SALAD_T(y);
+	shared_t sy = EMPTY_SHARED_INITIALIZER;
+	ASSERT_EQUAL(EXIT_SUCCESS, salad_from_shared("training", data->file, data->name, &y, &sy));
+	ASSERT_NOT_NULL(sy.addr);
+	ASSERT_TRUE(sy.bloom->a == (uint8_t*) sy.addr +SHARED_OFFSET);
+
+	ASSERT_EQUAL(0, bloom_compare(data->bloom, sx.bloom));
+	ASSERT_EQUAL(0, bloom_compare(data->bloom, sy.bloom));
+	ASSERT_TRUE(!salad_spec_diff(&x, &y));
+
+	salad_unshare(&sy);
+	salad_destroy(&y);
+	salad_unshare(&sx);
+	salad_destroy(&x);
+}
+
+CTEST2(shared, stale)
+{
+	// A publisher that died before the array was complete
+	const pid_t pid = fork();
+	if (pid == 0) _exit(0);
+	waitpid(pid, NULL, 0);
+
+	const int fd = shm_open(data->name, O_RDWR | O_CREAT | O_EXCL, 0644);
+	ASSERT_TRUE(fd >= 0);
+	ASSERT_EQUAL(0, ftruncate(fd, SHARED_OFFSET +data->bloom->size));
+
+	const shared_header_t h = {.magic = SHARED_MAGIC, .version = SHARED_VERSION, .pid = (uint64_t) pid, .ready = 0};
+	ASSERT_EQUAL((ssize_t) sizeof(h), pwrite(fd, &h, sizeof(h), 0));
+	close(fd);
+
+	const time_t start = time(NULL);
+
+	SALAD_T(x);
+	shared_t sx = EMPTY_SHARED_INITIALIZER;
+	ASSERT_EQUAL(EXIT_SUCCESS, salad_from_shared("training", data->file, data->name, &x, &sx));
+
+	// Replaced right away rather than waited for
+	ASSERT_TRUE(time(NULL) -start < 2);
+	ASSERT_NOT_NULL(sx.addr);
+	ASSERT_EQUAL(getpid(), (pid_t) ((shared_header_t*) sx.addr)->pid);
+	ASSERT_EQUAL(0, bloom_compare(data->bloom, sx.bloom));
+
+	salad_unshare(&sx);
+	salad_destroy(&x);
+}
+
+CTEST2(shared, other_file)
+{
+	SALAD_T(x);
+	shared_t sx = EMPTY_SHARED_INITIALIZER;
+	ASSERT_EQUAL(EXIT_SUCCESS, salad_from_shared("training", data->file, data->name, &x, &sx));
+	ASSERT_NOT_NULL(sx.addr);
+
+	// The model was retrained while its publisher is still around
+	const struct timespec t[2] = {{0, UTIME_OMIT}, {1, 0}};
+	ASSERT_EQUAL(0, utimensat(AT_FDCWD, data->file, t, 0));
+
+	SALAD_T(y);
+	shared_t sy = EMPTY_SHARED_INITIALIZER;
+	ASSERT_EQUAL(EXIT_SUCCESS, salad_from_shared("training", data->file, data->name, &y, &sy));
+	ASSERT_NULL(sy.addr);
+
+	BLOOM* const b = GET_BLOOMFILTER(y.model);
+	ASSERT_EQUAL(0, bloom_compare(data->bloom, b));
+
+	salad_destroy(&y);
+	salad_unshare(&sx);
+	salad_destroy(&x);
+}
+
+#endif
@@ -17,6 +17,8 @@
 
 #include <ctest.h>
 
+#include <util/cpu.h>
+
 #include <stdlib.h>
 #include <string.h>
 
@@ -64,6 +66,45 @@ CTEST(util, inline_decode)
 	}
 }
 
+CTEST(util, inline_decode_blocks)
+{
+	// Encodings at every offset of the blocks scanned at once
+	char in[300], expected[300], buf[400], pad[400];
+	size_t len = 0, n = 0;
+	for (size_t i = 0; len +3 < sizeof(in); i++)
+	{
+		if (i % 11 == 5)
+		{
+			len += (size_t) sprintf(in +len, "%%%02X", (unsigned int) (i % 0x100));
+			expected[n++] = (char) (i % 0x100);
+		}
+		else if (i % 17 == 3)
+		{
+			len += (size_t) sprintf(in +len, "%%x%c", (char) ('a' +(i % 26)));
+			n += (size_t) sprintf(expected +n, "%%x%c", (char) ('a' +(i % 26)));
+		}
+		else in[len++] = expected[n++] = (char) ('a' +(i % 26));
+	}
+	memset(pad, 'z', sizeof(pad));
+
+	const unsigned int masks[] = {~0u, CPU_SSE2, 0};
+	for (size_t k = 0; k < sizeof(masks)/sizeof(masks[0]); k++)
+	{
+		cpu_restrict_features(masks[k]);
+		for (size_t i = 0; i < 64; i++)
+		{
+			memcpy(buf, pad, i);
+			memcpy(buf +i, in, len);
+			ASSERT_EQUAL_U(i +n, inline_decode(buf, i +len));
+
+			memcpy(pad +i, expected, n);
+			ASSERT_DATA((const unsigned char*) pad, i +n, (const unsigned char*) buf, i +n);
+			memset(pad +i, 'z', n);
+		}
+	}
+	cpu_restrict_features(~0u);
+}
+
 CTEST(util, starts_with)
 {
 	#define STR "¼ pounder with cheese"
@@ -176,3 +217,16 @@ CTEST(util, memcmp_bytes)
 	a[size -1] = 0xFF;
 	ASSERT_EQUAL(0, memcmp_bytes(&a, &c, sizeof(uint8_t) *size));
 }
+
+CTEST(util, cpu_features)
+{
+	char buf[0x100];
+	const unsigned int x = cpu_features();
+
+	cpu_restrict_features(CPU_SSE2);
+	ASSERT_EQUAL_U(x & CPU_SSE2, cpu_features());
+	ASSERT_STR((x & CPU_SSE2 ? "sse2" : ""), cpu_features_str(buf, sizeof(buf)));
+
+	cpu_restrict_features(~0u);
+	ASSERT_EQUAL_U(x, cpu_features());
+}
@@ -0,0 +1,95 @@
+/*
+ * Salad - A Content Anomaly Detector based on n-Grams
+ * Copyright (c) 2012-2015, Christian Wressnegger
+ * --
+ * This file is part of Letter Salad or Salad for short.
+ *
+ * Salad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Salad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include <ctest.h>
+
+#include <container/hash.h>
+#include <container/xor.h>
+#include <util/util.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+
+#define NUM_KEYS 10000
+
+static void to_ngram(char* const buf, const size_t i)
+{
+	snprintf(buf, 0x10, "n%"ZU, (SIZE_T) i);
+}
+
+CTEST(xor, build)
+{
+	uint64_t* const keys = (uint64_t*) malloc(NUM_KEYS *sizeof(uint64_t));
+	ASSERT_NOT_NULL(keys);
+
+	char buf[0x10];
+	for (size_t i = 0; i < NUM_KEYS; i++)
+	{
+		to_ngram(buf, i);
+		keys[i] = murmur64_hash_n(buf, strlen(buf));
+	}
+
+	XORFILTER* const x = xor_build(keys, NUM_KEYS);
+	free(keys);
+	ASSERT_NOT_NULL(x);
+	ASSERT_EQUAL_U(NUM_KEYS, x->count);
+	// ~1.23 fingerprints per key
+	ASSERT_TRUE(xor_bitsize(x) < 25 *NUM_KEYS);
+
+	// No false negatives
+	for (size_t i = 0; i < NUM_KEYS; i++)
+	{
+		to_ngram(buf, i);
+		ASSERT_TRUE(xor_check_str(x, buf, strlen(buf)));
+	}
+
+	// The false positive rate is about 2^-16
+	size_t fp = 0;
+	for (size_t i = NUM_KEYS; i < 100 *NUM_KEYS; i++)
+	{
+		to_ngram(buf, i);
+		fp += xor_check_str(x, buf, strlen(buf));
+	}
+	ASSERT_TRUE(fp < 100);
+
+	xor_destroy(x);
+}
+
+CTEST(xor, empty)
+{
+	XORFILTER* const x = xor_build(NULL, 0);
+	ASSERT_NOT_NULL(x);
+	ASSERT_EQUAL_U(0, x->count);
+	ASSERT_FALSE(xor_check_str(x, "abc", 3));
+	xor_destroy(x);
+}
+
+CTEST(xor, compare)
+{
+	const uint64_t keys[] = { 1, 2, 3, 42 };
+
+	XORFILTER* const a = xor_build(keys, 4);
+	XORFILTER* const b = xor_build(keys, 4);
+	ASSERT_NOT_NULL(a);
+	ASSERT_NOT_NULL(b);
+	ASSERT_EQUAL(0, xor_compare(a, b));
+
+	xor_destroy(a);
+	xor_destroy(b);
+}